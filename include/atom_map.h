@@ -0,0 +1,100 @@
+#ifndef ATOM_MAP_H
+#define ATOM_MAP_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+/*
+ * Reaction atom-to-atom mapping.
+ *
+ * A reaction is given as two molecules, all reactants in one and all
+ * products in the other (disconnected fragments, as in "CCO.CC(=O)O").
+ * The mapping pairs reactant atoms with product atoms of the same element
+ * so that the fewest bonds are broken, formed or change order, which is
+ * the same as maximizing the common bond substructure of the two sides.
+ * Among mappings with equally few bond edits, fewer atoms changing
+ * hydrogen count, charge or aromaticity win. Terminal hydrogens are
+ * folded into counts and left unmapped, as in canonicalization.
+ *
+ * The search is depth-first branch and bound over the reactant atoms in
+ * breadth-first order from the rarest element. Candidates are tried in
+ * order of their added cost, so the first complete mapping is already a
+ * good one, and a branch is cut when its cost plus a lower bound on the
+ * remaining edits cannot beat the best so far. The bound matches the
+ * degree distributions of the still unmapped atoms of each element:
+ * every bond edit changes the degree of at most two of them by one.
+ * When the sides differ in composition, surplus atoms stay unmapped. A
+ * time budget caps each reaction; the best mapping found by then is
+ * returned, flagged as not proven optimal.
+ */
+
+#define ATOM_MAP_DEFAULT_BUDGET 0.1     /* Seconds per reaction */
+
+typedef struct {
+    int bonds_broken;           /* Reactant bonds with no product bond */
+    int bonds_formed;           /* Product bonds with no reactant bond */
+    int bonds_changed;          /* Bond kept with a different order */
+    int atoms_changed;          /* Mapped atoms whose H count, charge or aromaticity differ */
+    int unmapped;               /* Heavy reactant atoms without a partner */
+    bool optimal;               /* Search completed within the budget */
+    long long nodes;            /* Search nodes visited */
+} AtomMapResult;
+
+/* Reusable scratch space; use one mapper per thread */
+typedef struct {
+    int capacity;               /* Atoms per side */
+    int edge_capacity;
+    int candidate_capacity;
+
+    /* Per side (0 reactants, 1 products): heavy atoms and their graph */
+    int count[2];
+    int* atoms[2];              /* Kept index -> atom */
+    int* compact[2];            /* Atom -> kept index, -1 if folded hydrogen */
+    int* hydrogens[2];
+    int* classes[2];            /* Element class per kept atom */
+    int* offsets[2];            /* Kept-atom CSR adjacency */
+    int* neighbors[2];
+    unsigned char* bond_types[2];
+
+    int class_count;
+    int* class_sizes[2];
+    int* histograms[2];         /* Unmapped atoms per class and degree */
+    int* members;               /* Product atoms grouped by class */
+    int* member_offsets;
+
+    int* order;                 /* Reactant atoms in search order */
+    int* map;                   /* Reactant kept -> product kept, -1 unmapped */
+    int* inverse;
+    int* best;
+    int* candidates;            /* Per depth slices */
+    int* candidate_costs;
+} AtomMapper;
+
+void atom_mapper_init(AtomMapper* mapper);
+void atom_mapper_free(AtomMapper* mapper);
+
+/*
+ * Map reactants onto products. map (reactants->atom_count entries)
+ * receives the product atom of each reactant atom, -1 for folded hydrogens
+ * and unmapped atoms. budget <= 0 selects ATOM_MAP_DEFAULT_BUDGET. Returns
+ * false on allocation failure.
+ */
+bool atom_map(AtomMapper* mapper, const Molecule* reactants, const Molecule* products,
+              double budget, int* map, AtomMapResult* result);
+
+/*
+ * Split reaction SMILES "reactants>>products" (or "reactants>agents>products",
+ * agents ignored) and parse both sides with implicit hydrogens. Returns
+ * false if either side is missing or invalid.
+ */
+bool atom_map_parse_reaction(const char* smiles, Molecule* reactants, Molecule* products);
+
+/*
+ * Map count reactions in parallel, reaction i from reactants[i] to
+ * products[i] into maps[i] and results[i] (results may be NULL).
+ * threads <= 0 means one per CPU. Returns false on allocation failure.
+ */
+bool atom_map_batch(const Molecule* const* reactants, const Molecule* const* products, int count,
+                    double budget, int threads, int* const* maps, AtomMapResult* results);
+
+#endif /* ATOM_MAP_H */
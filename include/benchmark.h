@@ -0,0 +1,32 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*
+ * Throughput benchmarks for the batch engines.
+ * Each prints its workload, wall time and items per second to stdout.
+ */
+
+void benchmark_ionic_enumeration(void);
+void benchmark_mass_decomposition(void);
+void benchmark_isotope_pattern(void);
+void benchmark_molecule_pool(void);
+void benchmark_smiles_parsing(void);
+void benchmark_canonical_dedupe(void);
+void benchmark_substructure_search(void);
+void benchmark_similarity_search(void);
+void benchmark_validation(void);
+void benchmark_ring_perception(void);
+void benchmark_forcefield(void);
+void benchmark_descriptors(void);
+void benchmark_atom_mapping(void);
+void benchmark_reaction_similarity(void);
+void benchmark_network_expansion(void);
+void benchmark_kinetics(void);
+void benchmark_stochastic(void);
+void benchmark_thermochemistry(void);
+void benchmark_live_updates(void);
+
+/* Run every benchmark in sequence */
+void benchmark_run_all(void);
+
+#endif /* BENCHMARK_H */
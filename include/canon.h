@@ -0,0 +1,113 @@
+#ifndef CANON_H
+#define CANON_H
+
+#include "molecule.h"
+#include "ring.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Graph canonicalization.
+ *
+ * Terminal hydrogens (plain H with one single bond to a non-hydrogen) are
+ * folded into their neighbor's hydrogen count, so explicit- and
+ * implicit-hydrogen forms of a compound canonicalize identically.
+ * Aromaticity is perceived the same way for every input: an SSSR ring of
+ * alternating single and double bonds (or of atoms already marked
+ * aromatic) is aromatic when its pi electrons number 4n + 2, counting 1
+ * per atom with a double bond in a ring or an aromatic mark, 2 per
+ * lone-pair donor (NH, O, S, C-) and 0 for an exocyclic double bond or an
+ * empty p orbital (C+, B). Its atoms and bonds are then treated as
+ * aromatic, so Kekule and aromatic forms (C1=CC=CC=C1, c1ccccc1) give the
+ * same ranks, hash and SMILES. Marks the input already carries are kept.
+ * The remaining atoms are ranked by Morgan-style iterative refinement: atoms
+ * start in classes of equal invariants (element, isotope, charge,
+ * aromaticity, hydrogen count, degree) and each class is split by the
+ * sorted ranks and bond orders of its neighbors until stable. Remaining
+ * ties (symmetry) are broken one atom at a time, re-refining after each
+ * break. Invariant and neighbor comparisons are exact, never hashed.
+ *
+ * All functions need the molecule's adjacency to be built.
+ */
+
+/* 128-bit canonical graph hash */
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} CanonHash;
+
+/*
+ * Reusable scratch space. Arrays grow to the largest molecule seen, so a
+ * context reused across a library does no allocation once warmed up.
+ * Use one context per thread.
+ */
+typedef struct {
+    int capacity;               /* Atoms */
+    int edge_capacity;          /* Adjacency entries */
+    int kept;                   /* Atoms left after folding hydrogens */
+    int* compact;               /* Atom -> kept index, -1 if folded hydrogen */
+    int* atoms;                 /* Kept index -> atom */
+    int* hydrogens;             /* Folded hydrogens per kept atom */
+    uint64_t* invariants;
+    int* offsets;               /* Kept-atom CSR adjacency */
+    int* neighbors;
+    int* bond_codes;
+    int* keys;                  /* Per-entry neighbor keys / edge marks */
+    int* ranks;
+    int* order;                 /* Kept atoms sorted by rank */
+    int* scratch;
+    int* stack;                 /* SMILES writer DFS frames */
+    int* rings;                 /* Ring closures: open, close, bond, digit */
+    int* ring_offsets;          /* Per-atom ring opening and closing lists */
+    int* ring_lists;
+    unsigned char* aromatic;    /* Perceived, per atom */
+    unsigned char* bond_flags;  /* Per bond: in a ring, aromatic */
+    RingContext sssr;
+} CanonContext;
+
+void canon_context_init(CanonContext* ctx);
+void canon_context_free(CanonContext* ctx);
+
+/*
+ * Canonical rank of every atom, 0 .. atom_count - 1. Kept atoms come first;
+ * folded hydrogens follow, ordered by their neighbor's rank.
+ */
+bool canon_ranks(CanonContext* ctx, const Molecule* mol, int* ranks);
+
+/* 128-bit hash of the canonical graph; equal for identical compounds */
+bool canon_hash(CanonContext* ctx, const Molecule* mol, CanonHash* hash);
+
+/*
+ * Canonical SMILES with aromatic lowercase atoms and implicit hydrogens.
+ * Returns false if the buffer is too small or there are more than 99
+ * simultaneously open ring closures.
+ */
+bool canon_smiles(CanonContext* ctx, const Molecule* mol, char* buffer, size_t buffer_size);
+
+/* One-shot wrappers around a temporary context */
+bool molecule_canonical_hash(const Molecule* mol, CanonHash* hash);
+bool molecule_canonical_smiles(const Molecule* mol, char* buffer, size_t buffer_size);
+
+bool canon_hash_equals(const CanonHash* a, const CanonHash* b);
+
+/* ============ Hash Set ============ */
+
+/*
+ * Open-addressing set of canonical hashes for deduplicating libraries in a
+ * single pass.
+ */
+typedef struct {
+    CanonHash* slots;
+    unsigned char* used;
+    size_t capacity;            /* Power of two */
+    size_t count;
+} CanonHashSet;
+
+bool canon_hash_set_init(CanonHashSet* set, size_t expected);
+void canon_hash_set_free(CanonHashSet* set);
+/* Insert; returns 1 if new, 0 if already present, -1 on allocation failure */
+int canon_hash_set_insert(CanonHashSet* set, const CanonHash* hash);
+bool canon_hash_set_contains(const CanonHashSet* set, const CanonHash* hash);
+
+#endif /* CANON_H */
@@ -0,0 +1,108 @@
+#ifndef DESCRIPTOR_H
+#define DESCRIPTOR_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+/*
+ * Molecular descriptors for screening, computed for many molecules at once
+ * into columnar arrays (one array of doubles per descriptor).
+ *
+ * Descriptors are selected with a bit mask. Each molecule is scanned once
+ * per intermediate the selection needs: per-atom heavy degree, hydrogen
+ * count (implicit plus explicit neighbors), multiple-bond and carbonyl
+ * flags from one pass over the bonds; ring bonds from one bridge search;
+ * fragments from one union-find pass. Descriptors that share an
+ * intermediate reuse it, and intermediates nobody asked for are skipped.
+ *
+ * Definitions (explicit and implicit hydrogens give the same values):
+ *   donors      N or O atoms carrying at least one hydrogen
+ *   acceptors   N and O atoms without a positive charge, except amide N
+ *               and aromatic N with three connections or a hydrogen
+ *               (pyrrole type)
+ *   rotatable   non-ring single bonds between atoms with two or more heavy
+ *               neighbors, excluding bonds to triple-bonded atoms and
+ *               amide C-N bonds
+ *   rings       cyclomatic number, bonds - atoms + fragments
+ *   polarity    sum over bonds of the Pauling electronegativity difference
+ *               of the two atoms (elements without a value contribute 0)
+ *   Fsp3        sp3 carbons (no multiple bonds) over all carbons
+ */
+
+typedef enum {
+    DESCRIPTOR_MOLECULAR_WEIGHT,
+    DESCRIPTOR_HEAVY_ATOMS,
+    DESCRIPTOR_HETEROATOMS,         /* Heavy atoms other than carbon */
+    DESCRIPTOR_HBOND_DONORS,
+    DESCRIPTOR_HBOND_ACCEPTORS,
+    DESCRIPTOR_ROTATABLE_BONDS,
+    DESCRIPTOR_RING_COUNT,
+    DESCRIPTOR_AROMATIC_ATOMS,
+    DESCRIPTOR_FORMAL_CHARGE,
+    DESCRIPTOR_BOND_POLARITY,
+    DESCRIPTOR_FRACTION_CSP3,
+    DESCRIPTOR_COUNT
+} Descriptor;
+
+#define DESCRIPTOR_BIT(d) (1u << (d))
+#define DESCRIPTOR_ALL ((1u << DESCRIPTOR_COUNT) - 1)
+
+/* Short column name, e.g. "hbd" */
+const char* descriptor_name(Descriptor descriptor);
+
+/* Reusable per-atom scratch; use one context per thread */
+typedef struct {
+    int capacity;               /* Atoms */
+    int edge_capacity;          /* Adjacency entries */
+    int* heavy_degree;
+    int* hydrogens;
+    unsigned char* flags;       /* Multiple bond, triple bond, carbonyl carbon */
+    int* offsets;               /* CSR adjacency when the molecule has none */
+    int* neighbors;
+    int* bonds;
+    int* disc;                  /* Bridge search */
+    int* low;
+    int* stack;
+    int* parent;                /* Union-find */
+    unsigned char* ring_bond;
+} DescriptorContext;
+
+void descriptor_context_init(DescriptorContext* ctx);
+void descriptor_context_free(DescriptorContext* ctx);
+
+/*
+ * Compute the descriptors in mask for one molecule into
+ * values[DESCRIPTOR_COUNT]; unselected entries are left alone. Returns
+ * false on allocation failure.
+ */
+bool descriptor_compute(DescriptorContext* ctx, const Molecule* mol, unsigned int mask,
+                        double* values);
+
+/* ============ Columnar Table ============ */
+
+typedef struct {
+    unsigned int mask;                  /* Selected descriptors */
+    int count;                          /* Rows */
+    int capacity;
+    double* columns[DESCRIPTOR_COUNT];  /* NULL when not selected */
+} DescriptorTable;
+
+void descriptor_table_init(DescriptorTable* table, unsigned int mask);
+void descriptor_table_free(DescriptorTable* table);
+
+/* Grow or shrink to count rows; new rows are zeroed */
+bool descriptor_table_resize(DescriptorTable* table, int count);
+
+/* Column of a selected descriptor, NULL otherwise */
+double* descriptor_column(const DescriptorTable* table, Descriptor descriptor);
+
+/*
+ * Fill the table's selected columns for count molecules, row i for
+ * molecules[i], resizing it to count rows. Work is split across threads
+ * (<= 0 means one per CPU), each with its own context. Returns false on
+ * allocation failure.
+ */
+bool descriptor_compute_batch(const Molecule* const* molecules, int count, int threads,
+                              DescriptorTable* table);
+
+#endif /* DESCRIPTOR_H */
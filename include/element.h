@@ -2,13 +2,15 @@
 #define ELEMENT_H
 
 #include <stddef.h>
+#include <stdbool.h>
 
 /* Bond types */
 typedef enum {
     BOND_NONE = 0,
     BOND_SINGLE = 1,
     BOND_DOUBLE = 2,
-    BOND_TRIPLE = 3
+    BOND_TRIPLE = 3,
+    BOND_AROMATIC = 4           /* Delocalized, order 1.5 */
 } BondType;
 
 /* Element state at room temperature */
@@ -47,6 +49,14 @@ typedef struct {
     int common_charges[4];      /* Common ionic charges (0-terminated) */
 } Element;
 
+/* Naturally occurring isotope */
+typedef struct {
+    int atomic_number;
+    int mass_number;            /* Nucleon count, used as the nominal mass */
+    double mass;                /* Exact mass in u */
+    double abundance;           /* Terrestrial mole fraction (sums to 1 per element) */
+} Isotope;
+
 /* Number of elements in our database */
 #define NUM_ELEMENTS 118
 
@@ -66,4 +76,16 @@ void element_print(const Element* el);
 /* Calculate max bonds an element can typically form */
 int element_max_bonds(const Element* el);
 
+/*
+ * Stable and primordial isotopes of an element, ordered by mass number.
+ * Returns the count (0 for elements without natural isotopes).
+ */
+int element_isotopes(const Element* el, const Isotope** isotopes);
+
+/* Mass of the most abundant isotope (falls back to atomic_mass if none) */
+double element_monoisotopic_mass(const Element* el);
+
+/* True for alkali/alkaline earth, transition, post-transition, lanthanide and actinide metals */
+bool element_is_metal(const Element* el);
+
 #endif /* ELEMENT_H */
@@ -0,0 +1,98 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "molecule.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Circular (ECFP-like) fingerprints and Tanimoto similarity search.
+ *
+ * Terminal hydrogens are folded into counts as in canonicalization, so
+ * explicit- and implicit-hydrogen molecules give the same bits and the
+ * compact form skips the hydrogen atoms entirely. Each
+ * heavy atom starts from a hash of its element, isotope, charge, hydrogen
+ * count, heavy degree and aromaticity; every iteration rehashes it with
+ * the sorted (bond, neighbor identifier) pairs around it, so iteration r
+ * describes the atom's environment out to r bonds. Identifiers from all
+ * iterations are folded into a FINGERPRINT_BITS-bit vector.
+ *
+ * Fingerprints live in a FingerprintMatrix: fixed-width rows in one
+ * 64-byte aligned block, so each row starts on a cache line, plus a
+ * popcount per row for the Tanimoto denominator and bound pruning.
+ */
+
+#define FINGERPRINT_BITS 1024
+#define FINGERPRINT_WORDS (FINGERPRINT_BITS / 64)
+#define FINGERPRINT_ALIGNMENT 64
+#define FINGERPRINT_DEFAULT_RADIUS 2        /* ECFP4 */
+
+/* Reusable scratch space; use one context per thread */
+typedef struct {
+    int capacity;               /* Atoms */
+    int edge_capacity;          /* Adjacency entries */
+    int* compact;               /* Atom -> kept index, -1 if folded hydrogen */
+    int* atoms;                 /* Kept index -> atom */
+    int* hydrogens;
+    int* offsets;               /* Kept-atom CSR adjacency */
+    int* neighbors;
+    int* bond_codes;
+    uint64_t* ids;              /* Current identifier per kept atom */
+    uint64_t* next_ids;
+    uint64_t* keys;             /* Per-edge (bond, neighbor id) keys */
+} FingerprintContext;
+
+void fingerprint_context_init(FingerprintContext* ctx);
+void fingerprint_context_free(FingerprintContext* ctx);
+
+/*
+ * Circular fingerprint of mol with the given radius into
+ * FINGERPRINT_WORDS words. The molecule's adjacency must be built.
+ */
+bool fingerprint_ecfp(FingerprintContext* ctx, const Molecule* mol, int radius, uint64_t* bits);
+
+int fingerprint_popcount(const uint64_t* bits);
+double fingerprint_tanimoto(const uint64_t* a, const uint64_t* b);
+
+/* ============ Matrix ============ */
+
+typedef struct {
+    uint64_t* bits;             /* count rows of FINGERPRINT_WORDS, aligned */
+    int* popcounts;
+    int count;
+    int capacity;
+    void* block;                /* Unaligned allocation behind bits */
+} FingerprintMatrix;
+
+void fingerprint_matrix_init(FingerprintMatrix* matrix);
+void fingerprint_matrix_free(FingerprintMatrix* matrix);
+
+/* Grow or shrink to count rows; new rows are zeroed */
+bool fingerprint_matrix_resize(FingerprintMatrix* matrix, int count);
+
+/* Row pointer; rows are FINGERPRINT_WORDS words */
+uint64_t* fingerprint_matrix_row(const FingerprintMatrix* matrix, int row);
+
+/* Overwrite a row and its popcount; safe from different threads for different rows */
+void fingerprint_matrix_set(FingerprintMatrix* matrix, int row, const uint64_t* bits);
+
+/* Append a fingerprint; returns its row or -1 */
+int fingerprint_matrix_add(FingerprintMatrix* matrix, const uint64_t* bits);
+
+/* ============ Similarity Search ============ */
+
+typedef struct {
+    int index;
+    double similarity;
+} SimilarityHit;
+
+/*
+ * The k rows most similar to query by Tanimoto, across threads, in
+ * descending similarity (ties by ascending row). Rows whose popcount bound
+ * min(a, b) / max(a, b) cannot beat a worker's current k-th hit are skipped
+ * without reading their bits. Returns the number of hits written or -1.
+ */
+int fingerprint_top_k(const FingerprintMatrix* matrix, const uint64_t* query, int k,
+                      int threads, SimilarityHit* hits);
+
+#endif /* FINGERPRINT_H */
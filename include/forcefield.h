@@ -0,0 +1,137 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+#include "molecule.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Simple all-atom force field over a molecule's 3D coordinates.
+ *
+ *   E = sum_bonds  kb (r - r0)^2
+ *     + sum_angles ka (cos t - cos t0)^2
+ *     + sum_pairs  eps_ij ((rm_ij / r)^12 - 2 (rm_ij / r)^6)
+ *     + sum_pairs  332.06 qi qj / r
+ *
+ * in kcal/mol with distances in Angstrom. r0 comes from covalent radii
+ * shortened by bond order, t0 from the hybridization implied by the
+ * bonds of the central atom (sp3 109.5, sp2 120, sp 180), rm_ij and
+ * eps_ij from per-element van der Waals radii and well depths, and q from
+ * formal charges. Non-bonded pairs closer than 1-4 (bonded or sharing a
+ * neighbor) are excluded and pairs beyond the cutoff ignored. Only
+ * explicit atoms take part; expand implicit hydrogens first for an
+ * all-atom model.
+ *
+ * Non-bonded pairs are found with a cell list: atoms are counting-sorted
+ * into cubic cells half a cutoff wide, with cells numbered along x so that
+ * the five cells of a row around an atom hold one contiguous run of the
+ * sorted coordinate arrays. Each atom then meets its half shell of
+ * neighbors as thirteen contiguous runs, evaluated by a branch-free
+ * distance kernel (SSE2 where available) over structure-of-arrays data. Cells are processed in
+ * parallel with a gradient buffer per thread. Excluded pairs inside the
+ * cutoff are evaluated along with the rest and subtracted afterwards.
+ */
+
+#define FORCEFIELD_DEFAULT_CUTOFF 8.0
+
+typedef struct {
+    double bond;
+    double angle;
+    double van_der_waals;
+    double electrostatic;
+    double total;
+    long long pairs;            /* Non-bonded pairs inside the cutoff */
+} ForceFieldEnergy;
+
+/*
+ * Parameters for one molecule plus reusable scratch space. The topology
+ * is captured by forcefield_setup; coordinates are read from the molecule
+ * at each evaluation, so it must keep its atoms and bonds unchanged.
+ */
+typedef struct {
+    int atom_count;
+    double cutoff;
+
+    double* radius;             /* Half the van der Waals minimum distance */
+    double* sqrt_epsilon;       /* sqrt of the well depth, so eps_ij = product */
+    double* charge;
+    int* charged;               /* Atoms with non-zero charge */
+    int charged_count;
+
+    int bond_count;
+    int* bond_atoms;            /* Pairs */
+    double* bond_k;
+    double* bond_r0;
+
+    int angle_count;
+    int* angle_atoms;           /* Triples, center in the middle */
+    double* angle_k;
+    double* angle_cos0;
+
+    int exclusion_count;
+    long long* exclusions;      /* Sorted keys i << 32 | j with i < j */
+
+    double* grad_x;             /* Gradient from the last evaluation */
+    double* grad_y;
+    double* grad_z;
+
+    /* Cell list scratch, in sorted (cell) order */
+    int cell_capacity;
+    int* cell_start;
+    int* cell_of;
+    int* order;                 /* Sorted position -> atom */
+    double* sorted;             /* x, y, z, radius, sqrt_epsilon blocks of atom_count */
+
+    size_t worker_capacity;     /* Doubles */
+    double* worker_gradients;   /* Per thread x, y, z blocks of atom_count */
+
+    double* saved;              /* Minimizer: previous x, y, z */
+} ForceField;
+
+void forcefield_init(ForceField* ff);
+void forcefield_free(ForceField* ff);
+
+/*
+ * Assign parameters for a molecule. cutoff <= 0 selects
+ * FORCEFIELD_DEFAULT_CUTOFF. Builds the adjacency if needed. Returns false
+ * on allocation failure.
+ */
+bool forcefield_setup(ForceField* ff, Molecule* mol, double cutoff);
+
+/*
+ * Energy in kcal/mol of the molecule's current coordinates, broken down
+ * into terms when terms is not NULL. Fills ff->grad_x/y/z with the
+ * gradient (kcal/mol/A). threads <= 0 means one per CPU; small molecules
+ * are evaluated on the calling thread. Returns NAN without coordinates or
+ * if the molecule no longer matches the setup.
+ */
+double forcefield_energy(ForceField* ff, const Molecule* mol, int threads, ForceFieldEnergy* terms);
+
+/*
+ * Rough starting coordinates: each atom is placed one bond length from
+ * the atom it was reached from in a breadth-first walk, continuing away
+ * from its grandparent with a seeded random bend, and separate fragments
+ * are set side by side. Meant to be refined by forcefield_minimize.
+ */
+bool forcefield_embed(const ForceField* ff, Molecule* mol, unsigned int seed);
+
+typedef struct {
+    int steps;
+    double initial_energy;
+    double final_energy;
+    double rms_gradient;
+    bool converged;
+} MinimizeResult;
+
+/*
+ * Steepest descent on the molecule's coordinates. Each step moves every
+ * atom along its negative gradient, scaled so the largest move equals the
+ * step size; the step grows by 20% after a step that lowers the energy
+ * and halves after one that does not (which is undone). Stops when the
+ * RMS gradient falls below rms_tolerance or after max_steps. Returns
+ * false without coordinates or on allocation failure.
+ */
+bool forcefield_minimize(ForceField* ff, Molecule* mol, int max_steps, double rms_tolerance,
+                         int threads, MinimizeResult* result);
+
+#endif /* FORCEFIELD_H */
@@ -0,0 +1,55 @@
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include "reaction.h"
+#include <stdbool.h>
+
+/*
+ * Stockroom inventory over the reaction database.
+ *
+ * Each reaction keeps a count of distinct reactant species that are not in
+ * stock. Adding or removing a species only touches the reactions in that
+ * species' consumer postings, so building an inventory of N species costs
+ * O(total postings) and each update costs O(postings of that species).
+ * Runnable reactions (missing count 0) are kept in a dense set so listing
+ * them costs O(result).
+ *
+ * An inventory covers the reactions in the database when it was built:
+ * reactions inserted later are ignored until it is rebuilt, and removed
+ * ones are never runnable.
+ */
+typedef struct {
+    bool* in_stock;             /* Per species id */
+    int* missing;               /* Per reaction: reactant species not in stock */
+    int* runnable;              /* Dense list of runnable reaction indices */
+    int* runnable_pos;          /* Position in runnable list (-1 if absent) */
+    int runnable_count;
+    int species_count;
+    int reaction_count;
+} Inventory;
+
+/* Create an empty inventory (returns false on allocation failure) */
+bool inventory_init(Inventory* inv);
+void inventory_free(Inventory* inv);
+
+/* Remove all species from the inventory */
+void inventory_clear(Inventory* inv);
+
+/* Add/remove one species; species absent from the database are ignored */
+bool inventory_add(Inventory* inv, const Formula* species);
+bool inventory_remove(Inventory* inv, const Formula* species);
+bool inventory_add_string(Inventory* inv, const char* formula);
+bool inventory_remove_string(Inventory* inv, const char* formula);
+
+/* Check whether a species / reaction is available */
+bool inventory_has(const Inventory* inv, const Formula* species);
+bool inventory_can_run(const Inventory* inv, int reaction_index);
+
+/* List runnable reactions (returns number written to results) */
+int inventory_runnable(const Inventory* inv, const Reaction** results, int max_results);
+
+/* One-shot query: reactions whose reactants are all in the given set */
+int inventory_query(const Formula* species, int species_count,
+                    const Reaction** results, int max_results);
+
+#endif /* INVENTORY_H */
@@ -0,0 +1,104 @@
+#ifndef ION_H
+#define ION_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+#define MAX_ION_PARTS 3
+#define NUM_POLYATOMIC_IONS 20
+
+/* Common polyatomic ion with its composition */
+typedef struct {
+    const char* formula;        /* As written (e.g., "SO4") */
+    const char* name;           /* Common name (e.g., "Sulfate") */
+    int charge;
+    int part_count;
+    struct {
+        int atomic_number;
+        int count;
+    } parts[MAX_ION_PARTS];
+} PolyatomicIon;
+
+extern const PolyatomicIon POLYATOMIC_IONS[NUM_POLYATOMIC_IONS];
+
+/* A monatomic or polyatomic ion */
+typedef struct {
+    const Element* element;     /* Monatomic ion element (NULL if polyatomic) */
+    int polyatomic;             /* Index into POLYATOMIC_IONS (-1 if monatomic) */
+    int charge;
+} Ion;
+
+/* Lookup polyatomic ion index by formula (e.g., "NO3"), -1 if unknown */
+int polyatomic_find(const char* formula);
+
+/* Construct ions */
+Ion ion_monatomic(const Element* element, int charge);
+Ion ion_polyatomic(int index);
+bool ion_equals(const Ion* a, const Ion* b);
+
+/* Preferred charges from Element.common_charges (0 if the element has none) */
+int element_cation_charge(const Element* el);  /* First positive charge listed */
+int element_anion_charge(const Element* el);   /* First negative charge listed */
+
+/* Append count copies of an ion's atoms to a formula */
+bool ion_add_to_formula(const Ion* ion, int count, Formula* formula);
+
+/* Build the neutral compound of a cation and anion (e.g., Ca2+ + OH- -> CaO2H2) */
+bool ion_compound(const Ion* cation, const Ion* anion, Formula* result);
+
+/*
+ * Split a compound into cation_count cations and anion_count anions with
+ * matching charges. Cations are tried as a single metal, NH4, then H;
+ * anions as a monatomic nonmetal or a multiple of a polyatomic ion.
+ */
+bool ion_split(const Formula* compound, Ion* cation, int* cation_count,
+               Ion* anion, int* anion_count);
+
+/* Print ion with charge (e.g., "SO4(2-)") */
+void ion_print(const Ion* ion);
+
+/* ============ Ionic Compound Enumeration ============ */
+
+#define IONIC_MAX_IONS 3
+
+/* A charge-neutral combination of ions with reduced subscripts */
+typedef struct {
+    Ion ions[IONIC_MAX_IONS];           /* Cations first, then anions */
+    int counts[IONIC_MAX_IONS];
+    int ion_count;
+    uint64_t fingerprint;               /* Same as formula_fingerprint() of the composition */
+} IonicCompound;
+
+typedef struct {
+    int max_subscript;          /* Largest count of any one ion (default 6) */
+    int max_atomic_number;      /* Only elements up to this Z (default 86) */
+    bool include_ternary;       /* Two cations + one anion or one cation + two anions */
+    bool include_polyatomic;    /* Use POLYATOMIC_IONS as well as monatomic ions */
+    bool metal_cations_only;    /* Restrict monatomic cations to metals (default true) */
+    int threads;                /* Worker threads (<= 0: one per CPU) */
+} IonicEnumOptions;
+
+typedef struct {
+    long long candidates;       /* Neutral combinations generated */
+    long long unique;           /* After fingerprint dedupe */
+    double seconds;
+} IonicEnumStats;
+
+/*
+ * Called for each unique compound. Calls are serialized (never concurrent),
+ * arrive in batches from the worker threads, and are in no particular
+ * order. Return false to stop the enumeration early.
+ */
+typedef bool (*IonicEmitFn)(const IonicCompound* compound, void* user_data);
+
+void ionic_enum_options_default(IonicEnumOptions* options);
+
+/* Enumerate all neutral compounds within the option limits */
+bool ionic_enumerate(const IonicEnumOptions* options, IonicEmitFn emit,
+                     void* user_data, IonicEnumStats* stats);
+
+/* Convert to a Formula or a display string such as "Ca(NO3)2" */
+bool ionic_compound_to_formula(const IonicCompound* compound, Formula* formula);
+bool ionic_compound_format(const IonicCompound* compound, char* buffer, size_t buffer_size);
+
+#endif /* ION_H */
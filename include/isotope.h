@@ -0,0 +1,44 @@
+#ifndef ISOTOPE_H
+#define ISOTOPE_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+/* One aggregated peak: all isotopologues sharing a nominal mass */
+typedef struct {
+    int nominal_mass;           /* Sum of isotope mass numbers */
+    double mass;                /* Probability-weighted mean exact mass */
+    double probability;         /* Fraction of molecules in this peak */
+    double relative;            /* Intensity relative to the base peak (1.0) */
+} IsotopePeak;
+
+/* Isotopic pattern of a single molecule, ordered by nominal mass */
+typedef struct {
+    IsotopePeak* peaks;
+    int peak_count;
+    double monoisotopic_mass;
+    double average_mass;        /* Mean over the retained distribution */
+} IsotopePattern;
+
+typedef struct {
+    double prune_threshold;     /* Drop tail bins below this probability */
+    double min_relative;        /* Omit output peaks below this fraction of the base peak */
+} IsotopePatternOptions;
+
+/* Default options: prune below 1e-12, report peaks above 0.01% of the base */
+void isotope_pattern_options_default(IsotopePatternOptions* options);
+
+/*
+ * Compute the aggregated isotopic pattern of one formula unit (the leading
+ * coefficient is ignored). Each element's isotope distribution is raised
+ * to its atom count by repeated squaring, and tails below the prune
+ * threshold are cut after every convolution, so the cost grows with the
+ * width of the pattern rather than the number of atoms.
+ * Elements without natural isotopes contribute their average mass.
+ */
+bool isotope_pattern(const Formula* formula, const IsotopePatternOptions* options,
+                     IsotopePattern* pattern);
+void isotope_pattern_free(IsotopePattern* pattern);
+void isotope_pattern_print(const IsotopePattern* pattern);
+
+#endif /* ISOTOPE_H */
@@ -0,0 +1,102 @@
+#ifndef MASS_DECOMP_H
+#define MASS_DECOMP_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+#define MASS_MAX_ELEMENTS 16
+
+/* Which element mass to match against */
+typedef enum {
+    MASS_MONOISOTOPIC,
+    MASS_AVERAGE
+} MassType;
+
+/* One alphabet element with its allowed atom count range */
+typedef struct {
+    const Element* element;
+    int min_count;
+    int max_count;
+} MassAlphabetEntry;
+
+/*
+ * Mass decomposition engine (Boecker & Liptak extended residue table).
+ *
+ * Element masses are scaled by 1/precision and rounded to integers. The
+ * table holds, for each residue class modulo the smallest integer mass and
+ * each element prefix, the smallest integer mass in that class that the
+ * prefix can form. A query enumerates decompositions of each integer mass
+ * in the tolerance window and prunes every branch the table proves
+ * impossible, so work is proportional to the number of decompositions
+ * rather than to the product of the count ranges.
+ *
+ * The decomposer is read-only after init and safe to query from threads.
+ */
+typedef struct {
+    int element_count;
+    const Element* elements[MASS_MAX_ELEMENTS];     /* Sorted by mass */
+    double masses[MASS_MAX_ELEMENTS];               /* Real mass per element */
+    long long integer_masses[MASS_MAX_ELEMENTS];
+    int min_counts[MASS_MAX_ELEMENTS];
+    int ranges[MASS_MAX_ELEMENTS];                  /* max_count - min_count */
+    long long max_rest[MASS_MAX_ELEMENTS];          /* Largest mass of elements [0, i) */
+
+    MassType mass_type;
+    double precision;                               /* Daltons per integer unit */
+    double min_ratio;                               /* Bounds of integer/real mass ratio */
+    double max_ratio;
+
+    long long residue_count;                        /* integer_masses[0] */
+    long long* ert;                                 /* residue_count x element_count */
+} MassDecomposer;
+
+/* A matching formula */
+typedef struct {
+    int counts[MASS_MAX_ELEMENTS];                  /* Aligned with decomposer elements */
+    double mass;
+    double error_ppm;
+    double rdbe;                                    /* Ring plus double bond equivalents */
+} MassCandidate;
+
+typedef struct {
+    double ppm;                 /* Tolerance in parts per million */
+    bool use_rdbe;              /* Filter by RDBE from element_max_bonds */
+    double rdbe_min;
+    double rdbe_max;
+    bool integer_rdbe;          /* Even-electron neutral molecules only */
+} MassQueryOptions;
+
+/*
+ * Build tables for an alphabet. precision <= 0 selects 1e-4 Da; the value
+ * is nudged up to 4% coarser to minimize rounding error over the alphabet.
+ */
+bool mass_decomposer_init(MassDecomposer* decomposer, const MassAlphabetEntry* alphabet,
+                          int alphabet_count, MassType type, double precision);
+void mass_decomposer_free(MassDecomposer* decomposer);
+
+/* Default query options: 5 ppm, RDBE in [0, 50] */
+void mass_query_options_default(MassQueryOptions* options);
+
+/*
+ * Find formulas matching a mass. Writes up to max_results candidates and
+ * returns the total number of matches (which may exceed max_results).
+ */
+int mass_decompose(const MassDecomposer* decomposer, double mass,
+                   const MassQueryOptions* options,
+                   MassCandidate* results, int max_results);
+
+/*
+ * Decompose many masses across threads. Query q writes into
+ * results[q * max_per_query] and its total match count into counts[q].
+ */
+bool mass_decompose_batch(const MassDecomposer* decomposer,
+                          const double* masses, int mass_count,
+                          const MassQueryOptions* options,
+                          MassCandidate* results, int max_per_query,
+                          int* counts, int threads);
+
+/* Convert a candidate into a Formula */
+bool mass_candidate_to_formula(const MassDecomposer* decomposer,
+                               const MassCandidate* candidate, Formula* formula);
+
+#endif /* MASS_DECOMP_H */
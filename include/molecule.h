@@ -3,9 +3,9 @@
 
 #include "element.h"
 #include <stdbool.h>
+#include <stdint.h>
 
-#define MAX_ATOMS_PER_MOLECULE 100
-#define MAX_BONDS_PER_MOLECULE 150
+#define MAX_ATOMS_PER_MOLECULE 100   /* Distinct elements per Formula */
 #define MAX_FORMULA_LENGTH 256
 
 /* Atom within a molecule */
@@ -13,6 +13,9 @@ typedef struct {
     const Element* element;     /* Pointer to element in periodic table */
     int charge;                 /* Ionic charge (0 for neutral) */
     int id;                     /* Unique ID within molecule */
+    int isotope;                /* Mass number (0 = natural abundance) */
+    bool aromatic;              /* Member of an aromatic system */
+    unsigned char hydrogens;    /* Implicit hydrogens carried, not stored as atoms */
 } Atom;
 
 /* Bond between two atoms */
@@ -22,15 +25,73 @@ typedef struct {
     BondType type;              /* Single, double, or triple bond */
 } Bond;
 
-/* Molecule structure */
+typedef struct MoleculePool MoleculePool;
+
+/*
+ * Molecule structure
+ *
+ * Atoms and bonds live in growable arrays, so size is limited only by
+ * memory. Neighbor queries use a compressed-sparse-row adjacency built by
+ * molecule_build_adjacency: the neighbors of atom i are
+ * adjacency[adjacency_offsets[i] .. adjacency_offsets[i + 1]), with the
+ * matching bond indices in adjacency_bonds. Adding atoms or bonds marks
+ * the adjacency stale until it is rebuilt; the same goes for the ring
+ * cache filled by ring_perceive.
+ *
+ * Hydrogens may be stored as explicit atoms or as per-atom counts
+ * (Atom.hydrogens); the implicit form roughly halves the graph of an
+ * organic molecule. molecule_compact_hydrogens and
+ * molecule_expand_hydrogens convert between the two in place.
+ *
+ * 3D coordinates are optional. Once enabled they are kept as separate x,
+ * y and z arrays (structure of arrays, for vectorized geometry) that grow
+ * with the atoms; new atoms start at the origin.
+ *
+ * The element histogram, net charge, molecular mass and Hill formula are
+ * kept current by molecule_add_atom(s) and the atom setters, so reading
+ * them is O(1); implicit hydrogens are included. Edit atoms only through
+ * those functions, or call molecule_calculate_mass afterwards to
+ * resynchronize.
+ *
+ * A molecule owns its arrays; release them with molecule_free. When pool
+ * is set (see molecule_pool.h) the arrays come from that pool instead of
+ * the heap.
+ */
 typedef struct {
     char name[64];              /* Common name (e.g., "Water") */
-    char formula[MAX_FORMULA_LENGTH]; /* Chemical formula (e.g., "H2O") */
-    Atom atoms[MAX_ATOMS_PER_MOLECULE];
+    char formula[MAX_FORMULA_LENGTH]; /* Hill formula (e.g., "H2O"), generated */
+    Atom* atoms;
     int atom_count;
-    Bond bonds[MAX_BONDS_PER_MOLECULE];
+    int atom_capacity;
+    Bond* bonds;
     int bond_count;
-    double molecular_mass;      /* Calculated from atoms */
+    int bond_capacity;
+    double molecular_mass;      /* Sum of atom masses, maintained */
+    int total_charge;           /* Sum of atom charges, maintained */
+    int implicit_hydrogens;     /* Sum of Atom.hydrogens, maintained */
+
+    int element_counts[NUM_ELEMENTS + 1];   /* Atoms per atomic number */
+    unsigned char elements[NUM_ELEMENTS];   /* Atomic numbers present, by symbol */
+    int element_kinds;                      /* Entries used in elements */
+    unsigned short count_offsets[NUM_ELEMENTS + 1]; /* Where each count sits in formula */
+
+    int* adjacency_offsets;     /* atom_count + 1 entries */
+    int* adjacency;             /* Neighbor atom IDs, 2 * bond_count entries */
+    int* adjacency_bonds;       /* Bond index for each adjacency entry */
+    bool adjacency_valid;
+
+    int* ring_offsets;          /* SSSR cache (see ring.h): ring_count + 1 entries */
+    int* ring_atoms;            /* Atom IDs of each ring in cycle order */
+    int* ring_bonds;            /* Bond i joins ring atoms i and i + 1, cyclically */
+    int* atom_ring_counts;      /* SSSR rings through each atom */
+    int ring_count;
+    bool rings_valid;
+
+    double* coord_x;            /* Optional 3D coordinates (Angstrom) as */
+    double* coord_y;            /* structure of arrays, NULL until */
+    double* coord_z;            /* molecule_enable_coordinates */
+
+    MoleculePool* pool;         /* Storage source (NULL = heap) */
 } Molecule;
 
 /* Element count for formula representation */
@@ -49,26 +110,104 @@ typedef struct {
 /* Molecule creation and manipulation */
 void molecule_init(Molecule* mol, const char* name);
 int molecule_add_atom(Molecule* mol, const Element* element, int charge);
+/* Add count identical atoms in one step; returns the first new atom ID or -1 */
+int molecule_add_atoms(Molecule* mol, const Element* element, int charge, int count);
 bool molecule_add_bond(Molecule* mol, int atom1_id, int atom2_id, BondType type);
+/* Change an atom's charge or isotope, keeping charge and mass current */
+bool molecule_set_atom_charge(Molecule* mol, int atom_id, int charge);
+bool molecule_set_atom_isotope(Molecule* mol, int atom_id, int isotope);
+/* Set an atom's implicit hydrogen count (0-255), keeping properties current */
+bool molecule_set_atom_hydrogens(Molecule* mol, int atom_id, int count);
+/* Set all counts from counts[atom_count] with a single property update */
+bool molecule_set_hydrogens(Molecule* mol, const int* counts);
+/* Recompute histogram, charge, mass and formula from the atoms (O(atoms)) */
 void molecule_calculate_mass(Molecule* mol);
+void molecule_free(Molecule* mol);
+/* Remove all atoms and bonds, keeping allocated storage */
+void molecule_clear(Molecule* mol);
+/* Release a molecule from molecule_create_* or molecule_pool_create */
+void molecule_destroy(Molecule* mol);
+bool molecule_reserve(Molecule* mol, int atom_capacity, int bond_capacity);
+/*
+ * Resize or release a block owned by the molecule, taken from its pool
+ * when it has one; for modules that cache derived data on the molecule.
+ */
+void* molecule_storage_resize(Molecule* mol, void* block, size_t old_bytes, size_t new_bytes);
+void molecule_storage_release(Molecule* mol, void* block);
+
+/* ============ Implicit Hydrogens ============ */
+
+/*
+ * Default hydrogen count of an atom with the given explicit bond order sum
+ * (aromatic bonds count 1): element_max_bonds minus the sum, stepping up
+ * by two for hypervalent N, P, S and halogens. Aromatic atoms reserve one
+ * valence for the pi system.
+ */
+int molecule_default_hydrogens(const Atom* atom, int bond_order_sum);
+/* Set every non-hydrogen atom's count to its default; returns false on OOM */
+bool molecule_assign_hydrogens(Molecule* mol);
+/*
+ * Explicit to implicit: fold each plain hydrogen (no isotope or charge)
+ * singly bonded to a non-hydrogen into its neighbor's count, renumbering
+ * the remaining atoms and bonds. Properties are unchanged.
+ */
+bool molecule_compact_hydrogens(Molecule* mol);
+/* Implicit to explicit: append each atom's hydrogens as bonded atoms */
+bool molecule_expand_hydrogens(Molecule* mol);
+
+/* ============ Coordinates ============ */
+
+/* Allocate zeroed coordinates for every atom; no-op if already present */
+bool molecule_enable_coordinates(Molecule* mol);
+bool molecule_has_coordinates(const Molecule* mol);
+bool molecule_set_atom_position(Molecule* mol, int atom_id, double x, double y, double z);
+/* Distance between two atoms, -1 without coordinates */
+double molecule_distance(const Molecule* mol, int atom1_id, int atom2_id);
+
+/* Adjacency (CSR) */
+bool molecule_build_adjacency(Molecule* mol);
+int molecule_degree(const Molecule* mol, int atom_id);
+/*
+ * Neighbors of an atom in O(1). Sets *neighbors (and *bonds if non-NULL)
+ * to arrays of the returned length. Returns -1 if the adjacency is stale
+ * or the atom ID is invalid.
+ */
+int molecule_neighbors(const Molecule* mol, int atom_id,
+                       const int** neighbors, const int** bonds);
+/* Index of the bond between two atoms in O(degree), or -1 */
+int molecule_find_bond(const Molecule* mol, int atom1_id, int atom2_id);
 
 /* Formula parsing */
 bool formula_parse(const char* formula_str, Formula* result);
 void formula_print(const Formula* formula);
 double formula_mass(const Formula* formula);
+double formula_monoisotopic_mass(const Formula* formula);
 bool formula_to_string(const Formula* formula, char* buffer, size_t buffer_size);
+bool formula_add_element(Formula* formula, const Element* element, int count);
 
-/* Molecule information */
+/* Molecule information (O(1) reads of maintained properties) */
+int molecule_element_count(const Molecule* mol, const Element* element);
+int molecule_charge(const Molecule* mol);
+double molecule_mass(const Molecule* mol);
+const char* molecule_formula(const Molecule* mol);
+/* Element counts as a Formula, in Hill order */
+bool molecule_to_formula(const Molecule* mol, Formula* formula);
 void molecule_print(const Molecule* mol);
 void molecule_print_composition(const Molecule* mol);
 
-/* Create common molecules (convenience functions) */
-Molecule* molecule_create_water(void);
-Molecule* molecule_create_co2(void);
-Molecule* molecule_create_methane(void);
+/*
+ * Create common molecules (convenience functions). Each call returns a new
+ * molecule allocated from pool, or from the heap when pool is NULL; release
+ * it with molecule_destroy. Returns NULL on allocation failure.
+ */
+Molecule* molecule_create_water(MoleculePool* pool);
+Molecule* molecule_create_co2(MoleculePool* pool);
+Molecule* molecule_create_methane(MoleculePool* pool);
 
 /* Utility */
 bool formula_equals(const Formula* f1, const Formula* f2);
+uint64_t formula_fingerprint(const Formula* formula);
+uint64_t formula_fingerprint_parts(const ElementCount* elements, int element_count);
 void formula_simplify(Formula* formula);
 
 #endif /* MOLECULE_H */
@@ -0,0 +1,54 @@
+#ifndef MOLECULE_POOL_H
+#define MOLECULE_POOL_H
+
+#include "molecule.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MOLECULE_POOL_CLASSES 26           /* Power-of-two size classes, 16 B .. 512 MB */
+#define MOLECULE_POOL_DEFAULT_CHUNK (1 << 20)
+
+typedef struct MoleculePoolChunk MoleculePoolChunk;
+
+/*
+ * Arena allocator for molecules.
+ *
+ * Molecule structs and their atom, bond and adjacency arrays are carved
+ * from large chunks. Released blocks go onto per-size-class free lists and
+ * are reused by later molecules; molecule_pool_reset drops every molecule
+ * at once and rewinds the arena. Steady-state building therefore never
+ * reaches the system allocator.
+ *
+ * A pool is not synchronized: give each thread its own pool.
+ */
+struct MoleculePool {
+    MoleculePoolChunk* chunks;      /* Standard-size chunks, current first */
+    MoleculePoolChunk* large;       /* Oversized dedicated blocks */
+    char* cursor;                   /* Bump pointer in the current chunk */
+    size_t remaining;
+    size_t chunk_size;
+    void* free_lists[MOLECULE_POOL_CLASSES];
+
+    size_t live_molecules;
+    size_t system_allocations;      /* Chunk mallocs over the pool's lifetime */
+};
+
+/* chunk_size 0 selects MOLECULE_POOL_DEFAULT_CHUNK */
+void molecule_pool_init(MoleculePool* pool, size_t chunk_size);
+void molecule_pool_destroy(MoleculePool* pool);
+
+/* Release every molecule and block; chunks are kept for reuse */
+void molecule_pool_reset(MoleculePool* pool);
+
+/* Allocate an empty molecule owned by the pool */
+Molecule* molecule_pool_create(MoleculePool* pool, const char* name);
+/* Return a molecule and its arrays to the pool */
+void molecule_pool_release(MoleculePool* pool, Molecule* mol);
+
+/* Raw block allocation used for molecule storage (16-byte aligned) */
+void* molecule_pool_alloc(MoleculePool* pool, size_t bytes);
+void molecule_pool_free(MoleculePool* pool, void* block);
+/* Usable size of a block returned by molecule_pool_alloc */
+size_t molecule_pool_block_size(const void* block);
+
+#endif /* MOLECULE_POOL_H */
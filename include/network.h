@@ -0,0 +1,123 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "reaction.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Forward reaction network expansion.
+ *
+ * Starting from a seed set of species, every pair of species is offered to
+ * the rule engine (reaction_rules_apply: synthesis, combustion, single and
+ * double replacement, neutralization, the classes the database holds), and
+ * the products become new species. Generation g holds the species first
+ * made in round g; round g pairs each species of generation g - 1 with
+ * every species before it, so each pair is tried once. Pairs whose rule
+ * categories have no rule are never formed: species are bucketed by
+ * category and only compatible buckets are walked.
+ *
+ * A round runs in parallel over its frontier. Species are deduplicated by
+ * composition fingerprint (formula_fingerprint) through a sharded set with
+ * a lock per shard, shared by all threads; species first seen in a round
+ * are buffered per thread and given dense ids when the round is merged.
+ * The set of species and reactions does not depend on the thread count,
+ * though ids within a generation may be numbered differently.
+ *
+ * Expansion stops when a round finds nothing new, after max_generations
+ * rounds, once max_species is reached (the round is cut there and
+ * reactions making dropped species are discarded; which species of that
+ * round survive depends on scheduling) or when max_seconds run out (the
+ * round is kept as far as it got).
+ */
+
+#define NETWORK_MAX_ELEMENTS 8      /* Distinct elements per species */
+#define NETWORK_MAX_PRODUCTS 4
+
+/* Compact species record; see network_species_formula */
+typedef struct {
+    uint64_t fingerprint;
+    int generation;
+    unsigned char category;                         /* reaction_rules_category */
+    unsigned char element_count;
+    unsigned char atomic_numbers[NETWORK_MAX_ELEMENTS];
+    unsigned short counts[NETWORK_MAX_ELEMENTS];
+} NetworkSpecies;
+
+typedef struct {
+    int reactants[2];                               /* Species ids */
+    int reactant_coefficients[2];
+    int products[NETWORK_MAX_PRODUCTS];
+    int product_coefficients[NETWORK_MAX_PRODUCTS];
+    int product_count;
+    int generation;
+    ReactionType type;
+} NetworkReaction;
+
+typedef struct {
+    int max_species;            /* <= 0: no limit */
+    int max_generations;        /* Rounds after the seeds */
+    double max_seconds;         /* <= 0: no limit */
+    unsigned int type_mask;     /* REACTION_TYPE_BIT of the rules to apply */
+    int threads;                /* <= 0: one per CPU */
+} NetworkOptions;
+
+typedef enum {
+    NETWORK_STOP_EXHAUSTED,     /* A round found no new species */
+    NETWORK_STOP_GENERATIONS,
+    NETWORK_STOP_SPECIES,
+    NETWORK_STOP_TIME
+} NetworkStop;
+
+typedef struct {
+    int generations;            /* Rounds run */
+    long long pairs;            /* Pairs offered to the rules */
+    NetworkStop stop;
+    double seconds;
+} NetworkStats;
+
+typedef struct {
+    NetworkSpecies* species;
+    int species_count;
+    int species_capacity;
+
+    NetworkReaction* reactions;
+    int reaction_count;
+    int reaction_capacity;
+
+    int* generation_offsets;    /* First species of each generation, plus end */
+    int generation_count;
+
+    int* buckets[REACTION_RULE_CATEGORIES];         /* Species ids by category, ascending */
+    int bucket_counts[REACTION_RULE_CATEGORIES];
+    int bucket_capacities[REACTION_RULE_CATEGORIES];
+
+    void* shards;               /* Sharded fingerprint -> species id set */
+} ReactionNetwork;
+
+void network_options_default(NetworkOptions* options);
+
+void network_init(ReactionNetwork* network);
+void network_free(ReactionNetwork* network);
+
+/*
+ * Replace the network's contents with the expansion of seeds (generation
+ * 0; coefficients ignored, duplicates merged). stats may be NULL. Returns
+ * false on allocation failure or if a seed has more than
+ * NETWORK_MAX_ELEMENTS elements.
+ */
+bool network_expand(ReactionNetwork* network, const Formula* seeds, int seed_count,
+                    const NetworkOptions* options, NetworkStats* stats);
+
+/* Species id of a composition, -1 if absent */
+int network_species_find(const ReactionNetwork* network, const Formula* formula);
+
+/* Expand a species record into a Formula (coefficient 1) */
+bool network_species_formula(const ReactionNetwork* network, int species, Formula* out);
+
+/* Rebuild a network reaction as a Reaction, e.g. for reaction_print */
+bool network_reaction_get(const ReactionNetwork* network, int index, Reaction* out);
+
+const char* network_stop_str(NetworkStop stop);
+
+#endif /* NETWORK_H */
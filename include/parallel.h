@@ -0,0 +1,29 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdbool.h>
+
+/*
+ * Minimal thread pool helpers shared by the batch APIs.
+ * Work is split into chunks of indices handed out dynamically, so uneven
+ * items (large molecules, dense reactions) still balance across threads.
+ */
+
+/* Process indices [begin, end) on the given worker thread */
+typedef void (*ParallelRangeFn)(int begin, int end, int thread_index, void* user_data);
+
+/* Resolve a requested thread count (<= 0 means one per online CPU) */
+int parallel_thread_count(int requested);
+
+/*
+ * Run fn over [0, count) in chunks of chunk_size indices using up to
+ * threads workers; the caller's thread takes part. Every index is always
+ * processed, but false is returned if some workers could not be started.
+ */
+bool parallel_for(int count, int chunk_size, int threads,
+                  ParallelRangeFn fn, void* user_data);
+
+/* Monotonic wall clock in seconds, for benchmarks */
+double parallel_now(void);
+
+#endif /* PARALLEL_H */
@@ -2,6 +2,7 @@
 #define REACTION_H
 
 #include "molecule.h"
+#include "fingerprint.h"
 #include <stdbool.h>
 
 #define MAX_REACTANTS 10
@@ -30,6 +31,17 @@ typedef enum {
     RXTYPE_OTHER
 } ReactionType;
 
+/*
+ * Standard reaction energetics at 298.15 K and 1 bar from the formation
+ * data in thermo.h. Each value is NAN when a species lacks the data it
+ * needs; gibbs needs both.
+ */
+typedef struct {
+    double enthalpy;        /* Delta H, kJ/mol */
+    double entropy;         /* Delta S, J/(mol K) */
+    double gibbs;           /* Delta G = Delta H - T Delta S, kJ/mol */
+} ReactionEnergetics;
+
 /* A chemical reaction */
 typedef struct {
     Formula reactants[MAX_REACTANTS];
@@ -44,6 +56,13 @@ typedef struct {
 
     bool is_balanced;
     bool is_reversible;
+
+    /* Species ids from the database index (-1 when not indexed) */
+    int reactant_species[MAX_REACTANTS];
+    int product_species[MAX_PRODUCTS];
+
+    /* Cached when added to the database (NAN elsewhere until computed) */
+    ReactionEnergetics energetics;
 } Reaction;
 
 /* Initialize a reaction */
@@ -83,12 +102,139 @@ const Reaction* reaction_db_find_by_string(const char* reactants_str);
 /* Get all reactions involving an element */
 int reaction_db_find_by_element(const Element* el, const Reaction** results, int max_results);
 
-/* Get total number of reactions in database */
+/* Get total number of reaction rows in database, removed ones included */
 int reaction_db_count(void);
 
-/* Get reaction by index */
+/* Get reaction by index (NULL if out of range or removed) */
 const Reaction* reaction_db_get(int index);
 
+/*
+ * Recompute the cached energetics of every reaction after thermo data
+ * changes. The new values go into fresh copies of the records, published
+ * as one write, so readers see either all old or all new values. Pointers
+ * obtained earlier keep showing the old values. Nothing changes on
+ * allocation failure.
+ */
+void reaction_db_update_energetics(void);
+
+/* ============ Live Updates ============ */
+/*
+ * The database can change while other threads read it. Reactions are only
+ * appended or removed: an index never moves, and a removed row reads as
+ * NULL from then on. Each write builds a new snapshot of the indices and
+ * publishes it atomically; readers never lock and never wait for a writer.
+ * Writers are serialized among themselves. A write rebuilds only the
+ * postings of the species it touches; the rest of the new snapshot is a
+ * copy of small directories (a live flag per reaction, a pointer per
+ * species and per block of reactions, the species hash).
+ *
+ * Every read call sees one consistent snapshot. To see the same snapshot
+ * across several calls, bracket them with reaction_db_read_begin/end
+ * (sections nest per thread). Postings pointers are valid only inside the
+ * section that returned them. A Reaction pointer stays valid until the
+ * reaction is removed or reaction_db_update_energetics replaces its
+ * record, and every section that could have seen it has ended; species
+ * formulas are never freed.
+ */
+
+void reaction_db_read_begin(void);
+void reaction_db_read_end(void);
+
+/* Number of reactions not removed */
+int reaction_db_live_count(void);
+
+/*
+ * Append a copy of rxn (species ids, balance and energetics are filled in)
+ * and return its index, or -1 on allocation failure.
+ */
+int reaction_db_insert(const Reaction* rxn);
+
+/* Append count reactions in one write; indices (may be NULL) receives theirs */
+bool reaction_db_insert_batch(const Reaction* reactions, int count, int* indices);
+
+/* Remove a reaction; false if the index is out of range or already removed */
+bool reaction_db_remove(int index);
+
+/* Size of the database at one point, to roll back to */
+typedef struct {
+    int count;                  /* Reaction rows */
+    int species_count;
+} ReactionDbMark;
+
+void reaction_db_mark(ReactionDbMark* mark);
+
+/*
+ * Drop every reaction and species added since mark was taken, e.g. to undo
+ * the writes of a benchmark. Reactions removed since then stay removed.
+ * Waits for reads that began before the rollback, so it must not be called
+ * inside a read section; false then, on a stale mark or allocation failure.
+ */
+bool reaction_db_rollback(const ReactionDbMark* mark);
+
+/* ============ Species Index ============ */
+/*
+ * Every distinct composition in the database is assigned a dense species id
+ * (coefficients are ignored). Each species keeps postings lists with the
+ * indices of the reactions that consume and produce it; a reaction appears
+ * at most once in each list. Species stay when their reactions are
+ * removed, with those reactions dropped from their postings.
+ */
+
+/* Number of distinct species in the database */
+int reaction_db_species_count(void);
+
+/* Get species formula by id (coefficient is always 1) */
+const Formula* reaction_db_species_get(int species_id);
+
+/* Find the species id of a formula (returns -1 if not in database) */
+int reaction_db_species_find(const Formula* formula);
+
+/* Reactions consuming/producing a species; returns the postings length */
+int reaction_db_species_consumers(int species_id, const int** reactions);
+int reaction_db_species_producers(int species_id, const int** reactions);
+
+/* ============ Reaction Fingerprints ============ */
+/*
+ * A reaction fingerprint is the products-minus-reactants difference of
+ * species feature vectors, each species weighted by its coefficient, so
+ * reactions performing the same transformation on different substrates
+ * land close together. Element counts alone cancel in any balanced
+ * reaction, so a species contributes hashed features of its composition
+ * instead: the whole composition, each element with its count, and each
+ * pair of elements it contains. Features are folded into REACTION_FP_DIMS
+ * floats; unchanged groups cancel and only what the reaction rearranges
+ * remains.
+ *
+ * Similarity is the continuous Tanimoto a.b / (a.a + b.b - a.b), 1 for
+ * identical fingerprints and negative for opposite transformations. The
+ * database keeps its fingerprints in 64-byte aligned blocks of rows in
+ * database order, next to a squared length and the type of each reaction.
+ */
+
+#define REACTION_FP_DIMS 128
+#define REACTION_FP_ALIGNMENT 64
+
+#define REACTION_TYPE_BIT(t) (1u << (t))
+#define REACTION_TYPE_ALL (REACTION_TYPE_BIT(RXTYPE_OTHER + 1) - 1)
+
+/* Fingerprint of any reaction into REACTION_FP_DIMS floats */
+void reaction_fingerprint(const Reaction* rxn, float* vector);
+
+double reaction_fingerprint_similarity(const float* a, const float* b);
+
+/* Stored fingerprint of a database reaction (NULL if out of range or removed) */
+const float* reaction_db_fingerprint(int index);
+
+/*
+ * The k database reactions most similar to query whose type is in
+ * type_mask (REACTION_TYPE_BIT of each wanted type, or REACTION_TYPE_ALL),
+ * in descending similarity (ties by ascending index). Reactions whose
+ * length bound sqrt(a.a b.b) / (a.a + b.b - sqrt(a.a b.b)) cannot beat the
+ * current k-th hit are skipped without reading their row. Returns the
+ * number of hits written or -1.
+ */
+int reaction_db_similar(const Reaction* query, unsigned int type_mask, int k, SimilarityHit* hits);
+
 /* ============ Equation Balancing ============ */
 
 /* Attempt to balance a reaction equation */
@@ -100,4 +246,26 @@ bool reaction_balance(Reaction* rxn);
 bool reaction_predict(const Formula* reactants, int reactant_count,
                      Formula* products, int* product_count);
 
+/* Predict a complete balanced reaction (database first, then rules) */
+bool reaction_predict_reaction(const Formula* reactants, int reactant_count,
+                               Reaction* result);
+
+/*
+ * Apply the rule engine only: combustion, binary synthesis, single and
+ * double replacement, and neutralization. Rules are chosen by the pair of
+ * reactant categories and the result is balanced.
+ */
+bool reaction_rules_apply(const Formula* reactants, int reactant_count, Reaction* result);
+
+/*
+ * Reactant category the rules dispatch on (0 .. REACTION_RULE_CATEGORIES-1:
+ * metal, nonmetal, oxygen, hydrocarbon, acid, base, salt, other), and
+ * whether any rule covers a pair of categories. Callers pairing many
+ * species classify each once and skip pairs that cannot react.
+ */
+#define REACTION_RULE_CATEGORIES 8
+
+int reaction_rules_category(const Formula* reactant);
+bool reaction_rules_pair(int category_a, int category_b);
+
 #endif /* REACTION_H */
@@ -0,0 +1,108 @@
+#ifndef RING_H
+#define RING_H
+
+#include "molecule.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Ring perception: smallest set of smallest rings (SSSR).
+ *
+ * The bond graph is first split into biconnected components by an
+ * iterative Tarjan pass. Bridges, chains and terminal hydrogens fall out
+ * as single-bond components and are skipped; every other component is a
+ * ring system of V atoms and E bonds that holds E - V + 1 rings.
+ *
+ * Within a ring system, candidate rings are Vismara prototypes: from each
+ * atom r, a breadth-first search over atoms ordered before r closes odd
+ * cycles across an edge and even cycles at an atom whose two shortest
+ * paths back to r meet only at r. Candidates are taken shortest first and
+ * kept when independent of the rings already chosen (Gaussian elimination
+ * over GF(2) on bond bitsets), which yields a minimum cycle basis.
+ *
+ * The searches are depth-limited, first to rings of up to 7 atoms, and
+ * deepened only while rings are still missing, so the cost of a system of
+ * small fused rings grows about linearly with its size even for
+ * polycyclics of thousands of atoms.
+ *
+ * Results are cached on the molecule until its atoms or bonds change.
+ * Rings are grouped by ring system, smallest first within each.
+ */
+
+/*
+ * Reusable scratch space. Arrays grow to the largest molecule seen, so a
+ * context reused across a library does no allocation once warmed up.
+ * Use one context per thread.
+ */
+typedef struct {
+    int capacity;               /* Atoms */
+    int edge_capacity;          /* Bonds */
+    int* disc;                  /* DFS discovery time, 0 = unvisited */
+    int* low;
+    int* frames;                /* DFS stack: atom, next adjacency entry, tree bond */
+    int* edge_stack;
+    int* components;            /* Bonds of each ring system */
+    int* component_offsets;
+
+    int* local;                 /* Atom -> index in the current system, -1 if none */
+    int* atoms;                 /* System index -> atom */
+    int* offsets;               /* System CSR adjacency */
+    int* neighbors;
+    int* edges;                 /* System edge per adjacency entry */
+    int* bonds;                 /* System edge -> bond */
+    int* dist;                  /* Breadth-first search from the current root */
+    int* parent;
+    int* parent_edge;
+    int* queue;
+    int* pivots;                /* Edge -> basis row whose lowest bit it is, -1 if none */
+    uint64_t* row;              /* Candidate being reduced, all zero between uses */
+
+    int basis_capacity;         /* Words */
+    int basis_used;
+    uint64_t* basis;            /* Non-zero word span of each basis row */
+    int* row_spans;             /* Per row: offset into basis, first word, word count */
+
+    int candidate_count;
+    int candidate_capacity;
+    int* candidate_offsets;     /* Into path_atoms / path_edges */
+    long long* sorted;          /* Length << 32 | candidate */
+    int path_capacity;
+    int* path_atoms;            /* System atoms of each candidate, in cycle order */
+    int* path_edges;            /* Edge i joins path atoms i and i + 1 */
+
+    int ring_count;
+    int ring_capacity;
+    int ring_atom_capacity;
+    int* ring_offsets;
+    int* ring_atoms;
+    int* ring_bonds;
+} RingContext;
+
+void ring_context_init(RingContext* ctx);
+void ring_context_free(RingContext* ctx);
+
+/*
+ * Perceive the SSSR and cache it on the molecule (building the adjacency
+ * if needed). Does nothing if the cache is current. Returns false on
+ * allocation failure.
+ */
+bool ring_perceive(RingContext* ctx, Molecule* mol);
+
+/*
+ * Perceive the SSSR of a molecule with its adjacency built into the
+ * context only (ring_count, ring_offsets, ring_atoms, ring_bonds), for
+ * callers that may not modify the molecule. Valid until the next call.
+ */
+bool ring_find(RingContext* ctx, const Molecule* mol);
+
+/* ring_perceive with a temporary context */
+bool molecule_perceive_rings(Molecule* mol);
+
+/* Cached queries; -1 until the rings have been perceived */
+int molecule_ring_count(const Molecule* mol);
+/* Size of a ring; sets *atoms and *bonds (either may be NULL) to its members */
+int molecule_ring(const Molecule* mol, int ring, const int** atoms, const int** bonds);
+/* SSSR rings through an atom, 0 if acyclic */
+int molecule_atom_ring_count(const Molecule* mol, int atom_id);
+
+#endif /* RING_H */
@@ -0,0 +1,83 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include "reaction.h"
+#include <stdbool.h>
+
+#define ROUTE_MAX_STEPS 16
+#define ROUTE_CONDITION_COUNT (COND_ELECTROLYSIS + 1)
+
+/*
+ * Species/reaction bipartite graph over the reaction database, stored in
+ * CSR form. Species node s has edges to the reactions consuming it; reaction
+ * node r has edges to its products. The reverse adjacency (producers and
+ * reactants) is kept as well for backward search.
+ */
+typedef struct {
+    int species_count;
+    int reaction_count;
+
+    int* consumer_offsets;      /* species -> reactions using it (size S+1) */
+    int* consumers;
+    int* product_offsets;       /* reaction -> product species (size R+1) */
+    int* products;
+
+    int* producer_offsets;      /* species -> reactions making it (size S+1) */
+    int* producers;
+    int* reactant_offsets;      /* reaction -> reactant species (size R+1) */
+    int* reactants;
+} RouteGraph;
+
+/*
+ * A synthesis route: reactions in the order they are run. Every reactant of
+ * reactions[i] is a start species or a product of an earlier step, so the
+ * steps that make co-reactants are part of the route (and counted in steps
+ * and cost). species[i] is the product reactions[i] is run for; the last
+ * one is the target.
+ */
+typedef struct {
+    int steps;                              /* Number of reactions */
+    int reactions[ROUTE_MAX_STEPS];         /* Database reaction indices */
+    int species[ROUTE_MAX_STEPS + 1];       /* Species each step is run for */
+    double cost;
+} Route;
+
+/* Cost of using a reaction in a route (must be >= 0) */
+typedef double (*RouteCostFn)(const Reaction* rxn, void* user_data);
+
+typedef struct {
+    int max_steps;              /* Longest route to consider (<= ROUTE_MAX_STEPS) */
+    RouteCostFn cost;           /* NULL: route_cost_by_condition */
+    void* user_data;            /* Passed to cost */
+    bool use_heuristic;         /* A* with a reverse-distance bound, else Dijkstra */
+} RouteOptions;
+
+/* Build/free the CSR graph from a snapshot of the current reaction database */
+bool route_graph_build(RouteGraph* graph);
+void route_graph_free(RouteGraph* graph);
+
+/* Fill options with defaults (max steps, condition cost, A*) */
+void route_options_default(RouteOptions* options);
+
+/*
+ * One step per reaction plus a penalty for its condition. user_data may
+ * point to ROUTE_CONDITION_COUNT doubles indexed by ReactionCondition;
+ * NULL uses built-in penalties (e.g. +2 for COND_HIGH_PRESSURE).
+ */
+double route_cost_by_condition(const Reaction* rxn, void* user_data);
+
+/* Fewest-step route, co-reactant steps included (false if none within max_steps) */
+bool route_find_shortest(const RouteGraph* graph,
+                         const Formula* start, int start_count,
+                         const Formula* target, int max_steps, Route* route);
+
+/* Up to k cheapest loopless routes in increasing cost (returns number found) */
+int route_find_best(const RouteGraph* graph,
+                    const Formula* start, int start_count,
+                    const Formula* target, const RouteOptions* options,
+                    Route* routes, int k);
+
+/* Print a route, one reaction per line */
+void route_print(const Route* route);
+
+#endif /* ROUTE_H */
@@ -0,0 +1,82 @@
+#ifndef SMILES_H
+#define SMILES_H
+
+#include "molecule.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * SMILES reader.
+ *
+ * Supports the organic subset (B C N O P S F Cl Br I and aromatic
+ * b c n o p s), bracket atoms with isotope, chirality (ignored), hydrogen
+ * count, charge and atom class, branches, ring closures (digits and %nn),
+ * the bond symbols - = # $ : / \ and '.' for disconnected parts.
+ * Organic-subset atoms get implicit hydrogens from element_max_bonds,
+ * stepping up by two for hypervalent N, P, S and halogens. Hydrogens are
+ * added as explicit atoms, or kept as per-atom counts (Atom.hydrogens)
+ * when implicit_hydrogens is set. Text after the first whitespace is taken as
+ * the molecule name. Parsed molecules have their adjacency built.
+ */
+
+#define SMILES_MAX_RING_BONDS 100
+
+/*
+ * Reusable parse state. Scratch arrays grow to the largest molecule seen
+ * and are then reused, so parsing into a pooled molecule does no
+ * allocation once warmed up. Use one parser per thread.
+ */
+typedef struct {
+    int* bond_sums;             /* Per-atom explicit bond order sum (aromatic = 1) */
+    int* hydrogens;             /* Bracket hydrogen count, -1 for organic subset */
+    int capacity;
+    bool implicit_hydrogens;    /* Keep hydrogens as atom counts (default false) */
+
+    int error_position;         /* Offset of the first bad character, -1 if none */
+    const char* error;          /* Static description of the last error */
+} SmilesParser;
+
+void smiles_parser_init(SmilesParser* parser);
+void smiles_parser_free(SmilesParser* parser);
+
+/*
+ * Parse length bytes of text into mol, which must be initialized and is
+ * cleared first. Returns false and sets parser->error on invalid input.
+ */
+bool smiles_parser_parse(SmilesParser* parser, const char* text, size_t length, Molecule* mol);
+
+/* One-shot convenience wrapper around a temporary parser */
+bool smiles_parse(const char* smiles, Molecule* mol);
+
+/* ============ Bulk Parsing ============ */
+
+/*
+ * Called for each successfully parsed line, concurrently from worker
+ * threads; thread_index identifies the worker so callers can keep
+ * per-thread state. The molecule is released after the call returns.
+ */
+typedef void (*SmilesMoleculeFn)(const Molecule* mol, int line, int thread_index,
+                                 void* user_data);
+
+typedef struct {
+    int lines;                  /* Non-empty lines */
+    int parsed;
+    int failed;
+    long long atoms;            /* Stored atoms, excluding implicit hydrogens */
+    long long bytes;
+    double seconds;
+} SmilesBatchStats;
+
+/*
+ * Parse newline-separated SMILES in parallel. Each worker uses its own
+ * parser and molecule pool, producing implicit-hydrogen molecules when
+ * implicit_hydrogens is set. fn may be NULL to only validate and count.
+ */
+bool smiles_parse_buffer(const char* text, size_t length, int threads, bool implicit_hydrogens,
+                         SmilesMoleculeFn fn, void* user_data, SmilesBatchStats* stats);
+
+/* Read a file (one SMILES per line) and parse it with smiles_parse_buffer */
+bool smiles_parse_file(const char* path, int threads, bool implicit_hydrogens,
+                       SmilesMoleculeFn fn, void* user_data, SmilesBatchStats* stats);
+
+#endif /* SMILES_H */
@@ -0,0 +1,103 @@
+#ifndef STOCHASTIC_H
+#define STOCHASTIC_H
+
+#include "kinetics.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Stochastic simulation of a kinetics model at the level of molecule counts.
+ *
+ * Reaction j fires with propensity a_j = k_j prod_i C(n_i, a_ij), where
+ * n_i is the count of reactant i, a_ij its coefficient and C the binomial
+ * coefficient, so k_j is the stochastic rate constant (per combination of
+ * reactant molecules, per unit time).
+ *
+ * Trajectories follow the Gibson-Bruck next reaction method: every reaction
+ * holds a putative firing time in an indexed binary heap, and the reaction
+ * on top fires. A dependency graph built once per system lists, for each
+ * reaction, the reactions whose propensity depends on a species it
+ * changes; only those are recomputed after it fires and their firing times
+ * are rescaled rather than redrawn, so one event costs one random number
+ * and O(d log m) heap work for d dependents.
+ */
+
+typedef struct {
+    const KineticsModel* model;     /* Borrowed; must outlive the system */
+    int species_count;
+    int reaction_count;
+    int64_t* deltas;                /* Net count change per stoich entry */
+    int* dependency_offsets;        /* Reactions to update after each reaction */
+    int* dependencies;
+} StochasticSystem;
+
+/*
+ * Build the dependency graph for a model. The model must not change while
+ * the system is in use. Returns false on allocation failure.
+ */
+bool stochastic_system_init(StochasticSystem* system, const KineticsModel* model);
+void stochastic_system_free(StochasticSystem* system);
+
+/* One trajectory; reusable across systems and resets */
+typedef struct {
+    int64_t* counts;
+    double* propensities;
+    double* firing_times;           /* Absolute; INFINITY when a_j = 0 */
+    int* heap;                      /* Reactions ordered by firing time */
+    int* heap_index;                /* Reaction -> heap slot */
+    int species_capacity;
+    int reaction_capacity;
+    uint64_t rng;
+    double time;
+    long long events;
+} StochasticState;
+
+void stochastic_state_init(StochasticState* state);
+void stochastic_state_free(StochasticState* state);
+
+/*
+ * Start a trajectory at t = 0 from the given counts, with its own random
+ * stream derived from seed. Returns false on allocation failure or a
+ * negative count.
+ */
+bool stochastic_state_reset(StochasticState* state, const StochasticSystem* system,
+                            const int64_t* counts, uint64_t seed);
+
+/*
+ * Fire reactions until the next one would fall after t_end (time is then
+ * t_end) or max_events (<= 0: no limit) have fired in this call. Returns
+ * the number of events fired.
+ */
+long long stochastic_advance(StochasticState* state, const StochasticSystem* system,
+                             double t_end, long long max_events);
+
+typedef struct {
+    double t_end;
+    int sample_count;               /* Samples at t_end * s / sample_count, s = 1.. */
+    long long max_events;           /* Per trajectory; <= 0: no limit */
+    uint64_t seed;
+    int threads;                    /* <= 0: one per CPU */
+} StochasticOptions;
+
+typedef struct {
+    long long events;
+    int truncated;                  /* Trajectories stopped by max_events */
+    double seconds;
+} StochasticStats;
+
+void stochastic_options_default(StochasticOptions* options);
+
+/*
+ * Run independent trajectories in parallel from the same initial counts.
+ * Trajectory i draws from a stream seeded by (seed, i), so results do not
+ * depend on the thread count. samples, when not NULL, receives
+ * trajectories * sample_count * species_count counts laid out by
+ * trajectory, then sample, then species; a trajectory cut by max_events
+ * repeats its last state in the remaining samples. stats may be NULL.
+ * Returns false on invalid input or allocation failure.
+ */
+bool stochastic_run_ensemble(const StochasticSystem* system, const int64_t* initial_counts,
+                             int trajectories, const StochasticOptions* options,
+                             int64_t* samples, StochasticStats* stats);
+
+#endif /* STOCHASTIC_H */
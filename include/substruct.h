@@ -0,0 +1,85 @@
+#ifndef SUBSTRUCT_H
+#define SUBSTRUCT_H
+
+#include "molecule.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Substructure search.
+ *
+ * Molecules are reduced to heavy-atom graphs (terminal hydrogens are
+ * dropped, as in canonicalization; implicit-hydrogen molecules are already
+ * in this form and index fastest) and matched VF2-style: query atoms are
+ * taken in a connectivity-first order, each candidate comes from the
+ * neighbors of its already-mapped parent, and a pair is feasible when the
+ * element, charge and every bond to already-mapped atoms agree.
+ *
+ * A 1024-bit screening fingerprint of atoms, bonds and 2- and 3-bond paths
+ * is kept per library molecule. Every feature of a substructure is also a
+ * feature of the molecule containing it, so any molecule missing a query
+ * bit is rejected without graph matching.
+ */
+
+#define SUBSTRUCT_FP_WORDS 16
+
+typedef struct {
+    uint64_t bits[SUBSTRUCT_FP_WORDS];
+} SubstructFingerprint;
+
+/* Heavy-atom graphs of many molecules in shared CSR arrays */
+typedef struct {
+    int molecule_count;
+    int molecule_capacity;
+    int* atom_offsets;              /* Per molecule, molecule_count + 1 */
+    SubstructFingerprint* fingerprints;
+
+    int atom_count;
+    int atom_capacity;
+    uint32_t* atom_labels;          /* Atomic number << 8 | (charge + 128) */
+    int* edge_offsets;              /* Per atom into the edge arrays, atom_count + 1 */
+
+    int edge_count;
+    int edge_capacity;
+    int* edge_targets;              /* Neighbor index local to the molecule */
+    unsigned char* edge_types;      /* BondType */
+} SubstructLibrary;
+
+/* A compiled query */
+typedef struct {
+    SubstructLibrary graph;         /* The query as a one-molecule library */
+    int* order;                     /* Match order of query atoms */
+    int* parent;                    /* Earlier-matched neighbor per order slot, -1 if none */
+    int* parent_bond;               /* Bond type to that parent */
+} SubstructQuery;
+
+typedef struct {
+    int molecules;
+    int screened;                   /* Passed the fingerprint screen */
+    int matched;
+    double seconds;
+} SubstructSearchStats;
+
+void substruct_library_init(SubstructLibrary* lib);
+void substruct_library_free(SubstructLibrary* lib);
+/* Append a molecule (adjacency must be built); returns its index or -1 */
+int substruct_library_add(SubstructLibrary* lib, const Molecule* mol);
+
+bool substruct_query_compile(SubstructQuery* query, const Molecule* mol);
+void substruct_query_free(SubstructQuery* query);
+
+/* Screen and match one library entry */
+bool substruct_library_match(const SubstructLibrary* lib, int index, const SubstructQuery* query);
+
+/* Convenience: does mol contain the query? */
+bool substruct_match_molecule(const Molecule* mol, const SubstructQuery* query);
+
+/*
+ * Find all library molecules containing the query, across threads.
+ * Writes up to max_hits indices in ascending order and returns the total
+ * number of hits (-1 on allocation failure).
+ */
+int substruct_search(const SubstructLibrary* lib, const SubstructQuery* query,
+                     int threads, int* hits, int max_hits, SubstructSearchStats* stats);
+
+#endif /* SUBSTRUCT_H */
@@ -0,0 +1,103 @@
+#ifndef THERMO_H
+#define THERMO_H
+
+#include "reaction.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Thermochemistry.
+ *
+ * Species carry a standard enthalpy of formation (kJ/mol) and a standard
+ * molar entropy (absolute S, J/(mol K)) at 298.15 K and 1 bar, keyed by
+ * composition like the database's species index, so isomers share one
+ * entry. The built-in table holds common species in their stable phase at
+ * standard conditions (water is liquid, salts solid, no aqueous ions);
+ * entries can be added or overridden at run time. Either value may be NAN
+ * when unknown.
+ *
+ * Missing formation enthalpies can be inferred from reactions with
+ * measured enthalpies by Hess's law: each reaction gives one linear
+ * equation sum_i nu_i dHf_i = dH over its unknown species (net coefficient
+ * nu_i, products positive), with known species moved to the right-hand
+ * side. The sparse system is solved in the least-squares sense by CGLS
+ * (conjugate gradients on the normal equations), so redundant
+ * measurements are averaged; species the equations do not pin down get
+ * the minimum-norm solution.
+ */
+
+#define THERMO_STANDARD_TEMPERATURE 298.15
+
+typedef struct {
+    double enthalpy;        /* Delta Hf, kJ/mol */
+    double entropy;         /* S, J/(mol K) */
+} ThermoData;
+
+/* Data for a composition; false if the species has no entry */
+bool thermo_species_get(const Formula* formula, ThermoData* out);
+
+/* Add or replace a species entry. Returns false on allocation failure. */
+bool thermo_species_set(const Formula* formula, double enthalpy, double entropy);
+
+/* Number of species with an entry */
+int thermo_species_count(void);
+
+/*
+ * Drop the entries added since the table held count of them, e.g. to undo
+ * a benchmark (entries replaced since keep their new data). Returns false
+ * if count is out of range.
+ */
+bool thermo_species_truncate(int count);
+
+/*
+ * Energetics of a reaction from the species data (coefficients applied).
+ * Returns true if the enthalpy is known.
+ */
+bool thermo_reaction(const Reaction* rxn, ReactionEnergetics* out);
+
+/* Delta G at another temperature, assuming Delta H and Delta S do not vary */
+double thermo_gibbs_at(const ReactionEnergetics* energetics, double temperature);
+
+/*
+ * Order reactions by their cached Delta G, most favorable first, keeping
+ * those with Delta G <= max_gibbs (reactions with unknown Delta G are
+ * dropped). Writes indices into order and returns how many, or -1 on
+ * allocation failure.
+ */
+int thermo_rank(const Reaction* const* reactions, int count, double max_gibbs, int* order);
+
+/* ============ Hess's Law Fit ============ */
+
+typedef struct {
+    Formula* species;           /* Unknown species, first-seen order */
+    uint64_t* fingerprints;
+    double* enthalpies;         /* Fitted Delta Hf per species */
+    int count;
+    int capacity;
+    int* slots;                 /* Open-addressing species hash (-1 empty) */
+    int slot_count;
+
+    int equations;              /* Reactions used */
+    int iterations;
+    double rms_residual;        /* kJ/mol over the equations */
+} HessFit;
+
+void thermo_fit_init(HessFit* fit);
+void thermo_fit_free(HessFit* fit);
+
+/*
+ * Infer the formation enthalpies of every species in the reactions that
+ * has no known enthalpy, from the measured reaction enthalpies (kJ/mol;
+ * NAN entries are skipped). Reactions with no unknown species add no
+ * equation. Returns false on invalid input or allocation failure.
+ */
+bool thermo_fit_enthalpies(HessFit* fit, const Reaction* const* reactions,
+                           const double* reaction_enthalpies, int count);
+
+/*
+ * Store the fitted enthalpies as species data, keeping any known entropy.
+ * Call reaction_db_update_energetics afterwards to refresh the database.
+ */
+bool thermo_fit_store(const HessFit* fit);
+
+#endif /* THERMO_H */
@@ -0,0 +1,86 @@
+#ifndef VALIDATE_H
+#define VALIDATE_H
+
+#include "molecule.h"
+#include <stdbool.h>
+
+/*
+ * Valence and formal-charge validation.
+ *
+ * Bond-order sums are gathered per atom in one pass over the bond list,
+ * counting implicit hydrogens as single bonds.
+ * An atom with e = valence_electrons - charge available electrons may form
+ * e bonds when e <= 4 and 8 - e otherwise, plus 8 - e + 2, + 4, ... up to e
+ * for elements from period 3 on (P 3/5, S 2/4/6, Cl 1/3/5/7). Aromatic
+ * bonds count 1, and an aromatic atom is valid when either Kekule
+ * assignment (with or without one extra pi bond) fits. Transition metals,
+ * lanthanides and actinides are not checked.
+ *
+ * The formal charge of an atom is the charge of smallest magnitude whose
+ * valence states admit its bonds; a declared charge that disagrees with it
+ * is reported, as is a charge outside common_charges on a lone ion.
+ */
+
+typedef enum {
+    VALIDATION_BAD_BOND,            /* Bond to a missing atom or to itself */
+    VALIDATION_VALENCE_EXCEEDED,    /* More bonds than any charge state allows */
+    VALIDATION_VALENCE_UNSATISFIED, /* Fewer bonds than the charge state needs */
+    VALIDATION_CHARGE_MISMATCH,     /* Bonds imply a different formal charge */
+    VALIDATION_UNCOMMON_CHARGE,     /* Lone ion with a charge not in common_charges */
+    VALIDATION_KIND_COUNT
+} ValidationKind;
+
+typedef struct {
+    ValidationKind kind;
+    int atom;                       /* Atom ID, or bond index for VALIDATION_BAD_BOND */
+    int bond_order_sum;             /* Aromatic bonds count 1 */
+    int declared_charge;
+    int formal_charge;              /* Implied by the bonds, = declared if none fits */
+} ValidationIssue;
+
+/* Reusable per-atom scratch; use one validator per thread */
+typedef struct {
+    int* order_sums;                /* Non-aromatic bond orders */
+    int* aromatic_bonds;
+    int* formal_charges;            /* Filled by validator_check */
+    int capacity;
+} Validator;
+
+void validator_init(Validator* v);
+void validator_free(Validator* v);
+
+/*
+ * Check a molecule. Writes up to max_issues issues and returns the total
+ * number found (0 = valid), or -1 on allocation failure. Afterwards
+ * v->formal_charges holds the formal charge of each atom.
+ */
+int validator_check(Validator* v, const Molecule* mol, ValidationIssue* issues, int max_issues);
+
+/*
+ * Bond-order sums allowed for an element at a charge, ascending. Returns
+ * the number written (at most max), 0 if no state exists, or -1 if the
+ * element is not checked.
+ */
+int validate_valence_states(const Element* element, int charge, int* valences, int max);
+
+const char* validation_kind_str(ValidationKind kind);
+
+/* ============ Batch Validation ============ */
+
+typedef struct {
+    int molecules;
+    int valid;
+    int invalid;
+    long long issues[VALIDATION_KIND_COUNT];
+    double seconds;
+} ValidationStats;
+
+/*
+ * Validate a library across threads. issue_counts (may be NULL) receives
+ * the number of issues per molecule; a molecule is rejected when it is
+ * non-zero. Returns false on allocation failure.
+ */
+bool validate_molecules(const Molecule* const* molecules, int count, int threads,
+                        int* issue_counts, ValidationStats* stats);
+
+#endif /* VALIDATE_H */
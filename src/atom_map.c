@@ -0,0 +1,542 @@
+#include "atom_map.h"
+#include "smiles.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define ELEMENT_SLOTS 119
+#define DEGREE_BINS 8               /* Higher degrees share the last bin */
+#define EDIT_COST 16                /* One bond edit outweighs any atom changes */
+#define CLOCK_INTERVAL 255          /* Nodes between deadline checks */
+#define MAP_UNASSIGNED (-2)
+#define MAP_SKIPPED (-1)
+
+/* ============ Mapper ============ */
+
+void atom_mapper_init(AtomMapper* mapper) {
+    if (!mapper) return;
+    memset(mapper, 0, sizeof(*mapper));
+}
+
+void atom_mapper_free(AtomMapper* mapper) {
+    if (!mapper) return;
+    for (int s = 0; s < 2; s++) {
+        free(mapper->atoms[s]);
+        free(mapper->compact[s]);
+        free(mapper->hydrogens[s]);
+        free(mapper->classes[s]);
+        free(mapper->offsets[s]);
+        free(mapper->neighbors[s]);
+        free(mapper->bond_types[s]);
+        free(mapper->class_sizes[s]);
+        free(mapper->histograms[s]);
+    }
+    free(mapper->members);
+    free(mapper->member_offsets);
+    free(mapper->order);
+    free(mapper->map);
+    free(mapper->inverse);
+    free(mapper->best);
+    free(mapper->candidates);
+    free(mapper->candidate_costs);
+    atom_mapper_init(mapper);
+}
+
+static bool grow(void** array, size_t count, size_t item) {
+    void* resized = realloc(*array, (count > 0 ? count : 1) * item);
+    if (!resized) return false;
+    *array = resized;
+    return true;
+}
+
+static bool mapper_reserve(AtomMapper* m, int atoms, int bonds) {
+    if (atoms > m->capacity || !m->order) {
+        int cap = m->capacity < 64 ? 64 : m->capacity;
+        while (cap < atoms) cap *= 2;
+        for (int s = 0; s < 2; s++) {
+            if (!grow((void**)&m->atoms[s], cap, sizeof(int)) ||
+                !grow((void**)&m->compact[s], cap, sizeof(int)) ||
+                !grow((void**)&m->hydrogens[s], cap, sizeof(int)) ||
+                !grow((void**)&m->classes[s], cap, sizeof(int)) ||
+                !grow((void**)&m->offsets[s], cap + 1, sizeof(int)) ||
+                !grow((void**)&m->class_sizes[s], ELEMENT_SLOTS, sizeof(int)) ||
+                !grow((void**)&m->histograms[s], ELEMENT_SLOTS * DEGREE_BINS, sizeof(int))) {
+                return false;
+            }
+        }
+        if (!grow((void**)&m->members, cap, sizeof(int)) ||
+            !grow((void**)&m->member_offsets, ELEMENT_SLOTS + 1, sizeof(int)) ||
+            !grow((void**)&m->order, cap, sizeof(int)) ||
+            !grow((void**)&m->map, cap, sizeof(int)) ||
+            !grow((void**)&m->inverse, cap, sizeof(int)) ||
+            !grow((void**)&m->best, cap, sizeof(int))) {
+            return false;
+        }
+        m->capacity = cap;
+    }
+    if (2 * bonds > m->edge_capacity || !m->neighbors[0]) {
+        int cap = m->edge_capacity < 128 ? 128 : m->edge_capacity;
+        while (cap < 2 * bonds) cap *= 2;
+        for (int s = 0; s < 2; s++) {
+            if (!grow((void**)&m->neighbors[s], cap, sizeof(int)) ||
+                !grow((void**)&m->bond_types[s], cap, 1)) {
+                return false;
+            }
+        }
+        m->edge_capacity = cap;
+    }
+    return true;
+}
+
+/* ============ Graphs ============ */
+
+static bool foldable_hydrogen(const Molecule* mol, int atom, const int* degree) {
+    const Atom* a = &mol->atoms[atom];
+    return a->element->atomic_number == 1 && a->isotope == 0 && a->charge == 0 &&
+           degree[atom] == 1;
+}
+
+/* Heavy-atom graph of one side, hydrogens folded into counts */
+static void build_side(AtomMapper* m, int s, const Molecule* mol, int* class_of) {
+    int n = mol->atom_count;
+    int* compact = m->compact[s];
+
+    /* compact[] holds degrees until hydrogens are folded */
+    memset(compact, 0, (size_t)n * sizeof(int));
+    for (int b = 0; b < mol->bond_count; b++) {
+        compact[mol->bonds[b].atom1_id]++;
+        compact[mol->bonds[b].atom2_id]++;
+    }
+    int* folded_into = m->order;        /* Scratch: heavy partner of a folded hydrogen */
+    for (int i = 0; i < n; i++) folded_into[i] = -1;
+    for (int b = 0; b < mol->bond_count; b++) {
+        int a1 = mol->bonds[b].atom1_id, a2 = mol->bonds[b].atom2_id;
+        if (foldable_hydrogen(mol, a1, compact) && mol->atoms[a2].element->atomic_number != 1) {
+            folded_into[a1] = a2;
+        } else if (foldable_hydrogen(mol, a2, compact) &&
+                   mol->atoms[a1].element->atomic_number != 1) {
+            folded_into[a2] = a1;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (folded_into[i] >= 0) {
+            compact[i] = -1;
+            continue;
+        }
+        compact[i] = kept;
+        m->atoms[s][kept] = i;
+        m->hydrogens[s][kept] = mol->atoms[i].hydrogens;
+        int z = mol->atoms[i].element->atomic_number;
+        if (class_of[z] < 0) class_of[z] = m->class_count++;
+        m->classes[s][kept] = class_of[z];
+        kept++;
+    }
+    for (int i = 0; i < n; i++) {
+        if (folded_into[i] >= 0) m->hydrogens[s][compact[folded_into[i]]]++;
+    }
+    m->count[s] = kept;
+
+    int* offsets = m->offsets[s];
+    memset(offsets, 0, (size_t)(kept + 1) * sizeof(int));
+    for (int b = 0; b < mol->bond_count; b++) {
+        int a1 = compact[mol->bonds[b].atom1_id], a2 = compact[mol->bonds[b].atom2_id];
+        if (a1 < 0 || a2 < 0) continue;
+        offsets[a1 + 1]++;
+        offsets[a2 + 1]++;
+    }
+    for (int i = 0; i < kept; i++) offsets[i + 1] += offsets[i];
+    for (int b = 0; b < mol->bond_count; b++) {
+        int a1 = compact[mol->bonds[b].atom1_id], a2 = compact[mol->bonds[b].atom2_id];
+        if (a1 < 0 || a2 < 0) continue;
+        unsigned char type = (unsigned char)(mol->bonds[b].type + 1);
+        int k1 = offsets[a1]++, k2 = offsets[a2]++;
+        m->neighbors[s][k1] = a2;
+        m->bond_types[s][k1] = type;
+        m->neighbors[s][k2] = a1;
+        m->bond_types[s][k2] = type;
+    }
+    for (int i = kept; i > 0; i--) offsets[i] = offsets[i - 1];
+    offsets[0] = 0;
+}
+
+static int degree(const AtomMapper* m, int s, int a) {
+    return m->offsets[s][a + 1] - m->offsets[s][a];
+}
+
+static int degree_bin(const AtomMapper* m, int s, int a) {
+    int d = degree(m, s, a);
+    return d < DEGREE_BINS ? d : DEGREE_BINS - 1;
+}
+
+/* Bond type code between two kept atoms, 0 if none */
+static int bond_between(const AtomMapper* m, int s, int a, int b) {
+    for (int k = m->offsets[s][a]; k < m->offsets[s][a + 1]; k++) {
+        if (m->neighbors[s][k] == b) return m->bond_types[s][k];
+    }
+    return 0;
+}
+
+static bool same_atom_state(const AtomMapper* m, const Molecule* const* sides, int a, int p) {
+    const Atom* x = &sides[0]->atoms[m->atoms[0][a]];
+    const Atom* y = &sides[1]->atoms[m->atoms[1][p]];
+    return m->hydrogens[0][a] == m->hydrogens[1][p] && x->charge == y->charge &&
+           x->aromatic == y->aromatic;
+}
+
+/* Reactant atoms breadth first, each component from its rarest, busiest atom */
+static void search_order(AtomMapper* m) {
+    int n = m->count[0];
+    int* order = m->order;
+    int* seeds = m->best;               /* Scratch until the search starts */
+    int* seen = m->map;
+    for (int i = 0; i < n; i++) {
+        seeds[i] = i;
+        seen[i] = 0;
+    }
+    /* Insertion sort: class size ascending, then degree descending */
+    for (int i = 1; i < n; i++) {
+        int a = seeds[i];
+        int key_a = m->class_sizes[1][m->classes[0][a]] * 64 - degree(m, 0, a);
+        int j = i - 1;
+        while (j >= 0) {
+            int b = seeds[j];
+            int key_b = m->class_sizes[1][m->classes[0][b]] * 64 - degree(m, 0, b);
+            if (key_b <= key_a) break;
+            seeds[j + 1] = b;
+            j--;
+        }
+        seeds[j + 1] = a;
+    }
+
+    int tail = 0;
+    for (int i = 0; i < n; i++) {
+        if (seen[seeds[i]]) continue;
+        int head = tail;
+        order[tail++] = seeds[i];
+        seen[seeds[i]] = 1;
+        while (head < tail) {
+            int a = order[head++];
+            for (int k = m->offsets[0][a]; k < m->offsets[0][a + 1]; k++) {
+                int b = m->neighbors[0][k];
+                if (seen[b]) continue;
+                seen[b] = 1;
+                order[tail++] = b;
+            }
+        }
+    }
+}
+
+/* ============ Search ============ */
+
+typedef struct {
+    const Molecule* sides[2];
+    int* remaining[2];          /* Unmapped atoms per class */
+    int slice;                  /* Candidate slots per depth */
+    int best_cost;
+    double deadline;
+    long long nodes;
+    bool aborted;
+} SearchState;
+
+/* Cost of mapping reactant a to product p (or skipping it if p < 0) */
+static int assign_cost(const AtomMapper* m, const SearchState* st, int a, int p) {
+    int edits = 0;
+    for (int k = m->offsets[0][a]; k < m->offsets[0][a + 1]; k++) {
+        int mb = m->map[m->neighbors[0][k]];
+        if (mb == MAP_UNASSIGNED) continue;
+        if (p < 0 || mb == MAP_SKIPPED) {
+            edits++;
+            continue;
+        }
+        int type = bond_between(m, 1, p, mb);
+        if (type != m->bond_types[0][k]) edits++;
+    }
+    if (p < 0) return EDIT_COST * edits;
+
+    for (int k = m->offsets[1][p]; k < m->offsets[1][p + 1]; k++) {
+        int r = m->inverse[m->neighbors[1][k]];
+        if (r >= 0 && bond_between(m, 0, a, r) == 0) edits++;
+    }
+    return EDIT_COST * edits + (same_atom_state(m, st->sides, a, p) ? 0 : 1);
+}
+
+/* Every bond edit moves the degrees of at most two unmapped atoms by one */
+static int lower_bound(const AtomMapper* m, const SearchState* st) {
+    int total = 0;
+    for (int c = 0; c < m->class_count; c++) {
+        if (st->remaining[0][c] != st->remaining[1][c] || st->remaining[0][c] == 0) continue;
+        const int* hr = &m->histograms[0][c * DEGREE_BINS];
+        const int* hp = &m->histograms[1][c * DEGREE_BINS];
+        int cumulative = 0;
+        for (int d = 0; d < DEGREE_BINS; d++) {
+            cumulative += hr[d] - hp[d];
+            total += cumulative < 0 ? -cumulative : cumulative;
+        }
+    }
+    return EDIT_COST * ((total + 1) / 2);
+}
+
+/* Product bonds touching atoms no reactant atom maps to */
+static int leaf_cost(const AtomMapper* m) {
+    int edits = 0;
+    for (int p = 0; p < m->count[1]; p++) {
+        if (m->inverse[p] >= 0) continue;
+        for (int k = m->offsets[1][p]; k < m->offsets[1][p + 1]; k++) {
+            int q = m->neighbors[1][k];
+            if (m->inverse[q] >= 0 || q > p) edits++;
+        }
+    }
+    return EDIT_COST * edits;
+}
+
+static void set_mapping(AtomMapper* m, SearchState* st, int a, int p, int sign) {
+    int c = m->classes[0][a];
+    m->histograms[0][c * DEGREE_BINS + degree_bin(m, 0, a)] -= sign;
+    st->remaining[0][c] -= sign;
+    if (p >= 0) {
+        m->histograms[1][c * DEGREE_BINS + degree_bin(m, 1, p)] -= sign;
+        st->remaining[1][c] -= sign;
+        m->inverse[p] = sign > 0 ? a : -1;
+    }
+    m->map[a] = sign > 0 ? p : MAP_UNASSIGNED;
+}
+
+static void search(AtomMapper* m, SearchState* st, int depth, int cost) {
+    st->nodes++;
+    if ((st->nodes & CLOCK_INTERVAL) == 0 && parallel_now() > st->deadline) st->aborted = true;
+    if (st->aborted) return;
+
+    if (depth == m->count[0]) {
+        cost += leaf_cost(m);
+        if (cost < st->best_cost) {
+            st->best_cost = cost;
+            memcpy(m->best, m->map, (size_t)m->count[0] * sizeof(int));
+        }
+        return;
+    }
+    if (cost + lower_bound(m, st) >= st->best_cost) return;
+
+    int a = m->order[depth];
+    int c = m->classes[0][a];
+    int* candidates = m->candidates + (size_t)depth * st->slice;
+    int* costs = m->candidate_costs + (size_t)depth * st->slice;
+    int count = 0;
+
+    for (int k = m->member_offsets[c]; k < m->member_offsets[c + 1]; k++) {
+        int p = m->members[k];
+        if (m->inverse[p] >= 0) continue;
+        int ddeg = abs(degree(m, 0, a) - degree(m, 1, p));
+        candidates[count] = p;
+        costs[count++] = assign_cost(m, st, a, p) * 64 + (ddeg < 63 ? ddeg : 62);
+    }
+    if (st->remaining[0][c] > st->remaining[1][c]) {
+        candidates[count] = MAP_SKIPPED;
+        costs[count++] = assign_cost(m, st, a, -1) * 64 + 63;
+    }
+
+    /* Cheapest first; the list is short (atoms of one element) */
+    for (int i = 1; i < count; i++) {
+        int p = candidates[i], key = costs[i], j = i - 1;
+        while (j >= 0 && costs[j] > key) {
+            candidates[j + 1] = candidates[j];
+            costs[j + 1] = costs[j];
+            j--;
+        }
+        candidates[j + 1] = p;
+        costs[j + 1] = key;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int added = costs[i] / 64;
+        if (cost + added >= st->best_cost) break;
+        set_mapping(m, st, a, candidates[i], 1);
+        search(m, st, depth + 1, cost + added);
+        set_mapping(m, st, a, candidates[i], -1);
+        if (st->aborted) return;
+    }
+}
+
+/* Bond and atom changes of the best mapping */
+static void describe(const AtomMapper* m, const Molecule* const* sides, AtomMapResult* r) {
+    for (int p = 0; p < m->count[1]; p++) m->inverse[p] = -1;
+    for (int a = 0; a < m->count[0]; a++) {
+        if (m->best[a] >= 0) m->inverse[m->best[a]] = a;
+        else r->unmapped++;
+    }
+    for (int a = 0; a < m->count[0]; a++) {
+        for (int k = m->offsets[0][a]; k < m->offsets[0][a + 1]; k++) {
+            int b = m->neighbors[0][k];
+            if (b < a) continue;
+            int type = m->best[a] >= 0 && m->best[b] >= 0 ? bond_between(m, 1, m->best[a], m->best[b]) : 0;
+            if (type == 0) r->bonds_broken++;
+            else if (type != m->bond_types[0][k]) r->bonds_changed++;
+        }
+        if (m->best[a] >= 0 && !same_atom_state(m, sides, a, m->best[a])) r->atoms_changed++;
+    }
+    for (int p = 0; p < m->count[1]; p++) {
+        for (int k = m->offsets[1][p]; k < m->offsets[1][p + 1]; k++) {
+            int q = m->neighbors[1][k];
+            if (q < p) continue;
+            int a = m->inverse[p], b = m->inverse[q];
+            if (a < 0 || b < 0 || bond_between(m, 0, a, b) == 0) r->bonds_formed++;
+        }
+    }
+}
+
+bool atom_map(AtomMapper* mapper, const Molecule* reactants, const Molecule* products,
+              double budget, int* map, AtomMapResult* result) {
+    if (!mapper || !reactants || !products || !map) return false;
+    AtomMapper* m = mapper;
+    int atoms = reactants->atom_count > products->atom_count ? reactants->atom_count
+                                                             : products->atom_count;
+    int bonds = reactants->bond_count > products->bond_count ? reactants->bond_count
+                                                             : products->bond_count;
+    if (!mapper_reserve(m, atoms, bonds)) return false;
+
+    int class_of[ELEMENT_SLOTS];
+    for (int z = 0; z < ELEMENT_SLOTS; z++) class_of[z] = -1;
+    m->class_count = 0;
+    build_side(m, 0, reactants, class_of);
+    build_side(m, 1, products, class_of);
+
+    /* Per class sizes, degree histograms and product members */
+    for (int s = 0; s < 2; s++) {
+        memset(m->class_sizes[s], 0, (size_t)m->class_count * sizeof(int));
+        memset(m->histograms[s], 0, (size_t)m->class_count * DEGREE_BINS * sizeof(int));
+        for (int a = 0; a < m->count[s]; a++) {
+            int c = m->classes[s][a];
+            m->class_sizes[s][c]++;
+            m->histograms[s][c * DEGREE_BINS + degree_bin(m, s, a)]++;
+        }
+    }
+    int largest = 0;
+    int filled = 0;
+    for (int c = 0; c < m->class_count; c++) {
+        m->member_offsets[c] = filled;
+        for (int p = 0; p < m->count[1]; p++) {
+            if (m->classes[1][p] == c) m->members[filled++] = p;
+        }
+        if (m->class_sizes[1][c] > largest) largest = m->class_sizes[1][c];
+    }
+    m->member_offsets[m->class_count] = filled;
+
+    SearchState st;
+    memset(&st, 0, sizeof(st));
+    st.slice = largest + 1;
+    size_t slots = (size_t)(m->count[0] > 0 ? m->count[0] : 1) * st.slice;
+    if (slots > (size_t)m->candidate_capacity) {
+        if (!grow((void**)&m->candidates, slots, sizeof(int)) ||
+            !grow((void**)&m->candidate_costs, slots, sizeof(int))) {
+            return false;
+        }
+        m->candidate_capacity = (int)slots;
+    }
+
+    search_order(m);
+    for (int a = 0; a < m->count[0]; a++) m->map[a] = MAP_UNASSIGNED;
+    for (int p = 0; p < m->count[1]; p++) m->inverse[p] = -1;
+
+    int remaining[2][ELEMENT_SLOTS];
+    for (int s = 0; s < 2; s++) {
+        memcpy(remaining[s], m->class_sizes[s], (size_t)m->class_count * sizeof(int));
+        st.remaining[s] = remaining[s];
+    }
+    st.sides[0] = reactants;
+    st.sides[1] = products;
+    st.best_cost = INT_MAX;
+    st.deadline = parallel_now() + (budget > 0.0 ? budget : ATOM_MAP_DEFAULT_BUDGET);
+    search(m, &st, 0, 0);
+
+    AtomMapResult r;
+    memset(&r, 0, sizeof(r));
+    r.optimal = !st.aborted;
+    r.nodes = st.nodes;
+    for (int i = 0; i < reactants->atom_count; i++) map[i] = -1;
+    if (st.best_cost < INT_MAX) {
+        describe(m, st.sides, &r);
+        for (int a = 0; a < m->count[0]; a++) {
+            if (m->best[a] >= 0) map[m->atoms[0][a]] = m->atoms[1][m->best[a]];
+        }
+    } else {
+        r.unmapped = m->count[0];
+    }
+    if (result) *result = r;
+    return true;
+}
+
+/* ============ Reaction SMILES ============ */
+
+bool atom_map_parse_reaction(const char* smiles, Molecule* reactants, Molecule* products) {
+    if (!smiles || !reactants || !products) return false;
+    const char* first = strchr(smiles, '>');
+    if (!first) return false;
+    const char* last = strchr(first + 1, '>');
+    if (!last || strchr(last + 1, '>')) return false;
+
+    const char* product_text = last + 1;
+    size_t product_length = strcspn(product_text, " \t\r\n");
+
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    parser.implicit_hydrogens = true;
+    bool ok = first > smiles && product_length > 0 &&
+              smiles_parser_parse(&parser, smiles, (size_t)(first - smiles), reactants) &&
+              smiles_parser_parse(&parser, product_text, product_length, products);
+    smiles_parser_free(&parser);
+    return ok;
+}
+
+/* ============ Batch Mapping ============ */
+
+typedef struct {
+    AtomMapper mapper;
+    bool failed;
+    char padding[64];
+} MapWorker;
+
+typedef struct {
+    const Molecule* const* reactants;
+    const Molecule* const* products;
+    double budget;
+    int* const* maps;
+    AtomMapResult* results;
+    MapWorker* workers;
+} MapJob;
+
+static void map_range(int begin, int end, int thread_index, void* user_data) {
+    MapJob* job = user_data;
+    MapWorker* w = &job->workers[thread_index];
+    for (int i = begin; i < end; i++) {
+        AtomMapResult result;
+        if (!atom_map(&w->mapper, job->reactants[i], job->products[i], job->budget,
+                      job->maps[i], &result)) {
+            w->failed = true;
+            continue;
+        }
+        if (job->results) job->results[i] = result;
+    }
+}
+
+bool atom_map_batch(const Molecule* const* reactants, const Molecule* const* products, int count,
+                    double budget, int threads, int* const* maps, AtomMapResult* results) {
+    if (!reactants || !products || !maps || count < 0) return false;
+
+    threads = parallel_thread_count(threads);
+    MapWorker* workers = calloc(threads, sizeof(MapWorker));
+    if (!workers) return false;
+    for (int t = 0; t < threads; t++) atom_mapper_init(&workers[t].mapper);
+
+    /* One reaction per chunk: search times vary by orders of magnitude */
+    MapJob job = {reactants, products, budget, maps, results, workers};
+    bool ok = parallel_for(count, 1, threads, map_range, &job);
+
+    for (int t = 0; t < threads; t++) {
+        if (workers[t].failed) ok = false;
+        atom_mapper_free(&workers[t].mapper);
+    }
+    free(workers);
+    return ok;
+}
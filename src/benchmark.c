@@ -0,0 +1,1492 @@
+#include "benchmark.h"
+#include "parallel.h"
+#include "ion.h"
+#include "mass_decomp.h"
+#include "element.h"
+#include "isotope.h"
+#include "molecule_pool.h"
+#include "smiles.h"
+#include "canon.h"
+#include "substruct.h"
+#include "fingerprint.h"
+#include "validate.h"
+#include "ring.h"
+#include "forcefield.h"
+#include "descriptor.h"
+#include "atom_map.h"
+#include "reaction.h"
+#include "network.h"
+#include "kinetics.h"
+#include "stochastic.h"
+#include "thermo.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+static void print_rate(const char* label, long long items, double seconds) {
+    double rate = seconds > 0.0 ? (double)items / seconds : 0.0;
+    printf("  %-28s %12lld items %9.3f s %14.0f /s\n", label, items, seconds, rate);
+}
+
+/* Thread counts 1, 2, 4, ... capped at max */
+static int next_thread_count(int threads, int max_threads) {
+    return threads * 2 < max_threads ? threads * 2 : max_threads;
+}
+
+/* ============ Ionic Compound Enumeration ============ */
+
+static bool count_compound(const IonicCompound* compound, void* user_data) {
+    (void)compound;
+    (*(long long*)user_data)++;
+    return true;
+}
+
+void benchmark_ionic_enumeration(void) {
+    printf("\nIonic compound enumeration (binary + ternary + polyatomic, subscripts <= 6)\n");
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        IonicEnumOptions options;
+        ionic_enum_options_default(&options);
+        options.threads = threads;
+
+        long long emitted = 0;
+        IonicEnumStats stats;
+        if (!ionic_enumerate(&options, count_compound, &emitted, &stats)) {
+            printf("  enumeration failed\n");
+            return;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), unique", threads);
+        print_rate(label, stats.unique, stats.seconds);
+        snprintf(label, sizeof(label), "%d thread(s), candidates", threads);
+        print_rate(label, stats.candidates, stats.seconds);
+
+        if (threads == max_threads) break;
+    }
+}
+
+/* ============ Mass Decomposition ============ */
+
+#define MASS_BENCH_QUERIES 2000
+#define MASS_BENCH_RESULTS 64
+
+void benchmark_mass_decomposition(void) {
+    printf("\nMass decomposition (CHNOPS, 5 ppm, %d masses in 150-950 Da)\n",
+           MASS_BENCH_QUERIES);
+
+    MassAlphabetEntry alphabet[] = {
+        {element_by_symbol("C"), 0, 60},
+        {element_by_symbol("H"), 0, 120},
+        {element_by_symbol("N"), 0, 20},
+        {element_by_symbol("O"), 0, 30},
+        {element_by_symbol("P"), 0, 4},
+        {element_by_symbol("S"), 0, 4}
+    };
+    MassDecomposer decomposer;
+    double start = parallel_now();
+    if (!mass_decomposer_init(&decomposer, alphabet, 6, MASS_MONOISOTOPIC, 0.0)) {
+        printf("  decomposer init failed\n");
+        return;
+    }
+    printf("  table build %.3f ms\n", (parallel_now() - start) * 1000.0);
+
+    double* masses = malloc(MASS_BENCH_QUERIES * sizeof(double));
+    int* counts = malloc(MASS_BENCH_QUERIES * sizeof(int));
+    MassCandidate* results = malloc((size_t)MASS_BENCH_QUERIES * MASS_BENCH_RESULTS *
+                                    sizeof(MassCandidate));
+    if (!masses || !counts || !results) {
+        free(masses);
+        free(counts);
+        free(results);
+        mass_decomposer_free(&decomposer);
+        return;
+    }
+
+    /* Deterministic spread of query masses */
+    unsigned int seed = 12345;
+    for (int i = 0; i < MASS_BENCH_QUERIES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        masses[i] = 150.0 + 800.0 * (double)((seed >> 8) & 0xFFFF) / 65536.0;
+    }
+
+    MassQueryOptions options;
+    mass_query_options_default(&options);
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        start = parallel_now();
+        mass_decompose_batch(&decomposer, masses, MASS_BENCH_QUERIES, &options,
+                             results, MASS_BENCH_RESULTS, counts, threads);
+        double seconds = parallel_now() - start;
+
+        long long hits = 0;
+        for (int i = 0; i < MASS_BENCH_QUERIES; i++) hits += counts[i];
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), queries", threads);
+        print_rate(label, MASS_BENCH_QUERIES, seconds);
+        snprintf(label, sizeof(label), "%d thread(s), formulas", threads);
+        print_rate(label, hits, seconds);
+
+        if (threads == max_threads) break;
+    }
+
+    free(masses);
+    free(counts);
+    free(results);
+    mass_decomposer_free(&decomposer);
+}
+
+/* ============ Isotope Patterns ============ */
+
+void benchmark_isotope_pattern(void) {
+    static const char* formulas[] = {
+        "C6H12O6",
+        "C254H377N65O75S6",
+        "C2000H3000N500O600S20",
+        "C10000H15000N2500O3000S100Cl50Br20"
+    };
+    printf("\nIsotope pattern (repeated squaring, prune 1e-12)\n");
+
+    for (int f = 0; f < (int)(sizeof(formulas) / sizeof(formulas[0])); f++) {
+        Formula formula;
+        if (!formula_parse(formulas[f], &formula)) continue;
+
+        int runs = 0;
+        int peaks = 0;
+        double start = parallel_now();
+        double seconds;
+        do {
+            IsotopePattern pattern;
+            if (!isotope_pattern(&formula, NULL, &pattern)) {
+                printf("  pattern failed for %s\n", formulas[f]);
+                return;
+            }
+            peaks = pattern.peak_count;
+            isotope_pattern_free(&pattern);
+            runs++;
+            seconds = parallel_now() - start;
+        } while (seconds < 0.2);
+
+        printf("  %-36s %4d peaks %10.4f ms/pattern\n", formulas[f], peaks,
+               seconds * 1000.0 / runs);
+    }
+}
+
+/* ============ Molecule Allocation ============ */
+
+#define POOL_BENCH_MOLECULES 1000000
+#define POOL_BENCH_BATCH 10000
+
+static Molecule* build_small_molecule(MoleculePool* pool, int i) {
+    switch (i % 3) {
+        case 0: return molecule_create_water(pool);
+        case 1: return molecule_create_co2(pool);
+        default: return molecule_create_methane(pool);
+    }
+}
+
+/*
+ * Build a million small molecules in batches, keeping each batch alive
+ * until it is dropped: once with the heap, once with a pool that is bulk
+ * reset between batches.
+ */
+void benchmark_molecule_pool(void) {
+    printf("\nMolecule allocation (%d molecules, batches of %d)\n",
+           POOL_BENCH_MOLECULES, POOL_BENCH_BATCH);
+
+    Molecule** batch = malloc(POOL_BENCH_BATCH * sizeof(Molecule*));
+    if (!batch) return;
+
+    long long atoms = 0;
+    double start = parallel_now();
+    for (int done = 0; done < POOL_BENCH_MOLECULES; done += POOL_BENCH_BATCH) {
+        for (int i = 0; i < POOL_BENCH_BATCH; i++) {
+            batch[i] = build_small_molecule(NULL, done + i);
+            if (batch[i]) atoms += batch[i]->atom_count;
+        }
+        for (int i = 0; i < POOL_BENCH_BATCH; i++) molecule_destroy(batch[i]);
+    }
+    print_rate("heap, molecules", POOL_BENCH_MOLECULES, parallel_now() - start);
+
+    MoleculePool pool;
+    molecule_pool_init(&pool, 0);
+    long long pooled_atoms = 0;
+    start = parallel_now();
+    for (int done = 0; done < POOL_BENCH_MOLECULES; done += POOL_BENCH_BATCH) {
+        for (int i = 0; i < POOL_BENCH_BATCH; i++) {
+            Molecule* mol = build_small_molecule(&pool, done + i);
+            if (mol) pooled_atoms += mol->atom_count;
+        }
+        molecule_pool_reset(&pool);
+    }
+    print_rate("pool, molecules", POOL_BENCH_MOLECULES, parallel_now() - start);
+    printf("  atoms built: heap %lld, pool %lld; pool system allocations: %zu\n",
+           atoms, pooled_atoms, pool.system_allocations);
+
+    molecule_pool_destroy(&pool);
+    free(batch);
+}
+
+/* ============ SMILES Parsing ============ */
+
+#define SMILES_BENCH_LINES 500000
+
+static const char* BENCH_SMILES[] = {
+    "CC(=O)Oc1ccccc1C(=O)O aspirin",
+    "Cn1cnc2c1c(=O)n(C)c(=O)n2C caffeine",
+    "CC(C)Cc1ccc(cc1)C(C)C(=O)O ibuprofen",
+    "CC(=O)Nc1ccc(O)cc1 paracetamol",
+    "OC[C@H]1OC(O)[C@H](O)[C@@H](O)[C@@H]1O glucose",
+    "CN1CCC[C@H]1c1cccnc1 nicotine",
+    "O=C(O)c1ccccc1O salicylic_acid",
+    "CCN(CC)CC(=O)Nc1c(C)cccc1C lidocaine",
+    "C[C@]12CC[C@H]3[C@@H](CCc4cc(O)ccc34)[C@@H]1CC[C@@H]2O estradiol",
+    "NC(Cc1c[nH]c2ccccc12)C(=O)O tryptophan",
+    "[Na+].[O-]C(=O)c1ccccc1 sodium_benzoate",
+    "FC(F)(F)c1ccc(Oc2ccc(cc2)[N+](=O)[O-])cc1"
+};
+
+/* Newline-separated library cycling through BENCH_SMILES */
+static char* build_smiles_library(int lines, size_t* length_out) {
+    int templates = (int)(sizeof(BENCH_SMILES) / sizeof(BENCH_SMILES[0]));
+    size_t capacity = 0;
+    for (int i = 0; i < templates; i++) capacity += strlen(BENCH_SMILES[i]) + 1;
+    capacity = capacity * (lines / templates + 1);
+
+    char* text = malloc(capacity);
+    if (!text) return NULL;
+    size_t length = 0;
+    for (int i = 0; i < lines; i++) {
+        const char* line = BENCH_SMILES[i % templates];
+        size_t n = strlen(line);
+        memcpy(text + length, line, n);
+        length += n;
+        text[length++] = '\n';
+    }
+    *length_out = length;
+    return text;
+}
+
+void benchmark_smiles_parsing(void) {
+    size_t length;
+    char* text = build_smiles_library(SMILES_BENCH_LINES, &length);
+    if (!text) return;
+
+    printf("\nSMILES parsing (%d lines, %.1f MB, hydrogens made explicit)\n",
+           SMILES_BENCH_LINES, (double)length / (1024.0 * 1024.0));
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        SmilesBatchStats stats;
+        if (!smiles_parse_buffer(text, length, threads, false, NULL, NULL, &stats)) {
+            printf("  parsing failed\n");
+            break;
+        }
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), molecules", threads);
+        print_rate(label, stats.parsed, stats.seconds);
+        snprintf(label, sizeof(label), "%d thread(s), atoms", threads);
+        print_rate(label, stats.atoms, stats.seconds);
+        if (stats.failed > 0) printf("  %d line(s) failed\n", stats.failed);
+
+        if (threads == max_threads) break;
+    }
+
+    free(text);
+}
+
+/* ============ Canonical Dedupe ============ */
+
+typedef struct {
+    CanonContext* contexts;     /* One per worker */
+    CanonHash* hashes;          /* Per line */
+    unsigned char* valid;
+} DedupeState;
+
+static void hash_molecule(const Molecule* mol, int line, int thread_index, void* user_data) {
+    DedupeState* state = user_data;
+    state->valid[line] = canon_hash(&state->contexts[thread_index], mol, &state->hashes[line]);
+}
+
+/* Parse, canonicalize and hash a library, then dedupe in one hash-set pass */
+void benchmark_canonical_dedupe(void) {
+    size_t length;
+    char* text = build_smiles_library(SMILES_BENCH_LINES, &length);
+    if (!text) return;
+
+    printf("\nCanonical hash dedupe (%d lines)\n", SMILES_BENCH_LINES);
+
+    int max_threads = parallel_thread_count(0);
+    DedupeState state;
+    state.contexts = malloc(max_threads * sizeof(CanonContext));
+    state.hashes = malloc(SMILES_BENCH_LINES * sizeof(CanonHash));
+    state.valid = calloc(SMILES_BENCH_LINES, 1);
+    if (!state.contexts || !state.hashes || !state.valid) {
+        free(state.contexts);
+        free(state.hashes);
+        free(state.valid);
+        free(text);
+        return;
+    }
+    for (int t = 0; t < max_threads; t++) canon_context_init(&state.contexts[t]);
+
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        SmilesBatchStats stats;
+        if (!smiles_parse_buffer(text, length, threads, false, hash_molecule, &state, &stats)) {
+            printf("  parsing failed\n");
+            break;
+        }
+
+        double start = parallel_now();
+        CanonHashSet set;
+        int hashed = 0;
+        if (canon_hash_set_init(&set, SMILES_BENCH_LINES / 4)) {
+            for (int i = 0; i < stats.lines; i++) {
+                if (!state.valid[i]) continue;
+                canon_hash_set_insert(&set, &state.hashes[i]);
+                hashed++;
+            }
+        }
+        double dedupe_seconds = parallel_now() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), parse + hash", threads);
+        print_rate(label, hashed, stats.seconds);
+        snprintf(label, sizeof(label), "%d thread(s), hash-set pass", threads);
+        print_rate(label, hashed, dedupe_seconds);
+        printf("  %zu unique of %d\n", set.count, hashed);
+        canon_hash_set_free(&set);
+
+        if (threads == max_threads) break;
+    }
+
+    for (int t = 0; t < max_threads; t++) canon_context_free(&state.contexts[t]);
+    free(state.contexts);
+    free(state.hashes);
+    free(state.valid);
+    free(text);
+}
+
+/* ============ Substructure Search ============ */
+
+#define SUBSTRUCT_BENCH_MOLECULES 1000000
+
+static const char* BENCH_FRAGMENTS[] = {
+    "C", "C", "CC", "C(C)C", "O", "N", "S", "F", "Cl", "C#N", "C=C", "C(=O)O",
+    "C(=O)N", "OC", "c1ccccc1", "c1ccncc1", "C1CCCCC1", "C1CCOC1", "c1ccsc1", "N(C)C"
+};
+
+/* Random chain of fragments with branches, one SMILES per line */
+static char* build_random_library(int lines, unsigned int seed, size_t* length_out) {
+    int fragments = (int)(sizeof(BENCH_FRAGMENTS) / sizeof(BENCH_FRAGMENTS[0]));
+    size_t capacity = (size_t)lines * 96;
+    char* text = malloc(capacity);
+    if (!text) return NULL;
+
+    size_t length = 0;
+    for (int i = 0; i < lines; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int parts = 2 + (int)((seed >> 16) % 6);
+        for (int p = 0; p < parts; p++) {
+            seed = seed * 1103515245u + 12345u;
+            const char* fragment = BENCH_FRAGMENTS[(seed >> 16) % fragments];
+            bool branch = p > 0 && p < parts - 1 && ((seed >> 8) & 3) == 0;
+            if (branch) text[length++] = '(';
+            size_t n = strlen(fragment);
+            memcpy(text + length, fragment, n);
+            length += n;
+            if (branch) text[length++] = ')';
+        }
+        text[length++] = '\n';
+    }
+    *length_out = length;
+    return text;
+}
+
+void benchmark_substructure_search(void) {
+    size_t length;
+    char* text = build_random_library(SUBSTRUCT_BENCH_MOLECULES, 2024u, &length);
+    if (!text) return;
+
+    printf("\nSubstructure search (%d molecules)\n", SUBSTRUCT_BENCH_MOLECULES);
+
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    parser.implicit_hydrogens = true;
+    Molecule mol;
+    molecule_init(&mol, NULL);
+    SubstructLibrary lib;
+    substruct_library_init(&lib);
+
+    double start = parallel_now();
+    const char* line = text;
+    const char* end = text + length;
+    while (line < end) {
+        const char* next = memchr(line, '\n', end - line);
+        if (smiles_parser_parse(&parser, line, next - line, &mol)) substruct_library_add(&lib, &mol);
+        line = next + 1;
+    }
+    print_rate("parse + index", lib.molecule_count, parallel_now() - start);
+
+    static const char* queries[] = {
+        "C(=O)O", "c1ccncc1", "C#N", "C1CCOC1", "c1ccccc1C(=O)N", "ClC(C)C"
+    };
+    int max_threads = parallel_thread_count(0);
+    for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        Molecule query_mol;
+        molecule_init(&query_mol, NULL);
+        SubstructQuery query;
+        if (!smiles_parse(queries[q], &query_mol) || !substruct_query_compile(&query, &query_mol)) {
+            molecule_free(&query_mol);
+            continue;
+        }
+
+        for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+            SubstructSearchStats stats;
+            if (substruct_search(&lib, &query, threads, NULL, 0, &stats) < 0) break;
+
+            char label[64];
+            snprintf(label, sizeof(label), "%-14s %d thread(s)", queries[q], threads);
+            print_rate(label, stats.molecules, stats.seconds);
+            if (threads == 1) {
+                printf("  %d screened in, %d matched\n", stats.screened, stats.matched);
+            }
+            if (threads == max_threads) break;
+        }
+
+        substruct_query_free(&query);
+        molecule_free(&query_mol);
+    }
+
+    substruct_library_free(&lib);
+    molecule_free(&mol);
+    smiles_parser_free(&parser);
+    free(text);
+}
+
+/* ============ Similarity Search ============ */
+
+#define SIMILARITY_BENCH_MOLECULES 1000000
+#define SIMILARITY_BENCH_TOP_K 10
+
+typedef struct {
+    FingerprintContext* contexts;   /* One per worker */
+    FingerprintMatrix* matrix;
+} FingerprintState;
+
+static void fingerprint_line(const Molecule* mol, int line, int thread_index, void* user_data) {
+    FingerprintState* state = user_data;
+    uint64_t bits[FINGERPRINT_WORDS];
+    if (fingerprint_ecfp(&state->contexts[thread_index], mol, FINGERPRINT_DEFAULT_RADIUS, bits)) {
+        fingerprint_matrix_set(state->matrix, line, bits);
+    }
+}
+
+void benchmark_similarity_search(void) {
+    size_t length;
+    char* text = build_random_library(SIMILARITY_BENCH_MOLECULES, 4711u, &length);
+    if (!text) return;
+
+    printf("\nTanimoto top-%d search (%d ECFP4 fingerprints, %d bits)\n",
+           SIMILARITY_BENCH_TOP_K, SIMILARITY_BENCH_MOLECULES, FINGERPRINT_BITS);
+
+    int max_threads = parallel_thread_count(0);
+    FingerprintMatrix matrix;
+    fingerprint_matrix_init(&matrix);
+    FingerprintState state = {malloc(max_threads * sizeof(FingerprintContext)), &matrix};
+    if (!state.contexts || !fingerprint_matrix_resize(&matrix, SIMILARITY_BENCH_MOLECULES)) {
+        free(state.contexts);
+        fingerprint_matrix_free(&matrix);
+        free(text);
+        return;
+    }
+    for (int t = 0; t < max_threads; t++) fingerprint_context_init(&state.contexts[t]);
+
+    SmilesBatchStats stats;
+    if (smiles_parse_buffer(text, length, max_threads, true, fingerprint_line, &state, &stats)) {
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), parse + ECFP4", max_threads);
+        print_rate(label, stats.parsed, stats.seconds);
+
+        SimilarityHit hits[SIMILARITY_BENCH_TOP_K];
+        const int queries[] = {0, 12345, 777777};
+        for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+            double start = parallel_now();
+            double best = 0.0;
+            for (size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+                int found = fingerprint_top_k(&matrix, fingerprint_matrix_row(&matrix, queries[q]),
+                                              SIMILARITY_BENCH_TOP_K, threads, hits);
+                if (found > 0) best += hits[found - 1].similarity;
+            }
+            double seconds = parallel_now() - start;
+
+            snprintf(label, sizeof(label), "%d thread(s), top-%d", threads, SIMILARITY_BENCH_TOP_K);
+            print_rate(label, (long long)matrix.count * 3, seconds);
+            printf("  %.1f ms per query, mean k-th similarity %.3f\n",
+                   1000.0 * seconds / 3, best / 3);
+            if (threads == max_threads) break;
+        }
+    } else {
+        printf("  parsing failed\n");
+    }
+
+    for (int t = 0; t < max_threads; t++) fingerprint_context_free(&state.contexts[t]);
+    free(state.contexts);
+    fingerprint_matrix_free(&matrix);
+    free(text);
+}
+
+/* ============ Validation ============ */
+
+#define VALIDATION_BENCH_MOLECULES 200000
+
+void benchmark_validation(void) {
+    size_t length;
+    char* text = build_random_library(VALIDATION_BENCH_MOLECULES, 1337u, &length);
+    const Molecule** molecules = malloc(VALIDATION_BENCH_MOLECULES * sizeof(Molecule*));
+    if (!text || !molecules) {
+        free(text);
+        free(molecules);
+        return;
+    }
+
+    printf("\nValence validation (%d molecules)\n", VALIDATION_BENCH_MOLECULES);
+
+    MoleculePool pool;
+    molecule_pool_init(&pool, 0);
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+
+    int count = 0;
+    const char* line = text;
+    const char* end = text + length;
+    while (line < end) {
+        const char* next = memchr(line, '\n', end - line);
+        Molecule* mol = molecule_pool_create(&pool, NULL);
+        if (mol && smiles_parser_parse(&parser, line, next - line, mol)) molecules[count++] = mol;
+        line = next + 1;
+    }
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        ValidationStats stats;
+        if (!validate_molecules(molecules, count, threads, NULL, &stats)) break;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), molecules", threads);
+        print_rate(label, stats.molecules, stats.seconds);
+        if (threads == 1) {
+            printf("  %d valid, %d rejected", stats.valid, stats.invalid);
+            for (int k = 0; k < VALIDATION_KIND_COUNT; k++) {
+                if (stats.issues[k] > 0) {
+                    printf("; %s %lld", validation_kind_str((ValidationKind)k), stats.issues[k]);
+                }
+            }
+            printf("\n");
+        }
+        if (threads == max_threads) break;
+    }
+
+    smiles_parser_free(&parser);
+    molecule_pool_destroy(&pool);
+    free(molecules);
+    free(text);
+}
+
+/* ============ Ring Perception ============ */
+
+#define RING_BENCH_MOLECULES 200000
+
+/* Honeycomb sheet of width x width carbons (a fused polycyclic) */
+static bool build_honeycomb(Molecule* mol, int width) {
+    const Element* carbon = element_by_number(6);
+    int n = width * width;
+    if (!molecule_reserve(mol, n, 2 * n) || molecule_add_atoms(mol, carbon, 0, n) < 0) return false;
+    for (int y = 0; y < width; y++) {
+        for (int x = 0; x < width; x++) {
+            int a = y * width + x;
+            if (x + 1 < width && !molecule_add_bond(mol, a, a + 1, BOND_AROMATIC)) return false;
+            if (y + 1 < width && (x + y) % 2 == 0 &&
+                !molecule_add_bond(mol, a, a + width, BOND_AROMATIC)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void benchmark_ring_perception(void) {
+    size_t length;
+    char* text = build_random_library(RING_BENCH_MOLECULES, 99u, &length);
+    if (!text) return;
+
+    printf("\nRing perception (%d molecules, then fused sheets)\n", RING_BENCH_MOLECULES);
+
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    parser.implicit_hydrogens = true;
+    RingContext ctx;
+    ring_context_init(&ctx);
+    Molecule mol;
+    molecule_init(&mol, NULL);
+
+    int parsed = 0;
+    long long rings = 0;
+    double seconds = 0.0;
+    const char* line = text;
+    const char* end = text + length;
+    while (line < end) {
+        const char* next = memchr(line, '\n', end - line);
+        if (smiles_parser_parse(&parser, line, next - line, &mol)) {
+            double start = parallel_now();
+            if (ring_perceive(&ctx, &mol)) rings += mol.ring_count;
+            seconds += parallel_now() - start;
+            parsed++;
+        }
+        line = next + 1;
+    }
+    print_rate("SSSR, molecules", parsed, seconds);
+    printf("  %lld rings\n", rings);
+
+    for (int width = 25; width <= 200; width *= 2) {
+        molecule_clear(&mol);
+        if (!build_honeycomb(&mol, width) || !molecule_build_adjacency(&mol)) break;
+
+        double start = parallel_now();
+        if (!ring_perceive(&ctx, &mol)) break;
+        double elapsed = parallel_now() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d-atom sheet, rings", mol.atom_count);
+        print_rate(label, mol.ring_count, elapsed);
+    }
+
+    molecule_free(&mol);
+    ring_context_free(&ctx);
+    smiles_parser_free(&parser);
+    free(text);
+}
+
+/* ============ Force Field ============ */
+
+#define FF_BENCH_SIDE 15            /* Waters per box edge */
+#define FF_BENCH_SPACING 3.1        /* Liquid density, about 0.1 atoms per A^3 */
+#define FF_BENCH_EVALUATIONS 20
+#define FF_BENCH_STEPS 50
+
+/* Cubic lattice of randomly oriented waters */
+static bool build_water_box(Molecule* mol, int side, unsigned int seed) {
+    const Element* oxygen = element_by_number(8);
+    const Element* hydrogen = element_by_number(1);
+    int waters = side * side * side;
+    if (!molecule_reserve(mol, 3 * waters, 2 * waters) || !molecule_enable_coordinates(mol)) {
+        return false;
+    }
+
+    srand(seed);
+    for (int w = 0; w < waters; w++) {
+        int o = molecule_add_atom(mol, oxygen, 0);
+        int h1 = molecule_add_atom(mol, hydrogen, 0);
+        int h2 = molecule_add_atom(mol, hydrogen, 0);
+        if (o < 0 || h1 < 0 || h2 < 0 ||
+            !molecule_add_bond(mol, o, h1, BOND_SINGLE) || !molecule_add_bond(mol, o, h2, BOND_SINGLE)) {
+            return false;
+        }
+
+        double ox = FF_BENCH_SPACING * (w % side);
+        double oy = FF_BENCH_SPACING * ((w / side) % side);
+        double oz = FF_BENCH_SPACING * (w / (side * side));
+        double a = 6.283185307 * rand() / RAND_MAX, b = 3.141592654 * rand() / RAND_MAX;
+        double hx[2] = {0.757, -0.757}, hy = 0.586;
+        molecule_set_atom_position(mol, o, ox, oy, oz);
+        for (int h = 0; h < 2; h++) {
+            /* Rotate about z by a, then about x by b */
+            double x = hx[h] * cos(a) - hy * sin(a);
+            double y = hx[h] * sin(a) + hy * cos(a);
+            molecule_set_atom_position(mol, h == 0 ? h1 : h2, ox + x, oy + y * cos(b), oz + y * sin(b));
+        }
+    }
+    return true;
+}
+
+void benchmark_forcefield(void) {
+    Molecule mol;
+    molecule_init(&mol, NULL);
+    ForceField ff;
+    forcefield_init(&ff);
+    if (!build_water_box(&mol, FF_BENCH_SIDE, 42u) || !forcefield_setup(&ff, &mol, 0.0)) {
+        printf("  setup failed\n");
+        forcefield_free(&ff);
+        molecule_free(&mol);
+        return;
+    }
+
+    printf("\nForce field energy + gradient (%d-atom water box, %.0f A cutoff)\n",
+           mol.atom_count, ff.cutoff);
+
+    int max_threads = parallel_thread_count(0);
+    ForceFieldEnergy terms;
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        forcefield_energy(&ff, &mol, threads, &terms);
+        double start = parallel_now();
+        for (int i = 0; i < FF_BENCH_EVALUATIONS; i++) forcefield_energy(&ff, &mol, threads, &terms);
+        double seconds = parallel_now() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), evaluations", threads);
+        print_rate(label, FF_BENCH_EVALUATIONS, seconds);
+        printf("  %.2f ms per evaluation, %lld pairs\n",
+               1000.0 * seconds / FF_BENCH_EVALUATIONS, terms.pairs);
+        if (threads == max_threads) break;
+    }
+
+    MinimizeResult result;
+    double start = parallel_now();
+    if (forcefield_minimize(&ff, &mol, FF_BENCH_STEPS, 0.0, 0, &result)) {
+        print_rate("minimizer, steps", result.steps, parallel_now() - start);
+        printf("  energy %.1f -> %.1f kcal/mol\n", result.initial_energy, result.final_energy);
+    }
+
+    forcefield_free(&ff);
+    molecule_free(&mol);
+}
+
+/* ============ Descriptors ============ */
+
+#define DESCRIPTOR_BENCH_MOLECULES 200000
+
+void benchmark_descriptors(void) {
+    size_t length;
+    char* text = build_random_library(DESCRIPTOR_BENCH_MOLECULES, 4242u, &length);
+    const Molecule** molecules = malloc(DESCRIPTOR_BENCH_MOLECULES * sizeof(Molecule*));
+    if (!text || !molecules) {
+        free(text);
+        free(molecules);
+        return;
+    }
+
+    printf("\nDescriptor batch (%d molecules, %d descriptors)\n",
+           DESCRIPTOR_BENCH_MOLECULES, DESCRIPTOR_COUNT);
+
+    MoleculePool pool;
+    molecule_pool_init(&pool, 0);
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    parser.implicit_hydrogens = true;
+
+    int count = 0;
+    const char* line = text;
+    const char* end = text + length;
+    while (line < end) {
+        const char* next = memchr(line, '\n', end - line);
+        Molecule* mol = molecule_pool_create(&pool, NULL);
+        if (mol && smiles_parser_parse(&parser, line, next - line, mol)) molecules[count++] = mol;
+        line = next + 1;
+    }
+
+    DescriptorTable table;
+    descriptor_table_init(&table, DESCRIPTOR_ALL);
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        double start = parallel_now();
+        if (!descriptor_compute_batch(molecules, count, threads, &table)) break;
+        double seconds = parallel_now() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), molecules", threads);
+        print_rate(label, count, seconds);
+        if (threads == max_threads) break;
+    }
+
+    double sums[DESCRIPTOR_COUNT];
+    printf("  means:");
+    for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+        const double* column = descriptor_column(&table, (Descriptor)d);
+        sums[d] = 0.0;
+        for (int i = 0; i < count; i++) sums[d] += column[i];
+        printf(" %s %.2f", descriptor_name((Descriptor)d), count > 0 ? sums[d] / count : 0.0);
+    }
+    printf("\n");
+
+    /* Counts only: no per-atom intermediates are built */
+    descriptor_table_free(&table);
+    descriptor_table_init(&table, DESCRIPTOR_BIT(DESCRIPTOR_MOLECULAR_WEIGHT) |
+                                  DESCRIPTOR_BIT(DESCRIPTOR_HEAVY_ATOMS) |
+                                  DESCRIPTOR_BIT(DESCRIPTOR_FORMAL_CHARGE));
+    double start = parallel_now();
+    if (descriptor_compute_batch(molecules, count, 1, &table)) {
+        print_rate("1 thread, counts only", count, parallel_now() - start);
+    }
+
+    descriptor_table_free(&table);
+    smiles_parser_free(&parser);
+    molecule_pool_destroy(&pool);
+    free(molecules);
+    free(text);
+}
+
+/* ============ Atom Mapping ============ */
+
+#define ATOM_MAP_BENCH_ROUNDS 50    /* Copies of each reaction */
+
+static const char* const ATOM_MAP_BENCH_REACTIONS[] = {
+    "CC(=O)O.OCC>>CC(=O)OCC.O",
+    "C=CC=C.C=C>>C1CC=CCC1",
+    "CCBr.[OH-]>>CCO.[Br-]",
+    "CC(=O)Cl.NC>>CC(=O)NC.Cl",
+    "c1ccccc1.BrBr>>Brc1ccccc1.Br",
+    "CCCCCCCCCCCCCCCC(=O)OC.O>>CCCCCCCCCCCCCCCC(=O)O.CO",
+    "OC(=O)c1ccccc1O.CC(=O)OC(C)=O>>CC(=O)Oc1ccccc1C(=O)O.CC(=O)O",
+    "C1CCCCC1>>C=CCCCC",
+    "CC=O.[BH4-]>>CCO.[BH3]",
+    "NCC(=O)O.NC(C)C(=O)O>>NCC(=O)NC(C)C(=O)O.O",
+};
+
+void benchmark_atom_mapping(void) {
+    enum { KINDS = sizeof(ATOM_MAP_BENCH_REACTIONS) / sizeof(ATOM_MAP_BENCH_REACTIONS[0]) };
+    Molecule sides[2 * KINDS];
+    int kinds = KINDS;
+    int parsed = 0;
+    size_t atoms = 0;
+    for (; parsed < kinds; parsed++) {
+        molecule_init(&sides[2 * parsed], NULL);
+        molecule_init(&sides[2 * parsed + 1], NULL);
+        if (!atom_map_parse_reaction(ATOM_MAP_BENCH_REACTIONS[parsed], &sides[2 * parsed],
+                                     &sides[2 * parsed + 1])) {
+            molecule_free(&sides[2 * parsed]);
+            molecule_free(&sides[2 * parsed + 1]);
+            break;
+        }
+        atoms += (size_t)sides[2 * parsed].atom_count;
+    }
+
+    int count = kinds * ATOM_MAP_BENCH_ROUNDS;
+    const Molecule** reactants = malloc((size_t)count * sizeof(Molecule*));
+    const Molecule** products = malloc((size_t)count * sizeof(Molecule*));
+    int** maps = malloc((size_t)count * sizeof(int*));
+    AtomMapResult* results = malloc((size_t)count * sizeof(AtomMapResult));
+    int* storage = malloc(atoms * ATOM_MAP_BENCH_ROUNDS * sizeof(int));
+    if (parsed < kinds || !reactants || !products || !maps || !results || !storage) {
+        for (int i = 0; i < 2 * parsed; i++) molecule_free(&sides[i]);
+        free(reactants);
+        free(products);
+        free(maps);
+        free(results);
+        free(storage);
+        return;
+    }
+
+    int* next_map = storage;
+    for (int i = 0; i < count; i++) {
+        reactants[i] = &sides[2 * (i % kinds)];
+        products[i] = &sides[2 * (i % kinds) + 1];
+        maps[i] = next_map;
+        next_map += reactants[i]->atom_count;
+    }
+
+    printf("\nReaction atom mapping (%d reactions, %d distinct)\n", count, kinds);
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        double start = parallel_now();
+        if (!atom_map_batch(reactants, products, count, 0.0, threads, maps, results)) break;
+        double seconds = parallel_now() - start;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), reactions", threads);
+        print_rate(label, count, seconds);
+        if (threads == max_threads) break;
+    }
+
+    int optimal = 0;
+    long long nodes = 0, edits = 0;
+    for (int i = 0; i < count; i++) {
+        optimal += results[i].optimal;
+        nodes += results[i].nodes;
+        edits += results[i].bonds_broken + results[i].bonds_formed + results[i].bonds_changed;
+    }
+    printf("  optimal %d/%d, mean bond edits %.2f, mean search nodes %.0f\n", optimal, count,
+           (double)edits / count, (double)nodes / count);
+
+    for (int i = 0; i < 2 * kinds; i++) molecule_free(&sides[i]);
+    free(reactants);
+    free(products);
+    free(maps);
+    free(results);
+    free(storage);
+}
+
+/* ============ Reaction Similarity ============ */
+
+#define REACTION_BENCH_ROWS 4096    /* Synthetic reactions inserted before timing */
+#define REACTION_BENCH_QUERIES 20000
+#define REACTION_BENCH_K 5
+
+/* Alkane combustion, chlorination and dehydrogenation, alcohol combustion */
+static void build_synthetic_reaction(Reaction* rxn, int i) {
+    char text[32];
+    int n = i / 4 + 1;
+    reaction_init(rxn);
+    switch (i % 4) {
+        case 0:
+            snprintf(text, sizeof(text), "2C%dH%d", n, 2 * n + 2);
+            reaction_add_reactant(rxn, text);
+            snprintf(text, sizeof(text), "%dO2", 3 * n + 1);
+            reaction_add_reactant(rxn, text);
+            snprintf(text, sizeof(text), "%dCO2", 2 * n);
+            reaction_add_product(rxn, text);
+            snprintf(text, sizeof(text), "%dH2O", 2 * n + 2);
+            reaction_add_product(rxn, text);
+            rxn->type = RXTYPE_COMBUSTION;
+            break;
+        case 1:
+            snprintf(text, sizeof(text), "C%dH%d", n, 2 * n + 2);
+            reaction_add_reactant(rxn, text);
+            reaction_add_reactant(rxn, "Cl2");
+            snprintf(text, sizeof(text), "C%dH%dCl", n, 2 * n + 1);
+            reaction_add_product(rxn, text);
+            reaction_add_product(rxn, "HCl");
+            rxn->type = RXTYPE_SINGLE_REPLACE;
+            break;
+        case 2:
+            snprintf(text, sizeof(text), "C%dH%d", n + 1, 2 * n + 4);
+            reaction_add_reactant(rxn, text);
+            snprintf(text, sizeof(text), "C%dH%d", n + 1, 2 * n + 2);
+            reaction_add_product(rxn, text);
+            reaction_add_product(rxn, "H2");
+            rxn->type = RXTYPE_DECOMPOSITION;
+            break;
+        default:
+            snprintf(text, sizeof(text), "C%dH%dOH", n, 2 * n + 1);
+            reaction_add_reactant(rxn, text);
+            snprintf(text, sizeof(text), "%dO2", 3 * n);
+            reaction_add_reactant(rxn, text);
+            snprintf(text, sizeof(text), "%dCO2", 2 * n);
+            reaction_add_product(rxn, text);
+            snprintf(text, sizeof(text), "%dH2O", 2 * n + 2);
+            reaction_add_product(rxn, text);
+            rxn->type = RXTYPE_COMBUSTION;
+            break;
+    }
+}
+
+void benchmark_reaction_similarity(void) {
+    Reaction* pool = malloc(REACTION_BENCH_ROWS * sizeof(Reaction));
+    if (!pool) return;
+    for (int i = 0; i < REACTION_BENCH_ROWS; i++) build_synthetic_reaction(&pool[i], i);
+    ReactionDbMark mark;
+    reaction_db_mark(&mark);
+    if (!reaction_db_insert_batch(pool, REACTION_BENCH_ROWS, NULL)) {
+        printf("\nReaction similarity search: insert failed\n");
+        free(pool);
+        return;
+    }
+
+    printf("\nReaction similarity search (%d queries over %d reactions, top %d)\n",
+           REACTION_BENCH_QUERIES, reaction_db_live_count(), REACTION_BENCH_K);
+
+    /* Queries cycle through the synthetic reactions */
+    SimilarityHit hits[REACTION_BENCH_K];
+    double start = parallel_now();
+    long long found = 0;
+    for (int i = 0; i < REACTION_BENCH_QUERIES; i++) {
+        found += reaction_db_similar(&pool[i % REACTION_BENCH_ROWS], REACTION_TYPE_ALL, REACTION_BENCH_K, hits);
+    }
+    print_rate("all types, queries", REACTION_BENCH_QUERIES, parallel_now() - start);
+
+    /* Same-type filter: rows of other types are skipped from the type array */
+    start = parallel_now();
+    for (int i = 0; i < REACTION_BENCH_QUERIES; i++) {
+        const Reaction* query = &pool[i % REACTION_BENCH_ROWS];
+        found += reaction_db_similar(query, REACTION_TYPE_BIT(query->type), REACTION_BENCH_K, hits);
+    }
+    print_rate("same type, queries", REACTION_BENCH_QUERIES, parallel_now() - start);
+    printf("  hits returned: %lld\n", found);
+
+    /* Leave the database as the user had it */
+    if (!reaction_db_rollback(&mark)) printf("  rollback failed\n");
+    free(pool);
+}
+
+/* ============ Network Expansion ============ */
+
+#define NETWORK_BENCH_CHAIN 300     /* Alkanes and alcohols up to C300 */
+#define NETWORK_BENCH_GENERATIONS 3
+
+static const char* const NETWORK_BENCH_REAGENTS[] = {
+    "HCl", "HBr", "HNO3", "H2SO4", "H3PO4", "NaOH", "KOH", "Ca(OH)2", "CuSO4", "AgNO3", "BaCl2"
+};
+
+void benchmark_network_expansion(void) {
+    int reagents = (int)(sizeof(NETWORK_BENCH_REAGENTS) / sizeof(NETWORK_BENCH_REAGENTS[0]));
+    Formula* seeds = malloc((size_t)(NUM_ELEMENTS + 2 * NETWORK_BENCH_CHAIN + reagents) * sizeof(Formula));
+    if (!seeds) return;
+
+    /* Every element in its standard form, fuels, acids, bases and salts */
+    int count = 0;
+    char text[32];
+    for (int i = 0; i < NUM_ELEMENTS; i++) {
+        const Element* el = &PERIODIC_TABLE[i];
+        int z = el->atomic_number;
+        bool diatomic = z == 1 || z == 7 || z == 8 || z == 9 || z == 17 || z == 35 || z == 53;
+        snprintf(text, sizeof(text), diatomic ? "%s2" : "%s", el->symbol);
+        if (formula_parse(text, &seeds[count])) count++;
+    }
+    for (int c = 1; c <= NETWORK_BENCH_CHAIN; c++) {
+        snprintf(text, sizeof(text), "C%dH%d", c, 2 * c + 2);
+        if (formula_parse(text, &seeds[count])) count++;
+        snprintf(text, sizeof(text), "C%dH%dO", c, 2 * c + 2);
+        if (formula_parse(text, &seeds[count])) count++;
+    }
+    for (int i = 0; i < reagents; i++) {
+        if (formula_parse(NETWORK_BENCH_REAGENTS[i], &seeds[count])) count++;
+    }
+
+    printf("\nReaction network expansion (%d seeds, %d generations)\n", count,
+           NETWORK_BENCH_GENERATIONS);
+
+    ReactionNetwork network;
+    network_init(&network);
+    NetworkOptions options;
+    network_options_default(&options);
+    options.max_generations = NETWORK_BENCH_GENERATIONS;
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        options.threads = threads;
+        NetworkStats stats;
+        if (!network_expand(&network, seeds, count, &options, &stats)) break;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), pairs", threads);
+        print_rate(label, stats.pairs, stats.seconds);
+        if (threads == max_threads) {
+            printf("  %d species, %d reactions (%s)\n", network.species_count,
+                   network.reaction_count, network_stop_str(stats.stop));
+            break;
+        }
+    }
+
+    network_free(&network);
+    free(seeds);
+}
+
+/* ============ Kinetics ============ */
+
+#define KINETICS_BENCH_CHAIN 20000  /* Alkanes C1..C20000 */
+#define KINETICS_BENCH_T_END 1000.0
+
+/* Chain growth by methyl addition, its reverse and cracking, k over 8 decades */
+static bool build_alkane_chain(KineticsModel* model, int length, Reaction* rxn) {
+    char a[32], b[32];
+    for (int n = 1; n < length; n++) {
+        snprintf(a, sizeof(a), "C%dH%d", n, 2 * n + 2);
+        snprintf(b, sizeof(b), "C%dH%d", n + 1, 2 * n + 4);
+        double k = pow(10.0, (double)(n % 9) - 2.0);
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, a) || !reaction_add_reactant(rxn, "CH4") ||
+            !reaction_add_product(rxn, b) || !reaction_add_product(rxn, "H2") ||
+            kinetics_add_reaction(model, rxn, k) < 0) return false;
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, b) || !reaction_add_reactant(rxn, "H2") ||
+            !reaction_add_product(rxn, a) || !reaction_add_product(rxn, "CH4") ||
+            kinetics_add_reaction(model, rxn, 0.1 * k) < 0) return false;
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, b) || !reaction_add_product(rxn, a) ||
+            kinetics_add_reaction(model, rxn, 1e-3 / n) < 0) return false;
+    }
+    return true;
+}
+
+void benchmark_kinetics(void) {
+    KineticsModel model;
+    kinetics_model_init(&model);
+    Reaction* rxn = malloc(sizeof(Reaction));
+    if (!rxn || !build_alkane_chain(&model, KINETICS_BENCH_CHAIN, rxn)) {
+        free(rxn);
+        kinetics_model_free(&model);
+        return;
+    }
+    free(rxn);
+
+    double start = parallel_now();
+    kinetics_model_prepare(&model);
+    double prepare = parallel_now() - start;
+    printf("\nMass-action kinetics (%d species, %d reactions, %d LU nonzeros)\n",
+           model.species_count, model.reaction_count, model.lu_nonzeros);
+    print_rate("prepare, species", model.species_count, prepare);
+
+    double* c = calloc((size_t)model.species_count, sizeof(double));
+    if (!c) {
+        kinetics_model_free(&model);
+        return;
+    }
+    for (int i = 0; i < model.species_count; i++) c[i] = 1e-3;
+    c[0] = 1.0;                 /* CH4 feeds the chain */
+
+    KineticsOptions options;
+    kinetics_options_default(&options);
+    KineticsStats stats;
+    start = parallel_now();
+    bool ok = kinetics_simulate(&model, c, KINETICS_BENCH_T_END, &options, NULL, &stats);
+    double seconds = parallel_now() - start;
+    print_rate("ROS2 steps", stats.steps, seconds);
+    print_rate("RHS evaluations", stats.rhs_evaluations, seconds);
+    printf("  %s at t = %g: %lld rejected, %lld Jacobians, %lld factorizations\n",
+           ok ? "reached" : "stopped", stats.time, stats.rejected, stats.jacobians,
+           stats.factorizations);
+
+    free(c);
+    kinetics_model_free(&model);
+}
+
+/* ============ Stochastic Simulation ============ */
+
+#define STOCHASTIC_BENCH_CHAIN 1000
+#define STOCHASTIC_BENCH_TRAJECTORIES 64
+#define STOCHASTIC_BENCH_EVENTS 200000  /* Per trajectory */
+
+/*
+ * Local alkane ladder: C(n) <-> C(n+1) by unimolecular steps and
+ * 2 C(n) -> C(n-1) + C(n+1), so each species feeds a handful of reactions.
+ */
+static bool build_alkane_ladder(KineticsModel* model, int length, Reaction* rxn) {
+    char a[32], b[32], c[32];
+    for (int n = 2; n < length; n++) {
+        snprintf(a, sizeof(a), "C%dH%d", n - 1, 2 * n);
+        snprintf(b, sizeof(b), "C%dH%d", n, 2 * n + 2);
+        snprintf(c, sizeof(c), "C%dH%d", n + 1, 2 * n + 4);
+        double k = pow(10.0, (double)(n % 5) - 2.0);
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, b) || !reaction_add_product(rxn, c) ||
+            kinetics_add_reaction(model, rxn, k) < 0) return false;
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, c) || !reaction_add_product(rxn, b) ||
+            kinetics_add_reaction(model, rxn, 2.0 * k) < 0) return false;
+
+        reaction_init(rxn);
+        if (!reaction_add_reactant(rxn, b) || !reaction_add_reactant(rxn, b) ||
+            !reaction_add_product(rxn, a) || !reaction_add_product(rxn, c) ||
+            kinetics_add_reaction(model, rxn, 1e-4 * k) < 0) return false;
+    }
+    return true;
+}
+
+void benchmark_stochastic(void) {
+    KineticsModel model;
+    kinetics_model_init(&model);
+    Reaction* rxn = malloc(sizeof(Reaction));
+    int64_t* counts = NULL;
+    StochasticSystem system;
+    bool ready = rxn && build_alkane_ladder(&model, STOCHASTIC_BENCH_CHAIN, rxn) &&
+                 stochastic_system_init(&system, &model);
+    free(rxn);
+    if (ready) counts = malloc((size_t)model.species_count * sizeof(int64_t));
+    if (!counts) {
+        if (ready) stochastic_system_free(&system);
+        kinetics_model_free(&model);
+        return;
+    }
+    for (int i = 0; i < model.species_count; i++) counts[i] = 1000;
+
+    printf("\nStochastic simulation (%d species, %d reactions, %d trajectories x %d events)\n",
+           model.species_count, model.reaction_count, STOCHASTIC_BENCH_TRAJECTORIES,
+           STOCHASTIC_BENCH_EVENTS);
+
+    StochasticOptions options;
+    stochastic_options_default(&options);
+    options.t_end = 1e9;
+    options.max_events = STOCHASTIC_BENCH_EVENTS;
+
+    int max_threads = parallel_thread_count(0);
+    for (int threads = 1; ; threads = next_thread_count(threads, max_threads)) {
+        options.threads = threads;
+        StochasticStats stats;
+        if (!stochastic_run_ensemble(&system, counts, STOCHASTIC_BENCH_TRAJECTORIES, &options,
+                                     NULL, &stats)) break;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%d thread(s), events", threads);
+        print_rate(label, stats.events, stats.seconds);
+        if (threads == max_threads) break;
+    }
+
+    free(counts);
+    stochastic_system_free(&system);
+    kinetics_model_free(&model);
+}
+
+/* ============ Thermochemistry ============ */
+
+#define THERMO_BENCH_CHAIN 5000     /* Alkanes C5..C5004 with unknown data */
+#define THERMO_BENCH_RANKS 1000
+
+/* Group-additivity style ground truth for the synthetic alkanes */
+static double alkane_enthalpy(int n) { return -20.63 * n - 43.26; }
+static double alkane_entropy(int n) { return 38.9 * n + 115.0; }
+
+void benchmark_thermochemistry(void) {
+    int count = 2 * THERMO_BENCH_CHAIN;
+    Reaction* reactions = malloc((size_t)count * sizeof(Reaction));
+    const Reaction** pointers = malloc((size_t)count * sizeof(Reaction*));
+    double* measured = malloc((size_t)count * sizeof(double));
+    int* order = malloc((size_t)count * sizeof(int));
+    if (!reactions || !pointers || !measured || !order) {
+        free(reactions);
+        free(pointers);
+        free(measured);
+        free(order);
+        return;
+    }
+
+    /* Combustion and methyl addition of each alkane, with +-0.5 kJ/mol noise */
+    char text[32];
+    unsigned int seed = 12345u;
+    for (int i = 0; i < THERMO_BENCH_CHAIN; i++) {
+        int n = i + 5;
+        Reaction* burn = &reactions[2 * i];
+        reaction_init(burn);
+        snprintf(text, sizeof(text), "2C%dH%d", n, 2 * n + 2);
+        reaction_add_reactant(burn, text);
+        snprintf(text, sizeof(text), "%dO2", 3 * n + 1);
+        reaction_add_reactant(burn, text);
+        snprintf(text, sizeof(text), "%dCO2", 2 * n);
+        reaction_add_product(burn, text);
+        snprintf(text, sizeof(text), "%dH2O", 2 * n + 2);
+        reaction_add_product(burn, text);
+
+        Reaction* grow = &reactions[2 * i + 1];
+        reaction_init(grow);
+        snprintf(text, sizeof(text), "C%dH%d", n, 2 * n + 2);
+        reaction_add_reactant(grow, text);
+        reaction_add_reactant(grow, "CH4");
+        snprintf(text, sizeof(text), "C%dH%d", n + 1, 2 * n + 4);
+        reaction_add_product(grow, text);
+        reaction_add_product(grow, "H2");
+
+        double noise[2];
+        for (int k = 0; k < 2; k++) {
+            seed = seed * 1103515245u + 12345u;
+            noise[k] = ((seed >> 8) & 0xFFFF) / 65535.0 - 0.5;
+        }
+        measured[2 * i] = 2 * n * -393.51 + (2 * n + 2) * -285.83 - 2 * alkane_enthalpy(n) + noise[0];
+        measured[2 * i + 1] = alkane_enthalpy(n + 1) - alkane_enthalpy(n) + 74.87 + noise[1];
+        pointers[2 * i] = &reactions[2 * i];
+        pointers[2 * i + 1] = &reactions[2 * i + 1];
+    }
+
+    printf("\nThermochemistry (%d reactions, Hess's law fit of %d+ species)\n", count,
+           THERMO_BENCH_CHAIN);
+
+    /* The fitted species are only lent to the table for the energetics pass */
+    int table_count = thermo_species_count();
+    HessFit fit;
+    thermo_fit_init(&fit);
+    double start = parallel_now();
+    bool ok = thermo_fit_enthalpies(&fit, pointers, measured, count);
+    print_rate("Hess fit, species", fit.count, parallel_now() - start);
+
+    if (ok) {
+        double worst = 0.0;
+        for (int i = 0; i < fit.count; i++) {
+            int carbons = fit.species[i].elements[0].count;
+            double error = fabs(fit.enthalpies[i] - alkane_enthalpy(carbons));
+            if (error > worst) worst = error;
+            if (!thermo_species_get(&fit.species[i], NULL)) {
+                thermo_species_set(&fit.species[i], fit.enthalpies[i], alkane_entropy(carbons));
+            }
+        }
+        printf("  %d equations, %d iterations, rms residual %.3f, max error %.3f kJ/mol\n",
+               fit.equations, fit.iterations, fit.rms_residual, worst);
+
+        start = parallel_now();
+        for (int i = 0; i < count; i++) thermo_reaction(&reactions[i], &reactions[i].energetics);
+        print_rate("energetics, reactions", count, parallel_now() - start);
+
+        /* Ranking only reads the cached values */
+        start = parallel_now();
+        long long kept = 0;
+        for (int r = 0; r < THERMO_BENCH_RANKS; r++) kept += thermo_rank(pointers, count, 0.0, order);
+        print_rate("rank by Delta G, reactions", (long long)count * THERMO_BENCH_RANKS, parallel_now() - start);
+        printf("  %lld favorable per pass\n", kept / THERMO_BENCH_RANKS);
+    }
+
+    thermo_species_truncate(table_count);
+    thermo_fit_free(&fit);
+    free(reactions);
+    free(pointers);
+    free(measured);
+    free(order);
+}
+
+/* ============ Live Database Updates ============ */
+
+#define LIVE_BENCH_ROWS 4096        /* Reactions inserted before measuring */
+#define LIVE_BENCH_QUERIES 2000     /* Per reader */
+#define LIVE_BENCH_WRITES 1000
+#define LIVE_BENCH_WINDOW 32        /* Writer removes each insert this many writes later */
+
+typedef struct {
+    double* latencies;
+    int count;
+    bool failed;
+    char padding[64];
+} LiveWorker;
+
+typedef struct {
+    LiveWorker* workers;
+    const Reaction* pool;
+    int pool_count;
+    bool writing;
+    long long writes;
+} LiveBench;
+
+/* Index 0 writes (when enabled), every other index reads */
+static void live_bench_range(int begin, int end, int thread_index, void* user_data) {
+    (void)thread_index;
+    LiveBench* bench = user_data;
+
+    for (int role = begin; role < end; role++) {
+        LiveWorker* w = &bench->workers[role];
+        if (role > 0) {
+            SimilarityHit hits[REACTION_BENCH_K];
+            for (int q = 0; q < LIVE_BENCH_QUERIES; q++) {
+                const Reaction* query = &bench->pool[(q * 7 + role) % bench->pool_count];
+                double start = parallel_now();
+                if (reaction_db_similar(query, REACTION_TYPE_ALL, REACTION_BENCH_K, hits) < 0) {
+                    w->failed = true;
+                }
+                w->latencies[w->count++] = parallel_now() - start;
+            }
+            continue;
+        }
+        if (!bench->writing) continue;
+
+        int window[LIVE_BENCH_WINDOW];
+        for (int i = 0; i < LIVE_BENCH_WRITES; i++) {
+            int slot = i % LIVE_BENCH_WINDOW;
+            if (i >= LIVE_BENCH_WINDOW && !reaction_db_remove(window[slot])) w->failed = true;
+            window[slot] = reaction_db_insert(&bench->pool[i % bench->pool_count]);
+            if (window[slot] < 0) w->failed = true;
+            bench->writes += 2;
+        }
+        for (int i = 0; i < LIVE_BENCH_WINDOW && i < LIVE_BENCH_WRITES; i++) {
+            reaction_db_remove(window[i]);
+        }
+    }
+}
+
+static int compare_latency(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_latencies(const char* label, LiveBench* bench, int readers, double* merged) {
+    int n = 0;
+    for (int r = 1; r <= readers; r++) {
+        memcpy(&merged[n], bench->workers[r].latencies, (size_t)bench->workers[r].count * sizeof(double));
+        n += bench->workers[r].count;
+    }
+    qsort(merged, (size_t)n, sizeof(double), compare_latency);
+    printf("  %-28s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", label,
+           merged[n / 2] * 1e6, merged[(int)(n * 0.99)] * 1e6, merged[n - 1] * 1e6);
+}
+
+static void live_bench_run(Reaction* pool, int* indices, LiveWorker* workers, int threads,
+                           double* merged) {
+    int readers = threads - 1;
+    for (int i = 0; i < LIVE_BENCH_ROWS; i++) build_synthetic_reaction(&pool[i], i);
+
+    printf("\nLive database updates (%d reactions, %d reader(s) x %d similarity queries)\n",
+           LIVE_BENCH_ROWS, readers, LIVE_BENCH_QUERIES);
+
+    ReactionDbMark mark;
+    reaction_db_mark(&mark);
+    double start = parallel_now();
+    if (!reaction_db_insert_batch(pool, LIVE_BENCH_ROWS, indices)) {
+        printf("  insert failed\n");
+        return;
+    }
+    print_rate("batch insert, reactions", LIVE_BENCH_ROWS, parallel_now() - start);
+
+    LiveBench bench = {workers, pool, LIVE_BENCH_ROWS, false, 0};
+    bool failed = false;
+    for (int pass = 0; pass < 2; pass++) {
+        bench.writing = pass == 1;
+        bench.writes = 0;
+        for (int r = 0; r < threads; r++) workers[r].count = 0;
+
+        start = parallel_now();
+        parallel_for(threads, 1, threads, live_bench_range, &bench);
+        double seconds = parallel_now() - start;
+
+        print_latencies(bench.writing ? "queries, writer active" : "queries, no writer",
+                        &bench, readers, merged);
+        if (bench.writing) print_rate("inserts + removes", bench.writes, seconds);
+        for (int r = 0; r < threads; r++) failed = failed || workers[r].failed;
+    }
+    if (failed) printf("  some operations failed\n");
+
+    start = parallel_now();
+    for (int i = 0; i < LIVE_BENCH_ROWS; i++) reaction_db_remove(indices[i]);
+    print_rate("single removes", LIVE_BENCH_ROWS, parallel_now() - start);
+
+    /* Drop the tombstones and the writer's rows: leave the database as the user had it */
+    if (!reaction_db_rollback(&mark)) printf("  rollback failed\n");
+}
+
+void benchmark_live_updates(void) {
+    /* At least one reader beside the writer, even on one CPU */
+    int threads = parallel_thread_count(0);
+    if (threads < 2) threads = 2;
+
+    Reaction* pool = malloc(LIVE_BENCH_ROWS * sizeof(Reaction));
+    int* indices = malloc(LIVE_BENCH_ROWS * sizeof(int));
+    LiveWorker* workers = calloc((size_t)threads, sizeof(LiveWorker));
+    double* merged = malloc((size_t)(threads - 1) * LIVE_BENCH_QUERIES * sizeof(double));
+    bool ok = pool && indices && workers && merged;
+    for (int r = 1; ok && r < threads; r++) {
+        workers[r].latencies = malloc(LIVE_BENCH_QUERIES * sizeof(double));
+        ok = workers[r].latencies != NULL;
+    }
+    if (ok) live_bench_run(pool, indices, workers, threads, merged);
+
+    for (int r = 0; workers && r < threads; r++) free(workers[r].latencies);
+    free(workers);
+    free(merged);
+    free(indices);
+    free(pool);
+}
+
+void benchmark_run_all(void) {
+    printf("Running benchmarks on %d CPU(s)\n", parallel_thread_count(0));
+    benchmark_ionic_enumeration();
+    benchmark_mass_decomposition();
+    benchmark_isotope_pattern();
+    benchmark_molecule_pool();
+    benchmark_smiles_parsing();
+    benchmark_canonical_dedupe();
+    benchmark_substructure_search();
+    benchmark_similarity_search();
+    benchmark_validation();
+    benchmark_ring_perception();
+    benchmark_forcefield();
+    benchmark_descriptors();
+    benchmark_atom_mapping();
+    benchmark_reaction_similarity();
+    benchmark_network_expansion();
+    benchmark_kinetics();
+    benchmark_stochastic();
+    benchmark_thermochemistry();
+    benchmark_live_updates();
+}
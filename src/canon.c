@@ -0,0 +1,811 @@
+#include "canon.h"
+#include "smiles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RING_DIGITS 100
+
+/* Per-bond flags from aromaticity perception */
+#define BOND_FLAG_RING 1
+#define BOND_FLAG_AROMATIC 2
+
+/* Bond codes used in neighbor keys: 1-3 bond order, 4 aromatic */
+static int bond_code(BondType type) {
+    switch (type) {
+        case BOND_DOUBLE: return 2;
+        case BOND_TRIPLE: return 3;
+        case BOND_AROMATIC: return 4;
+        default: return 1;
+    }
+}
+
+/* ============ Context ============ */
+
+void canon_context_init(CanonContext* ctx) {
+    if (!ctx) return;
+    memset(ctx, 0, sizeof(*ctx));
+    ring_context_init(&ctx->sssr);
+}
+
+void canon_context_free(CanonContext* ctx) {
+    if (!ctx) return;
+    free(ctx->compact);
+    free(ctx->atoms);
+    free(ctx->hydrogens);
+    free(ctx->invariants);
+    free(ctx->offsets);
+    free(ctx->neighbors);
+    free(ctx->bond_codes);
+    free(ctx->keys);
+    free(ctx->ranks);
+    free(ctx->order);
+    free(ctx->scratch);
+    free(ctx->stack);
+    free(ctx->rings);
+    free(ctx->ring_offsets);
+    free(ctx->ring_lists);
+    free(ctx->aromatic);
+    free(ctx->bond_flags);
+    ring_context_free(&ctx->sssr);
+    canon_context_init(ctx);
+}
+
+static bool grow(void** array, size_t count, size_t item) {
+    void* p = realloc(*array, count * item);
+    if (!p) return false;
+    *array = p;
+    return true;
+}
+
+static bool context_reserve(CanonContext* ctx, int atoms, int edges) {
+    if (atoms > ctx->capacity) {
+        int cap = ctx->capacity < 64 ? 64 : ctx->capacity;
+        while (cap < atoms) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->compact, n, sizeof(int)) ||
+            !grow((void**)&ctx->atoms, n, sizeof(int)) ||
+            !grow((void**)&ctx->hydrogens, n, sizeof(int)) ||
+            !grow((void**)&ctx->invariants, n, sizeof(uint64_t)) ||
+            !grow((void**)&ctx->offsets, n, sizeof(int)) ||
+            !grow((void**)&ctx->ranks, n, sizeof(int)) ||
+            !grow((void**)&ctx->order, n, sizeof(int)) ||
+            !grow((void**)&ctx->scratch, n, sizeof(int)) ||
+            !grow((void**)&ctx->stack, 4 * n, sizeof(int)) ||
+            !grow((void**)&ctx->ring_offsets, 2 * n + 2, sizeof(int)) ||
+            !grow((void**)&ctx->aromatic, n, sizeof(unsigned char))) {
+            return false;
+        }
+        ctx->capacity = cap;
+    }
+    if (edges > ctx->edge_capacity) {
+        int cap = ctx->edge_capacity < 128 ? 128 : ctx->edge_capacity;
+        while (cap < edges) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->neighbors, n, sizeof(int)) ||
+            !grow((void**)&ctx->bond_codes, n, sizeof(int)) ||
+            !grow((void**)&ctx->keys, n, sizeof(int)) ||
+            !grow((void**)&ctx->rings, 2 * n, sizeof(int)) ||
+            !grow((void**)&ctx->ring_lists, n, sizeof(int)) ||
+            !grow((void**)&ctx->bond_flags, n, sizeof(unsigned char))) {
+            return false;
+        }
+        ctx->edge_capacity = cap;
+    }
+    return true;
+}
+
+/* Plain hydrogen singly bonded to a non-hydrogen */
+static bool foldable_hydrogen(const Molecule* mol, int atom) {
+    const Atom* a = &mol->atoms[atom];
+    if (a->element->atomic_number != 1 || a->isotope != 0 || a->charge != 0) return false;
+
+    const int* neighbors;
+    const int* bonds;
+    if (molecule_neighbors(mol, atom, &neighbors, &bonds) != 1) return false;
+    return mol->atoms[neighbors[0]].element->atomic_number != 1 &&
+           mol->bonds[bonds[0]].type == BOND_SINGLE;
+}
+
+/* ============ Aromaticity ============ */
+
+/* Pi electrons an atom gives a ring (see canon.h), -1 if it cannot be aromatic */
+static int pi_electrons(const CanonContext* ctx, const Molecule* mol, int atom) {
+    const Atom* a = &mol->atoms[atom];
+    const int* bonds;
+    int degree = molecule_neighbors(mol, atom, NULL, &bonds);
+
+    bool ring_double = false, exocyclic_double = false;
+    for (int j = 0; j < degree; j++) {
+        if (mol->bonds[bonds[j]].type != BOND_DOUBLE) continue;
+        if (ctx->bond_flags[bonds[j]] & BOND_FLAG_RING) ring_double = true;
+        else exocyclic_double = true;
+    }
+    if (ring_double) return 1;
+    if (exocyclic_double) return 0;
+
+    int z = a->element->atomic_number;
+    int connections = degree + a->hydrogens;
+    if (a->charge == 0 && (((z == 7 || z == 15) && connections == 3) ||
+                           ((z == 8 || z == 16 || z == 34) && connections == 2))) {
+        return 2;
+    }
+    if (z == 6 && connections == 3 && a->charge == -1) return 2;
+    if (connections == 3 && ((z == 6 && a->charge == 1) || (z == 5 && a->charge == 0))) return 0;
+    return a->aromatic ? 1 : -1;
+}
+
+/* Aromatic flags for every atom and bond: the input's marks plus 4n + 2 SSSR rings */
+static bool perceive_aromaticity(CanonContext* ctx, const Molecule* mol) {
+    bool kekule = false;
+    for (int i = 0; i < mol->atom_count; i++) ctx->aromatic[i] = mol->atoms[i].aromatic;
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        ctx->bond_flags[b] = bond->type == BOND_AROMATIC ? BOND_FLAG_AROMATIC : 0;
+        if (bond->type == BOND_DOUBLE &&
+            molecule_neighbors(mol, bond->atom1_id, NULL, NULL) > 1 &&
+            molecule_neighbors(mol, bond->atom2_id, NULL, NULL) > 1) {
+            kekule = true;
+        }
+    }
+    /* Only a double bond that can lie in a ring makes a ring the input did not mark */
+    if (!kekule) return true;
+
+    const RingContext* rings = &ctx->sssr;
+    if (!ring_find(&ctx->sssr, mol)) return false;
+    int total = rings->ring_count > 0 ? rings->ring_offsets[rings->ring_count] : 0;
+    for (int i = 0; i < total; i++) ctx->bond_flags[rings->ring_bonds[i]] |= BOND_FLAG_RING;
+
+    for (int r = 0; r < rings->ring_count; r++) {
+        int begin = rings->ring_offsets[r], end = rings->ring_offsets[r + 1];
+        int electrons = 0;
+        for (int i = begin; i < end && electrons >= 0; i++) {
+            int e = pi_electrons(ctx, mol, rings->ring_atoms[i]);
+            electrons = e < 0 ? -1 : electrons + e;
+        }
+        if (electrons < 0 || electrons % 4 != 2) continue;
+        for (int i = begin; i < end; i++) {
+            ctx->aromatic[rings->ring_atoms[i]] = 1;
+            ctx->bond_flags[rings->ring_bonds[i]] |= BOND_FLAG_AROMATIC;
+        }
+    }
+    return true;
+}
+
+/* ============ Preparation ============ */
+
+/* Fold hydrogens and build the kept-atom graph with invariants */
+static bool prepare(CanonContext* ctx, const Molecule* mol) {
+    if (!mol || !mol->adjacency_valid) return false;
+
+    int n = mol->atom_count;
+    if (!context_reserve(ctx, n, 2 * mol->bond_count)) return false;
+    if (!perceive_aromaticity(ctx, mol)) return false;
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (foldable_hydrogen(mol, i)) {
+            ctx->compact[i] = -1;
+        } else {
+            ctx->atoms[kept] = i;
+            ctx->hydrogens[kept] = mol->atoms[i].hydrogens;
+            ctx->compact[i] = kept++;
+        }
+    }
+    ctx->kept = kept;
+
+    for (int i = 0; i < n; i++) {
+        if (ctx->compact[i] < 0) {
+            const int* neighbors;
+            molecule_neighbors(mol, i, &neighbors, NULL);
+            ctx->hydrogens[ctx->compact[neighbors[0]]]++;
+        }
+    }
+
+    int edge = 0;
+    for (int k = 0; k < kept; k++) {
+        const int* neighbors;
+        const int* bonds;
+        int degree = molecule_neighbors(mol, ctx->atoms[k], &neighbors, &bonds);
+
+        ctx->offsets[k] = edge;
+        for (int j = 0; j < degree; j++) {
+            int c = ctx->compact[neighbors[j]];
+            if (c < 0) continue;
+            ctx->neighbors[edge] = c;
+            ctx->bond_codes[edge++] = (ctx->bond_flags[bonds[j]] & BOND_FLAG_AROMATIC)
+                                      ? 4 : bond_code(mol->bonds[bonds[j]].type);
+        }
+
+        const Atom* atom = &mol->atoms[ctx->atoms[k]];
+        bool aromatic = ctx->aromatic[ctx->atoms[k]];
+        uint64_t heavy_degree = (uint64_t)(edge - ctx->offsets[k]);
+        ctx->invariants[k] = ((uint64_t)atom->element->atomic_number << 50) |
+                             ((uint64_t)(atom->isotope & 0xFFF) << 38) |
+                             ((uint64_t)((atom->charge + 128) & 0xFF) << 30) |
+                             ((uint64_t)(ctx->hydrogens[k] & 0xFF) << 22) |
+                             ((heavy_degree & 0xFF) << 14) |
+                             ((uint64_t)(aromatic ? 1 : 0) << 13);
+    }
+    ctx->offsets[kept] = edge;
+    return true;
+}
+
+/* ============ Ranking ============ */
+
+typedef int (*AtomCompareFn)(const CanonContext* ctx, int a, int b);
+
+static int compare_invariants(const CanonContext* ctx, int a, int b) {
+    uint64_t x = ctx->invariants[a], y = ctx->invariants[b];
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Current rank, then sorted neighbor keys */
+static int compare_refined(const CanonContext* ctx, int a, int b) {
+    if (ctx->ranks[a] != ctx->ranks[b]) return ctx->ranks[a] < ctx->ranks[b] ? -1 : 1;
+
+    int ia = ctx->offsets[a], ea = ctx->offsets[a + 1];
+    int ib = ctx->offsets[b], eb = ctx->offsets[b + 1];
+    for (; ia < ea && ib < eb; ia++, ib++) {
+        if (ctx->keys[ia] != ctx->keys[ib]) return ctx->keys[ia] < ctx->keys[ib] ? -1 : 1;
+    }
+    return (ea - ia) - (eb - ib);
+}
+
+/* Stable sort of order[lo, hi): insertion for short runs, else bottom-up merge */
+static void sort_range(CanonContext* ctx, int lo, int hi, AtomCompareFn compare) {
+    int* order = ctx->order;
+    if (hi - lo <= 16) {
+        for (int i = lo + 1; i < hi; i++) {
+            int atom = order[i];
+            int j = i;
+            while (j > lo && compare(ctx, atom, order[j - 1]) < 0) {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = atom;
+        }
+        return;
+    }
+
+    int* src = order + lo;
+    int* dst = ctx->scratch + lo;
+    int n = hi - lo;
+    for (int width = 1; width < n; width *= 2) {
+        for (int start = 0; start < n; start += 2 * width) {
+            int mid = start + width < n ? start + width : n;
+            int end = start + 2 * width < n ? start + 2 * width : n;
+            int i = start, j = mid, k = start;
+            while (i < mid && j < end) {
+                dst[k++] = compare(ctx, src[j], src[i]) < 0 ? src[j++] : src[i++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < end) dst[k++] = src[j++];
+        }
+        int* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != order + lo) memcpy(order + lo, src, n * sizeof(int));
+}
+
+/* End of the class starting at position i of order */
+static int class_end(const CanonContext* ctx, int i) {
+    int rank = ctx->ranks[ctx->order[i]];
+    int j = i + 1;
+    while (j < ctx->kept && ctx->ranks[ctx->order[j]] == rank) j++;
+    return j;
+}
+
+/*
+ * Rank = position of the first atom of its class in order, for the
+ * positions [lo, hi). Returns the number of classes found there.
+ */
+static int assign_ranks(CanonContext* ctx, int lo, int hi, AtomCompareFn compare) {
+    int classes = 0;
+    int start = lo;
+    for (int i = lo; i < hi; i++) {
+        if (i == lo || compare(ctx, ctx->order[i - 1], ctx->order[i]) != 0) {
+            start = i;
+            classes++;
+        }
+        ctx->scratch[i] = start;
+    }
+    for (int i = lo; i < hi; i++) ctx->ranks[ctx->order[i]] = ctx->scratch[i];
+    return classes;
+}
+
+/* Neighbor keys (rank, bond code) of one atom, sorted */
+static void build_neighbor_keys(CanonContext* ctx, int a) {
+    int begin = ctx->offsets[a], end = ctx->offsets[a + 1];
+    for (int e = begin; e < end; e++) {
+        int key = ctx->ranks[ctx->neighbors[e]] * 8 + ctx->bond_codes[e];
+        int j = e;
+        while (j > begin && ctx->keys[j - 1] > key) {
+            ctx->keys[j] = ctx->keys[j - 1];
+            j--;
+        }
+        ctx->keys[j] = key;
+    }
+}
+
+/*
+ * Split classes by neighbor ranks until stable. Only classes with more
+ * than one member are re-keyed and re-sorted; keys are computed from the
+ * ranks at the start of each round before any class is split.
+ */
+static int refine(CanonContext* ctx, int classes) {
+    while (classes < ctx->kept) {
+        for (int i = 0; i < ctx->kept; ) {
+            int j = class_end(ctx, i);
+            if (j - i > 1) {
+                for (int k = i; k < j; k++) build_neighbor_keys(ctx, ctx->order[k]);
+            }
+            i = j;
+        }
+
+        int refined = 0;
+        for (int i = 0; i < ctx->kept; ) {
+            int j = class_end(ctx, i);
+            if (j - i > 1) {
+                sort_range(ctx, i, j, compare_refined);
+                refined += assign_ranks(ctx, i, j, compare_refined);
+            } else {
+                refined++;
+            }
+            i = j;
+        }
+
+        if (refined == classes) break;
+        classes = refined;
+    }
+    return classes;
+}
+
+static void canonicalize(CanonContext* ctx) {
+    for (int i = 0; i < ctx->kept; i++) ctx->order[i] = i;
+    sort_range(ctx, 0, ctx->kept, compare_invariants);
+    int classes = refine(ctx, assign_ranks(ctx, 0, ctx->kept, compare_invariants));
+
+    /* Break the lowest tied class by promoting all but its first member */
+    while (classes < ctx->kept) {
+        int i = 0;
+        while (ctx->ranks[ctx->order[i]] != ctx->ranks[ctx->order[i + 1]]) i++;
+
+        int r = ctx->ranks[ctx->order[i]];
+        for (int j = i + 1; j < ctx->kept && ctx->ranks[ctx->order[j]] == r; j++) {
+            ctx->ranks[ctx->order[j]] = r + 1;
+        }
+        classes = refine(ctx, classes + 1);
+    }
+
+    /* order[r] is now the atom of rank r */
+    for (int k = 0; k < ctx->kept; k++) ctx->order[ctx->ranks[k]] = k;
+}
+
+bool canon_ranks(CanonContext* ctx, const Molecule* mol, int* ranks) {
+    if (!ctx || !ranks || !prepare(ctx, mol)) return false;
+    canonicalize(ctx);
+
+    /* Folded hydrogens after all kept atoms, grouped by neighbor rank */
+    int next = ctx->kept;
+    for (int r = 0; r < ctx->kept; r++) {
+        int k = ctx->order[r];
+        ctx->scratch[r] = next;
+        next += ctx->hydrogens[k] - mol->atoms[ctx->atoms[k]].hydrogens;
+    }
+    for (int i = 0; i < mol->atom_count; i++) {
+        int c = ctx->compact[i];
+        if (c >= 0) {
+            ranks[i] = ctx->ranks[c];
+        } else {
+            const int* neighbors;
+            molecule_neighbors(mol, i, &neighbors, NULL);
+            ranks[i] = ctx->scratch[ctx->ranks[ctx->compact[neighbors[0]]]]++;
+        }
+    }
+    return true;
+}
+
+/* ============ Hash ============ */
+
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static void hash_feed(CanonHash* h, uint64_t value) {
+    h->lo = mix64(h->lo ^ value);
+    h->hi = mix64(h->hi ^ (value * 0xC2B2AE3D27D4EB4FULL + 0x165667B19E3779F9ULL));
+}
+
+bool canon_hash(CanonContext* ctx, const Molecule* mol, CanonHash* hash) {
+    if (!ctx || !hash || !prepare(ctx, mol)) return false;
+    canonicalize(ctx);
+    for (int a = 0; a < ctx->kept; a++) build_neighbor_keys(ctx, a);
+
+    CanonHash h = {0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL};
+    hash_feed(&h, (uint64_t)ctx->kept);
+    for (int r = 0; r < ctx->kept; r++) hash_feed(&h, ctx->invariants[ctx->order[r]]);
+
+    /* Each edge once, from its lower-ranked end, in canonical order */
+    for (int r = 0; r < ctx->kept; r++) {
+        int a = ctx->order[r];
+        for (int e = ctx->offsets[a]; e < ctx->offsets[a + 1]; e++) {
+            if (ctx->keys[e] / 8 > r) {
+                hash_feed(&h, ((uint64_t)r << 32) | (uint64_t)ctx->keys[e]);
+            }
+        }
+    }
+
+    *hash = h;
+    return true;
+}
+
+bool canon_hash_equals(const CanonHash* a, const CanonHash* b) {
+    return a && b && a->hi == b->hi && a->lo == b->lo;
+}
+
+/* ============ SMILES Writer ============ */
+
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t length;
+    bool ok;
+} Output;
+
+static void out_text(Output* out, const char* text) {
+    size_t n = strlen(text);
+    if (!out->ok || out->length + n >= out->size) {
+        out->ok = false;
+        return;
+    }
+    memcpy(out->buffer + out->length, text, n + 1);
+    out->length += n;
+}
+
+static void out_char(Output* out, char c) {
+    char text[2] = {c, '\0'};
+    out_text(out, text);
+}
+
+static bool organic_subset(const Atom* atom) {
+    switch (atom->element->atomic_number) {
+        case 5: case 6: case 7: case 8: case 15: case 16:
+            return true;
+        case 9: case 17: case 35: case 53:
+            return !atom->aromatic;
+        default:
+            return false;
+    }
+}
+
+static void write_atom(Output* out, const CanonContext* ctx, const Molecule* mol, int k) {
+    /* The atom as perceived: a Kekule ring atom is written aromatic */
+    Atom perceived = mol->atoms[ctx->atoms[k]];
+    perceived.aromatic = ctx->aromatic[ctx->atoms[k]];
+    const Atom* atom = &perceived;
+    int hydrogens = ctx->hydrogens[k];
+
+    int bond_sum = 0;
+    for (int e = ctx->offsets[k]; e < ctx->offsets[k + 1]; e++) {
+        bond_sum += ctx->bond_codes[e] == 4 ? 1 : ctx->bond_codes[e];
+    }
+
+    char symbol[4];
+    snprintf(symbol, sizeof(symbol), "%s", atom->element->symbol);
+    if (atom->aromatic) symbol[0] = (char)(symbol[0] - 'A' + 'a');
+
+    if (organic_subset(atom) && atom->isotope == 0 && atom->charge == 0 &&
+        molecule_default_hydrogens(atom, bond_sum) == hydrogens) {
+        out_text(out, symbol);
+        return;
+    }
+
+    char text[32];
+    int n = snprintf(text, sizeof(text), "[");
+    if (atom->isotope > 0) n += snprintf(text + n, sizeof(text) - n, "%d", atom->isotope);
+    n += snprintf(text + n, sizeof(text) - n, "%s", symbol);
+    if (hydrogens == 1) n += snprintf(text + n, sizeof(text) - n, "H");
+    else if (hydrogens > 1) n += snprintf(text + n, sizeof(text) - n, "H%d", hydrogens);
+    if (atom->charge == 1) n += snprintf(text + n, sizeof(text) - n, "+");
+    else if (atom->charge == -1) n += snprintf(text + n, sizeof(text) - n, "-");
+    else if (atom->charge != 0) n += snprintf(text + n, sizeof(text) - n, "%+d", atom->charge);
+    snprintf(text + n, sizeof(text) - n, "]");
+    out_text(out, text);
+}
+
+static void write_bond(Output* out, const CanonContext* ctx,
+                       int a, int b, int code) {
+    bool aromatic = ctx->aromatic[ctx->atoms[a]] && ctx->aromatic[ctx->atoms[b]];
+    switch (code) {
+        case 1: if (aromatic) out_char(out, '-'); break;
+        case 2: out_char(out, '='); break;
+        case 3: out_char(out, '#'); break;
+        case 4: if (!aromatic) out_char(out, ':'); break;
+    }
+}
+
+static void write_ring_digit(Output* out, int digit) {
+    char text[16];
+    if (digit < 10) snprintf(text, sizeof(text), "%d", digit);
+    else snprintf(text, sizeof(text), "%%%02d", digit);
+    out_text(out, text);
+}
+
+/* Order each atom's neighbors by canonical rank */
+static void sort_neighbors_by_rank(CanonContext* ctx) {
+    for (int a = 0; a < ctx->kept; a++) {
+        int begin = ctx->offsets[a], end = ctx->offsets[a + 1];
+        for (int e = begin + 1; e < end; e++) {
+            int nb = ctx->neighbors[e], code = ctx->bond_codes[e];
+            int j = e;
+            while (j > begin && ctx->ranks[ctx->neighbors[j - 1]] > ctx->ranks[nb]) {
+                ctx->neighbors[j] = ctx->neighbors[j - 1];
+                ctx->bond_codes[j] = ctx->bond_codes[j - 1];
+                j--;
+            }
+            ctx->neighbors[j] = nb;
+            ctx->bond_codes[j] = code;
+        }
+    }
+}
+
+/*
+ * Pass 1: depth-first search from the lowest-ranked atom of each
+ * component, visiting neighbors in rank order. Tree edges are marked in
+ * keys (1); back edges become ring closures opened at the earlier atom.
+ * Returns the ring count.
+ */
+static int find_rings(CanonContext* ctx) {
+    int* visit = ctx->scratch;
+    int* stack = ctx->stack;
+    int rings = 0;
+    int time = 0;
+
+    for (int k = 0; k < ctx->kept; k++) visit[k] = -1;
+    for (int e = 0; e < ctx->offsets[ctx->kept]; e++) ctx->keys[e] = 0;
+
+    for (int r = 0; r < ctx->kept; r++) {
+        int root = ctx->order[r];
+        if (visit[root] >= 0) continue;
+
+        /* Frame: atom, parent, next edge */
+        int top = 0;
+        visit[root] = time++;
+        stack[0] = root;
+        stack[1] = -1;
+        stack[2] = ctx->offsets[root];
+
+        while (top >= 0) {
+            int* frame = &stack[3 * top];
+            int a = frame[0];
+            if (frame[2] == ctx->offsets[a + 1]) {
+                top--;
+                continue;
+            }
+
+            int e = frame[2]++;
+            int b = ctx->neighbors[e];
+            if (b == frame[1]) {
+                frame[1] = -2;          /* Skip the tree edge to the parent once */
+            } else if (visit[b] < 0) {
+                ctx->keys[e] = 1;
+                visit[b] = time++;
+                top++;
+                stack[3 * top] = b;
+                stack[3 * top + 1] = a;
+                stack[3 * top + 2] = ctx->offsets[b];
+            } else if (visit[b] < visit[a]) {
+                int* ring = &ctx->rings[4 * rings++];
+                ring[0] = b;
+                ring[1] = a;
+                ring[2] = ctx->bond_codes[e];
+                ring[3] = 0;
+            }
+        }
+    }
+    return rings;
+}
+
+/* Per-atom lists of rings opening (first half) and closing (second half) */
+static void index_rings(CanonContext* ctx, int rings) {
+    int n = ctx->kept;
+    int* opens = ctx->ring_offsets;
+    int* closes = ctx->ring_offsets + n + 1;
+
+    memset(ctx->ring_offsets, 0, (2 * (size_t)n + 2) * sizeof(int));
+    for (int i = 0; i < rings; i++) {
+        opens[ctx->rings[4 * i] + 1]++;
+        closes[ctx->rings[4 * i + 1] + 1]++;
+    }
+    for (int k = 0; k < n; k++) {
+        opens[k + 1] += opens[k];
+        closes[k + 1] += closes[k];
+    }
+
+    /* Opening lists fill [0, rings), closing lists [rings, 2 * rings) */
+    int* fill = ctx->scratch;
+    for (int k = 0; k < n; k++) fill[k] = opens[k];
+    for (int i = 0; i < rings; i++) ctx->ring_lists[fill[ctx->rings[4 * i]]++] = i;
+    for (int k = 0; k < n; k++) fill[k] = rings + closes[k];
+    for (int i = 0; i < rings; i++) ctx->ring_lists[fill[ctx->rings[4 * i + 1]]++] = i;
+}
+
+static bool write_ring_marks(Output* out, CanonContext* ctx,
+                             int a, int rings, bool* digits_used) {
+    int n = ctx->kept;
+    const int* opens = ctx->ring_offsets;
+    const int* closes = ctx->ring_offsets + n + 1;
+
+    for (int i = opens[a]; i < opens[a + 1]; i++) {
+        int* ring = &ctx->rings[4 * ctx->ring_lists[i]];
+        int digit = 1;
+        while (digit < MAX_RING_DIGITS && digits_used[digit]) digit++;
+        if (digit == MAX_RING_DIGITS) return false;
+        digits_used[digit] = true;
+        ring[3] = digit;
+        write_bond(out, ctx, ring[0], ring[1], ring[2]);
+        write_ring_digit(out, digit);
+    }
+    for (int i = rings + closes[a]; i < rings + closes[a + 1]; i++) {
+        int* ring = &ctx->rings[4 * ctx->ring_lists[i]];
+        write_ring_digit(out, ring[3]);
+        digits_used[ring[3]] = false;
+    }
+    return true;
+}
+
+bool canon_smiles(CanonContext* ctx, const Molecule* mol, char* buffer, size_t buffer_size) {
+    if (!ctx || !buffer || buffer_size == 0 || !prepare(ctx, mol)) return false;
+    buffer[0] = '\0';
+    if (ctx->kept == 0) return true;
+
+    canonicalize(ctx);
+    sort_neighbors_by_rank(ctx);
+    int rings = find_rings(ctx);
+    index_rings(ctx, rings);
+
+    Output out = {buffer, buffer_size, 0, true};
+    bool digits_used[MAX_RING_DIGITS] = {false};
+    int* written = ctx->scratch;
+    int* stack = ctx->stack;
+    for (int k = 0; k < ctx->kept; k++) written[k] = 0;
+
+    /* Pass 2: same traversal, writing atoms, ring marks and branches */
+    for (int r = 0; r < ctx->kept && out.ok; r++) {
+        int root = ctx->order[r];
+        if (written[root]) continue;
+        if (out.length > 0) out_char(&out, '.');
+
+        /* Frame: atom, next edge, remaining tree children, branch open */
+        int top = 0;
+        stack[0] = root;
+        stack[1] = ctx->offsets[root];
+        stack[3] = 0;
+        written[root] = 1;
+        write_atom(&out, ctx, mol, root);
+        if (!write_ring_marks(&out, ctx, root, rings, digits_used)) return false;
+
+        while (top >= 0 && out.ok) {
+            int* frame = &stack[4 * top];
+            int a = frame[0];
+            if (frame[1] == ctx->offsets[a]) {
+                int children = 0;
+                for (int e = ctx->offsets[a]; e < ctx->offsets[a + 1]; e++) children += ctx->keys[e];
+                frame[2] = children;
+            }
+
+            int e = frame[1];
+            while (e < ctx->offsets[a + 1] && ctx->keys[e] != 1) e++;
+            if (e == ctx->offsets[a + 1]) {
+                top--;
+                if (top >= 0 && stack[4 * top + 3]) {
+                    out_char(&out, ')');
+                    stack[4 * top + 3] = 0;
+                }
+                continue;
+            }
+            frame[1] = e + 1;
+
+            int b = ctx->neighbors[e];
+            frame[3] = --frame[2] > 0;
+            if (frame[3]) out_char(&out, '(');
+            write_bond(&out, ctx, a, b, ctx->bond_codes[e]);
+            written[b] = 1;
+            write_atom(&out, ctx, mol, b);
+            if (!write_ring_marks(&out, ctx, b, rings, digits_used)) return false;
+
+            top++;
+            stack[4 * top] = b;
+            stack[4 * top + 1] = ctx->offsets[b];
+            stack[4 * top + 3] = 0;
+        }
+    }
+    return out.ok;
+}
+
+/* ============ Convenience ============ */
+
+bool molecule_canonical_hash(const Molecule* mol, CanonHash* hash) {
+    CanonContext ctx;
+    canon_context_init(&ctx);
+    bool ok = canon_hash(&ctx, mol, hash);
+    canon_context_free(&ctx);
+    return ok;
+}
+
+bool molecule_canonical_smiles(const Molecule* mol, char* buffer, size_t buffer_size) {
+    CanonContext ctx;
+    canon_context_init(&ctx);
+    bool ok = canon_smiles(&ctx, mol, buffer, buffer_size);
+    canon_context_free(&ctx);
+    return ok;
+}
+
+/* ============ Hash Set ============ */
+
+bool canon_hash_set_init(CanonHashSet* set, size_t expected) {
+    if (!set) return false;
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity *= 2;
+
+    set->slots = malloc(capacity * sizeof(CanonHash));
+    set->used = calloc(capacity, 1);
+    set->capacity = capacity;
+    set->count = 0;
+    if (!set->slots || !set->used) {
+        canon_hash_set_free(set);
+        return false;
+    }
+    return true;
+}
+
+void canon_hash_set_free(CanonHashSet* set) {
+    if (!set) return;
+    free(set->slots);
+    free(set->used);
+    memset(set, 0, sizeof(*set));
+}
+
+static size_t probe(const CanonHashSet* set, const CanonHash* hash) {
+    size_t mask = set->capacity - 1;
+    size_t i = (size_t)hash->lo & mask;
+    while (set->used[i] && !canon_hash_equals(&set->slots[i], hash)) i = (i + 1) & mask;
+    return i;
+}
+
+static bool rehash(CanonHashSet* set) {
+    CanonHashSet bigger;
+    if (!canon_hash_set_init(&bigger, set->capacity)) return false;
+    for (size_t i = 0; i < set->capacity; i++) {
+        if (!set->used[i]) continue;
+        size_t j = probe(&bigger, &set->slots[i]);
+        bigger.slots[j] = set->slots[i];
+        bigger.used[j] = 1;
+        bigger.count++;
+    }
+    canon_hash_set_free(set);
+    *set = bigger;
+    return true;
+}
+
+int canon_hash_set_insert(CanonHashSet* set, const CanonHash* hash) {
+    if (!set || !hash || !set->slots) return -1;
+    if ((set->count + 1) * 2 > set->capacity && !rehash(set)) return -1;
+
+    size_t i = probe(set, hash);
+    if (set->used[i]) return 0;
+    set->slots[i] = *hash;
+    set->used[i] = 1;
+    set->count++;
+    return 1;
+}
+
+bool canon_hash_set_contains(const CanonHashSet* set, const CanonHash* hash) {
+    if (!set || !hash || !set->slots) return false;
+    return set->used[probe(set, hash)] != 0;
+}
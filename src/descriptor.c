@@ -0,0 +1,441 @@
+#include "descriptor.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DESCRIPTOR_CHUNK 256
+#define HYDROGEN_ELECTRONEGATIVITY 2.20
+
+#define FLAG_MULTIPLE 0x01          /* Double, triple or aromatic bond */
+#define FLAG_TRIPLE 0x02
+#define FLAG_CARBONYL 0x04          /* Carbon double-bonded to O or S */
+#define FLAG_AMIDE 0x08             /* Non-aromatic N single-bonded to a carbonyl carbon */
+
+/* Intermediates, and the descriptors that need them */
+#define NEED_ATOMS (DESCRIPTOR_BIT(DESCRIPTOR_HBOND_DONORS) | \
+                    DESCRIPTOR_BIT(DESCRIPTOR_HBOND_ACCEPTORS) | \
+                    DESCRIPTOR_BIT(DESCRIPTOR_ROTATABLE_BONDS) | \
+                    DESCRIPTOR_BIT(DESCRIPTOR_FRACTION_CSP3))
+#define NEED_RING_BONDS DESCRIPTOR_BIT(DESCRIPTOR_ROTATABLE_BONDS)
+#define NEED_FRAGMENTS DESCRIPTOR_BIT(DESCRIPTOR_RING_COUNT)
+
+const char* descriptor_name(Descriptor descriptor) {
+    switch (descriptor) {
+        case DESCRIPTOR_MOLECULAR_WEIGHT: return "mw";
+        case DESCRIPTOR_HEAVY_ATOMS: return "heavy";
+        case DESCRIPTOR_HETEROATOMS: return "hetero";
+        case DESCRIPTOR_HBOND_DONORS: return "hbd";
+        case DESCRIPTOR_HBOND_ACCEPTORS: return "hba";
+        case DESCRIPTOR_ROTATABLE_BONDS: return "rotb";
+        case DESCRIPTOR_RING_COUNT: return "rings";
+        case DESCRIPTOR_AROMATIC_ATOMS: return "arom";
+        case DESCRIPTOR_FORMAL_CHARGE: return "charge";
+        case DESCRIPTOR_BOND_POLARITY: return "polarity";
+        case DESCRIPTOR_FRACTION_CSP3: return "fsp3";
+        default: return "unknown";
+    }
+}
+
+/* ============ Context ============ */
+
+void descriptor_context_init(DescriptorContext* ctx) {
+    if (!ctx) return;
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void descriptor_context_free(DescriptorContext* ctx) {
+    if (!ctx) return;
+    free(ctx->heavy_degree);
+    free(ctx->hydrogens);
+    free(ctx->flags);
+    free(ctx->offsets);
+    free(ctx->neighbors);
+    free(ctx->bonds);
+    free(ctx->disc);
+    free(ctx->low);
+    free(ctx->stack);
+    free(ctx->parent);
+    free(ctx->ring_bond);
+    descriptor_context_init(ctx);
+}
+
+static bool grow(void** array, int count, size_t item) {
+    void* resized = realloc(*array, (size_t)count * item);
+    if (!resized) return false;
+    *array = resized;
+    return true;
+}
+
+static bool context_reserve(DescriptorContext* ctx, int atoms, int bonds) {
+    if (atoms > ctx->capacity || !ctx->heavy_degree) {
+        int cap = ctx->capacity < 64 ? 64 : ctx->capacity;
+        while (cap < atoms) cap *= 2;
+        if (!grow((void**)&ctx->heavy_degree, cap, sizeof(int)) ||
+            !grow((void**)&ctx->hydrogens, cap, sizeof(int)) ||
+            !grow((void**)&ctx->flags, cap, 1) ||
+            !grow((void**)&ctx->offsets, cap + 1, sizeof(int)) ||
+            !grow((void**)&ctx->disc, cap, sizeof(int)) ||
+            !grow((void**)&ctx->low, cap, sizeof(int)) ||
+            !grow((void**)&ctx->stack, 3 * cap, sizeof(int)) ||
+            !grow((void**)&ctx->parent, cap, sizeof(int))) {
+            return false;
+        }
+        ctx->capacity = cap;
+    }
+    if (2 * bonds > ctx->edge_capacity || !ctx->neighbors) {
+        int cap = ctx->edge_capacity < 128 ? 128 : ctx->edge_capacity;
+        while (cap < 2 * bonds) cap *= 2;
+        if (!grow((void**)&ctx->neighbors, cap, sizeof(int)) ||
+            !grow((void**)&ctx->bonds, cap, sizeof(int)) ||
+            !grow((void**)&ctx->ring_bond, cap / 2, 1)) {
+            return false;
+        }
+        ctx->edge_capacity = cap;
+    }
+    return true;
+}
+
+/* ============ Intermediates ============ */
+
+static bool is_hydrogen(const Atom* atom) {
+    return atom->element->atomic_number == 1;
+}
+
+/* Heavy degree, hydrogen count and bond flags in two passes over the bonds */
+static void atom_features(DescriptorContext* ctx, const Molecule* mol) {
+    int n = mol->atom_count;
+    for (int i = 0; i < n; i++) {
+        ctx->heavy_degree[i] = 0;
+        ctx->hydrogens[i] = mol->atoms[i].hydrogens;
+        ctx->flags[i] = 0;
+    }
+
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        int ends[2] = {bond->atom1_id, bond->atom2_id};
+        for (int e = 0; e < 2; e++) {
+            int a = ends[e];
+            const Atom* other = &mol->atoms[ends[1 - e]];
+            if (is_hydrogen(other)) ctx->hydrogens[a]++;
+            else ctx->heavy_degree[a]++;
+
+            if (bond->type == BOND_SINGLE) continue;
+            ctx->flags[a] |= FLAG_MULTIPLE;
+            if (bond->type == BOND_TRIPLE) ctx->flags[a] |= FLAG_TRIPLE;
+            int z = other->element->atomic_number;
+            if (bond->type == BOND_DOUBLE && mol->atoms[a].element->atomic_number == 6 &&
+                (z == 8 || z == 16)) {
+                ctx->flags[a] |= FLAG_CARBONYL;
+            }
+        }
+    }
+
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        if (bond->type != BOND_SINGLE) continue;
+        int ends[2] = {bond->atom1_id, bond->atom2_id};
+        for (int e = 0; e < 2; e++) {
+            const Atom* atom = &mol->atoms[ends[e]];
+            if (atom->element->atomic_number == 7 && !atom->aromatic &&
+                (ctx->flags[ends[1 - e]] & FLAG_CARBONYL)) {
+                ctx->flags[ends[e]] |= FLAG_AMIDE;
+            }
+        }
+    }
+}
+
+/* The molecule's adjacency, or a CSR built in the context if it has none */
+static void adjacency(DescriptorContext* ctx, const Molecule* mol,
+                      const int** offsets, const int** neighbors, const int** bonds) {
+    if (mol->adjacency_valid) {
+        *offsets = mol->adjacency_offsets;
+        *neighbors = mol->adjacency;
+        *bonds = mol->adjacency_bonds;
+        return;
+    }
+
+    int n = mol->atom_count;
+    memset(ctx->offsets, 0, (size_t)(n + 1) * sizeof(int));
+    for (int b = 0; b < mol->bond_count; b++) {
+        ctx->offsets[mol->bonds[b].atom1_id + 1]++;
+        ctx->offsets[mol->bonds[b].atom2_id + 1]++;
+    }
+    for (int i = 0; i < n; i++) ctx->offsets[i + 1] += ctx->offsets[i];
+    for (int b = 0; b < mol->bond_count; b++) {
+        int a1 = mol->bonds[b].atom1_id, a2 = mol->bonds[b].atom2_id;
+        int k1 = ctx->offsets[a1]++, k2 = ctx->offsets[a2]++;
+        ctx->neighbors[k1] = a2;
+        ctx->bonds[k1] = b;
+        ctx->neighbors[k2] = a1;
+        ctx->bonds[k2] = b;
+    }
+    for (int i = n; i > 0; i--) ctx->offsets[i] = ctx->offsets[i - 1];
+    ctx->offsets[0] = 0;
+
+    *offsets = ctx->offsets;
+    *neighbors = ctx->neighbors;
+    *bonds = ctx->bonds;
+}
+
+/* Mark every bond that is not a bridge (iterative Tarjan) */
+static void find_ring_bonds(DescriptorContext* ctx, const Molecule* mol) {
+    const int* offsets;
+    const int* neighbors;
+    const int* bonds;
+    adjacency(ctx, mol, &offsets, &neighbors, &bonds);
+
+    int n = mol->atom_count;
+    memset(ctx->disc, 0, (size_t)n * sizeof(int));
+    memset(ctx->ring_bond, 1, (size_t)mol->bond_count);
+    int* frames = ctx->stack;           /* Atom, next adjacency entry, tree bond */
+    int time = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (ctx->disc[root]) continue;
+        int top = 0;
+        frames[0] = root;
+        frames[1] = offsets[root];
+        frames[2] = -1;
+        ctx->disc[root] = ctx->low[root] = ++time;
+
+        while (top >= 0) {
+            int* frame = &frames[3 * top];
+            int v = frame[0];
+            if (frame[1] < offsets[v + 1]) {
+                int k = frame[1]++;
+                int u = neighbors[k];
+                if (bonds[k] == frame[2]) continue;
+                if (ctx->disc[u] == 0) {
+                    ctx->disc[u] = ctx->low[u] = ++time;
+                    top++;
+                    frames[3 * top] = u;
+                    frames[3 * top + 1] = offsets[u];
+                    frames[3 * top + 2] = bonds[k];
+                } else if (ctx->disc[u] < ctx->low[v]) {
+                    ctx->low[v] = ctx->disc[u];
+                }
+                continue;
+            }
+
+            int tree_bond = frame[2];
+            top--;
+            if (top < 0) break;
+            int p = frames[3 * top];
+            if (ctx->low[v] < ctx->low[p]) ctx->low[p] = ctx->low[v];
+            if (ctx->low[v] > ctx->disc[p]) ctx->ring_bond[tree_bond] = 0;
+        }
+    }
+}
+
+static int find_root(int* parent, int a) {
+    while (parent[a] != a) {
+        parent[a] = parent[parent[a]];
+        a = parent[a];
+    }
+    return a;
+}
+
+static int count_fragments(DescriptorContext* ctx, const Molecule* mol) {
+    int n = mol->atom_count;
+    for (int i = 0; i < n; i++) ctx->parent[i] = i;
+    int fragments = n;
+    for (int b = 0; b < mol->bond_count; b++) {
+        int r1 = find_root(ctx->parent, mol->bonds[b].atom1_id);
+        int r2 = find_root(ctx->parent, mol->bonds[b].atom2_id);
+        if (r1 == r2) continue;
+        ctx->parent[r1] = r2;
+        fragments--;
+    }
+    return fragments;
+}
+
+/* ============ Descriptors ============ */
+
+static bool is_acceptor(const DescriptorContext* ctx, const Atom* atom, int i) {
+    int z = atom->element->atomic_number;
+    if ((z != 7 && z != 8) || atom->charge > 0) return false;
+    if (z == 8) return true;
+    if (ctx->flags[i] & FLAG_AMIDE) return false;
+    /* Pyrrole-type nitrogen has no lone pair to spare */
+    if (atom->aromatic && (ctx->hydrogens[i] > 0 || ctx->heavy_degree[i] >= 3)) return false;
+    return true;
+}
+
+static int rotatable_bonds(const DescriptorContext* ctx, const Molecule* mol) {
+    int count = 0;
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        if (bond->type != BOND_SINGLE || ctx->ring_bond[b]) continue;
+        int a1 = bond->atom1_id, a2 = bond->atom2_id;
+        if (ctx->heavy_degree[a1] < 2 || ctx->heavy_degree[a2] < 2) continue;
+        if ((ctx->flags[a1] | ctx->flags[a2]) & FLAG_TRIPLE) continue;
+        bool amide = ((ctx->flags[a1] & FLAG_AMIDE) && (ctx->flags[a2] & FLAG_CARBONYL)) ||
+                     ((ctx->flags[a2] & FLAG_AMIDE) && (ctx->flags[a1] & FLAG_CARBONYL));
+        if (!amide) count++;
+    }
+    return count;
+}
+
+static double bond_polarity(const Molecule* mol) {
+    double polarity = 0.0;
+    for (int b = 0; b < mol->bond_count; b++) {
+        double x1 = mol->atoms[mol->bonds[b].atom1_id].element->electronegativity;
+        double x2 = mol->atoms[mol->bonds[b].atom2_id].element->electronegativity;
+        if (x1 > 0.0 && x2 > 0.0) polarity += x1 > x2 ? x1 - x2 : x2 - x1;
+    }
+    for (int i = 0; i < mol->atom_count; i++) {
+        double x = mol->atoms[i].element->electronegativity;
+        if (x > 0.0 && mol->atoms[i].hydrogens > 0) {
+            double delta = x > HYDROGEN_ELECTRONEGATIVITY ? x - HYDROGEN_ELECTRONEGATIVITY
+                                                          : HYDROGEN_ELECTRONEGATIVITY - x;
+            polarity += delta * mol->atoms[i].hydrogens;
+        }
+    }
+    return polarity;
+}
+
+bool descriptor_compute(DescriptorContext* ctx, const Molecule* mol, unsigned int mask,
+                        double* values) {
+    if (!ctx || !mol || !values) return false;
+    if ((mask & (NEED_ATOMS | NEED_RING_BONDS | NEED_FRAGMENTS)) &&
+        !context_reserve(ctx, mol->atom_count, mol->bond_count)) {
+        return false;
+    }
+
+    if (mask & NEED_ATOMS) atom_features(ctx, mol);
+    if (mask & NEED_RING_BONDS) find_ring_bonds(ctx, mol);
+
+    /* Atom counts in one pass */
+    int heavy = 0, hetero = 0, aromatic = 0, donors = 0, acceptors = 0, carbons = 0, sp3 = 0;
+    bool per_atom = (mask & NEED_ATOMS) != 0;
+    for (int i = 0; i < mol->atom_count; i++) {
+        const Atom* atom = &mol->atoms[i];
+        int z = atom->element->atomic_number;
+        if (z == 1) continue;
+        heavy++;
+        if (z != 6) hetero++;
+        if (atom->aromatic) aromatic++;
+        if (!per_atom) continue;
+        if ((z == 7 || z == 8) && ctx->hydrogens[i] > 0) donors++;
+        if (is_acceptor(ctx, atom, i)) acceptors++;
+        if (z == 6) {
+            carbons++;
+            if (!(ctx->flags[i] & FLAG_MULTIPLE)) sp3++;
+        }
+    }
+
+    for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+        if (!(mask & DESCRIPTOR_BIT(d))) continue;
+        double value = 0.0;
+        switch ((Descriptor)d) {
+            case DESCRIPTOR_MOLECULAR_WEIGHT: value = molecule_mass(mol); break;
+            case DESCRIPTOR_HEAVY_ATOMS: value = heavy; break;
+            case DESCRIPTOR_HETEROATOMS: value = hetero; break;
+            case DESCRIPTOR_HBOND_DONORS: value = donors; break;
+            case DESCRIPTOR_HBOND_ACCEPTORS: value = acceptors; break;
+            case DESCRIPTOR_ROTATABLE_BONDS: value = rotatable_bonds(ctx, mol); break;
+            case DESCRIPTOR_RING_COUNT:
+                value = mol->bond_count - mol->atom_count + count_fragments(ctx, mol);
+                break;
+            case DESCRIPTOR_AROMATIC_ATOMS: value = aromatic; break;
+            case DESCRIPTOR_FORMAL_CHARGE: value = molecule_charge(mol); break;
+            case DESCRIPTOR_BOND_POLARITY: value = bond_polarity(mol); break;
+            case DESCRIPTOR_FRACTION_CSP3: value = carbons > 0 ? (double)sp3 / carbons : 0.0; break;
+            default: break;
+        }
+        values[d] = value;
+    }
+    return true;
+}
+
+/* ============ Columnar Table ============ */
+
+void descriptor_table_init(DescriptorTable* table, unsigned int mask) {
+    if (!table) return;
+    memset(table, 0, sizeof(*table));
+    table->mask = mask & DESCRIPTOR_ALL;
+}
+
+void descriptor_table_free(DescriptorTable* table) {
+    if (!table) return;
+    for (int d = 0; d < DESCRIPTOR_COUNT; d++) free(table->columns[d]);
+    descriptor_table_init(table, table->mask);
+}
+
+bool descriptor_table_resize(DescriptorTable* table, int count) {
+    if (!table || count < 0) return false;
+    if (count > table->capacity) {
+        int cap = table->capacity < 64 ? 64 : table->capacity;
+        while (cap < count) cap *= 2;
+        for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+            if (!(table->mask & DESCRIPTOR_BIT(d))) continue;
+            if (!grow((void**)&table->columns[d], cap, sizeof(double))) return false;
+        }
+        table->capacity = cap;
+    }
+    for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+        if (table->columns[d] && count > table->count) {
+            memset(table->columns[d] + table->count, 0,
+                   (size_t)(count - table->count) * sizeof(double));
+        }
+    }
+    table->count = count;
+    return true;
+}
+
+double* descriptor_column(const DescriptorTable* table, Descriptor descriptor) {
+    if (!table || (int)descriptor < 0 || (int)descriptor >= DESCRIPTOR_COUNT) return NULL;
+    return table->columns[descriptor];
+}
+
+/* ============ Batch ============ */
+
+typedef struct {
+    DescriptorContext ctx;
+    bool failed;
+    char padding[64];
+} DescriptorWorker;
+
+typedef struct {
+    const Molecule* const* molecules;
+    DescriptorTable* table;
+    DescriptorWorker* workers;
+} DescriptorJob;
+
+static void descriptor_range(int begin, int end, int thread_index, void* user_data) {
+    DescriptorJob* job = user_data;
+    DescriptorWorker* w = &job->workers[thread_index];
+    DescriptorTable* table = job->table;
+    double values[DESCRIPTOR_COUNT];
+
+    for (int m = begin; m < end; m++) {
+        if (!descriptor_compute(&w->ctx, job->molecules[m], table->mask, values)) {
+            w->failed = true;
+            continue;
+        }
+        for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+            if (table->columns[d]) table->columns[d][m] = values[d];
+        }
+    }
+}
+
+bool descriptor_compute_batch(const Molecule* const* molecules, int count, int threads,
+                              DescriptorTable* table) {
+    if (!molecules || !table || count < 0) return false;
+    if (!descriptor_table_resize(table, count)) return false;
+
+    threads = parallel_thread_count(threads);
+    DescriptorWorker* workers = calloc(threads, sizeof(DescriptorWorker));
+    if (!workers) return false;
+    for (int t = 0; t < threads; t++) descriptor_context_init(&workers[t].ctx);
+
+    DescriptorJob job = {molecules, table, workers};
+    bool ok = parallel_for(count, DESCRIPTOR_CHUNK, threads, descriptor_range, &job);
+
+    for (int t = 0; t < threads; t++) {
+        if (workers[t].failed) ok = false;
+        descriptor_context_free(&workers[t].ctx);
+    }
+    free(workers);
+    return ok;
+}
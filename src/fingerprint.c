@@ -0,0 +1,411 @@
+#include "fingerprint.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_CHUNK 4096
+
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/* Bond codes: 1-3 bond order, 4 aromatic */
+static int bond_code(BondType type) {
+    switch (type) {
+        case BOND_DOUBLE: return 2;
+        case BOND_TRIPLE: return 3;
+        case BOND_AROMATIC: return 4;
+        default: return 1;
+    }
+}
+
+/* ============ Popcount ============ */
+
+/*
+ * Popcount of a AND b over a whole row. Without a hardware popcount the
+ * per-word bit counts are kept as byte lanes and summed once per row;
+ * the loop has no multiplies or branches so the compiler can vectorize it.
+ */
+static int popcount_and(const uint64_t* a, const uint64_t* b) {
+#if defined(__POPCNT__) && (defined(__GNUC__) || defined(__clang__))
+    int count = 0;
+    for (int w = 0; w < FINGERPRINT_WORDS; w++) count += __builtin_popcountll(a[w] & b[w]);
+    return count;
+#else
+    const uint64_t M1 = 0x5555555555555555ULL;
+    const uint64_t M2 = 0x3333333333333333ULL;
+    const uint64_t M4 = 0x0F0F0F0F0F0F0F0FULL;
+    const uint64_t M8 = 0x00FF00FF00FF00FFULL;
+    uint64_t bytes = 0;
+    for (int w = 0; w < FINGERPRINT_WORDS; w++) {
+        uint64_t x = a[w] & b[w];
+        x = x - ((x >> 1) & M1);
+        x = (x & M2) + ((x >> 2) & M2);
+        bytes += (x + (x >> 4)) & M4;           /* At most 8 * 16 per byte lane */
+    }
+    uint64_t shorts = (bytes & M8) + ((bytes >> 8) & M8);
+    return (int)((shorts * 0x0001000100010001ULL) >> 48);
+#endif
+}
+
+int fingerprint_popcount(const uint64_t* bits) {
+    return popcount_and(bits, bits);
+}
+
+double fingerprint_tanimoto(const uint64_t* a, const uint64_t* b) {
+    int common = popcount_and(a, b);
+    int total = fingerprint_popcount(a) + fingerprint_popcount(b) - common;
+    return total > 0 ? (double)common / total : 0.0;
+}
+
+/* ============ Context ============ */
+
+void fingerprint_context_init(FingerprintContext* ctx) {
+    if (!ctx) return;
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void fingerprint_context_free(FingerprintContext* ctx) {
+    if (!ctx) return;
+    free(ctx->compact);
+    free(ctx->atoms);
+    free(ctx->hydrogens);
+    free(ctx->offsets);
+    free(ctx->neighbors);
+    free(ctx->bond_codes);
+    free(ctx->ids);
+    free(ctx->next_ids);
+    free(ctx->keys);
+    fingerprint_context_init(ctx);
+}
+
+static bool grow(void** array, size_t count, size_t item) {
+    void* p = realloc(*array, count * item);
+    if (!p) return false;
+    *array = p;
+    return true;
+}
+
+static bool context_reserve(FingerprintContext* ctx, int atoms, int edges) {
+    if (atoms > ctx->capacity) {
+        int cap = ctx->capacity < 64 ? 64 : ctx->capacity;
+        while (cap < atoms) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->compact, n, sizeof(int)) ||
+            !grow((void**)&ctx->atoms, n, sizeof(int)) ||
+            !grow((void**)&ctx->hydrogens, n, sizeof(int)) ||
+            !grow((void**)&ctx->offsets, n, sizeof(int)) ||
+            !grow((void**)&ctx->ids, n, sizeof(uint64_t)) ||
+            !grow((void**)&ctx->next_ids, n, sizeof(uint64_t))) {
+            return false;
+        }
+        ctx->capacity = cap;
+    }
+    if (edges > ctx->edge_capacity) {
+        int cap = ctx->edge_capacity < 128 ? 128 : ctx->edge_capacity;
+        while (cap < edges) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->neighbors, n, sizeof(int)) ||
+            !grow((void**)&ctx->bond_codes, n, sizeof(int)) ||
+            !grow((void**)&ctx->keys, n, sizeof(uint64_t))) {
+            return false;
+        }
+        ctx->edge_capacity = cap;
+    }
+    return true;
+}
+
+/* Plain hydrogen singly bonded to a non-hydrogen */
+static bool foldable_hydrogen(const Molecule* mol, int atom) {
+    const Atom* a = &mol->atoms[atom];
+    if (a->element->atomic_number != 1 || a->isotope != 0 || a->charge != 0) return false;
+
+    const int* neighbors;
+    const int* bonds;
+    if (molecule_neighbors(mol, atom, &neighbors, &bonds) != 1) return false;
+    return mol->atoms[neighbors[0]].element->atomic_number != 1 &&
+           mol->bonds[bonds[0]].type == BOND_SINGLE;
+}
+
+/* Fold hydrogens, build the kept-atom graph and the initial identifiers */
+static int prepare(FingerprintContext* ctx, const Molecule* mol) {
+    int n = mol->atom_count;
+    if (!context_reserve(ctx, n, 2 * mol->bond_count)) return -1;
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (foldable_hydrogen(mol, i)) {
+            ctx->compact[i] = -1;
+        } else {
+            ctx->atoms[kept] = i;
+            ctx->hydrogens[kept] = mol->atoms[i].hydrogens;
+            ctx->compact[i] = kept++;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (ctx->compact[i] < 0) {
+            const int* neighbors;
+            molecule_neighbors(mol, i, &neighbors, NULL);
+            ctx->hydrogens[ctx->compact[neighbors[0]]]++;
+        }
+    }
+
+    int edge = 0;
+    for (int k = 0; k < kept; k++) {
+        const int* neighbors;
+        const int* bonds;
+        int degree = molecule_neighbors(mol, ctx->atoms[k], &neighbors, &bonds);
+
+        ctx->offsets[k] = edge;
+        for (int j = 0; j < degree; j++) {
+            int c = ctx->compact[neighbors[j]];
+            if (c < 0) continue;
+            ctx->neighbors[edge] = c;
+            ctx->bond_codes[edge++] = bond_code(mol->bonds[bonds[j]].type);
+        }
+
+        const Atom* atom = &mol->atoms[ctx->atoms[k]];
+        uint64_t heavy_degree = (uint64_t)(edge - ctx->offsets[k]);
+        ctx->ids[k] = mix64(((uint64_t)atom->element->atomic_number << 50) |
+                            ((uint64_t)(atom->isotope & 0xFFF) << 38) |
+                            ((uint64_t)((atom->charge + 128) & 0xFF) << 30) |
+                            ((uint64_t)(ctx->hydrogens[k] & 0xFF) << 22) |
+                            ((heavy_degree & 0xFF) << 14) |
+                            ((uint64_t)(atom->aromatic ? 1 : 0) << 13));
+    }
+    ctx->offsets[kept] = edge;
+    return kept;
+}
+
+static void set_bit(uint64_t* bits, uint64_t id) {
+    uint64_t bit = mix64(id) % FINGERPRINT_BITS;
+    bits[bit >> 6] |= 1ULL << (bit & 63);
+}
+
+bool fingerprint_ecfp(FingerprintContext* ctx, const Molecule* mol, int radius, uint64_t* bits) {
+    if (!ctx || !mol || !bits || !mol->adjacency_valid || radius < 0) return false;
+
+    memset(bits, 0, FINGERPRINT_WORDS * sizeof(uint64_t));
+    int kept = prepare(ctx, mol);
+    if (kept < 0) return false;
+
+    for (int k = 0; k < kept; k++) set_bit(bits, ctx->ids[k]);
+
+    for (int iteration = 1; iteration <= radius; iteration++) {
+        for (int k = 0; k < kept; k++) {
+            int lo = ctx->offsets[k], hi = ctx->offsets[k + 1];
+
+            /* Neighbor keys sorted so the identifier ignores atom order */
+            for (int e = lo; e < hi; e++) {
+                uint64_t key = mix64(ctx->ids[ctx->neighbors[e]] ^ (uint64_t)ctx->bond_codes[e]);
+                int j = e;
+                while (j > lo && ctx->keys[j - 1] > key) {
+                    ctx->keys[j] = ctx->keys[j - 1];
+                    j--;
+                }
+                ctx->keys[j] = key;
+            }
+
+            uint64_t id = mix64(ctx->ids[k] + (uint64_t)iteration);
+            for (int e = lo; e < hi; e++) id = mix64(id ^ ctx->keys[e]);
+            ctx->next_ids[k] = id;
+        }
+
+        uint64_t* swap = ctx->ids;
+        ctx->ids = ctx->next_ids;
+        ctx->next_ids = swap;
+        for (int k = 0; k < kept; k++) set_bit(bits, ctx->ids[k]);
+    }
+    return true;
+}
+
+/* ============ Matrix ============ */
+
+void fingerprint_matrix_init(FingerprintMatrix* matrix) {
+    if (!matrix) return;
+    memset(matrix, 0, sizeof(*matrix));
+}
+
+void fingerprint_matrix_free(FingerprintMatrix* matrix) {
+    if (!matrix) return;
+    free(matrix->block);
+    free(matrix->popcounts);
+    fingerprint_matrix_init(matrix);
+}
+
+static bool matrix_reserve(FingerprintMatrix* matrix, int rows) {
+    if (rows <= matrix->capacity) return true;
+
+    int cap = matrix->capacity < 256 ? 256 : matrix->capacity;
+    while (cap < rows) cap *= 2;
+
+    size_t row_bytes = FINGERPRINT_WORDS * sizeof(uint64_t);
+    void* block = malloc((size_t)cap * row_bytes + FINGERPRINT_ALIGNMENT);
+    int* popcounts = realloc(matrix->popcounts, (size_t)cap * sizeof(int));
+    if (!block || !popcounts) {
+        free(block);
+        if (popcounts) matrix->popcounts = popcounts;
+        return false;
+    }
+
+    uintptr_t address = (uintptr_t)block;
+    address = (address + FINGERPRINT_ALIGNMENT - 1) & ~(uintptr_t)(FINGERPRINT_ALIGNMENT - 1);
+    uint64_t* bits = (uint64_t*)address;
+    if (matrix->count > 0) memcpy(bits, matrix->bits, (size_t)matrix->count * row_bytes);
+
+    free(matrix->block);
+    matrix->block = block;
+    matrix->bits = bits;
+    matrix->popcounts = popcounts;
+    matrix->capacity = cap;
+    return true;
+}
+
+bool fingerprint_matrix_resize(FingerprintMatrix* matrix, int count) {
+    if (!matrix || count < 0 || !matrix_reserve(matrix, count)) return false;
+    if (count > matrix->count) {
+        memset(matrix->bits + (size_t)matrix->count * FINGERPRINT_WORDS, 0,
+               (size_t)(count - matrix->count) * FINGERPRINT_WORDS * sizeof(uint64_t));
+        memset(matrix->popcounts + matrix->count, 0, (size_t)(count - matrix->count) * sizeof(int));
+    }
+    matrix->count = count;
+    return true;
+}
+
+uint64_t* fingerprint_matrix_row(const FingerprintMatrix* matrix, int row) {
+    return matrix->bits + (size_t)row * FINGERPRINT_WORDS;
+}
+
+void fingerprint_matrix_set(FingerprintMatrix* matrix, int row, const uint64_t* bits) {
+    if (!matrix || row < 0 || row >= matrix->count) return;
+    memcpy(fingerprint_matrix_row(matrix, row), bits, FINGERPRINT_WORDS * sizeof(uint64_t));
+    matrix->popcounts[row] = fingerprint_popcount(bits);
+}
+
+int fingerprint_matrix_add(FingerprintMatrix* matrix, const uint64_t* bits) {
+    if (!matrix || !bits) return -1;
+    int row = matrix->count;
+    if (!fingerprint_matrix_resize(matrix, row + 1)) return -1;
+    fingerprint_matrix_set(matrix, row, bits);
+    return row;
+}
+
+/* ============ Similarity Search ============ */
+
+/* Better hits order first: higher similarity, then lower row */
+static bool hit_better(const SimilarityHit* a, const SimilarityHit* b) {
+    if (a->similarity != b->similarity) return a->similarity > b->similarity;
+    return a->index < b->index;
+}
+
+static int compare_hits(const void* a, const void* b) {
+    const SimilarityHit* x = a;
+    const SimilarityHit* y = b;
+    if (hit_better(x, y)) return -1;
+    return hit_better(y, x) ? 1 : 0;
+}
+
+/* Bounded heap with the worst kept hit at the root */
+typedef struct {
+    SimilarityHit* heap;
+    int count;
+    char padding[64];
+} TopKWorker;
+
+static void heap_sift_down(SimilarityHit* heap, int count, int i) {
+    for (;;) {
+        int worst = i;
+        int left = 2 * i + 1, right = left + 1;
+        if (left < count && hit_better(&heap[worst], &heap[left])) worst = left;
+        if (right < count && hit_better(&heap[worst], &heap[right])) worst = right;
+        if (worst == i) return;
+        SimilarityHit t = heap[i];
+        heap[i] = heap[worst];
+        heap[worst] = t;
+        i = worst;
+    }
+}
+
+static void heap_offer(TopKWorker* w, int k, SimilarityHit hit) {
+    if (w->count < k) {
+        int i = w->count++;
+        w->heap[i] = hit;
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!hit_better(&w->heap[parent], &w->heap[i])) break;
+            SimilarityHit t = w->heap[i];
+            w->heap[i] = w->heap[parent];
+            w->heap[parent] = t;
+            i = parent;
+        }
+    } else if (hit_better(&hit, &w->heap[0])) {
+        w->heap[0] = hit;
+        heap_sift_down(w->heap, w->count, 0);
+    }
+}
+
+typedef struct {
+    const FingerprintMatrix* matrix;
+    const uint64_t* query;
+    int query_count;
+    int k;
+    TopKWorker* workers;
+} TopKJob;
+
+static void top_k_range(int begin, int end, int thread_index, void* user_data) {
+    TopKJob* job = user_data;
+    TopKWorker* w = &job->workers[thread_index];
+    const int* popcounts = job->matrix->popcounts;
+    int q = job->query_count;
+
+    for (int row = begin; row < end; row++) {
+        int p = popcounts[row];
+        if (w->count == job->k) {
+            /* Tanimoto <= min / max of the two popcounts */
+            int lo = p < q ? p : q, hi = p < q ? q : p;
+            if (hi > 0 && (double)lo / hi < w->heap[0].similarity) continue;
+        }
+
+        int common = popcount_and(job->query, fingerprint_matrix_row(job->matrix, row));
+        int total = p + q - common;
+        SimilarityHit hit = {row, total > 0 ? (double)common / total : 0.0};
+        heap_offer(w, job->k, hit);
+    }
+}
+
+int fingerprint_top_k(const FingerprintMatrix* matrix, const uint64_t* query, int k,
+                      int threads, SimilarityHit* hits) {
+    if (!matrix || !query || !hits || k < 0) return -1;
+    if (k == 0 || matrix->count == 0) return 0;
+
+    threads = parallel_thread_count(threads);
+    TopKWorker* workers = calloc(threads, sizeof(TopKWorker));
+    SimilarityHit* all = malloc((size_t)threads * k * sizeof(SimilarityHit));
+    if (!workers || !all) {
+        free(workers);
+        free(all);
+        return -1;
+    }
+    for (int t = 0; t < threads; t++) workers[t].heap = all + (size_t)t * k;
+
+    TopKJob job = {matrix, query, fingerprint_popcount(query), k, workers};
+    parallel_for(matrix->count, SEARCH_CHUNK, threads, top_k_range, &job);
+
+    /* Compact the per-worker heaps, then order the union */
+    int total = 0;
+    for (int t = 0; t < threads; t++) {
+        memmove(all + total, workers[t].heap, workers[t].count * sizeof(SimilarityHit));
+        total += workers[t].count;
+    }
+    qsort(all, total, sizeof(SimilarityHit), compare_hits);
+
+    int written = total < k ? total : k;
+    memcpy(hits, all, written * sizeof(SimilarityHit));
+
+    free(workers);
+    free(all);
+    return written;
+}
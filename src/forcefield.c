@@ -0,0 +1,825 @@
+#include "forcefield.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define COULOMB_CONSTANT 332.0636   /* kcal A / (mol e^2) */
+#define MIN_PAIR_DISTANCE2 0.25     /* Below this, linear in r^2 so overlaps stay finite */
+#define ANGLE_K 60.0
+#define MAX_ANGLE_DEGREE 4          /* No angle terms around hypervalent centers */
+#define PARALLEL_MIN_ATOMS 2048
+#define CELL_CHUNK 16
+#define CELL_REACH 2                /* Cells span cutoff / CELL_REACH */
+#define ROW_COUNT (CELL_REACH + CELL_REACH * (2 * CELL_REACH + 1))
+
+/* ============ Parameters ============ */
+
+typedef struct {
+    int atomic_number;
+    double covalent_radius;
+    double vdw_radius;
+    double epsilon;
+} AtomParameters;
+
+/* Covalent radii (Cordero), van der Waals radii (Bondi), UFF-like well depths */
+static const AtomParameters ATOM_PARAMETERS[] = {
+    {1, 0.31, 1.20, 0.044},
+    {5, 0.84, 1.92, 0.180},
+    {6, 0.76, 1.70, 0.105},
+    {7, 0.71, 1.55, 0.069},
+    {8, 0.66, 1.52, 0.060},
+    {9, 0.57, 1.47, 0.050},
+    {14, 1.11, 2.10, 0.402},
+    {15, 1.07, 1.80, 0.305},
+    {16, 1.05, 1.80, 0.274},
+    {17, 1.02, 1.75, 0.227},
+    {35, 1.20, 1.85, 0.251},
+    {53, 1.39, 1.98, 0.339},
+};
+static const AtomParameters DEFAULT_PARAMETERS = {0, 1.20, 2.00, 0.100};
+
+static const AtomParameters* atom_parameters(const Atom* atom) {
+    int count = (int)(sizeof(ATOM_PARAMETERS) / sizeof(ATOM_PARAMETERS[0]));
+    for (int i = 0; i < count; i++) {
+        if (ATOM_PARAMETERS[i].atomic_number == atom->element->atomic_number) {
+            return &ATOM_PARAMETERS[i];
+        }
+    }
+    return &DEFAULT_PARAMETERS;
+}
+
+/* Bond length shortening and force constant by bond type */
+static void bond_parameters(BondType type, double* shortening, double* k) {
+    switch (type) {
+        case BOND_DOUBLE: *shortening = 0.18; *k = 570.0; break;
+        case BOND_TRIPLE: *shortening = 0.32; *k = 800.0; break;
+        case BOND_AROMATIC: *shortening = 0.12; *k = 470.0; break;
+        default: *shortening = 0.0; *k = 340.0; break;
+    }
+}
+
+/* Ideal angle cosine from the bonds around a center */
+static double center_cos0(const Molecule* mol, int center) {
+    int doubles = 0, triples = 0, aromatic = 0;
+    for (int k = mol->adjacency_offsets[center]; k < mol->adjacency_offsets[center + 1]; k++) {
+        BondType type = mol->bonds[mol->adjacency_bonds[k]].type;
+        if (type == BOND_DOUBLE) doubles++;
+        else if (type == BOND_TRIPLE) triples++;
+        else if (type == BOND_AROMATIC) aromatic++;
+    }
+    if (triples > 0 || doubles > 1) return -1.0;        /* sp */
+    if (doubles > 0 || aromatic > 0) return -0.5;       /* sp2 */
+    return -1.0 / 3.0;                                  /* sp3 */
+}
+
+/* ============ Setup ============ */
+
+void forcefield_init(ForceField* ff) {
+    if (!ff) return;
+    memset(ff, 0, sizeof(*ff));
+}
+
+void forcefield_free(ForceField* ff) {
+    if (!ff) return;
+    free(ff->radius);
+    free(ff->sqrt_epsilon);
+    free(ff->charge);
+    free(ff->charged);
+    free(ff->bond_atoms);
+    free(ff->bond_k);
+    free(ff->bond_r0);
+    free(ff->angle_atoms);
+    free(ff->angle_k);
+    free(ff->angle_cos0);
+    free(ff->exclusions);
+    free(ff->grad_x);
+    free(ff->grad_y);
+    free(ff->grad_z);
+    free(ff->cell_start);
+    free(ff->cell_of);
+    free(ff->order);
+    free(ff->sorted);
+    free(ff->worker_gradients);
+    free(ff->saved);
+    forcefield_init(ff);
+}
+
+static bool grow(void** array, size_t count, size_t item) {
+    void* resized = realloc(*array, (count > 0 ? count : 1) * item);
+    if (!resized) return false;
+    *array = resized;
+    return true;
+}
+
+static int compare_keys(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+static long long pair_key(int a, int b) {
+    return a < b ? ((long long)a << 32) | b : ((long long)b << 32) | a;
+}
+
+bool forcefield_setup(ForceField* ff, Molecule* mol, double cutoff) {
+    if (!ff || !mol) return false;
+    if (!molecule_build_adjacency(mol)) return false;
+
+    int n = mol->atom_count;
+    int m = mol->bond_count;
+    int angles = 0;
+    for (int i = 0; i < n; i++) {
+        int degree = molecule_degree(mol, i);
+        angles += degree * (degree - 1) / 2;
+    }
+
+    if (!grow((void**)&ff->radius, n, sizeof(double)) ||
+        !grow((void**)&ff->sqrt_epsilon, n, sizeof(double)) ||
+        !grow((void**)&ff->charge, n, sizeof(double)) ||
+        !grow((void**)&ff->charged, n, sizeof(int)) ||
+        !grow((void**)&ff->grad_x, n, sizeof(double)) ||
+        !grow((void**)&ff->grad_y, n, sizeof(double)) ||
+        !grow((void**)&ff->grad_z, n, sizeof(double)) ||
+        !grow((void**)&ff->cell_of, n, sizeof(int)) ||
+        !grow((void**)&ff->order, n, sizeof(int)) ||
+        !grow((void**)&ff->sorted, 5 * (size_t)n, sizeof(double)) ||
+        !grow((void**)&ff->saved, 6 * (size_t)n, sizeof(double)) ||
+        !grow((void**)&ff->bond_atoms, 2 * (size_t)m, sizeof(int)) ||
+        !grow((void**)&ff->bond_k, m, sizeof(double)) ||
+        !grow((void**)&ff->bond_r0, m, sizeof(double)) ||
+        !grow((void**)&ff->angle_atoms, 3 * (size_t)angles, sizeof(int)) ||
+        !grow((void**)&ff->angle_k, angles, sizeof(double)) ||
+        !grow((void**)&ff->angle_cos0, angles, sizeof(double)) ||
+        !grow((void**)&ff->exclusions, (size_t)m + angles, sizeof(long long))) {
+        return false;
+    }
+
+    ff->atom_count = n;
+    ff->cutoff = cutoff > 0.0 ? cutoff : FORCEFIELD_DEFAULT_CUTOFF;
+    ff->charged_count = 0;
+    for (int i = 0; i < n; i++) {
+        const AtomParameters* p = atom_parameters(&mol->atoms[i]);
+        ff->radius[i] = p->vdw_radius;
+        ff->sqrt_epsilon[i] = sqrt(p->epsilon);
+        ff->charge[i] = mol->atoms[i].charge;
+        if (mol->atoms[i].charge != 0) ff->charged[ff->charged_count++] = i;
+    }
+
+    /* Bonds stay aligned with the molecule's bond indices */
+    int exclusions = 0;
+    for (int b = 0; b < m; b++) {
+        const Bond* bond = &mol->bonds[b];
+        double shortening, k;
+        bond_parameters(bond->type, &shortening, &k);
+        ff->bond_atoms[2 * b] = bond->atom1_id;
+        ff->bond_atoms[2 * b + 1] = bond->atom2_id;
+        ff->bond_k[b] = k;
+        ff->bond_r0[b] = atom_parameters(&mol->atoms[bond->atom1_id])->covalent_radius +
+                         atom_parameters(&mol->atoms[bond->atom2_id])->covalent_radius - shortening;
+        ff->exclusions[exclusions++] = pair_key(bond->atom1_id, bond->atom2_id);
+    }
+    ff->bond_count = m;
+
+    ff->angle_count = 0;
+    for (int c = 0; c < n; c++) {
+        int begin = mol->adjacency_offsets[c], end = mol->adjacency_offsets[c + 1];
+        bool terms = end - begin <= MAX_ANGLE_DEGREE;
+        double cos0 = terms ? center_cos0(mol, c) : 0.0;
+        for (int i = begin; i < end; i++) {
+            for (int j = i + 1; j < end; j++) {
+                int a = mol->adjacency[i], b = mol->adjacency[j];
+                ff->exclusions[exclusions++] = pair_key(a, b);
+                if (!terms) continue;
+                int* t = &ff->angle_atoms[3 * ff->angle_count];
+                t[0] = a;
+                t[1] = c;
+                t[2] = b;
+                ff->angle_k[ff->angle_count] = ANGLE_K;
+                ff->angle_cos0[ff->angle_count++] = cos0;
+            }
+        }
+    }
+
+    /* 1-2 and 1-3 pairs, deduplicated for small rings */
+    qsort(ff->exclusions, exclusions, sizeof(long long), compare_keys);
+    int unique = 0;
+    for (int i = 0; i < exclusions; i++) {
+        if (unique == 0 || ff->exclusions[unique - 1] != ff->exclusions[i]) {
+            ff->exclusions[unique++] = ff->exclusions[i];
+        }
+    }
+    ff->exclusion_count = unique;
+    return true;
+}
+
+static bool excluded(const ForceField* ff, int a, int b) {
+    long long key = pair_key(a, b);
+    int lo = 0, hi = ff->exclusion_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ff->exclusions[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < ff->exclusion_count && ff->exclusions[lo] == key;
+}
+
+/* ============ Non-bonded Kernel ============ */
+
+typedef struct {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* radius;
+    const double* sqrt_epsilon;
+    double cutoff2;
+} PairData;
+
+typedef struct {
+    double energy;
+    double gx, gy, gz;          /* Gradient on the row atom */
+    long long pairs;
+} RowSum;
+
+/*
+ * Lennard-Jones between sorted atom i and sorted atoms [begin, end), with
+ * the gradient on j scattered into gx/gy/gz and that on i summed in row.
+ * Pairs beyond the cutoff are masked rather than branched around.
+ */
+static void lj_row(const PairData* d, int i, int begin, int end,
+                   double* restrict gx, double* restrict gy, double* restrict gz, RowSum* row) {
+    const double* restrict x = d->x;
+    const double* restrict y = d->y;
+    const double* restrict z = d->z;
+    const double* restrict radius = d->radius;
+    const double* restrict se = d->sqrt_epsilon;
+    double xi = x[i], yi = y[i], zi = z[i], ri = radius[i], sei = se[i];
+    int j = begin;
+
+#if defined(__SSE2__)
+    __m128d vxi = _mm_set1_pd(xi), vyi = _mm_set1_pd(yi), vzi = _mm_set1_pd(zi);
+    __m128d vri = _mm_set1_pd(ri), vsei = _mm_set1_pd(sei);
+    __m128d cutoff2 = _mm_set1_pd(d->cutoff2), min2 = _mm_set1_pd(MIN_PAIR_DISTANCE2);
+    __m128d one = _mm_set1_pd(1.0), two = _mm_set1_pd(2.0), twelve = _mm_set1_pd(12.0);
+    __m128d half = _mm_set1_pd(0.5);
+    __m128d energy = _mm_setzero_pd();
+    __m128d sx = _mm_setzero_pd(), sy = _mm_setzero_pd(), sz = _mm_setzero_pd();
+    long long pairs = 0;
+    for (; j + 2 <= end; j += 2) {
+        __m128d dx = _mm_sub_pd(vxi, _mm_loadu_pd(x + j));
+        __m128d dy = _mm_sub_pd(vyi, _mm_loadu_pd(y + j));
+        __m128d dz = _mm_sub_pd(vzi, _mm_loadu_pd(z + j));
+        __m128d r2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                                _mm_mul_pd(dz, dz));
+        __m128d inside = _mm_cmplt_pd(r2, cutoff2);
+        __m128d clamped = _mm_max_pd(r2, min2);
+        __m128d inv = _mm_div_pd(one, clamped);
+        __m128d rm = _mm_add_pd(vri, _mm_loadu_pd(radius + j));
+        __m128d s2 = _mm_mul_pd(_mm_mul_pd(rm, rm), inv);
+        __m128d s6 = _mm_mul_pd(_mm_mul_pd(s2, s2), s2);
+        __m128d s12 = _mm_mul_pd(s6, s6);
+        __m128d eps = _mm_and_pd(inside, _mm_mul_pd(vsei, _mm_loadu_pd(se + j)));
+        __m128d f = _mm_mul_pd(_mm_mul_pd(twelve, eps), _mm_mul_pd(_mm_sub_pd(s6, s12), inv));
+        __m128d e = _mm_mul_pd(eps, _mm_sub_pd(s12, _mm_mul_pd(two, s6)));
+        e = _mm_add_pd(e, _mm_mul_pd(_mm_mul_pd(half, f), _mm_sub_pd(r2, clamped)));
+        energy = _mm_add_pd(energy, e);
+        __m128d fx = _mm_mul_pd(f, dx), fy = _mm_mul_pd(f, dy), fz = _mm_mul_pd(f, dz);
+        sx = _mm_add_pd(sx, fx);
+        sy = _mm_add_pd(sy, fy);
+        sz = _mm_add_pd(sz, fz);
+        _mm_storeu_pd(gx + j, _mm_sub_pd(_mm_loadu_pd(gx + j), fx));
+        _mm_storeu_pd(gy + j, _mm_sub_pd(_mm_loadu_pd(gy + j), fy));
+        _mm_storeu_pd(gz + j, _mm_sub_pd(_mm_loadu_pd(gz + j), fz));
+        int mask = _mm_movemask_pd(inside);
+        pairs += (mask & 1) + (mask >> 1);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, energy);
+    row->energy += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sx);
+    row->gx += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sy);
+    row->gy += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, sz);
+    row->gz += lanes[0] + lanes[1];
+    row->pairs += pairs;
+#endif
+
+    for (; j < end; j++) {
+        double dx = xi - x[j], dy = yi - y[j], dz = zi - z[j];
+        double r2 = dx * dx + dy * dy + dz * dz;
+        double inside = r2 < d->cutoff2 ? 1.0 : 0.0;
+        double clamped = r2 > MIN_PAIR_DISTANCE2 ? r2 : MIN_PAIR_DISTANCE2;
+        double inv = 1.0 / clamped;
+        double rm = ri + radius[j];
+        double s2 = rm * rm * inv;
+        double s6 = s2 * s2 * s2;
+        double s12 = s6 * s6;
+        double eps = inside * sei * se[j];
+        double f = 12.0 * eps * (s6 - s12) * inv;
+        row->energy += eps * (s12 - 2.0 * s6) + 0.5 * f * (r2 - clamped);
+        row->gx += f * dx;
+        row->gy += f * dy;
+        row->gz += f * dz;
+        gx[j] -= f * dx;
+        gy[j] -= f * dy;
+        gz[j] -= f * dz;
+        row->pairs += r2 < d->cutoff2;
+    }
+}
+
+/* ============ Cell List ============ */
+
+typedef struct {
+    double energy;
+    long long pairs;
+    char padding[64];
+} PairWorker;
+
+typedef struct {
+    const ForceField* ff;
+    PairData data;
+    int nx, ny, nz;
+    PairWorker* workers;
+} PairJob;
+
+static void pair_cells(int begin, int end, int thread_index, void* user_data) {
+    PairJob* job = user_data;
+    const ForceField* ff = job->ff;
+    const int* start = ff->cell_start;
+    int n = ff->atom_count;
+    int nx = job->nx, ny = job->ny, nz = job->nz;
+    double* gx = ff->worker_gradients + (size_t)thread_index * 3 * n;
+    double* gy = gx + n;
+    double* gz = gy + n;
+    PairWorker* w = &job->workers[thread_index];
+
+    for (int c = begin; c < end; c++) {
+        if (start[c] == start[c + 1]) continue;
+        int cx = c % nx, cy = (c / nx) % ny, cz = c / (nx * ny);
+        int lo = cx - CELL_REACH > 0 ? cx - CELL_REACH : 0;
+        int hi = cx + CELL_REACH < nx - 1 ? cx + CELL_REACH : nx - 1;
+        int own_end = start[c - cx + hi + 1];
+
+        /* Half shell: the rest of the own row, then the rows above in y and z */
+        int runs[ROW_COUNT][2];
+        int run_count = 0;
+        for (int dz = 0; dz <= CELL_REACH; dz++) {
+            for (int dy = dz == 0 ? 1 : -CELL_REACH; dy <= CELL_REACH; dy++) {
+                int y = cy + dy, z = cz + dz;
+                if (y < 0 || y >= ny || z >= nz) continue;
+                int row = (z * ny + y) * nx;
+                if (start[row + lo] == start[row + hi + 1]) continue;
+                runs[run_count][0] = start[row + lo];
+                runs[run_count++][1] = start[row + hi + 1];
+            }
+        }
+
+        for (int i = start[c]; i < start[c + 1]; i++) {
+            RowSum sum = {0.0, 0.0, 0.0, 0.0, 0};
+            lj_row(&job->data, i, i + 1, own_end, gx, gy, gz, &sum);
+            for (int r = 0; r < run_count; r++) {
+                lj_row(&job->data, i, runs[r][0], runs[r][1], gx, gy, gz, &sum);
+            }
+            gx[i] += sum.gx;
+            gy[i] += sum.gy;
+            gz[i] += sum.gz;
+            w->energy += sum.energy;
+            w->pairs += sum.pairs;
+        }
+    }
+}
+
+static int axis_cells(double extent, double width) {
+    return (int)(extent / width) + 1;
+}
+
+/* Sort atoms into cells; returns the number of cells or -1 */
+static int build_cells(ForceField* ff, const Molecule* mol, int* nx, int* ny, int* nz) {
+    int n = ff->atom_count;
+    const double* x = mol->coord_x;
+    const double* y = mol->coord_y;
+    const double* z = mol->coord_z;
+
+    double lo[3] = {x[0], y[0], z[0]}, hi[3] = {x[0], y[0], z[0]};
+    for (int i = 1; i < n; i++) {
+        double p[3] = {x[i], y[i], z[i]};
+        for (int a = 0; a < 3; a++) {
+            if (p[a] < lo[a]) lo[a] = p[a];
+            if (p[a] > hi[a]) hi[a] = p[a];
+        }
+    }
+
+    if (!isfinite(lo[0] + lo[1] + lo[2] + hi[0] + hi[1] + hi[2])) return -1;
+
+    /* Cells at least cutoff / CELL_REACH wide, widened for sparse systems */
+    double width = ff->cutoff / CELL_REACH;
+    long long limit = 4LL * n + 64;
+    long long cells;
+    for (;;) {
+        *nx = axis_cells(hi[0] - lo[0], width);
+        *ny = axis_cells(hi[1] - lo[1], width);
+        *nz = axis_cells(hi[2] - lo[2], width);
+        cells = (long long)*nx * *ny * *nz;
+        if (cells <= limit) break;
+        width *= 1.26;
+    }
+
+    if (cells + 1 > ff->cell_capacity) {
+        if (!grow((void**)&ff->cell_start, cells + 1, sizeof(int))) return -1;
+        ff->cell_capacity = (int)cells + 1;
+    }
+    int* start = ff->cell_start;
+    memset(start, 0, (cells + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int cx = (int)((x[i] - lo[0]) / width);
+        int cy = (int)((y[i] - lo[1]) / width);
+        int cz = (int)((z[i] - lo[2]) / width);
+        int c = (cz * *ny + cy) * *nx + cx;
+        ff->cell_of[i] = c;
+        start[c + 1]++;
+    }
+    for (long long c = 0; c < cells; c++) start[c + 1] += start[c];
+
+    double* sx = ff->sorted;
+    double* sy = sx + n;
+    double* sz = sy + n;
+    double* sr = sz + n;
+    double* se = sr + n;
+    for (int i = 0; i < n; i++) {
+        int k = start[ff->cell_of[i]]++;
+        ff->order[k] = i;
+        sx[k] = x[i];
+        sy[k] = y[i];
+        sz[k] = z[i];
+        sr[k] = ff->radius[i];
+        se[k] = ff->sqrt_epsilon[i];
+    }
+    /* Undo the shift left by the placement pass */
+    for (long long c = cells; c > 0; c--) start[c] = start[c - 1];
+    start[0] = 0;
+    return (int)cells;
+}
+
+static bool nonbonded(ForceField* ff, const Molecule* mol, int threads, ForceFieldEnergy* e) {
+    int n = ff->atom_count;
+    int nx, ny, nz;
+    int cells = build_cells(ff, mol, &nx, &ny, &nz);
+    if (cells < 0) return false;
+
+    size_t needed = 3 * (size_t)n * threads;
+    if (needed > ff->worker_capacity) {
+        if (!grow((void**)&ff->worker_gradients, needed, sizeof(double))) return false;
+        ff->worker_capacity = needed;
+    }
+    memset(ff->worker_gradients, 0, needed * sizeof(double));
+    PairWorker* workers = calloc(threads, sizeof(PairWorker));
+    if (!workers) return false;
+
+    PairJob job;
+    job.ff = ff;
+    job.data.x = ff->sorted;
+    job.data.y = ff->sorted + n;
+    job.data.z = ff->sorted + 2 * (size_t)n;
+    job.data.radius = ff->sorted + 3 * (size_t)n;
+    job.data.sqrt_epsilon = ff->sorted + 4 * (size_t)n;
+    job.data.cutoff2 = ff->cutoff * ff->cutoff;
+    job.nx = nx;
+    job.ny = ny;
+    job.nz = nz;
+    job.workers = workers;
+    parallel_for(cells, CELL_CHUNK, threads, pair_cells, &job);
+
+    for (int t = 0; t < threads; t++) {
+        e->van_der_waals += workers[t].energy;
+        e->pairs += workers[t].pairs;
+        const double* g = ff->worker_gradients + (size_t)t * 3 * n;
+        for (int k = 0; k < n; k++) {
+            int i = ff->order[k];
+            ff->grad_x[i] += g[k];
+            ff->grad_y[i] += g[n + k];
+            ff->grad_z[i] += g[2 * n + k];
+        }
+    }
+    free(workers);
+    return true;
+}
+
+/* ============ Energy ============ */
+
+/* Remove excluded pairs that the cell pass counted, exactly as it did */
+static void subtract_exclusions(ForceField* ff, const Molecule* mol, ForceFieldEnergy* e) {
+    const double* x = mol->coord_x;
+    const double* y = mol->coord_y;
+    const double* z = mol->coord_z;
+    double cutoff2 = ff->cutoff * ff->cutoff;
+
+    for (int k = 0; k < ff->exclusion_count; k++) {
+        int i = (int)(ff->exclusions[k] >> 32);
+        int j = (int)(ff->exclusions[k] & 0xFFFFFFFF);
+        double dx = x[i] - x[j], dy = y[i] - y[j], dz = z[i] - z[j];
+        double r2 = dx * dx + dy * dy + dz * dz;
+        if (!(r2 < cutoff2)) continue;
+        double clamped = r2 > MIN_PAIR_DISTANCE2 ? r2 : MIN_PAIR_DISTANCE2;
+        double inv = 1.0 / clamped;
+        double rm = ff->radius[i] + ff->radius[j];
+        double s2 = rm * rm * inv;
+        double s6 = s2 * s2 * s2;
+        double s12 = s6 * s6;
+        double eps = ff->sqrt_epsilon[i] * ff->sqrt_epsilon[j];
+        double f = 12.0 * eps * (s6 - s12) * inv;
+        e->van_der_waals -= eps * (s12 - 2.0 * s6) + 0.5 * f * (r2 - clamped);
+        e->pairs--;
+        ff->grad_x[i] -= f * dx;
+        ff->grad_y[i] -= f * dy;
+        ff->grad_z[i] -= f * dz;
+        ff->grad_x[j] += f * dx;
+        ff->grad_y[j] += f * dy;
+        ff->grad_z[j] += f * dz;
+    }
+}
+
+/* Coulomb over the (usually few) charged atoms */
+static void electrostatics(ForceField* ff, const Molecule* mol, ForceFieldEnergy* e) {
+    const double* x = mol->coord_x;
+    const double* y = mol->coord_y;
+    const double* z = mol->coord_z;
+    double cutoff2 = ff->cutoff * ff->cutoff;
+
+    for (int a = 0; a < ff->charged_count; a++) {
+        int i = ff->charged[a];
+        for (int b = a + 1; b < ff->charged_count; b++) {
+            int j = ff->charged[b];
+            double dx = x[i] - x[j], dy = y[i] - y[j], dz = z[i] - z[j];
+            double r2 = dx * dx + dy * dy + dz * dz;
+            if (!(r2 < cutoff2) || excluded(ff, i, j)) continue;
+            double clamped = r2 > MIN_PAIR_DISTANCE2 ? r2 : MIN_PAIR_DISTANCE2;
+            double r = sqrt(clamped);
+            double energy = COULOMB_CONSTANT * ff->charge[i] * ff->charge[j] / r;
+            double f = -energy / clamped;
+            e->electrostatic += energy + 0.5 * f * (r2 - clamped);
+            ff->grad_x[i] += f * dx;
+            ff->grad_y[i] += f * dy;
+            ff->grad_z[i] += f * dz;
+            ff->grad_x[j] -= f * dx;
+            ff->grad_y[j] -= f * dy;
+            ff->grad_z[j] -= f * dz;
+        }
+    }
+}
+
+static void bond_terms(ForceField* ff, const Molecule* mol, ForceFieldEnergy* e) {
+    const double* x = mol->coord_x;
+    const double* y = mol->coord_y;
+    const double* z = mol->coord_z;
+
+    for (int b = 0; b < ff->bond_count; b++) {
+        int i = ff->bond_atoms[2 * b], j = ff->bond_atoms[2 * b + 1];
+        double dx = x[i] - x[j], dy = y[i] - y[j], dz = z[i] - z[j];
+        double r = sqrt(dx * dx + dy * dy + dz * dz);
+        double stretch = r - ff->bond_r0[b];
+        e->bond += ff->bond_k[b] * stretch * stretch;
+        if (r < 1e-12) continue;
+        double f = 2.0 * ff->bond_k[b] * stretch / r;
+        ff->grad_x[i] += f * dx;
+        ff->grad_y[i] += f * dy;
+        ff->grad_z[i] += f * dz;
+        ff->grad_x[j] -= f * dx;
+        ff->grad_y[j] -= f * dy;
+        ff->grad_z[j] -= f * dz;
+    }
+}
+
+static void angle_terms(ForceField* ff, const Molecule* mol, ForceFieldEnergy* e) {
+    const double* x = mol->coord_x;
+    const double* y = mol->coord_y;
+    const double* z = mol->coord_z;
+
+    for (int t = 0; t < ff->angle_count; t++) {
+        int a = ff->angle_atoms[3 * t], c = ff->angle_atoms[3 * t + 1], b = ff->angle_atoms[3 * t + 2];
+        double u[3] = {x[a] - x[c], y[a] - y[c], z[a] - z[c]};
+        double v[3] = {x[b] - x[c], y[b] - y[c], z[b] - z[c]};
+        double uu = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+        double vv = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+        if (uu < 1e-12 || vv < 1e-12) continue;
+        double norm = 1.0 / sqrt(uu * vv);
+        double cos = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) * norm;
+        double delta = cos - ff->angle_cos0[t];
+        e->angle += ff->angle_k[t] * delta * delta;
+
+        double f = 2.0 * ff->angle_k[t] * delta;
+        double* g[3] = {ff->grad_x, ff->grad_y, ff->grad_z};
+        for (int k = 0; k < 3; k++) {
+            double da = f * (v[k] * norm - cos * u[k] / uu);
+            double db = f * (u[k] * norm - cos * v[k] / vv);
+            g[k][a] += da;
+            g[k][b] += db;
+            g[k][c] -= da + db;
+        }
+    }
+}
+
+double forcefield_energy(ForceField* ff, const Molecule* mol, int threads, ForceFieldEnergy* terms) {
+    if (!ff || !mol || !mol->coord_x || mol->atom_count != ff->atom_count) return NAN;
+
+    ForceFieldEnergy e;
+    memset(&e, 0, sizeof(e));
+    int n = ff->atom_count;
+    if (n > 0) {
+        memset(ff->grad_x, 0, n * sizeof(double));
+        memset(ff->grad_y, 0, n * sizeof(double));
+        memset(ff->grad_z, 0, n * sizeof(double));
+
+        threads = n < PARALLEL_MIN_ATOMS ? 1 : parallel_thread_count(threads);
+        if (!nonbonded(ff, mol, threads, &e)) return NAN;
+        subtract_exclusions(ff, mol, &e);
+        electrostatics(ff, mol, &e);
+        bond_terms(ff, mol, &e);
+        angle_terms(ff, mol, &e);
+    }
+
+    e.total = e.bond + e.angle + e.van_der_waals + e.electrostatic;
+    if (terms) *terms = e;
+    return e.total;
+}
+
+/* ============ Embedding ============ */
+
+static double random_unit(unsigned int* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state & 0xFFFFFF) / (double)0x1000000;
+}
+
+/* Random direction, uniform in the unit ball then normalized */
+static void random_direction(unsigned int* state, double d[3]) {
+    double r2;
+    do {
+        for (int k = 0; k < 3; k++) d[k] = 2.0 * random_unit(state) - 1.0;
+        r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    } while (r2 > 1.0 || r2 < 1e-4);
+    double scale = 1.0 / sqrt(r2);
+    for (int k = 0; k < 3; k++) d[k] *= scale;
+}
+
+#define EMBED_BEND 1.2
+#define FRAGMENT_GAP 4.0
+
+bool forcefield_embed(const ForceField* ff, Molecule* mol, unsigned int seed) {
+    if (!ff || !mol || mol->atom_count != ff->atom_count) return false;
+    if (!molecule_enable_coordinates(mol) || !molecule_build_adjacency(mol)) return false;
+
+    int n = mol->atom_count;
+    int* parent = malloc((n > 0 ? n : 1) * sizeof(int));
+    int* queue = malloc((n > 0 ? n : 1) * sizeof(int));
+    if (!parent || !queue) {
+        free(parent);
+        free(queue);
+        return false;
+    }
+    for (int i = 0; i < n; i++) parent[i] = -2;
+
+    unsigned int state = seed ? seed : 0x9E3779B9u;
+    double* x = mol->coord_x;
+    double* y = mol->coord_y;
+    double* z = mol->coord_z;
+    double right = -FRAGMENT_GAP;
+
+    for (int root = 0; root < n; root++) {
+        if (parent[root] != -2) continue;
+        parent[root] = -1;
+        x[root] = right + FRAGMENT_GAP;
+        y[root] = 0.0;
+        z[root] = 0.0;
+        int head = 0, tail = 0;
+        queue[tail++] = root;
+
+        while (head < tail) {
+            int v = queue[head++];
+            double base[3];
+            if (parent[v] >= 0) {
+                int p = parent[v];
+                base[0] = x[v] - x[p];
+                base[1] = y[v] - y[p];
+                base[2] = z[v] - z[p];
+                double len = sqrt(base[0] * base[0] + base[1] * base[1] + base[2] * base[2]);
+                for (int k = 0; k < 3; k++) base[k] = len > 1e-12 ? base[k] / len : 0.0;
+            } else {
+                base[0] = base[1] = base[2] = 0.0;
+            }
+
+            for (int k = mol->adjacency_offsets[v]; k < mol->adjacency_offsets[v + 1]; k++) {
+                int u = mol->adjacency[k];
+                if (parent[u] != -2) continue;
+                parent[u] = v;
+                queue[tail++] = u;
+
+                double d[3];
+                random_direction(&state, d);
+                for (int a = 0; a < 3; a++) d[a] = base[a] + EMBED_BEND * d[a];
+                double len = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+                double r0 = ff->bond_r0[mol->adjacency_bonds[k]];
+                double scale = len > 1e-12 ? r0 / len : 0.0;
+                x[u] = x[v] + scale * d[0];
+                y[u] = y[v] + scale * d[1];
+                z[u] = z[v] + scale * d[2];
+            }
+        }
+
+        /* Next fragment starts clear of this one */
+        for (int k = 0; k < tail; k++) {
+            if (x[queue[k]] > right) right = x[queue[k]];
+        }
+    }
+
+    free(parent);
+    free(queue);
+    return true;
+}
+
+/* ============ Minimization ============ */
+
+#define INITIAL_STEP 0.1
+#define MAX_STEP 0.5
+#define MIN_STEP 1e-6
+
+static double gradient_norms(const ForceField* ff, double* max_norm) {
+    double sum = 0.0, max2 = 0.0;
+    for (int i = 0; i < ff->atom_count; i++) {
+        double g2 = ff->grad_x[i] * ff->grad_x[i] + ff->grad_y[i] * ff->grad_y[i] +
+                    ff->grad_z[i] * ff->grad_z[i];
+        sum += g2;
+        if (g2 > max2) max2 = g2;
+    }
+    *max_norm = sqrt(max2);
+    return ff->atom_count > 0 ? sqrt(sum / ff->atom_count) : 0.0;
+}
+
+bool forcefield_minimize(ForceField* ff, Molecule* mol, int max_steps, double rms_tolerance,
+                         int threads, MinimizeResult* result) {
+    MinimizeResult r;
+    memset(&r, 0, sizeof(r));
+    if (result) *result = r;
+
+    double energy = forcefield_energy(ff, mol, threads, NULL);
+    if (isnan(energy)) return false;
+    r.initial_energy = energy;
+
+    int n = ff->atom_count;
+    size_t bytes = (size_t)n * sizeof(double);
+    double* saved = ff->saved;
+    double* x = mol->coord_x;
+    double* y = mol->coord_y;
+    double* z = mol->coord_z;
+    double step = INITIAL_STEP;
+    double max_gradient;
+    r.rms_gradient = gradient_norms(ff, &max_gradient);
+
+    while (r.steps < max_steps) {
+        if (r.rms_gradient < rms_tolerance) {
+            r.converged = true;
+            break;
+        }
+        if (step < MIN_STEP || max_gradient <= 0.0) break;
+        r.steps++;
+
+        memcpy(saved, x, bytes);
+        memcpy(saved + n, y, bytes);
+        memcpy(saved + 2 * n, z, bytes);
+        memcpy(saved + 3 * n, ff->grad_x, bytes);
+        memcpy(saved + 4 * n, ff->grad_y, bytes);
+        memcpy(saved + 5 * n, ff->grad_z, bytes);
+
+        double scale = step / max_gradient;
+        for (int i = 0; i < n; i++) {
+            x[i] -= scale * ff->grad_x[i];
+            y[i] -= scale * ff->grad_y[i];
+            z[i] -= scale * ff->grad_z[i];
+        }
+
+        double trial = forcefield_energy(ff, mol, threads, NULL);
+        if (isnan(trial)) return false;
+        if (trial < energy) {
+            energy = trial;
+            r.rms_gradient = gradient_norms(ff, &max_gradient);
+            step = step * 1.2 < MAX_STEP ? step * 1.2 : MAX_STEP;
+        } else {
+            memcpy(x, saved, bytes);
+            memcpy(y, saved + n, bytes);
+            memcpy(z, saved + 2 * n, bytes);
+            memcpy(ff->grad_x, saved + 3 * n, bytes);
+            memcpy(ff->grad_y, saved + 4 * n, bytes);
+            memcpy(ff->grad_z, saved + 5 * n, bytes);
+            step *= 0.5;
+        }
+    }
+    if (r.rms_gradient < rms_tolerance) r.converged = true;
+
+    r.final_energy = energy;
+    if (result) *result = r;
+    return true;
+}
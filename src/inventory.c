@@ -0,0 +1,171 @@
+#include "inventory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Count distinct species ids among a reaction's reactants (-1 if removed: never runnable) */
+static int distinct_reactant_species(const Reaction* rxn) {
+    if (!rxn) return -1;
+    int distinct = 0;
+    for (int i = 0; i < rxn->reactant_count; i++) {
+        bool repeated = false;
+        for (int j = 0; j < i; j++) {
+            if (rxn->reactant_species[j] == rxn->reactant_species[i]) {
+                repeated = true;
+                break;
+            }
+        }
+        if (!repeated) distinct++;
+    }
+    return distinct;
+}
+
+static void runnable_insert(Inventory* inv, int rxn) {
+    if (inv->runnable_pos[rxn] >= 0) return;
+    inv->runnable_pos[rxn] = inv->runnable_count;
+    inv->runnable[inv->runnable_count++] = rxn;
+}
+
+static void runnable_erase(Inventory* inv, int rxn) {
+    int pos = inv->runnable_pos[rxn];
+    if (pos < 0) return;
+
+    int last = inv->runnable[--inv->runnable_count];
+    inv->runnable[pos] = last;
+    inv->runnable_pos[last] = pos;
+    inv->runnable_pos[rxn] = -1;
+}
+
+bool inventory_init(Inventory* inv) {
+    if (!inv) return false;
+    memset(inv, 0, sizeof(Inventory));
+
+    /* Sizes and counts come from one database snapshot */
+    reaction_db_read_begin();
+    inv->species_count = reaction_db_species_count();
+    inv->reaction_count = reaction_db_count();
+
+    size_t species_n = (size_t)(inv->species_count > 0 ? inv->species_count : 1);
+    size_t reaction_n = (size_t)(inv->reaction_count > 0 ? inv->reaction_count : 1);
+
+    inv->in_stock = calloc(species_n, sizeof(bool));
+    inv->missing = malloc(reaction_n * sizeof(int));
+    inv->runnable = malloc(reaction_n * sizeof(int));
+    inv->runnable_pos = malloc(reaction_n * sizeof(int));
+    if (!inv->in_stock || !inv->missing || !inv->runnable || !inv->runnable_pos) {
+        reaction_db_read_end();
+        inventory_free(inv);
+        return false;
+    }
+
+    inventory_clear(inv);
+    reaction_db_read_end();
+    return true;
+}
+
+void inventory_free(Inventory* inv) {
+    if (!inv) return;
+    free(inv->in_stock);
+    free(inv->missing);
+    free(inv->runnable);
+    free(inv->runnable_pos);
+    memset(inv, 0, sizeof(Inventory));
+}
+
+void inventory_clear(Inventory* inv) {
+    if (!inv || !inv->missing) return;
+
+    memset(inv->in_stock, 0, (size_t)inv->species_count * sizeof(bool));
+    inv->runnable_count = 0;
+    reaction_db_read_begin();
+    for (int r = 0; r < inv->reaction_count; r++) {
+        inv->missing[r] = distinct_reactant_species(reaction_db_get(r));
+        inv->runnable_pos[r] = -1;
+        if (inv->missing[r] == 0) runnable_insert(inv, r);
+    }
+    reaction_db_read_end();
+}
+
+static void inventory_set(Inventory* inv, int species_id, bool present) {
+    if (species_id < 0 || species_id >= inv->species_count) return;
+    if (inv->in_stock[species_id] == present) return;
+    inv->in_stock[species_id] = present;
+
+    /* Postings may list reactions added after the inventory was built */
+    reaction_db_read_begin();
+    const int* postings;
+    int n = reaction_db_species_consumers(species_id, &postings);
+    for (int i = 0; i < n; i++) {
+        int r = postings[i];
+        if (r >= inv->reaction_count || inv->missing[r] < 0) continue;
+        if (present) {
+            if (--inv->missing[r] == 0) runnable_insert(inv, r);
+        } else {
+            if (inv->missing[r]++ == 0) runnable_erase(inv, r);
+        }
+    }
+    reaction_db_read_end();
+}
+
+bool inventory_add(Inventory* inv, const Formula* species) {
+    if (!inv || !inv->missing || !species) return false;
+    inventory_set(inv, reaction_db_species_find(species), true);
+    return true;
+}
+
+bool inventory_remove(Inventory* inv, const Formula* species) {
+    if (!inv || !inv->missing || !species) return false;
+    inventory_set(inv, reaction_db_species_find(species), false);
+    return true;
+}
+
+bool inventory_add_string(Inventory* inv, const char* formula) {
+    Formula f;
+    if (!formula_parse(formula, &f)) return false;
+    return inventory_add(inv, &f);
+}
+
+bool inventory_remove_string(Inventory* inv, const char* formula) {
+    Formula f;
+    if (!formula_parse(formula, &f)) return false;
+    return inventory_remove(inv, &f);
+}
+
+bool inventory_has(const Inventory* inv, const Formula* species) {
+    if (!inv || !inv->in_stock || !species) return false;
+    int id = reaction_db_species_find(species);
+    return id >= 0 && id < inv->species_count && inv->in_stock[id];
+}
+
+bool inventory_can_run(const Inventory* inv, int reaction_index) {
+    if (!inv || !inv->missing) return false;
+    if (reaction_index < 0 || reaction_index >= inv->reaction_count) return false;
+    return inv->missing[reaction_index] == 0 && reaction_db_get(reaction_index) != NULL;
+}
+
+int inventory_runnable(const Inventory* inv, const Reaction** results, int max_results) {
+    if (!inv || !results || max_results <= 0) return 0;
+
+    int count = 0;
+    for (int i = 0; i < inv->runnable_count && count < max_results; i++) {
+        const Reaction* rxn = reaction_db_get(inv->runnable[i]);
+        if (rxn) results[count++] = rxn;
+    }
+    return count;
+}
+
+int inventory_query(const Formula* species, int species_count,
+                    const Reaction** results, int max_results) {
+    if (!species || species_count < 0) return 0;
+
+    Inventory inv;
+    if (!inventory_init(&inv)) return 0;
+
+    for (int i = 0; i < species_count; i++) {
+        inventory_add(&inv, &species[i]);
+    }
+    int count = inventory_runnable(&inv, results, max_results);
+
+    inventory_free(&inv);
+    return count;
+}
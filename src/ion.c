@@ -0,0 +1,285 @@
+#include "ion.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Common polyatomic ions
+ * Parts list atomic numbers and counts in the order the formula is written
+ */
+const PolyatomicIon POLYATOMIC_IONS[NUM_POLYATOMIC_IONS] = {
+    {"NH4",    "Ammonium",           1, 2, {{7, 1}, {1, 4}}},
+    {"OH",     "Hydroxide",         -1, 2, {{8, 1}, {1, 1}}},
+    {"NO3",    "Nitrate",           -1, 2, {{7, 1}, {8, 3}}},
+    {"NO2",    "Nitrite",           -1, 2, {{7, 1}, {8, 2}}},
+    {"SO4",    "Sulfate",           -2, 2, {{16, 1}, {8, 4}}},
+    {"SO3",    "Sulfite",           -2, 2, {{16, 1}, {8, 3}}},
+    {"HSO4",   "Hydrogen Sulfate",  -1, 3, {{1, 1}, {16, 1}, {8, 4}}},
+    {"CO3",    "Carbonate",         -2, 2, {{6, 1}, {8, 3}}},
+    {"HCO3",   "Bicarbonate",       -1, 3, {{1, 1}, {6, 1}, {8, 3}}},
+    {"PO4",    "Phosphate",         -3, 2, {{15, 1}, {8, 4}}},
+    {"HPO4",   "Hydrogen Phosphate",-2, 3, {{1, 1}, {15, 1}, {8, 4}}},
+    {"H2PO4",  "Dihydrogen Phosphate",-1, 3, {{1, 2}, {15, 1}, {8, 4}}},
+    {"ClO",    "Hypochlorite",      -1, 2, {{17, 1}, {8, 1}}},
+    {"ClO3",   "Chlorate",          -1, 2, {{17, 1}, {8, 3}}},
+    {"ClO4",   "Perchlorate",       -1, 2, {{17, 1}, {8, 4}}},
+    {"C2H3O2", "Acetate",           -1, 3, {{6, 2}, {1, 3}, {8, 2}}},
+    {"MnO4",   "Permanganate",      -1, 2, {{25, 1}, {8, 4}}},
+    {"CrO4",   "Chromate",          -2, 2, {{24, 1}, {8, 4}}},
+    {"Cr2O7",  "Dichromate",        -2, 2, {{24, 2}, {8, 7}}},
+    {"CN",     "Cyanide",           -1, 2, {{6, 1}, {7, 1}}}
+};
+
+#define AMMONIUM_INDEX 0
+
+int polyatomic_find(const char* formula) {
+    if (!formula) return -1;
+    for (int i = 0; i < NUM_POLYATOMIC_IONS; i++) {
+        if (strcmp(POLYATOMIC_IONS[i].formula, formula) == 0) return i;
+    }
+    return -1;
+}
+
+Ion ion_monatomic(const Element* element, int charge) {
+    Ion ion = {element, -1, charge};
+    return ion;
+}
+
+Ion ion_polyatomic(int index) {
+    Ion ion = {NULL, index, 0};
+    if (index >= 0 && index < NUM_POLYATOMIC_IONS) {
+        ion.charge = POLYATOMIC_IONS[index].charge;
+    } else {
+        ion.polyatomic = -1;
+    }
+    return ion;
+}
+
+bool ion_equals(const Ion* a, const Ion* b) {
+    if (!a || !b) return false;
+    return a->element == b->element && a->polyatomic == b->polyatomic &&
+           a->charge == b->charge;
+}
+
+int element_cation_charge(const Element* el) {
+    if (!el) return 0;
+    for (int i = 0; i < 4 && el->common_charges[i] != 0; i++) {
+        if (el->common_charges[i] > 0) return el->common_charges[i];
+    }
+    return 0;
+}
+
+int element_anion_charge(const Element* el) {
+    if (!el) return 0;
+    for (int i = 0; i < 4 && el->common_charges[i] != 0; i++) {
+        if (el->common_charges[i] < 0) return el->common_charges[i];
+    }
+    return 0;
+}
+
+bool ion_add_to_formula(const Ion* ion, int count, Formula* formula) {
+    if (!ion || !formula || count <= 0) return false;
+
+    if (ion->element) {
+        return formula_add_element(formula, ion->element, count);
+    }
+    if (ion->polyatomic < 0 || ion->polyatomic >= NUM_POLYATOMIC_IONS) return false;
+
+    const PolyatomicIon* poly = &POLYATOMIC_IONS[ion->polyatomic];
+    for (int i = 0; i < poly->part_count; i++) {
+        const Element* el = element_by_number(poly->parts[i].atomic_number);
+        if (!formula_add_element(formula, el, poly->parts[i].count * count)) return false;
+    }
+    return true;
+}
+
+static int gcd(int a, int b) {
+    if (a < 0) a = -a;
+    if (b < 0) b = -b;
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+bool ion_compound(const Ion* cation, const Ion* anion, Formula* result) {
+    if (!cation || !anion || !result) return false;
+    if (cation->charge <= 0 || anion->charge >= 0) return false;
+
+    int g = gcd(cation->charge, anion->charge);
+    memset(result, 0, sizeof(Formula));
+    result->coefficient = 1;
+    return ion_add_to_formula(cation, -anion->charge / g, result) &&
+           ion_add_to_formula(anion, cation->charge / g, result);
+}
+
+/* ============ Compound Splitting ============ */
+
+/* Remaining composition after removing the cations */
+typedef struct {
+    const Element* element[MAX_ION_PARTS + 1];
+    int count[MAX_ION_PARTS + 1];
+    int length;
+} Remainder;
+
+/* Subtract count copies of an ion from a compound; false if it doesn't fit */
+static bool subtract_ion(const Formula* compound, const Ion* ion, int count, Remainder* rem) {
+    int taken[MAX_ATOMS_PER_MOLECULE] = {0};
+
+    if (ion->element) {
+        bool found = false;
+        for (int i = 0; i < compound->element_count; i++) {
+            if (compound->elements[i].element == ion->element) {
+                taken[i] = count;
+                found = true;
+            }
+        }
+        if (!found) return false;
+    } else {
+        const PolyatomicIon* poly = &POLYATOMIC_IONS[ion->polyatomic];
+        for (int p = 0; p < poly->part_count; p++) {
+            bool found = false;
+            for (int i = 0; i < compound->element_count; i++) {
+                if (compound->elements[i].element->atomic_number == poly->parts[p].atomic_number) {
+                    taken[i] = poly->parts[p].count * count;
+                    found = true;
+                }
+            }
+            if (!found) return false;
+        }
+    }
+
+    rem->length = 0;
+    for (int i = 0; i < compound->element_count; i++) {
+        int left = compound->elements[i].count - taken[i];
+        if (left < 0) return false;
+        if (left == 0) continue;
+        if (rem->length > MAX_ION_PARTS) return false;
+        rem->element[rem->length] = compound->elements[i].element;
+        rem->count[rem->length] = left;
+        rem->length++;
+    }
+    return rem->length > 0;
+}
+
+/* Match a remainder as m anions; returns m or 0 */
+static int match_anion(const Remainder* rem, Ion* anion) {
+    if (rem->length == 1 && !element_is_metal(rem->element[0])) {
+        int charge = element_anion_charge(rem->element[0]);
+        if (charge < 0) {
+            *anion = ion_monatomic(rem->element[0], charge);
+            return rem->count[0];
+        }
+    }
+
+    for (int p = 0; p < NUM_POLYATOMIC_IONS; p++) {
+        const PolyatomicIon* poly = &POLYATOMIC_IONS[p];
+        if (poly->charge >= 0 || poly->part_count != rem->length) continue;
+
+        int multiple = 0;
+        bool match = true;
+        for (int i = 0; i < poly->part_count && match; i++) {
+            bool found = false;
+            for (int j = 0; j < rem->length; j++) {
+                if (rem->element[j]->atomic_number != poly->parts[i].atomic_number) continue;
+                int c = rem->count[j];
+                if (c % poly->parts[i].count != 0) break;
+                int m = c / poly->parts[i].count;
+                if (multiple == 0) multiple = m;
+                if (m == multiple) found = true;
+                break;
+            }
+            match = found;
+        }
+        if (match && multiple > 0) {
+            *anion = ion_polyatomic(p);
+            return multiple;
+        }
+    }
+    return 0;
+}
+
+/* Try a cation with a given charge for every plausible cation count */
+static bool try_cation(const Formula* compound, const Ion* cation, int max_count,
+                       Ion* anion, int* cation_count, int* anion_count) {
+    for (int n = max_count; n >= 1; n--) {
+        Remainder rem;
+        if (!subtract_ion(compound, cation, n, &rem)) continue;
+
+        int m = match_anion(&rem, anion);
+        if (m > 0 && n * cation->charge == -m * anion->charge) {
+            *cation_count = n;
+            *anion_count = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ion_split(const Formula* compound, Ion* cation, int* cation_count,
+               Ion* anion, int* anion_count) {
+    if (!compound || !cation || !cation_count || !anion || !anion_count) return false;
+    if (compound->element_count < 2 || compound->element_count > MAX_ION_PARTS + 1) return false;
+
+    const Element* metal = NULL;
+    int metal_count = 0, metals = 0;
+    int n_count = 0, h_count = 0;
+    for (int i = 0; i < compound->element_count; i++) {
+        const Element* el = compound->elements[i].element;
+        if (element_is_metal(el)) {
+            metal = el;
+            metal_count = compound->elements[i].count;
+            metals++;
+        }
+        if (el->atomic_number == 7) n_count = compound->elements[i].count;
+        if (el->atomic_number == 1) h_count = compound->elements[i].count;
+    }
+
+    /* Single metal cation, any of its common positive charges */
+    if (metals == 1) {
+        for (int i = 0; i < 4 && metal->common_charges[i] != 0; i++) {
+            if (metal->common_charges[i] <= 0) continue;
+            *cation = ion_monatomic(metal, metal->common_charges[i]);
+            if (try_cation(compound, cation, metal_count, anion, cation_count, anion_count)) {
+                /* Metal atoms must all belong to the cation */
+                return true;
+            }
+        }
+        return false;
+    }
+    if (metals > 1) return false;
+
+    /* Ammonium salts */
+    if (n_count > 0 && h_count >= 4) {
+        *cation = ion_polyatomic(AMMONIUM_INDEX);
+        int max_count = n_count < h_count / 4 ? n_count : h_count / 4;
+        if (try_cation(compound, cation, max_count, anion, cation_count, anion_count)) return true;
+    }
+
+    /* Acids: H+ with an anion */
+    if (h_count > 0) {
+        *cation = ion_monatomic(element_by_number(1), 1);
+        if (try_cation(compound, cation, h_count, anion, cation_count, anion_count)) return true;
+    }
+
+    return false;
+}
+
+void ion_print(const Ion* ion) {
+    if (!ion) {
+        printf("(null ion)");
+        return;
+    }
+
+    const char* symbol = "?";
+    if (ion->element) symbol = ion->element->symbol;
+    else if (ion->polyatomic >= 0) symbol = POLYATOMIC_IONS[ion->polyatomic].formula;
+
+    int magnitude = ion->charge < 0 ? -ion->charge : ion->charge;
+    if (magnitude > 1) {
+        printf("%s(%d%c)", symbol, magnitude, ion->charge < 0 ? '-' : '+');
+    } else {
+        printf("%s(%c)", symbol, ion->charge < 0 ? '-' : '+');
+    }
+}
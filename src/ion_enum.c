@@ -0,0 +1,401 @@
+#include "ion.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Enumeration of charge-neutral ionic compounds
+ *
+ * Ions come from Element.common_charges (plus POLYATOMIC_IONS). Work is
+ * partitioned by first cation and handed to worker threads; every
+ * candidate is reduced by the GCD of its subscripts, deduplicated through
+ * a sharded fingerprint set, and buffered per worker before being passed
+ * to the caller's emit function.
+ */
+
+#define FINGERPRINT_SHARDS 64
+#define EMIT_BATCH 256
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t* keys;             /* 0 marks an empty slot */
+    size_t capacity;
+    size_t count;
+} FingerprintShard;
+
+typedef struct {
+    const IonicEnumOptions* options;
+    Ion* cations;
+    int cation_count;
+    Ion* anions;
+    int anion_count;
+
+    FingerprintShard shards[FINGERPRINT_SHARDS];
+
+    pthread_mutex_t emit_lock;  /* Guards everything below */
+    IonicEmitFn emit;
+    void* user_data;
+    bool stop;
+    bool failed;
+    long long candidates;
+    long long unique;
+} EnumContext;
+
+typedef struct {
+    IonicCompound batch[EMIT_BATCH];
+    int batch_count;
+    long long candidates;
+    long long unique;
+} EnumBuffer;
+
+void ionic_enum_options_default(IonicEnumOptions* options) {
+    if (!options) return;
+    options->max_subscript = 6;
+    options->max_atomic_number = 86;
+    options->include_ternary = true;
+    options->include_polyatomic = true;
+    options->metal_cations_only = true;
+    options->threads = 0;
+}
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* ============ Fingerprint Set ============ */
+
+/* Insert a fingerprint; returns 1 if new, 0 if present, -1 on allocation failure */
+static int shard_insert(FingerprintShard* shard, uint64_t key) {
+    if (key == 0) key = 1;
+
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 2 > shard->capacity) {
+        size_t capacity = shard->capacity ? shard->capacity * 2 : 1024;
+        uint64_t* keys = calloc(capacity, sizeof(uint64_t));
+        if (!keys) {
+            pthread_mutex_unlock(&shard->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < shard->capacity; i++) {
+            uint64_t k = shard->keys[i];
+            if (!k) continue;
+            size_t slot = (size_t)k & (capacity - 1);
+            while (keys[slot]) slot = (slot + 1) & (capacity - 1);
+            keys[slot] = k;
+        }
+        free(shard->keys);
+        shard->keys = keys;
+        shard->capacity = capacity;
+    }
+
+    int inserted = 1;
+    size_t slot = (size_t)key & (shard->capacity - 1);
+    while (shard->keys[slot]) {
+        if (shard->keys[slot] == key) {
+            inserted = 0;
+            break;
+        }
+        slot = (slot + 1) & (shard->capacity - 1);
+    }
+    if (inserted) {
+        shard->keys[slot] = key;
+        shard->count++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return inserted;
+}
+
+/* ============ Candidate Handling ============ */
+
+static uint64_t compound_fingerprint(const IonicCompound* c) {
+    ElementCount parts[IONIC_MAX_IONS * MAX_ION_PARTS];
+    int n = 0;
+
+    for (int i = 0; i < c->ion_count; i++) {
+        const Ion* ion = &c->ions[i];
+        int piece_count = ion->element ? 1 : POLYATOMIC_IONS[ion->polyatomic].part_count;
+
+        for (int p = 0; p < piece_count; p++) {
+            const Element* el;
+            int count;
+            if (ion->element) {
+                el = ion->element;
+                count = c->counts[i];
+            } else {
+                const PolyatomicIon* poly = &POLYATOMIC_IONS[ion->polyatomic];
+                el = element_by_number(poly->parts[p].atomic_number);
+                count = poly->parts[p].count * c->counts[i];
+            }
+
+            int k = 0;
+            while (k < n && parts[k].element != el) k++;
+            if (k == n) {
+                parts[n].element = el;
+                parts[n].count = 0;
+                n++;
+            }
+            parts[k].count += count;
+        }
+    }
+    return formula_fingerprint_parts(parts, n);
+}
+
+/* Hand the buffered compounds to the caller; returns false once stopped */
+static bool flush_buffer(EnumContext* ctx, EnumBuffer* buf) {
+    pthread_mutex_lock(&ctx->emit_lock);
+    for (int i = 0; i < buf->batch_count && !ctx->stop; i++) {
+        if (ctx->emit && !ctx->emit(&buf->batch[i], ctx->user_data)) ctx->stop = true;
+    }
+    ctx->candidates += buf->candidates;
+    ctx->unique += buf->unique;
+    bool running = !ctx->stop;
+    pthread_mutex_unlock(&ctx->emit_lock);
+
+    buf->batch_count = 0;
+    buf->candidates = 0;
+    buf->unique = 0;
+    return running;
+}
+
+static bool consider(EnumContext* ctx, EnumBuffer* buf,
+                     const Ion* ions, int* counts, int ion_count) {
+    int g = 0;
+    for (int i = 0; i < ion_count; i++) g = gcd(counts[i], g);
+
+    IonicCompound* c = &buf->batch[buf->batch_count];
+    for (int i = 0; i < ion_count; i++) {
+        c->ions[i] = ions[i];
+        c->counts[i] = counts[i] / g;
+    }
+    c->ion_count = ion_count;
+    c->fingerprint = compound_fingerprint(c);
+    buf->candidates++;
+
+    int inserted = shard_insert(&ctx->shards[c->fingerprint >> 58], c->fingerprint);
+    if (inserted < 0) {
+        pthread_mutex_lock(&ctx->emit_lock);
+        ctx->failed = true;
+        ctx->stop = true;
+        pthread_mutex_unlock(&ctx->emit_lock);
+        return false;
+    }
+    if (inserted == 0) return true;
+
+    buf->unique++;
+    if (++buf->batch_count == EMIT_BATCH) return flush_buffer(ctx, buf);
+    return true;
+}
+
+/* All compounds whose first cation is cations[i] */
+static bool enumerate_cation(EnumContext* ctx, EnumBuffer* buf, int i) {
+    const Ion* cation = &ctx->cations[i];
+    int max = ctx->options->max_subscript;
+    int q = cation->charge;
+    Ion ions[IONIC_MAX_IONS];
+    int counts[IONIC_MAX_IONS];
+
+    /* Binary: one cation, one anion */
+    for (int a = 0; a < ctx->anion_count; a++) {
+        int qa = -ctx->anions[a].charge;
+        int g = gcd(q, qa);
+        counts[0] = qa / g;
+        counts[1] = q / g;
+        if (counts[0] > max || counts[1] > max) continue;
+        ions[0] = *cation;
+        ions[1] = ctx->anions[a];
+        if (!consider(ctx, buf, ions, counts, 2)) return false;
+    }
+
+    if (!ctx->options->include_ternary) return true;
+
+    /* Two cations, one anion: n1*q1 + n2*q2 = m*qa */
+    for (int j = i + 1; j < ctx->cation_count; j++) {
+        int q2 = ctx->cations[j].charge;
+        for (int a = 0; a < ctx->anion_count; a++) {
+            int qa = -ctx->anions[a].charge;
+            for (int n1 = 1; n1 <= max; n1++) {
+                for (int n2 = 1; n2 <= max; n2++) {
+                    int total = n1 * q + n2 * q2;
+                    if (total % qa != 0 || total / qa > max) continue;
+                    ions[0] = *cation;
+                    ions[1] = ctx->cations[j];
+                    ions[2] = ctx->anions[a];
+                    counts[0] = n1;
+                    counts[1] = n2;
+                    counts[2] = total / qa;
+                    if (!consider(ctx, buf, ions, counts, 3)) return false;
+                }
+            }
+        }
+    }
+
+    /* One cation, two anions: n*q = m1*qa1 + m2*qa2 */
+    for (int a1 = 0; a1 < ctx->anion_count; a1++) {
+        int qa1 = -ctx->anions[a1].charge;
+        for (int a2 = a1 + 1; a2 < ctx->anion_count; a2++) {
+            int qa2 = -ctx->anions[a2].charge;
+            for (int m1 = 1; m1 <= max; m1++) {
+                for (int m2 = 1; m2 <= max; m2++) {
+                    int total = m1 * qa1 + m2 * qa2;
+                    if (total % q != 0 || total / q > max) continue;
+                    ions[0] = *cation;
+                    ions[1] = ctx->anions[a1];
+                    ions[2] = ctx->anions[a2];
+                    counts[0] = total / q;
+                    counts[1] = m1;
+                    counts[2] = m2;
+                    if (!consider(ctx, buf, ions, counts, 3)) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void enumerate_range(int begin, int end, int thread_index, void* user_data) {
+    (void)thread_index;
+    EnumContext* ctx = user_data;
+
+    EnumBuffer* buf = malloc(sizeof(EnumBuffer));
+    if (!buf) {
+        pthread_mutex_lock(&ctx->emit_lock);
+        ctx->failed = true;
+        ctx->stop = true;
+        pthread_mutex_unlock(&ctx->emit_lock);
+        return;
+    }
+    buf->batch_count = 0;
+    buf->candidates = 0;
+    buf->unique = 0;
+
+    for (int i = begin; i < end; i++) {
+        pthread_mutex_lock(&ctx->emit_lock);
+        bool stopped = ctx->stop;
+        pthread_mutex_unlock(&ctx->emit_lock);
+        if (stopped || !enumerate_cation(ctx, buf, i)) break;
+    }
+    flush_buffer(ctx, buf);
+    free(buf);
+}
+
+/* ============ Ion Pools ============ */
+
+static bool build_ion_pools(EnumContext* ctx) {
+    const IonicEnumOptions* opt = ctx->options;
+    int capacity = NUM_ELEMENTS * 4 + NUM_POLYATOMIC_IONS;
+
+    ctx->cations = malloc((size_t)capacity * sizeof(Ion));
+    ctx->anions = malloc((size_t)capacity * sizeof(Ion));
+    if (!ctx->cations || !ctx->anions) return false;
+
+    for (int z = 1; z <= NUM_ELEMENTS && z <= opt->max_atomic_number; z++) {
+        const Element* el = element_by_number(z);
+        bool metal = element_is_metal(el);
+
+        for (int i = 0; i < 4 && el->common_charges[i] != 0; i++) {
+            int charge = el->common_charges[i];
+            if (charge > 0 && (metal || (!opt->metal_cations_only && z != 1))) {
+                ctx->cations[ctx->cation_count++] = ion_monatomic(el, charge);
+            } else if (charge < 0 && !metal) {
+                ctx->anions[ctx->anion_count++] = ion_monatomic(el, charge);
+            }
+        }
+    }
+
+    if (opt->include_polyatomic) {
+        for (int p = 0; p < NUM_POLYATOMIC_IONS; p++) {
+            if (POLYATOMIC_IONS[p].charge > 0) ctx->cations[ctx->cation_count++] = ion_polyatomic(p);
+            else ctx->anions[ctx->anion_count++] = ion_polyatomic(p);
+        }
+    }
+    return true;
+}
+
+bool ionic_enumerate(const IonicEnumOptions* options, IonicEmitFn emit,
+                     void* user_data, IonicEnumStats* stats) {
+    IonicEnumOptions opt;
+    if (options) opt = *options;
+    else ionic_enum_options_default(&opt);
+    if (opt.max_subscript < 1) opt.max_subscript = 1;
+
+    double start = parallel_now();
+
+    EnumContext ctx;
+    memset(&ctx, 0, sizeof(EnumContext));
+    ctx.options = &opt;
+    ctx.emit = emit;
+    ctx.user_data = user_data;
+    pthread_mutex_init(&ctx.emit_lock, NULL);
+    for (int s = 0; s < FINGERPRINT_SHARDS; s++) {
+        pthread_mutex_init(&ctx.shards[s].lock, NULL);
+    }
+
+    bool ok = build_ion_pools(&ctx);
+    if (ok) {
+        parallel_for(ctx.cation_count, 1, opt.threads, enumerate_range, &ctx);
+        ok = !ctx.failed;
+    }
+
+    if (stats) {
+        stats->candidates = ctx.candidates;
+        stats->unique = ctx.unique;
+        stats->seconds = parallel_now() - start;
+    }
+
+    for (int s = 0; s < FINGERPRINT_SHARDS; s++) {
+        free(ctx.shards[s].keys);
+        pthread_mutex_destroy(&ctx.shards[s].lock);
+    }
+    pthread_mutex_destroy(&ctx.emit_lock);
+    free(ctx.cations);
+    free(ctx.anions);
+    return ok;
+}
+
+/* ============ Output ============ */
+
+bool ionic_compound_to_formula(const IonicCompound* compound, Formula* formula) {
+    if (!compound || !formula) return false;
+
+    memset(formula, 0, sizeof(Formula));
+    formula->coefficient = 1;
+    for (int i = 0; i < compound->ion_count; i++) {
+        if (!ion_add_to_formula(&compound->ions[i], compound->counts[i], formula)) return false;
+    }
+    return true;
+}
+
+bool ionic_compound_format(const IonicCompound* compound, char* buffer, size_t buffer_size) {
+    if (!compound || !buffer || buffer_size == 0) return false;
+
+    char* p = buffer;
+    size_t remaining = buffer_size;
+    buffer[0] = '\0';
+
+    for (int i = 0; i < compound->ion_count; i++) {
+        const Ion* ion = &compound->ions[i];
+        const char* symbol = ion->element ? ion->element->symbol
+                                          : POLYATOMIC_IONS[ion->polyatomic].formula;
+        int count = compound->counts[i];
+        int written;
+
+        if (count == 1) {
+            written = snprintf(p, remaining, "%s", symbol);
+        } else if (ion->element) {
+            written = snprintf(p, remaining, "%s%d", symbol, count);
+        } else {
+            written = snprintf(p, remaining, "(%s)%d", symbol, count);
+        }
+        if (written < 0 || (size_t)written >= remaining) return false;
+        p += written;
+        remaining -= written;
+    }
+    return true;
+}
@@ -0,0 +1,226 @@
+#include "isotope.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Distribution over consecutive nominal masses. weighted[i] holds the sum
+ * of probability * exact mass of every isotopologue in bin i, which keeps
+ * convolution bilinear; the peak mass is weighted[i] / probability[i].
+ */
+typedef struct {
+    int first;                  /* Nominal mass of bin 0 */
+    int length;
+    double* probability;
+    double* weighted;
+} Distribution;
+
+static void dist_free(Distribution* d) {
+    free(d->probability);
+    free(d->weighted);
+    memset(d, 0, sizeof(*d));
+}
+
+static bool dist_alloc(Distribution* d, int first, int length) {
+    d->first = first;
+    d->length = length;
+    d->probability = calloc(length, sizeof(double));
+    d->weighted = calloc(length, sizeof(double));
+    if (!d->probability || !d->weighted) {
+        dist_free(d);
+        return false;
+    }
+    return true;
+}
+
+/* Point distribution: nominal mass 0 with probability 1 */
+static bool dist_unit(Distribution* d) {
+    if (!dist_alloc(d, 0, 1)) return false;
+    d->probability[0] = 1.0;
+    return true;
+}
+
+/* Single-atom distribution of an element */
+static bool dist_element(Distribution* d, const Element* el) {
+    const Isotope* isotopes;
+    int count = element_isotopes(el, &isotopes);
+
+    if (count == 0) {
+        if (!dist_alloc(d, (int)lround(el->atomic_mass), 1)) return false;
+        d->probability[0] = 1.0;
+        d->weighted[0] = el->atomic_mass;
+        return true;
+    }
+
+    int first = isotopes[0].mass_number;
+    if (!dist_alloc(d, first, isotopes[count - 1].mass_number - first + 1)) return false;
+    for (int i = 0; i < count; i++) {
+        int bin = isotopes[i].mass_number - first;
+        d->probability[bin] += isotopes[i].abundance;
+        d->weighted[bin] += isotopes[i].abundance * isotopes[i].mass;
+    }
+    return true;
+}
+
+/* Cut leading and trailing bins below the threshold */
+static void dist_trim(Distribution* d, double threshold) {
+    int begin = 0, end = d->length;
+    while (begin < end - 1 && d->probability[begin] < threshold) begin++;
+    while (end - 1 > begin && d->probability[end - 1] < threshold) end--;
+
+    if (begin > 0) {
+        memmove(d->probability, d->probability + begin, (end - begin) * sizeof(double));
+        memmove(d->weighted, d->weighted + begin, (end - begin) * sizeof(double));
+    }
+    d->first += begin;
+    d->length = end - begin;
+}
+
+/* out = a * b, trimmed; out must not alias a or b */
+static bool dist_convolve(const Distribution* a, const Distribution* b,
+                          Distribution* out, double threshold) {
+    if (!dist_alloc(out, a->first + b->first, a->length + b->length - 1)) return false;
+
+    for (int i = 0; i < a->length; i++) {
+        double pa = a->probability[i];
+        double wa = a->weighted[i];
+        if (pa == 0.0) continue;
+
+        double* p = out->probability + i;
+        double* w = out->weighted + i;
+        for (int j = 0; j < b->length; j++) {
+            p[j] += pa * b->probability[j];
+            w[j] += wa * b->probability[j] + pa * b->weighted[j];
+        }
+    }
+
+    dist_trim(out, threshold);
+    return true;
+}
+
+/* Replace *acc with *acc * factor */
+static bool dist_multiply(Distribution* acc, const Distribution* factor, double threshold) {
+    Distribution product;
+    if (!dist_convolve(acc, factor, &product, threshold)) return false;
+    dist_free(acc);
+    *acc = product;
+    return true;
+}
+
+/* acc *= base^exponent by repeated squaring */
+static bool dist_multiply_power(Distribution* acc, const Distribution* base,
+                                int exponent, double threshold) {
+    Distribution square;
+    if (!dist_alloc(&square, base->first, base->length)) return false;
+    memcpy(square.probability, base->probability, base->length * sizeof(double));
+    memcpy(square.weighted, base->weighted, base->length * sizeof(double));
+
+    bool ok = true;
+    while (ok && exponent > 0) {
+        if (exponent & 1) ok = dist_multiply(acc, &square, threshold);
+        exponent >>= 1;
+        if (ok && exponent > 0) {
+            Distribution next;
+            ok = dist_convolve(&square, &square, &next, threshold);
+            if (ok) {
+                dist_free(&square);
+                square = next;
+            }
+        }
+    }
+
+    dist_free(&square);
+    return ok;
+}
+
+/* ============ Public API ============ */
+
+void isotope_pattern_options_default(IsotopePatternOptions* options) {
+    if (!options) return;
+    options->prune_threshold = 1e-12;
+    options->min_relative = 1e-4;
+}
+
+bool isotope_pattern(const Formula* formula, const IsotopePatternOptions* options,
+                     IsotopePattern* pattern) {
+    if (!formula || !pattern) return false;
+    memset(pattern, 0, sizeof(*pattern));
+
+    IsotopePatternOptions defaults;
+    if (!options) {
+        isotope_pattern_options_default(&defaults);
+        options = &defaults;
+    }
+
+    Distribution total;
+    if (!dist_unit(&total)) return false;
+
+    for (int i = 0; i < formula->element_count; i++) {
+        const ElementCount* ec = &formula->elements[i];
+        if (ec->count <= 0) continue;
+
+        Distribution atom;
+        if (!dist_element(&atom, ec->element)) {
+            dist_free(&total);
+            return false;
+        }
+        bool ok = dist_multiply_power(&total, &atom, ec->count, options->prune_threshold);
+        dist_free(&atom);
+        if (!ok) {
+            dist_free(&total);
+            return false;
+        }
+    }
+
+    double base = 0.0, sum = 0.0, weighted = 0.0;
+    for (int i = 0; i < total.length; i++) {
+        if (total.probability[i] > base) base = total.probability[i];
+        sum += total.probability[i];
+        weighted += total.weighted[i];
+    }
+
+    pattern->peaks = malloc(total.length * sizeof(IsotopePeak));
+    if (!pattern->peaks) {
+        dist_free(&total);
+        return false;
+    }
+
+    for (int i = 0; i < total.length; i++) {
+        double p = total.probability[i];
+        if (p <= 0.0 || p < base * options->min_relative) continue;
+
+        IsotopePeak* peak = &pattern->peaks[pattern->peak_count++];
+        peak->nominal_mass = total.first + i;
+        peak->mass = total.weighted[i] / p;
+        peak->probability = p;
+        peak->relative = p / base;
+    }
+
+    Formula unit = *formula;
+    unit.coefficient = 1;
+    pattern->monoisotopic_mass = formula_monoisotopic_mass(&unit);
+    pattern->average_mass = sum > 0.0 ? weighted / sum : 0.0;
+
+    dist_free(&total);
+    return true;
+}
+
+void isotope_pattern_free(IsotopePattern* pattern) {
+    if (!pattern) return;
+    free(pattern->peaks);
+    memset(pattern, 0, sizeof(*pattern));
+}
+
+void isotope_pattern_print(const IsotopePattern* pattern) {
+    if (!pattern) return;
+
+    printf("Monoisotopic mass: %.6f\n", pattern->monoisotopic_mass);
+    printf("Average mass:      %.6f\n", pattern->average_mass);
+    printf("  Nominal        Mass    Abundance  Relative\n");
+    for (int i = 0; i < pattern->peak_count; i++) {
+        const IsotopePeak* peak = &pattern->peaks[i];
+        printf("  %7d  %12.6f  %10.6f%%  %7.2f%%\n", peak->nominal_mass, peak->mass,
+               peak->probability * 100.0, peak->relative * 100.0);
+    }
+}
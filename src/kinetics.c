@@ -0,0 +1,790 @@
+#include "kinetics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ROS2_GAMMA 1.7071067811865476      /* 1 + 1/sqrt(2) */
+#define STEP_KEEP_LOW 1.0                  /* Keep h (and W) for growth factors in here */
+#define STEP_KEEP_HIGH 1.2
+#define STEP_SAFETY 0.9
+#define STEP_MIN_FACTOR 0.2
+#define STEP_MAX_FACTOR 5.0
+
+void kinetics_options_default(KineticsOptions* options) {
+    if (!options) return;
+    options->rtol = 1e-4;
+    options->atol = 1e-10;
+    options->initial_step = 0.0;
+    options->max_step = 0.0;
+    options->max_steps = 1000000;
+    options->output_interval = 0.0;
+    options->jacobian_age = 20;
+}
+
+/* ============ Model ============ */
+
+void kinetics_model_init(KineticsModel* model) {
+    if (!model) return;
+    memset(model, 0, sizeof(KineticsModel));
+}
+
+static void free_pattern(KineticsModel* model) {
+    free(model->position);
+    free(model->lu_offsets);
+    free(model->lu_columns);
+    free(model->lu_diagonal);
+    free(model->lu_values);
+    free(model->jacobian_slots);
+    free(model->jacobian_values);
+    free(model->rates);
+    free(model->work);
+    model->position = NULL;
+    model->lu_offsets = NULL;
+    model->lu_columns = NULL;
+    model->lu_diagonal = NULL;
+    model->lu_values = NULL;
+    model->jacobian_slots = NULL;
+    model->jacobian_values = NULL;
+    model->rates = NULL;
+    model->work = NULL;
+    model->lu_nonzeros = 0;
+    model->jacobian_terms = 0;
+    model->prepared = false;
+}
+
+void kinetics_model_free(KineticsModel* model) {
+    if (!model) return;
+    free_pattern(model);
+    free(model->names);
+    free(model->fingerprints);
+    free(model->slots);
+    free(model->rate_constants);
+    free(model->reactant_offsets);
+    free(model->reactant_species);
+    free(model->reactant_orders);
+    free(model->stoich_offsets);
+    free(model->stoich_species);
+    free(model->stoich_values);
+    kinetics_model_init(model);
+}
+
+/* realloc that leaves *array untouched on failure */
+static bool resize(void** array, size_t bytes) {
+    void* grown = realloc(*array, bytes);
+    if (!grown) return false;
+    *array = grown;
+    return true;
+}
+
+static int next_capacity(int capacity, int needed) {
+    int cap = capacity ? capacity : 64;
+    while (cap < needed) cap *= 2;
+    return cap;
+}
+
+/* Grow the per-reaction and per-entry arrays; each group shares one capacity */
+static bool reserve_reactions(KineticsModel* model, int reactions, int reactant_entries,
+                              int stoich_entries) {
+    if (reactions > model->reaction_capacity) {
+        int cap = next_capacity(model->reaction_capacity, reactions);
+        if (!resize((void**)&model->rate_constants, (size_t)cap * sizeof(double)) ||
+            !resize((void**)&model->reactant_offsets, (size_t)(cap + 1) * sizeof(int)) ||
+            !resize((void**)&model->stoich_offsets, (size_t)(cap + 1) * sizeof(int))) {
+            return false;
+        }
+        model->reaction_capacity = cap;
+    }
+    if (reactant_entries > model->reactant_capacity) {
+        int cap = next_capacity(model->reactant_capacity, reactant_entries);
+        if (!resize((void**)&model->reactant_species, (size_t)cap * sizeof(int)) ||
+            !resize((void**)&model->reactant_orders, (size_t)cap * sizeof(int))) {
+            return false;
+        }
+        model->reactant_capacity = cap;
+    }
+    if (stoich_entries > model->stoich_capacity) {
+        int cap = next_capacity(model->stoich_capacity, stoich_entries);
+        if (!resize((void**)&model->stoich_species, (size_t)cap * sizeof(int)) ||
+            !resize((void**)&model->stoich_values, (size_t)cap * sizeof(double))) {
+            return false;
+        }
+        model->stoich_capacity = cap;
+    }
+    return true;
+}
+
+static int species_lookup(const KineticsModel* model, uint64_t fp) {
+    if (model->slot_count == 0) return -1;
+    int mask = model->slot_count - 1;
+    for (int slot = (int)(fp & (uint64_t)mask); ; slot = (slot + 1) & mask) {
+        int id = model->slots[slot];
+        if (id < 0 || model->fingerprints[id] == fp) return id;
+    }
+}
+
+static void species_slot_insert(KineticsModel* model, int id) {
+    int mask = model->slot_count - 1;
+    int slot = (int)(model->fingerprints[id] & (uint64_t)mask);
+    while (model->slots[slot] >= 0) slot = (slot + 1) & mask;
+    model->slots[slot] = id;
+}
+
+/* Species index of a formula, adding it if new (-1 on allocation failure) */
+static int species_intern(KineticsModel* model, const Formula* formula) {
+    uint64_t fp = formula_fingerprint(formula);
+    int id = species_lookup(model, fp);
+    if (id >= 0) return id;
+
+    int capacity = model->species_capacity;
+    if (model->species_count == capacity) {
+        capacity = capacity ? capacity * 2 : 64;
+        void* names = realloc(model->names, (size_t)capacity * KINETICS_NAME_LENGTH);
+        if (!names) return -1;
+        model->names = names;
+        uint64_t* fps = realloc(model->fingerprints, (size_t)capacity * sizeof(uint64_t));
+        if (!fps) return -1;
+        model->fingerprints = fps;
+        model->species_capacity = capacity;
+    }
+    if ((model->species_count + 1) * 2 > model->slot_count) {
+        int slot_count = model->slot_count ? model->slot_count * 2 : 128;
+        int* slots = malloc((size_t)slot_count * sizeof(int));
+        if (!slots) return -1;
+        free(model->slots);
+        model->slots = slots;
+        model->slot_count = slot_count;
+        for (int i = 0; i < slot_count; i++) slots[i] = -1;
+        for (int i = 0; i < model->species_count; i++) species_slot_insert(model, i);
+    }
+
+    id = model->species_count++;
+    model->fingerprints[id] = fp;
+    Formula bare = *formula;
+    bare.coefficient = 1;
+    if (!formula_to_string(&bare, model->names[id], KINETICS_NAME_LENGTH)) {
+        snprintf(model->names[id], KINETICS_NAME_LENGTH, "S%d", id);
+    }
+    species_slot_insert(model, id);
+    return id;
+}
+
+int kinetics_species_find(const KineticsModel* model, const Formula* formula) {
+    if (!model || !formula) return -1;
+    return species_lookup(model, formula_fingerprint(formula));
+}
+
+int kinetics_add_reaction(KineticsModel* model, const Reaction* rxn, double k) {
+    if (!model || !rxn || !(k >= 0.0) || rxn->reactant_count + rxn->product_count == 0) return -1;
+
+    /* Orders per distinct reactant, net change per distinct species */
+    int reactants[MAX_REACTANTS], orders[MAX_REACTANTS], reactant_count = 0;
+    int species[MAX_REACTANTS + MAX_PRODUCTS];
+    double change[MAX_REACTANTS + MAX_PRODUCTS];
+    int species_count = 0;
+
+    for (int side = 0; side < 2; side++) {
+        const Formula* formulas = side == 0 ? rxn->reactants : rxn->products;
+        int count = side == 0 ? rxn->reactant_count : rxn->product_count;
+        for (int i = 0; i < count; i++) {
+            int id = species_intern(model, &formulas[i]);
+            if (id < 0) return -1;
+            int coefficient = formulas[i].coefficient > 0 ? formulas[i].coefficient : 1;
+
+            if (side == 0) {
+                int r = 0;
+                while (r < reactant_count && reactants[r] != id) r++;
+                if (r == reactant_count) {
+                    reactants[reactant_count] = id;
+                    orders[reactant_count++] = 0;
+                }
+                orders[r] += coefficient;
+            }
+            int s = 0;
+            while (s < species_count && species[s] != id) s++;
+            if (s == species_count) {
+                species[species_count] = id;
+                change[species_count++] = 0.0;
+            }
+            change[s] += side == 0 ? -coefficient : coefficient;
+        }
+    }
+
+    int j = model->reaction_count;
+    int reactant_base = j > 0 ? model->reactant_offsets[j] : 0;
+    int stoich_base = j > 0 ? model->stoich_offsets[j] : 0;
+    if (!reserve_reactions(model, j + 1, reactant_base + reactant_count, stoich_base + species_count)) {
+        return -1;
+    }
+
+    model->rate_constants[j] = k;
+    model->reactant_offsets[j] = reactant_base;
+    for (int r = 0; r < reactant_count; r++) {
+        model->reactant_species[reactant_base + r] = reactants[r];
+        model->reactant_orders[reactant_base + r] = orders[r];
+    }
+    model->reactant_offsets[j + 1] = reactant_base + reactant_count;
+
+    model->stoich_offsets[j] = stoich_base;
+    int kept = 0;
+    for (int s = 0; s < species_count; s++) {
+        if (change[s] == 0.0) continue;
+        model->stoich_species[stoich_base + kept] = species[s];
+        model->stoich_values[stoich_base + kept++] = change[s];
+    }
+    model->stoich_offsets[j + 1] = stoich_base + kept;
+
+    model->reaction_count++;
+    model->prepared = false;
+    return j;
+}
+
+/* ============ Sparse Pattern ============ */
+
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} IntList;
+
+static bool list_push(IntList* list, int value) {
+    if (list->count == list->capacity) {
+        int cap = list->capacity ? list->capacity * 2 : 8;
+        int* items = realloc(list->items, (size_t)cap * sizeof(int));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = cap;
+    }
+    list->items[list->count++] = value;
+    return true;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_keys(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* Min-heap of degree * n + species keys, so ties go to the lowest index */
+typedef struct {
+    long long* keys;
+    int count;
+    int capacity;
+} DegreeHeap;
+
+static bool heap_push(DegreeHeap* heap, long long key) {
+    if (heap->count == heap->capacity) {
+        int cap = heap->capacity ? heap->capacity * 2 : 64;
+        long long* keys = realloc(heap->keys, (size_t)cap * sizeof(long long));
+        if (!keys) return false;
+        heap->keys = keys;
+        heap->capacity = cap;
+    }
+    int i = heap->count++;
+    while (i > 0 && heap->keys[(i - 1) / 2] > key) {
+        heap->keys[i] = heap->keys[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap->keys[i] = key;
+    return true;
+}
+
+static long long heap_pop(DegreeHeap* heap) {
+    long long top = heap->keys[0];
+    long long last = heap->keys[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->keys[child + 1] < heap->keys[child]) child++;
+        if (heap->keys[child] >= last) break;
+        heap->keys[i] = heap->keys[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->keys[i] = last;
+    return top;
+}
+
+/*
+ * Minimum-degree elimination on the symmetrized Jacobian graph. Each
+ * eliminated species' remaining neighbors become a clique (the fill) and
+ * are recorded as its U row, so upper[p] lists the species in U row p.
+ * Degrees live in a heap with lazy deletion: a species is pushed again
+ * whenever its degree changes and stale keys are skipped on pop.
+ * Returns false on allocation failure.
+ */
+static bool eliminate(KineticsModel* model, IntList* graph, IntList* upper, int* stamp) {
+    int n = model->species_count;
+    bool* done = calloc((size_t)(n > 0 ? n : 1), sizeof(bool));
+    DegreeHeap heap = {NULL, 0, 0};
+    bool ok = done != NULL;
+    for (int i = 0; ok && i < n; i++) {
+        stamp[i] = -1;
+        ok = heap_push(&heap, (long long)graph[i].count * n + i);
+    }
+
+    for (int p = 0; p < n && ok; p++) {
+        int v;
+        for (;;) {
+            long long key = heap_pop(&heap);
+            v = (int)(key % n);
+            if (!done[v] && key / n == graph[v].count) break;
+        }
+        done[v] = true;
+        model->position[v] = p;
+
+        IntList* nv = &graph[v];
+        for (int a = 0; a < nv->count && ok; a++) {
+            int u = nv->items[a];
+            IntList* nu = &graph[u];
+
+            /* Drop v from u's list, then add v's other neighbors */
+            int kept = 0;
+            for (int b = 0; b < nu->count; b++) {
+                if (nu->items[b] != v) {
+                    nu->items[kept++] = nu->items[b];
+                    stamp[nu->items[b]] = u;
+                }
+            }
+            nu->count = kept;
+            for (int b = 0; b < nv->count && ok; b++) {
+                int w = nv->items[b];
+                if (w != u && stamp[w] != u) ok = list_push(nu, w);
+            }
+            if (ok) ok = heap_push(&heap, (long long)nu->count * n + u);
+        }
+        upper[p] = *nv;
+        nv->items = NULL;
+        nv->count = nv->capacity = 0;
+    }
+    free(heap.keys);
+    free(done);
+    return ok;
+}
+
+/* Build CSR rows [L | diagonal | U] by pivot position from the U rows */
+static bool build_lu_pattern(KineticsModel* model, IntList* upper) {
+    int n = model->species_count;
+    int* lower_count = calloc((size_t)n + 1, sizeof(int));
+    model->lu_offsets = malloc(((size_t)n + 1) * sizeof(int));
+    model->lu_diagonal = malloc(((size_t)n > 0 ? n : 1) * sizeof(int));
+    if (!lower_count || !model->lu_offsets || !model->lu_diagonal) {
+        free(lower_count);
+        return false;
+    }
+
+    for (int p = 0; p < n; p++) {
+        for (int a = 0; a < upper[p].count; a++) {
+            upper[p].items[a] = model->position[upper[p].items[a]];
+            lower_count[upper[p].items[a]]++;
+        }
+        qsort(upper[p].items, upper[p].count, sizeof(int), compare_ints);
+    }
+
+    int total = 0;
+    for (int p = 0; p < n; p++) {
+        model->lu_offsets[p] = total;
+        model->lu_diagonal[p] = total + lower_count[p];
+        total += lower_count[p] + 1 + upper[p].count;
+    }
+    model->lu_offsets[n] = total;
+    model->lu_nonzeros = total;
+
+    model->lu_columns = malloc(((size_t)total > 0 ? total : 1) * sizeof(int));
+    model->lu_values = malloc(((size_t)total > 0 ? total : 1) * sizeof(double));
+    if (!model->lu_columns || !model->lu_values) {
+        free(lower_count);
+        return false;
+    }
+
+    /* L entries arrive in ascending pivot order */
+    for (int p = 0; p < n; p++) lower_count[p] = 0;
+    for (int p = 0; p < n; p++) {
+        int d = model->lu_diagonal[p];
+        model->lu_columns[d] = p;
+        for (int a = 0; a < upper[p].count; a++) {
+            int r = upper[p].items[a];
+            model->lu_columns[d + 1 + a] = r;
+            model->lu_columns[model->lu_offsets[r] + lower_count[r]++] = p;
+        }
+    }
+    free(lower_count);
+    return true;
+}
+
+/* LU entry (row, column) by pivot position; the pattern is known to hold it */
+static int lu_find(const KineticsModel* model, int row, int column) {
+    int lo = model->lu_offsets[row], hi = model->lu_offsets[row + 1] - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (model->lu_columns[mid] < column) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+bool kinetics_model_prepare(KineticsModel* model) {
+    if (!model) return false;
+    free_pattern(model);
+    int n = model->species_count;
+    int m = model->reaction_count;
+
+    /* Jacobian terms: species i changed by reaction j, rate depending on species a */
+    int terms = 0;
+    for (int j = 0; j < m; j++) {
+        terms += (model->reactant_offsets[j + 1] - model->reactant_offsets[j]) *
+                 (model->stoich_offsets[j + 1] - model->stoich_offsets[j]);
+    }
+    int reactant_entries = m > 0 ? model->reactant_offsets[m] : 0;
+
+    size_t alloc_n = (size_t)(n > 0 ? n : 1);
+    long long* keys = malloc((size_t)(terms > 0 ? terms : 1) * sizeof(long long));
+    IntList* graph = calloc(alloc_n, sizeof(IntList));
+    IntList* upper = calloc(alloc_n, sizeof(IntList));
+    int* stamp = malloc(alloc_n * sizeof(int));
+    model->position = malloc(alloc_n * sizeof(int));
+    model->jacobian_slots = malloc((size_t)(terms > 0 ? terms : 1) * sizeof(int));
+    model->jacobian_values = malloc((size_t)(reactant_entries > 0 ? reactant_entries : 1) * sizeof(double));
+    model->rates = malloc((size_t)(m > 0 ? m : 1) * sizeof(double));
+    model->work = calloc(alloc_n, sizeof(double));
+    bool ok = keys && graph && upper && stamp && model->position && model->jacobian_slots &&
+              model->jacobian_values && model->rates && model->work;
+
+    /* Symmetrized off-diagonal pattern, duplicates removed */
+    int key_count = 0;
+    for (int j = 0; ok && j < m; j++) {
+        for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+            int a = model->reactant_species[r];
+            for (int s = model->stoich_offsets[j]; s < model->stoich_offsets[j + 1]; s++) {
+                int i = model->stoich_species[s];
+                if (i == a) continue;
+                keys[key_count++] = i < a ? (long long)i * n + a : (long long)a * n + i;
+            }
+        }
+    }
+    if (ok) qsort(keys, key_count, sizeof(long long), compare_keys);
+    for (int k = 0; ok && k < key_count; k++) {
+        if (k > 0 && keys[k] == keys[k - 1]) continue;
+        int i = (int)(keys[k] / n), a = (int)(keys[k] % n);
+        ok = list_push(&graph[i], a) && list_push(&graph[a], i);
+    }
+
+    ok = ok && eliminate(model, graph, upper, stamp) && build_lu_pattern(model, upper);
+
+    if (ok) {
+        int t = 0;
+        for (int j = 0; j < m; j++) {
+            for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+                int column = model->position[model->reactant_species[r]];
+                for (int s = model->stoich_offsets[j]; s < model->stoich_offsets[j + 1]; s++) {
+                    int row = model->position[model->stoich_species[s]];
+                    model->jacobian_slots[t++] = lu_find(model, row, column);
+                }
+            }
+        }
+        model->jacobian_terms = terms;
+    }
+
+    for (int i = 0; graph && i < n; i++) free(graph[i].items);
+    for (int i = 0; upper && i < n; i++) free(upper[i].items);
+    free(graph);
+    free(upper);
+    free(keys);
+    free(stamp);
+    if (!ok) {
+        free_pattern(model);
+        return false;
+    }
+    model->prepared = true;
+    return true;
+}
+
+/* ============ Rates and Jacobian ============ */
+
+static double power(double c, int order) {
+    double value = 1.0;
+    for (int i = 0; i < order; i++) value *= c;
+    return value;
+}
+
+static void evaluate_rates(KineticsModel* model, const double* c) {
+    for (int j = 0; j < model->reaction_count; j++) {
+        double rate = model->rate_constants[j];
+        for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+            rate *= power(c[model->reactant_species[r]], model->reactant_orders[r]);
+        }
+        model->rates[j] = rate;
+    }
+}
+
+void kinetics_derivatives(KineticsModel* model, const double* c, double* dcdt) {
+    if (!model || !c || !dcdt) return;
+    if (!model->prepared && !kinetics_model_prepare(model)) return;
+
+    evaluate_rates(model, c);
+    memset(dcdt, 0, (size_t)model->species_count * sizeof(double));
+    for (int j = 0; j < model->reaction_count; j++) {
+        double rate = model->rates[j];
+        for (int s = model->stoich_offsets[j]; s < model->stoich_offsets[j + 1]; s++) {
+            dcdt[model->stoich_species[s]] += model->stoich_values[s] * rate;
+        }
+    }
+}
+
+/* dr_j/dc_a for every reactant entry, evaluated at c */
+static void evaluate_jacobian(KineticsModel* model, const double* c) {
+    for (int j = 0; j < model->reaction_count; j++) {
+        int begin = model->reactant_offsets[j], end = model->reactant_offsets[j + 1];
+        for (int r = begin; r < end; r++) {
+            int order = model->reactant_orders[r];
+            double d = model->rate_constants[j] * order * power(c[model->reactant_species[r]], order - 1);
+            for (int o = begin; o < end; o++) {
+                if (o != r) d *= power(c[model->reactant_species[o]], model->reactant_orders[o]);
+            }
+            model->jacobian_values[r] = d;
+        }
+    }
+}
+
+/* ============ Linear Algebra ============ */
+
+/* Assemble W = I - gh J into the LU pattern and factor it in place */
+static bool factor_w(KineticsModel* model, double gh) {
+    int n = model->species_count;
+    double* values = model->lu_values;
+    memset(values, 0, (size_t)model->lu_nonzeros * sizeof(double));
+    for (int p = 0; p < n; p++) values[model->lu_diagonal[p]] = 1.0;
+
+    int t = 0;
+    for (int j = 0; j < model->reaction_count; j++) {
+        for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+            double d = gh * model->jacobian_values[r];
+            for (int s = model->stoich_offsets[j]; s < model->stoich_offsets[j + 1]; s++) {
+                values[model->jacobian_slots[t++]] -= model->stoich_values[s] * d;
+            }
+        }
+    }
+
+    /* Row-by-row elimination; the fill pattern is closed, so updates stay in row */
+    const int* offsets = model->lu_offsets;
+    const int* columns = model->lu_columns;
+    const int* diagonal = model->lu_diagonal;
+    double* w = model->work;
+    for (int i = 0; i < n; i++) {
+        for (int e = offsets[i]; e < offsets[i + 1]; e++) w[columns[e]] = values[e];
+        for (int e = offsets[i]; e < diagonal[i]; e++) {
+            int k = columns[e];
+            double l = w[k] / values[diagonal[k]];
+            w[k] = l;
+            if (l == 0.0) continue;
+            for (int f = diagonal[k] + 1; f < offsets[k + 1]; f++) w[columns[f]] -= l * values[f];
+        }
+        double pivot = w[i];
+        for (int e = offsets[i]; e < offsets[i + 1]; e++) {
+            values[e] = w[columns[e]];
+            w[columns[e]] = 0.0;
+        }
+        if (pivot == 0.0 || !isfinite(pivot)) return false;
+    }
+    return true;
+}
+
+/* Solve W x = b in place (species order) with the factored W */
+static void solve_w(KineticsModel* model, double* b) {
+    int n = model->species_count;
+    const int* offsets = model->lu_offsets;
+    const int* columns = model->lu_columns;
+    const int* diagonal = model->lu_diagonal;
+    const double* values = model->lu_values;
+    double* x = model->work;
+
+    for (int s = 0; s < n; s++) x[model->position[s]] = b[s];
+    for (int i = 0; i < n; i++) {
+        double sum = x[i];
+        for (int e = offsets[i]; e < diagonal[i]; e++) sum -= values[e] * x[columns[e]];
+        x[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double sum = x[i];
+        for (int e = diagonal[i] + 1; e < offsets[i + 1]; e++) sum -= values[e] * x[columns[e]];
+        x[i] = sum / values[diagonal[i]];
+    }
+    for (int s = 0; s < n; s++) {
+        b[s] = x[model->position[s]];
+        x[model->position[s]] = 0.0;
+    }
+}
+
+/* ============ Integration ============ */
+
+static void write_header(const KineticsModel* model, FILE* csv) {
+    fputs("time", csv);
+    for (int i = 0; i < model->species_count; i++) fprintf(csv, ",%s", model->names[i]);
+    fputc('\n', csv);
+}
+
+static void write_row(FILE* csv, double t, const double* c, int n) {
+    fprintf(csv, "%.9g", t);
+    for (int i = 0; i < n; i++) fprintf(csv, ",%.9g", c[i]);
+    fputc('\n', csv);
+}
+
+/* Cubic Hermite interpolation between accepted steps, clipped at zero */
+static void interpolate(const double* y0, const double* y1, const double* f0, const double* f1,
+                        double h, double theta, double* out, int n) {
+    for (int i = 0; i < n; i++) {
+        double dy = y1[i] - y0[i];
+        double v = (1.0 - theta) * y0[i] + theta * y1[i] +
+                   theta * (theta - 1.0) *
+                       ((1.0 - 2.0 * theta) * dy + (theta - 1.0) * h * f0[i] + theta * h * f1[i]);
+        out[i] = v > 0.0 ? v : 0.0;
+    }
+}
+
+bool kinetics_simulate(KineticsModel* model, double* concentrations, double t_end,
+                       const KineticsOptions* options, FILE* csv, KineticsStats* stats) {
+    if (!model || !concentrations || !(t_end >= 0.0)) return false;
+    if (!model->prepared && !kinetics_model_prepare(model)) return false;
+
+    KineticsOptions defaults;
+    if (!options) {
+        kinetics_options_default(&defaults);
+        options = &defaults;
+    }
+    KineticsStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(KineticsStats));
+
+    int n = model->species_count;
+    double* block = malloc((size_t)6 * (n > 0 ? n : 1) * sizeof(double));
+    if (!block) return false;
+    double* f0 = block;
+    double* f1 = block + n;
+    double* k1 = block + 2 * n;
+    double* k2 = block + 3 * n;
+    double* y1 = block + 4 * n;
+    double* row = block + 5 * n;
+    double* c = concentrations;
+
+    if (csv) {
+        write_header(model, csv);
+        write_row(csv, 0.0, c, n);
+    }
+
+    double t = 0.0;
+    double h = options->initial_step > 0.0 ? options->initial_step : 1e-6 * t_end;
+    double min_step = 1e-14 * (t_end > 1.0 ? t_end : 1.0);
+    double interval = options->output_interval;
+    int age = options->jacobian_age > 0 ? options->jacobian_age : 1;
+    long long output_index = 1;
+    double next_output = interval > 0.0 && interval < t_end ? interval : t_end;
+
+    kinetics_derivatives(model, c, f0);
+    stats->rhs_evaluations++;
+
+    bool need_jacobian = true;
+    double factored_h = 0.0;
+    int jacobian_steps = 0;
+    bool ok = true;
+
+    while (t < t_end) {
+        if (stats->steps >= options->max_steps) {
+            ok = false;
+            break;
+        }
+        double step = h;
+        if (options->max_step > 0.0 && step > options->max_step) step = options->max_step;
+        if (t + 1.01 * step >= t_end) step = t_end - t;
+        if (step < min_step) {
+            ok = false;
+            break;
+        }
+
+        if (need_jacobian) {
+            evaluate_jacobian(model, c);
+            stats->jacobians++;
+            need_jacobian = false;
+            jacobian_steps = 0;
+            factored_h = 0.0;
+        }
+        if (step != factored_h) {
+            stats->factorizations++;
+            if (!factor_w(model, ROS2_GAMMA * step)) {
+                factored_h = 0.0;
+                h = 0.5 * step;
+                stats->rejected++;
+                continue;
+            }
+            factored_h = step;
+        }
+
+        /* W k1 = f(c); W k2 = f(c + h k1) - 2 k1; c' = c + h (3/2 k1 + 1/2 k2) */
+        memcpy(k1, f0, (size_t)n * sizeof(double));
+        solve_w(model, k1);
+        for (int i = 0; i < n; i++) y1[i] = c[i] + step * k1[i];
+        kinetics_derivatives(model, y1, k2);
+        stats->rhs_evaluations++;
+        for (int i = 0; i < n; i++) k2[i] -= 2.0 * k1[i];
+        solve_w(model, k2);
+
+        /* Error against the embedded first-order solution c + h k1 */
+        double sum = 0.0;
+        for (int i = 0; i < n; i++) {
+            y1[i] = c[i] + step * (1.5 * k1[i] + 0.5 * k2[i]);
+            double a = fabs(c[i]) > fabs(y1[i]) ? fabs(c[i]) : fabs(y1[i]);
+            double e = 0.5 * step * (k1[i] + k2[i]) / (options->atol + options->rtol * a);
+            sum += e * e;
+        }
+        double error = n > 0 ? sqrt(sum / n) : 0.0;
+
+        if (!(error <= 1.0)) {
+            double factor = isfinite(error) ? STEP_SAFETY / sqrt(error) : STEP_MIN_FACTOR;
+            h = step * (factor > STEP_MIN_FACTOR ? factor : STEP_MIN_FACTOR);
+            need_jacobian = jacobian_steps > 0;
+            stats->rejected++;
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (y1[i] < 0.0) y1[i] = 0.0;
+        }
+        kinetics_derivatives(model, y1, f1);
+        stats->rhs_evaluations++;
+
+        double t_new = t + step;
+        if (csv && interval > 0.0) {
+            while (next_output <= t_new * (1.0 + 1e-12)) {
+                double theta = (next_output - t) / step;
+                if (theta >= 1.0) memcpy(row, y1, (size_t)n * sizeof(double));
+                else interpolate(c, y1, f0, f1, step, theta, row, n);
+                write_row(csv, next_output, row, n);
+                if (next_output >= t_end) break;
+                output_index++;
+                next_output = output_index * interval < t_end ? output_index * interval : t_end;
+            }
+        } else if (csv) {
+            write_row(csv, t_new, y1, n);
+        }
+
+        memcpy(c, y1, (size_t)n * sizeof(double));
+        double* swap = f0;
+        f0 = f1;
+        f1 = swap;
+        t = t_new;
+        stats->steps++;
+        if (++jacobian_steps >= age) need_jacobian = true;
+
+        /* Keep h, and with it the factored W, unless the change is worth it */
+        double factor = error > 0.0 ? STEP_SAFETY / sqrt(error) : STEP_MAX_FACTOR;
+        if (factor > STEP_MAX_FACTOR) factor = STEP_MAX_FACTOR;
+        if (factor < STEP_KEEP_LOW || factor > STEP_KEEP_HIGH) h = step * factor;
+        else h = step;
+    }
+
+    stats->time = t;
+    free(block);
+    return ok;
+}
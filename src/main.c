@@ -7,10 +7,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 
 #include "element.h"
 #include "molecule.h"
 #include "reaction.h"
+#include "inventory.h"
+#include "route.h"
+#include "ion.h"
+#include "mass_decomp.h"
+#include "isotope.h"
+#include "smiles.h"
+#include "canon.h"
+#include "substruct.h"
+#include "fingerprint.h"
+#include "validate.h"
+#include "ring.h"
+#include "forcefield.h"
+#include "descriptor.h"
+#include "atom_map.h"
+#include "network.h"
+#include "kinetics.h"
+#include "stochastic.h"
+#include "thermo.h"
+#include "benchmark.h"
 
 /* ============ Menu Functions ============ */
 
@@ -91,6 +111,13 @@ static void demo_formula_parser(void) {
 
         double mass = formula_mass(&formula);
         printf("\nMolecular mass: %.3f g/mol\n", mass);
+
+        IsotopePattern pattern;
+        if (isotope_pattern(&formula, NULL, &pattern)) {
+            printf("\nIsotopic pattern (per molecule):\n");
+            isotope_pattern_print(&pattern);
+            isotope_pattern_free(&pattern);
+        }
     } else {
         printf("Failed to parse formula: %s\n", input);
     }
@@ -102,19 +129,25 @@ static void demo_molecules(void) {
     print_header("Common Molecules");
 
     printf("\n--- Water (H2O) ---\n");
-    Molecule* water = molecule_create_water();
+    Molecule* water = molecule_create_water(NULL);
+    if (!water) return;
     molecule_print(water);
     molecule_print_composition(water);
+    molecule_destroy(water);
 
     printf("\n--- Carbon Dioxide (CO2) ---\n");
-    Molecule* co2 = molecule_create_co2();
+    Molecule* co2 = molecule_create_co2(NULL);
+    if (!co2) return;
     molecule_print(co2);
     molecule_print_composition(co2);
+    molecule_destroy(co2);
 
     printf("\n--- Methane (CH4) ---\n");
-    Molecule* methane = molecule_create_methane();
+    Molecule* methane = molecule_create_methane(NULL);
+    if (!methane) return;
     molecule_print(methane);
     molecule_print_composition(methane);
+    molecule_destroy(methane);
 }
 
 /* ============ Reaction Lookup Demo ============ */
@@ -145,13 +178,14 @@ static void demo_reaction_lookup(void) {
 static void demo_list_reactions(void) {
     print_header("Known Reactions Database");
 
-    reaction_db_init();
+    reaction_db_read_begin();
     int count = reaction_db_count();
 
-    printf("\nDatabase contains %d reactions:\n\n", count);
+    printf("\nDatabase contains %d reactions:\n\n", reaction_db_live_count());
 
     for (int i = 0; i < count; i++) {
         const Reaction* rxn = reaction_db_get(i);
+        if (!rxn) continue;
         printf("%2d. ", i + 1);
         reaction_print(rxn);
         printf("    Type: %s, Condition: %s\n",
@@ -162,6 +196,7 @@ static void demo_list_reactions(void) {
         }
         printf("\n");
     }
+    reaction_db_read_end();
 }
 
 /* ============ Periodic Table Overview ============ */
@@ -226,6 +261,1002 @@ static void demo_reactions_by_element(void) {
     }
 }
 
+/* ============ Inventory Demo ============ */
+
+static void demo_inventory(void) {
+    print_header("Reactions Runnable from Inventory");
+
+    char input[256];
+    printf("Enter available species separated by ',' (e.g., CH4, O2, Zn, HCl): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Inventory inv;
+    if (!inventory_init(&inv)) {
+        printf("Failed to allocate inventory.\n");
+        return;
+    }
+
+    char* token = strtok(input, ",");
+    while (token) {
+        while (*token && isspace((unsigned char)*token)) token++;
+        if (*token && !inventory_add_string(&inv, token)) {
+            printf("Skipping invalid formula: %s\n", token);
+        }
+        token = strtok(NULL, ",");
+    }
+
+    const Reaction* results[MAX_REACTIONS];
+    int count = inventory_runnable(&inv, results, MAX_REACTIONS);
+
+    printf("\n%d reaction(s) can be run:\n\n", count);
+    for (int i = 0; i < count; i++) {
+        printf("%d. ", i + 1);
+        reaction_print(results[i]);
+        if (results[i]->description[0]) {
+            printf("   %s\n", results[i]->description);
+        }
+    }
+
+    inventory_free(&inv);
+}
+
+/* ============ Synthesis Route Demo ============ */
+
+static void demo_routes(void) {
+    print_header("Synthesis Route Search");
+
+    char input[256];
+    char target_str[64];
+    printf("Enter starting species separated by ',' (e.g., CH4, O2): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+    printf("Enter target species (e.g., H2): ");
+    if (fgets(target_str, sizeof(target_str), stdin) == NULL) return;
+    target_str[strcspn(target_str, "\n")] = 0;
+
+    Formula start[MAX_REACTANTS];
+    int start_count = 0;
+    char* token = strtok(input, ",");
+    while (token && start_count < MAX_REACTANTS) {
+        if (formula_parse(token, &start[start_count])) start_count++;
+        token = strtok(NULL, ",");
+    }
+
+    Formula target;
+    if (start_count == 0 || !formula_parse(target_str, &target)) {
+        printf("Invalid input.\n");
+        return;
+    }
+
+    RouteGraph graph;
+    if (!route_graph_build(&graph)) {
+        printf("Failed to build reaction graph.\n");
+        return;
+    }
+
+    Route routes[3];
+    RouteOptions options;
+    route_options_default(&options);
+
+    printf("\nFewest steps:\n");
+    if (route_find_shortest(&graph, start, start_count, &target, options.max_steps, &routes[0])) {
+        route_print(&routes[0]);
+    } else {
+        printf("No route found within %d steps.\n", options.max_steps);
+    }
+
+    int count = route_find_best(&graph, start, start_count, &target, &options, routes, 3);
+    printf("\nCheapest routes (condition-weighted):\n");
+    for (int i = 0; i < count; i++) {
+        route_print(&routes[i]);
+    }
+    if (count == 0) printf("None.\n");
+
+    route_graph_free(&graph);
+}
+
+/* ============ Reaction Prediction Demo ============ */
+
+static void demo_predict(void) {
+    print_header("Predict Reaction Products");
+
+    char input[256];
+    printf("Enter two reactants separated by '+' (e.g., C3H8 + O2, Zn + CuSO4): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Formula reactants[MAX_REACTANTS];
+    int count = 0;
+    char* token = strtok(input, "+");
+    while (token && count < MAX_REACTANTS) {
+        if (formula_parse(token, &reactants[count])) count++;
+        token = strtok(NULL, "+");
+    }
+
+    Reaction rxn;
+    if (reaction_predict_reaction(reactants, count, &rxn)) {
+        printf("\n");
+        reaction_print_detailed(&rxn);
+    } else {
+        printf("\nNo reaction predicted.\n");
+    }
+}
+
+/* ============ Ionic Compound Enumeration Demo ============ */
+
+typedef struct {
+    int shown;
+    int limit;
+} EnumPrintState;
+
+static bool print_compound(const IonicCompound* compound, void* user_data) {
+    EnumPrintState* state = user_data;
+    if (state->shown >= state->limit) return true;
+
+    char buffer[64];
+    if (ionic_compound_format(compound, buffer, sizeof(buffer))) {
+        printf("%-14s%s", buffer, (++state->shown % 5 == 0) ? "\n" : "");
+    }
+    return true;
+}
+
+static void demo_ionic_enumeration(void) {
+    print_header("Enumerate Ionic Compounds");
+
+    char input[32];
+    printf("Maximum subscript per ion (1-12, default 4): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+
+    IonicEnumOptions options;
+    ionic_enum_options_default(&options);
+    int max = atoi(input);
+    options.max_subscript = (max >= 1 && max <= 12) ? max : 4;
+
+    EnumPrintState state = {0, 40};
+    IonicEnumStats stats;
+    printf("\nSample compounds:\n");
+    if (!ionic_enumerate(&options, print_compound, &state, &stats)) {
+        printf("\nEnumeration failed.\n");
+        return;
+    }
+    printf("\n\n%lld unique compounds from %lld candidates in %.3f s\n",
+           stats.unique, stats.candidates, stats.seconds);
+}
+
+/* ============ Mass Decomposition Demo ============ */
+
+#define DEMO_MASS_RESULTS 20
+
+static void demo_mass_decomposition(void) {
+    print_header("Find Formulas for a Mass");
+
+    char input[64];
+    printf("Enter monoisotopic mass in Da (e.g., 180.0634): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    double mass = atof(input);
+    if (mass <= 0.0) {
+        printf("\nInvalid mass.\n");
+        return;
+    }
+
+    printf("Tolerance in ppm (default 5): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+
+    MassQueryOptions options;
+    mass_query_options_default(&options);
+    double ppm = atof(input);
+    if (ppm > 0.0) options.ppm = ppm;
+
+    MassAlphabetEntry alphabet[] = {
+        {element_by_symbol("C"), 0, 100},
+        {element_by_symbol("H"), 0, 200},
+        {element_by_symbol("N"), 0, 20},
+        {element_by_symbol("O"), 0, 40},
+        {element_by_symbol("P"), 0, 4},
+        {element_by_symbol("S"), 0, 4}
+    };
+    MassDecomposer decomposer;
+    if (!mass_decomposer_init(&decomposer, alphabet, 6, MASS_MONOISOTOPIC, 0.0)) {
+        printf("\nFailed to build decomposition tables.\n");
+        return;
+    }
+
+    MassCandidate results[DEMO_MASS_RESULTS];
+    int total = mass_decompose(&decomposer, mass, &options, results, DEMO_MASS_RESULTS);
+    int shown = total < DEMO_MASS_RESULTS ? total : DEMO_MASS_RESULTS;
+
+    printf("\n%d CHNOPS formula(s) within %.1f ppm:\n", total, options.ppm);
+    for (int i = 0; i < shown; i++) {
+        Formula formula;
+        char buffer[128];
+        if (!mass_candidate_to_formula(&decomposer, &results[i], &formula) ||
+            !formula_to_string(&formula, buffer, sizeof(buffer))) continue;
+        printf("  %-18s %12.6f Da %+8.2f ppm  RDBE %.1f\n",
+               buffer, results[i].mass, results[i].error_ppm, results[i].rdbe);
+    }
+    if (total > shown) printf("  ... and %d more\n", total - shown);
+
+    mass_decomposer_free(&decomposer);
+}
+
+/* ============ SMILES Demo ============ */
+
+static void demo_smiles(void) {
+    print_header("Read SMILES");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter SMILES, or @path to parse a file (e.g., CC(=O)O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    if (input[0] == '@') {
+        SmilesBatchStats stats;
+        if (!smiles_parse_file(input + 1, 0, false, NULL, NULL, &stats)) {
+            printf("\nFailed to read %s\n", input + 1);
+            return;
+        }
+        printf("\n%d line(s): %d parsed, %d failed, %lld atoms in %.3f s (%.0f molecules/s)\n",
+               stats.lines, stats.parsed, stats.failed, stats.atoms, stats.seconds,
+               stats.seconds > 0.0 ? stats.parsed / stats.seconds : 0.0);
+        return;
+    }
+
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    Molecule mol;
+    molecule_init(&mol, NULL);
+
+    if (smiles_parser_parse(&parser, input, strlen(input), &mol)) {
+        printf("\n");
+        molecule_print(&mol);
+        molecule_print_composition(&mol);
+
+        char canonical[1024];
+        CanonHash hash;
+        if (molecule_canonical_smiles(&mol, canonical, sizeof(canonical)) &&
+            molecule_canonical_hash(&mol, &hash)) {
+            printf("Canonical SMILES: %s\n", canonical);
+            printf("Canonical hash: %016llx%016llx\n",
+                   (unsigned long long)hash.hi, (unsigned long long)hash.lo);
+        }
+        if (molecule_perceive_rings(&mol)) {
+            printf("Rings (SSSR): %d", molecule_ring_count(&mol));
+            for (int r = 0; r < molecule_ring_count(&mol); r++) {
+                printf("%s%d", r == 0 ? " of size " : ", ", molecule_ring(&mol, r, NULL, NULL));
+            }
+            printf("\n");
+        }
+        if (molecule_compact_hydrogens(&mol)) {
+            printf("Implicit-H form: %d atoms, %d bonds, %d implicit H (%s)\n",
+                   mol.atom_count, mol.bond_count, mol.implicit_hydrogens, molecule_formula(&mol));
+        }
+    } else {
+        printf("\nInvalid SMILES at position %d: %s\n", parser.error_position, parser.error);
+    }
+
+    molecule_free(&mol);
+    smiles_parser_free(&parser);
+}
+
+/* ============ Substructure Search Demo ============ */
+
+static const char* DEMO_LIBRARY[] = {
+    "CC(=O)Oc1ccccc1C(=O)O aspirin",
+    "Cn1cnc2c1c(=O)n(C)c(=O)n2C caffeine",
+    "CC(C)Cc1ccc(cc1)C(C)C(=O)O ibuprofen",
+    "CC(=O)Nc1ccc(O)cc1 paracetamol",
+    "CN1CCCC1c1cccnc1 nicotine",
+    "O=C(O)c1ccccc1O salicylic_acid",
+    "CCN(CC)CC(=O)Nc1c(C)cccc1C lidocaine",
+    "NC(Cc1c[nH]c2ccccc12)C(=O)O tryptophan",
+    "CCO ethanol",
+    "CC(=O)O acetic_acid",
+    "c1ccccc1 benzene",
+    "CC(=O)OCC ethyl_acetate"
+};
+
+#define DEMO_LIBRARY_SIZE ((int)(sizeof(DEMO_LIBRARY) / sizeof(DEMO_LIBRARY[0])))
+#define DEMO_SUBSTRUCT_HITS 20
+
+static void add_to_library(const Molecule* mol, int line, int thread_index, void* user_data) {
+    (void)line;
+    (void)thread_index;
+    substruct_library_add(user_data, mol);
+}
+
+static void demo_substructure(void) {
+    print_header("Substructure Search");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter query SMILES (e.g., C(=O)O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Molecule query_mol;
+    molecule_init(&query_mol, NULL);
+    SubstructQuery query;
+    if (!smiles_parse(input, &query_mol) || !substruct_query_compile(&query, &query_mol)) {
+        printf("\nInvalid query SMILES.\n");
+        molecule_free(&query_mol);
+        return;
+    }
+
+    char path[MAX_FORMULA_LENGTH];
+    printf("Library file (one SMILES per line, blank for built-in set): ");
+    if (fgets(path, sizeof(path), stdin) == NULL) path[0] = 0;
+    path[strcspn(path, "\n")] = 0;
+
+    /* Built on one thread so entries keep line order */
+    SubstructLibrary lib;
+    substruct_library_init(&lib);
+    if (path[0]) {
+        if (!smiles_parse_file(path, 1, true, add_to_library, &lib, NULL)) {
+            printf("\nFailed to read %s\n", path);
+        }
+    } else {
+        for (int i = 0; i < DEMO_LIBRARY_SIZE; i++) {
+            Molecule mol;
+            molecule_init(&mol, NULL);
+            if (smiles_parse(DEMO_LIBRARY[i], &mol)) substruct_library_add(&lib, &mol);
+            molecule_free(&mol);
+        }
+    }
+
+    int hits[DEMO_SUBSTRUCT_HITS];
+    SubstructSearchStats stats;
+    int total = substruct_search(&lib, &query, 0, hits, DEMO_SUBSTRUCT_HITS, &stats);
+    if (total >= 0) {
+        printf("\n%d of %d molecule(s) match (%d passed the screen) in %.3f s\n",
+               total, stats.molecules, stats.screened, stats.seconds);
+        int shown = total < DEMO_SUBSTRUCT_HITS ? total : DEMO_SUBSTRUCT_HITS;
+        for (int i = 0; i < shown; i++) {
+            if (path[0]) {
+                printf("  entry %d\n", hits[i] + 1);
+            } else {
+                printf("  %s\n", DEMO_LIBRARY[hits[i]]);
+            }
+        }
+        if (total > shown) printf("  ... and %d more\n", total - shown);
+    }
+
+    substruct_library_free(&lib);
+    substruct_query_free(&query);
+    molecule_free(&query_mol);
+}
+
+/* ============ Similarity Search Demo ============ */
+
+#define DEMO_SIMILAR_HITS 10
+
+typedef struct {
+    FingerprintContext context;
+    FingerprintMatrix matrix;
+} DemoFingerprints;
+
+static void add_fingerprint(const Molecule* mol, int line, int thread_index, void* user_data) {
+    (void)line;
+    (void)thread_index;
+    DemoFingerprints* fps = user_data;
+    uint64_t bits[FINGERPRINT_WORDS];
+    if (fingerprint_ecfp(&fps->context, mol, FINGERPRINT_DEFAULT_RADIUS, bits)) {
+        fingerprint_matrix_add(&fps->matrix, bits);
+    }
+}
+
+static void demo_similarity(void) {
+    print_header("Similarity Search");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter query SMILES (e.g., OC(=O)c1ccccc1O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    DemoFingerprints fps;
+    fingerprint_context_init(&fps.context);
+    fingerprint_matrix_init(&fps.matrix);
+
+    Molecule query_mol;
+    molecule_init(&query_mol, NULL);
+    uint64_t query[FINGERPRINT_WORDS];
+    if (!smiles_parse(input, &query_mol) ||
+        !fingerprint_ecfp(&fps.context, &query_mol, FINGERPRINT_DEFAULT_RADIUS, query)) {
+        printf("\nInvalid query SMILES.\n");
+        molecule_free(&query_mol);
+        fingerprint_context_free(&fps.context);
+        return;
+    }
+
+    char path[MAX_FORMULA_LENGTH];
+    printf("Library file (one SMILES per line, blank for built-in set): ");
+    if (fgets(path, sizeof(path), stdin) == NULL) path[0] = 0;
+    path[strcspn(path, "\n")] = 0;
+
+    /* Built on one thread so rows keep line order */
+    if (path[0]) {
+        if (!smiles_parse_file(path, 1, true, add_fingerprint, &fps, NULL)) {
+            printf("\nFailed to read %s\n", path);
+        }
+    } else {
+        for (int i = 0; i < DEMO_LIBRARY_SIZE; i++) {
+            Molecule mol;
+            molecule_init(&mol, NULL);
+            if (smiles_parse(DEMO_LIBRARY[i], &mol)) add_fingerprint(&mol, i, 0, &fps);
+            molecule_free(&mol);
+        }
+    }
+
+    SimilarityHit hits[DEMO_SIMILAR_HITS];
+    int found = fingerprint_top_k(&fps.matrix, query, DEMO_SIMILAR_HITS, 0, hits);
+    printf("\nTop %d of %d by Tanimoto (ECFP4):\n", found > 0 ? found : 0, fps.matrix.count);
+    for (int i = 0; i < found; i++) {
+        if (path[0]) {
+            printf("  %.3f  entry %d\n", hits[i].similarity, hits[i].index + 1);
+        } else {
+            printf("  %.3f  %s\n", hits[i].similarity, DEMO_LIBRARY[hits[i].index]);
+        }
+    }
+
+    molecule_free(&query_mol);
+    fingerprint_matrix_free(&fps.matrix);
+    fingerprint_context_free(&fps.context);
+}
+
+/* ============ Validation Demo ============ */
+
+#define DEMO_VALIDATION_ISSUES 16
+
+static void demo_validation(void) {
+    print_header("Validate Valences");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter SMILES (e.g., C[N](=O)=O or [CH3]): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Molecule mol;
+    molecule_init(&mol, NULL);
+    if (!smiles_parse(input, &mol)) {
+        printf("\nInvalid SMILES.\n");
+        molecule_free(&mol);
+        return;
+    }
+
+    Validator validator;
+    validator_init(&validator);
+    ValidationIssue issues[DEMO_VALIDATION_ISSUES];
+    int found = validator_check(&validator, &mol, issues, DEMO_VALIDATION_ISSUES);
+
+    if (found == 0) {
+        printf("\n%s: all valences and charges consistent\n", molecule_formula(&mol));
+    } else if (found > 0) {
+        printf("\n%s: %d issue(s)\n", molecule_formula(&mol), found);
+        int shown = found < DEMO_VALIDATION_ISSUES ? found : DEMO_VALIDATION_ISSUES;
+        for (int i = 0; i < shown; i++) {
+            const ValidationIssue* issue = &issues[i];
+            if (issue->kind == VALIDATION_BAD_BOND) {
+                printf("  bond %d: %s\n", issue->atom, validation_kind_str(issue->kind));
+                continue;
+            }
+            printf("  atom %d (%s): %s, bond order sum %d, charge %+d",
+                   issue->atom, mol.atoms[issue->atom].element->symbol,
+                   validation_kind_str(issue->kind), issue->bond_order_sum, issue->declared_charge);
+            if (issue->formal_charge != issue->declared_charge) {
+                printf(", formal charge %+d", issue->formal_charge);
+            }
+            printf("\n");
+        }
+    } else {
+        printf("\nOut of memory.\n");
+    }
+
+    validator_free(&validator);
+    molecule_free(&mol);
+}
+
+/* ============ Geometry ============ */
+
+#define DEMO_MINIMIZE_STEPS 5000
+#define DEMO_RMS_GRADIENT 0.05
+
+static void demo_minimize(void) {
+    print_header("Minimize Geometry");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter SMILES (e.g., CCO or c1ccccc1O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Molecule mol;
+    molecule_init(&mol, NULL);
+    if (!smiles_parse(input, &mol)) {
+        printf("\nInvalid SMILES.\n");
+        molecule_free(&mol);
+        return;
+    }
+
+    ForceField ff;
+    forcefield_init(&ff);
+    MinimizeResult result;
+    ForceFieldEnergy terms;
+    if (!molecule_expand_hydrogens(&mol) || !forcefield_setup(&ff, &mol, 0.0) ||
+        !forcefield_embed(&ff, &mol, 1u) ||
+        !forcefield_minimize(&ff, &mol, DEMO_MINIMIZE_STEPS, DEMO_RMS_GRADIENT, 0, &result)) {
+        printf("\nOut of memory.\n");
+        forcefield_free(&ff);
+        molecule_free(&mol);
+        return;
+    }
+    forcefield_energy(&ff, &mol, 0, &terms);
+
+    printf("\n%s, %d atoms with hydrogens\n", molecule_formula(&mol), mol.atom_count);
+    printf("Energy: %.2f -> %.2f kcal/mol in %d steps (%s, RMS gradient %.3f)\n",
+           result.initial_energy, result.final_energy, result.steps,
+           result.converged ? "converged" : "not converged", result.rms_gradient);
+    printf("  bonds %.2f, angles %.2f, van der Waals %.2f, electrostatic %.2f\n",
+           terms.bond, terms.angle, terms.van_der_waals, terms.electrostatic);
+
+    printf("\n  %-4s %10s %10s %10s\n", "Atom", "x", "y", "z");
+    for (int i = 0; i < mol.atom_count; i++) {
+        printf("  %-2s%-2d %10.4f %10.4f %10.4f\n", mol.atoms[i].element->symbol, i + 1,
+               mol.coord_x[i], mol.coord_y[i], mol.coord_z[i]);
+    }
+
+    forcefield_free(&ff);
+    molecule_free(&mol);
+}
+
+/* ============ Descriptors ============ */
+
+static void demo_descriptors(void) {
+    print_header("Molecular Descriptors");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter SMILES (e.g., CC(=O)Oc1ccccc1C(=O)O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Molecule mol;
+    molecule_init(&mol, NULL);
+    if (!smiles_parse(input, &mol)) {
+        printf("\nInvalid SMILES.\n");
+        molecule_free(&mol);
+        return;
+    }
+
+    DescriptorContext ctx;
+    descriptor_context_init(&ctx);
+    double values[DESCRIPTOR_COUNT];
+    if (descriptor_compute(&ctx, &mol, DESCRIPTOR_ALL, values)) {
+        printf("\n%s\n", molecule_formula(&mol));
+        for (int d = 0; d < DESCRIPTOR_COUNT; d++) {
+            printf("  %-10s %10.3f\n", descriptor_name((Descriptor)d), values[d]);
+        }
+    } else {
+        printf("\nOut of memory.\n");
+    }
+
+    descriptor_context_free(&ctx);
+    molecule_free(&mol);
+}
+
+static void demo_atom_map(void) {
+    print_header("Reaction Atom Mapping");
+
+    char input[MAX_FORMULA_LENGTH];
+    printf("Enter reaction SMILES (e.g., CC(=O)O.OCC>>CC(=O)OCC.O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Molecule reactants, products;
+    molecule_init(&reactants, NULL);
+    molecule_init(&products, NULL);
+    if (!atom_map_parse_reaction(input, &reactants, &products)) {
+        printf("\nInvalid reaction SMILES.\n");
+        molecule_free(&reactants);
+        molecule_free(&products);
+        return;
+    }
+
+    int* map = malloc((size_t)(reactants.atom_count > 0 ? reactants.atom_count : 1) * sizeof(int));
+    AtomMapper mapper;
+    atom_mapper_init(&mapper);
+    AtomMapResult result;
+    if (map && atom_map(&mapper, &reactants, &products, 0.0, map, &result)) {
+        printf("\n%s -> %s\n", molecule_formula(&reactants), molecule_formula(&products));
+        printf("Bonds broken %d, formed %d, changed order %d\n", result.bonds_broken,
+               result.bonds_formed, result.bonds_changed);
+        printf("Atoms changed %d, unmapped %d, search nodes %lld%s\n\n", result.atoms_changed,
+               result.unmapped, result.nodes,
+               result.optimal ? "" : " (time budget reached, may not be optimal)");
+        for (int i = 0; i < reactants.atom_count; i++) {
+            if (map[i] < 0) continue;
+            printf("  %-2s%-3d -> %-2s%-3d\n", reactants.atoms[i].element->symbol, i + 1,
+                   products.atoms[map[i]].element->symbol, map[i] + 1);
+        }
+    } else {
+        printf("\nOut of memory.\n");
+    }
+
+    atom_mapper_free(&mapper);
+    free(map);
+    molecule_free(&reactants);
+    molecule_free(&products);
+}
+
+/* Add the '+'-separated formulas of one side; false if any fails to parse */
+static bool parse_reaction_side(char* text, Reaction* rxn, bool products) {
+    char* token = strtok(text, "+");
+    if (!token) return false;
+    while (token) {
+        bool ok = products ? reaction_add_product(rxn, token) : reaction_add_reactant(rxn, token);
+        if (!ok) return false;
+        token = strtok(NULL, "+");
+    }
+    return true;
+}
+
+static void demo_reaction_similarity(void) {
+    print_header("Similar Reactions");
+
+    char input[256];
+    printf("Enter a reaction (e.g., KOH + HCl -> KCl + H2O): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Reaction query;
+    reaction_init(&query);
+    char* arrow = strstr(input, "->");
+    if (arrow) *arrow = '\0';
+    if (!arrow || !parse_reaction_side(input, &query, false) ||
+        !parse_reaction_side(arrow + 2, &query, true)) {
+        printf("\nInvalid reaction.\n");
+        return;
+    }
+
+    char type_input[32];
+    printf("Restrict to a type (0-%d, blank for all):\n", RXTYPE_OTHER);
+    for (int t = 0; t <= RXTYPE_OTHER; t++) {
+        printf("  %d. %s\n", t, reaction_type_str((ReactionType)t));
+    }
+    printf("Type: ");
+    if (fgets(type_input, sizeof(type_input), stdin) == NULL) return;
+    unsigned int mask = REACTION_TYPE_ALL;
+    if (isdigit((unsigned char)type_input[0])) {
+        int type = atoi(type_input);
+        if (type >= 0 && type <= RXTYPE_OTHER) mask = REACTION_TYPE_BIT(type);
+    }
+
+    SimilarityHit hits[5];
+    reaction_db_read_begin();
+    int count = reaction_db_similar(&query, mask, 5, hits);
+    if (count <= 0) {
+        printf("\nNo reactions of that type.\n");
+    } else {
+        printf("\n");
+    }
+    for (int i = 0; i < count; i++) {
+        const Reaction* rxn = reaction_db_get(hits[i].index);
+        printf("  %6.3f  %-20s ", hits[i].similarity, reaction_type_str(rxn->type));
+        reaction_print(rxn);
+    }
+    reaction_db_read_end();
+}
+
+static void demo_network(void) {
+    print_header("Reaction Network Expansion");
+
+    char input[256];
+    printf("Enter seed species separated by ',' (e.g., Na, Cl2, H2, O2, CH4, Zn, HCl): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    Formula seeds[32];
+    int count = 0;
+    char* token = strtok(input, ",");
+    while (token && count < 32) {
+        if (formula_parse(token, &seeds[count])) count++;
+        token = strtok(NULL, ",");
+    }
+    if (count == 0) {
+        printf("\nNo valid species.\n");
+        return;
+    }
+
+    char number[32];
+    printf("Generations (default 3): ");
+    if (fgets(number, sizeof(number), stdin) == NULL) return;
+
+    NetworkOptions options;
+    network_options_default(&options);
+    if (atoi(number) > 0) options.max_generations = atoi(number);
+    options.max_seconds = 10.0;
+
+    ReactionNetwork network;
+    network_init(&network);
+    NetworkStats stats;
+    if (!network_expand(&network, seeds, count, &options, &stats)) {
+        printf("\nExpansion failed.\n");
+        network_free(&network);
+        return;
+    }
+
+    printf("\n%d species, %d reactions from %lld pairs in %.3f s (stopped: %s)\n",
+           network.species_count, network.reaction_count, stats.pairs, stats.seconds,
+           network_stop_str(stats.stop));
+    for (int g = 0; g < network.generation_count; g++) {
+        printf("  Generation %d: %d species\n", g,
+               network.generation_offsets[g + 1] - network.generation_offsets[g]);
+    }
+
+    int shown = network.reaction_count < 20 ? network.reaction_count : 20;
+    if (shown > 0) printf("\nFirst %d reactions:\n", shown);
+    Reaction* rxn = malloc(sizeof(Reaction));
+    for (int i = 0; rxn && i < shown; i++) {
+        network_reaction_get(&network, i, rxn);
+        printf("  [%d] ", network.reactions[i].generation);
+        reaction_print(rxn);
+    }
+
+    free(rxn);
+    network_free(&network);
+}
+
+/* Read 'k: reactants -> products' lines until a blank one; false if none */
+static bool read_kinetics_model(KineticsModel* model, const char* example) {
+    Reaction* rxn = malloc(sizeof(Reaction));
+    if (!rxn) return false;
+
+    char input[256];
+    printf("Enter reactions as 'k: reactants -> products', blank line to finish\n");
+    printf("(e.g., %s):\n", example);
+    while (fgets(input, sizeof(input), stdin) != NULL) {
+        input[strcspn(input, "\n")] = 0;
+        if (input[0] == '\0') break;
+
+        char* colon = strchr(input, ':');
+        char* arrow = colon ? strstr(colon, "->") : NULL;
+        reaction_init(rxn);
+        if (arrow) *arrow = '\0';
+        if (!arrow || !parse_reaction_side(colon + 1, rxn, false) ||
+            !parse_reaction_side(arrow + 2, rxn, true) ||
+            kinetics_add_reaction(model, rxn, atof(input)) < 0) {
+            printf("  Invalid reaction, skipped.\n");
+        }
+    }
+    free(rxn);
+    if (model->reaction_count == 0) {
+        printf("\nNo reactions.\n");
+        return false;
+    }
+    printf("Species:");
+    for (int i = 0; i < model->species_count; i++) printf(" %s", model->names[i]);
+    printf("\n");
+    return true;
+}
+
+static void demo_kinetics(void) {
+    print_header("Mass-Action Kinetics");
+
+    KineticsModel model;
+    kinetics_model_init(&model);
+    if (!read_kinetics_model(&model, "0.04: O3 -> O2 + O")) {
+        kinetics_model_free(&model);
+        return;
+    }
+
+    double* c = calloc((size_t)model.species_count, sizeof(double));
+    if (!c) {
+        kinetics_model_free(&model);
+        return;
+    }
+    char input[256];
+    printf("Initial concentrations (e.g., O3=1, O2=0.5; others 0): ");
+    if (fgets(input, sizeof(input), stdin) != NULL) {
+        input[strcspn(input, "\n")] = 0;
+        char* token = strtok(input, ",");
+        while (token) {
+            char* equals = strchr(token, '=');
+            Formula species;
+            if (equals) *equals = '\0';
+            int index = equals && formula_parse(token, &species) ? kinetics_species_find(&model, &species) : -1;
+            if (index >= 0) c[index] = atof(equals + 1);
+            else printf("  Unknown species '%s' ignored.\n", token);
+            token = strtok(NULL, ",");
+        }
+    }
+
+    char number[32];
+    printf("End time (default 10): ");
+    if (fgets(number, sizeof(number), stdin) == NULL) number[0] = '\0';
+    double t_end = atof(number) > 0.0 ? atof(number) : 10.0;
+
+    char path[256];
+    printf("CSV file (blank for screen): ");
+    if (fgets(path, sizeof(path), stdin) == NULL) path[0] = '\0';
+    path[strcspn(path, "\n")] = 0;
+    FILE* csv = path[0] ? fopen(path, "w") : stdout;
+    if (!csv) {
+        printf("\nCannot open %s.\n", path);
+        free(c);
+        kinetics_model_free(&model);
+        return;
+    }
+
+    KineticsOptions options;
+    kinetics_options_default(&options);
+    options.output_interval = t_end / 20.0;
+    KineticsStats stats;
+    printf("\n");
+    bool ok = kinetics_simulate(&model, c, t_end, &options, csv, &stats);
+    if (csv != stdout) fclose(csv);
+
+    printf("\n%s at t = %g after %lld steps (%lld rejected, %lld factorizations)\n",
+           ok ? "Reached" : "Stopped", stats.time, stats.steps, stats.rejected, stats.factorizations);
+    for (int i = 0; i < model.species_count; i++) printf("  %-12s %.6g\n", model.names[i], c[i]);
+
+    free(c);
+    kinetics_model_free(&model);
+}
+
+static void demo_stochastic(void) {
+    print_header("Stochastic Kinetics");
+
+    KineticsModel model;
+    kinetics_model_init(&model);
+    StochasticSystem system;
+    if (!read_kinetics_model(&model, "0.001: NO2 + NO2 -> N2O4") ||
+        !stochastic_system_init(&system, &model)) {
+        kinetics_model_free(&model);
+        return;
+    }
+
+    int n = model.species_count;
+    int64_t* counts = calloc((size_t)n, sizeof(int64_t));
+    double* sum = calloc((size_t)n, sizeof(double));
+    double* sum_squares = calloc((size_t)n, sizeof(double));
+    char input[256];
+    printf("Initial molecule counts (e.g., NO2=500; others 0): ");
+    if (counts && sum && sum_squares && fgets(input, sizeof(input), stdin) != NULL) {
+        input[strcspn(input, "\n")] = 0;
+        char* token = strtok(input, ",");
+        while (token) {
+            char* equals = strchr(token, '=');
+            Formula species;
+            if (equals) *equals = '\0';
+            int index = equals && formula_parse(token, &species) ? kinetics_species_find(&model, &species) : -1;
+            if (index >= 0 && atoll(equals + 1) >= 0) counts[index] = atoll(equals + 1);
+            else printf("  Unknown species '%s' ignored.\n", token);
+            token = strtok(NULL, ",");
+        }
+    }
+
+    StochasticOptions options;
+    stochastic_options_default(&options);
+    char number[32];
+    printf("End time (default 10): ");
+    if (fgets(number, sizeof(number), stdin) == NULL) number[0] = '\0';
+    options.t_end = atof(number) > 0.0 ? atof(number) : 10.0;
+    printf("Trajectories (default 1000): ");
+    if (fgets(number, sizeof(number), stdin) == NULL) number[0] = '\0';
+    int trajectories = atoi(number) > 0 ? atoi(number) : 1000;
+    options.max_events = 10000000;
+
+    int64_t* samples = malloc((size_t)trajectories * n * sizeof(int64_t));
+    StochasticStats stats;
+    if (!counts || !sum || !sum_squares || !samples ||
+        !stochastic_run_ensemble(&system, counts, trajectories, &options, samples, &stats)) {
+        printf("\nSimulation failed.\n");
+    } else {
+        for (int t = 0; t < trajectories; t++) {
+            for (int i = 0; i < n; i++) {
+                double v = (double)samples[(size_t)t * n + i];
+                sum[i] += v;
+                sum_squares[i] += v * v;
+            }
+        }
+        printf("\n%lld events in %.3f s", stats.events, stats.seconds);
+        if (stats.truncated > 0) printf(" (%d trajectories cut short)", stats.truncated);
+        printf("\nCounts at t = %g over %d trajectories (mean, std dev):\n", options.t_end, trajectories);
+        for (int i = 0; i < n; i++) {
+            double mean = sum[i] / trajectories;
+            double variance = sum_squares[i] / trajectories - mean * mean;
+            printf("  %-12s %12.2f %10.2f\n", model.names[i], mean, variance > 0.0 ? sqrt(variance) : 0.0);
+        }
+    }
+
+    free(samples);
+    free(counts);
+    free(sum);
+    free(sum_squares);
+    stochastic_system_free(&system);
+    kinetics_model_free(&model);
+}
+
+static void demo_energetics(void) {
+    print_header("Reaction Energetics");
+
+    char input[64];
+    printf("Show reactions with Delta G below (kJ/mol, blank for all): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    double max_gibbs = input[0] == '\n' ? INFINITY : atof(input);
+
+    reaction_db_read_begin();
+    int count = reaction_db_count();
+    const Reaction** reactions = malloc((size_t)(count > 0 ? count : 1) * sizeof(Reaction*));
+    int* order = malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+    int kept = -1;
+    if (reactions && order) {
+        for (int i = 0; i < count; i++) reactions[i] = reaction_db_get(i);
+        kept = thermo_rank(reactions, count, max_gibbs, order);
+    }
+    if (kept < 0) {
+        printf("\nRanking failed.\n");
+    } else {
+        printf("\n%d of %d reactions, most favorable first (298.15 K):\n", kept,
+               reaction_db_live_count());
+        printf("  %10s %12s %10s  %s\n", "dH kJ/mol", "dS J/(mol K)", "dG kJ/mol", "Reaction");
+        for (int i = 0; i < kept; i++) {
+            const Reaction* rxn = reactions[order[i]];
+            const ReactionEnergetics* e = &rxn->energetics;
+            printf("  %10.2f %12.2f %10.2f  %s\n", e->enthalpy, e->entropy, e->gibbs, rxn->description);
+        }
+    }
+    reaction_db_read_end();
+
+    free(reactions);
+    free(order);
+}
+
+static void demo_edit_database(void) {
+    print_header("Edit Reaction Database");
+
+    char input[256];
+    printf("Enter a reaction to add (e.g., 2CO + O2 -> 2CO2),\n");
+    printf("or '-' and a number to remove one (e.g., -3): ");
+    if (fgets(input, sizeof(input), stdin) == NULL) return;
+    input[strcspn(input, "\n")] = 0;
+
+    if (input[0] == '-') {
+        int number = atoi(input + 1);
+        if (reaction_db_remove(number - 1)) {
+            printf("\nRemoved reaction %d; %d reactions remain.\n", number, reaction_db_live_count());
+        } else {
+            printf("\nNo reaction %d.\n", number);
+        }
+        return;
+    }
+
+    Reaction* rxn = malloc(sizeof(Reaction));
+    if (!rxn) return;
+    reaction_init(rxn);
+    char* arrow = strstr(input, "->");
+    if (arrow) *arrow = '\0';
+    if (!arrow || !parse_reaction_side(input, rxn, false) ||
+        !parse_reaction_side(arrow + 2, rxn, true)) {
+        printf("\nInvalid reaction.\n");
+        free(rxn);
+        return;
+    }
+    printf("Type (0-%d, blank for other): ", RXTYPE_OTHER);
+    if (fgets(input, sizeof(input), stdin) != NULL && isdigit((unsigned char)input[0])) {
+        int type = atoi(input);
+        if (type >= 0 && type <= RXTYPE_OTHER) reaction_set_type(rxn, (ReactionType)type);
+    }
+    strncpy(rxn->description, "User reaction", sizeof(rxn->description) - 1);
+
+    int index = reaction_db_insert(rxn);
+    free(rxn);
+    if (index < 0) {
+        printf("\nCould not add the reaction.\n");
+        return;
+    }
+    const Reaction* added = reaction_db_get(index);
+    printf("\nAdded as reaction %d (%s):\n", index + 1,
+           added->is_balanced ? "balanced" : "not balanced");
+    reaction_print_detailed(added);
+}
+
 /* ============ Interactive Menu ============ */
 
 static void print_menu(void) {
@@ -238,6 +1269,25 @@ static void print_menu(void) {
     printf("  5. List all known reactions\n");
     printf("  6. Show periodic table overview\n");
     printf("  7. Find reactions by element\n");
+    printf("  8. Find reactions runnable from inventory\n");
+    printf("  9. Search synthesis routes\n");
+    printf(" 10. Predict reaction products\n");
+    printf(" 11. Enumerate ionic compounds\n");
+    printf(" 12. Run performance benchmarks\n");
+    printf(" 13. Find formulas for a mass\n");
+    printf(" 14. Read SMILES\n");
+    printf(" 15. Substructure search\n");
+    printf(" 16. Similarity search\n");
+    printf(" 17. Validate valences\n");
+    printf(" 18. Minimize geometry\n");
+    printf(" 19. Molecular descriptors\n");
+    printf(" 20. Map reaction atoms\n");
+    printf(" 21. Find similar reactions\n");
+    printf(" 22. Expand a reaction network\n");
+    printf(" 23. Simulate kinetics\n");
+    printf(" 24. Simulate stochastic kinetics\n");
+    printf(" 25. Rank reactions by energy\n");
+    printf(" 26. Add or remove a database reaction\n");
     printf("  0. Exit\n");
     printf("\n");
     printf("Enter choice: ");
@@ -290,6 +1340,64 @@ int main(void) {
             case 7:
                 demo_reactions_by_element();
                 break;
+            case 8:
+                demo_inventory();
+                break;
+            case 9:
+                demo_routes();
+                break;
+            case 10:
+                demo_predict();
+                break;
+            case 11:
+                demo_ionic_enumeration();
+                break;
+            case 12:
+                print_header("Performance Benchmarks");
+                benchmark_run_all();
+                break;
+            case 13:
+                demo_mass_decomposition();
+                break;
+            case 14:
+                demo_smiles();
+                break;
+            case 15:
+                demo_substructure();
+                break;
+            case 16:
+                demo_similarity();
+                break;
+            case 17:
+                demo_validation();
+                break;
+            case 18:
+                demo_minimize();
+                break;
+            case 19:
+                demo_descriptors();
+                break;
+            case 20:
+                demo_atom_map();
+                break;
+            case 21:
+                demo_reaction_similarity();
+                break;
+            case 22:
+                demo_network();
+                break;
+            case 23:
+                demo_kinetics();
+                break;
+            case 24:
+                demo_stochastic();
+                break;
+            case 25:
+                demo_energetics();
+                break;
+            case 26:
+                demo_edit_database();
+                break;
             default:
                 printf("Invalid choice. Please try again.\n");
                 break;
@@ -0,0 +1,341 @@
+#include "mass_decomp.h"
+#include "parallel.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ERT_INFINITY LLONG_MAX
+
+static long long gcd_ll(long long a, long long b) {
+    while (b) {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static double element_mass_of(const Element* el, MassType type) {
+    return type == MASS_MONOISOTOPIC ? element_monoisotopic_mass(el) : el->atomic_mass;
+}
+
+/* ============ Table Construction ============ */
+
+/*
+ * Round-robin fill of column i from column i - 1: within each cycle of
+ * residues reachable by adding integer_masses[i], start from the smallest
+ * known value and walk the cycle keeping the running minimum.
+ */
+static void ert_fill_column(MassDecomposer* d, int i) {
+    long long a0 = d->residue_count;
+    long long ai = d->integer_masses[i];
+    int k = d->element_count;
+    long long* ert = d->ert;
+    long long g = gcd_ll(a0, ai);
+    long long cycle = a0 / g;
+
+    for (long long phase = 0; phase < g; phase++) {
+        long long n = ERT_INFINITY;
+        for (long long step = 0, r = phase; step < cycle; step++, r = (r + ai) % a0) {
+            if (ert[r * k + (i - 1)] < n) n = ert[r * k + (i - 1)];
+        }
+
+        if (n == ERT_INFINITY) {
+            for (long long step = 0, r = phase; step < cycle; step++, r = (r + ai) % a0) {
+                ert[r * k + i] = ERT_INFINITY;
+            }
+            continue;
+        }
+
+        ert[(n % a0) * k + i] = n;
+        for (long long step = 1; step < cycle; step++) {
+            n += ai;
+            long long r = n % a0;
+            if (ert[r * k + (i - 1)] < n) n = ert[r * k + (i - 1)];
+            ert[r * k + i] = n;
+        }
+    }
+}
+
+/* Spread of the integer/real mass ratios for a given scale */
+static double rounding_spread(const double* masses, int count, double scale) {
+    double lo = INFINITY, hi = 0.0;
+    for (int i = 0; i < count; i++) {
+        double ratio = (double)llround(masses[i] * scale) / (masses[i] * scale);
+        if (ratio < lo) lo = ratio;
+        if (ratio > hi) hi = ratio;
+    }
+    return hi - lo;
+}
+
+/*
+ * The query window grows with the spread of rounding errors, so search a
+ * few percent above the requested scale for one where all alphabet masses
+ * round almost exactly (the "blowup" optimization).
+ */
+static double best_precision(const double* masses, int count, double precision) {
+    double base = 1.0 / precision;
+    double best_scale = base;
+    double best = rounding_spread(masses, count, base);
+
+    for (int step = 1; step <= 20000; step++) {
+        double scale = base * (1.0 + step * 2e-6);
+        double spread = rounding_spread(masses, count, scale);
+        if (spread < best) {
+            best = spread;
+            best_scale = scale;
+        }
+    }
+    return 1.0 / best_scale;
+}
+
+bool mass_decomposer_init(MassDecomposer* d, const MassAlphabetEntry* alphabet,
+                          int alphabet_count, MassType type, double precision) {
+    if (!d || !alphabet || alphabet_count <= 0 || alphabet_count > MASS_MAX_ELEMENTS) return false;
+    memset(d, 0, sizeof(MassDecomposer));
+
+    d->mass_type = type;
+    d->precision = precision > 0.0 ? precision : 1e-4;
+    d->element_count = alphabet_count;
+
+    /* Insertion sort by mass so the smallest mass defines the residue classes */
+    for (int i = 0; i < alphabet_count; i++) {
+        const MassAlphabetEntry* e = &alphabet[i];
+        if (!e->element || e->min_count < 0 || e->max_count < e->min_count) return false;
+
+        double mass = element_mass_of(e->element, type);
+        int j = i;
+        while (j > 0 && d->masses[j - 1] > mass) {
+            d->elements[j] = d->elements[j - 1];
+            d->masses[j] = d->masses[j - 1];
+            d->min_counts[j] = d->min_counts[j - 1];
+            d->ranges[j] = d->ranges[j - 1];
+            j--;
+        }
+        d->elements[j] = e->element;
+        d->masses[j] = mass;
+        d->min_counts[j] = e->min_count;
+        d->ranges[j] = e->max_count - e->min_count;
+    }
+
+    d->precision = best_precision(d->masses, alphabet_count, d->precision);
+    d->min_ratio = INFINITY;
+    d->max_ratio = 0.0;
+    for (int i = 0; i < alphabet_count; i++) {
+        d->integer_masses[i] = llround(d->masses[i] / d->precision);
+        if (d->integer_masses[i] <= 0) return false;
+
+        double ratio = (double)d->integer_masses[i] * d->precision / d->masses[i];
+        if (ratio < d->min_ratio) d->min_ratio = ratio;
+        if (ratio > d->max_ratio) d->max_ratio = ratio;
+
+        d->max_rest[i] = i == 0 ? 0 : d->max_rest[i - 1] +
+                         (long long)d->ranges[i - 1] * d->integer_masses[i - 1];
+    }
+
+    d->residue_count = d->integer_masses[0];
+    d->ert = malloc((size_t)d->residue_count * alphabet_count * sizeof(long long));
+    if (!d->ert) return false;
+
+    for (long long r = 0; r < d->residue_count; r++) {
+        d->ert[r * alphabet_count] = r == 0 ? 0 : ERT_INFINITY;
+    }
+    for (int i = 1; i < alphabet_count; i++) {
+        ert_fill_column(d, i);
+    }
+    return true;
+}
+
+void mass_decomposer_free(MassDecomposer* d) {
+    if (!d) return;
+    free(d->ert);
+    memset(d, 0, sizeof(MassDecomposer));
+}
+
+void mass_query_options_default(MassQueryOptions* options) {
+    if (!options) return;
+    options->ppm = 5.0;
+    options->use_rdbe = true;
+    options->rdbe_min = 0.0;
+    options->rdbe_max = 50.0;
+    options->integer_rdbe = false;
+}
+
+/* ============ Queries ============ */
+
+typedef struct {
+    const MassDecomposer* d;
+    const MassQueryOptions* options;
+    double target;
+    double tolerance;
+    int counts[MASS_MAX_ELEMENTS];      /* Free counts above min_counts */
+    MassCandidate* results;
+    int max_results;
+    int found;
+} MassSearch;
+
+static void check_candidate(MassSearch* s) {
+    const MassDecomposer* d = s->d;
+    double mass = 0.0;
+    double rdbe = 1.0;
+
+    for (int i = 0; i < d->element_count; i++) {
+        int n = s->counts[i] + d->min_counts[i];
+        mass += n * d->masses[i];
+        rdbe += n * (element_max_bonds(d->elements[i]) - 2) / 2.0;
+    }
+
+    if (fabs(mass - s->target) > s->tolerance) return;
+    if (s->options->use_rdbe) {
+        if (rdbe < s->options->rdbe_min - 1e-9 || rdbe > s->options->rdbe_max + 1e-9) return;
+        if (s->options->integer_rdbe && fabs(rdbe - floor(rdbe + 0.5)) > 1e-9) return;
+    }
+
+    if (s->found < s->max_results) {
+        MassCandidate* c = &s->results[s->found];
+        for (int i = 0; i < d->element_count; i++) c->counts[i] = s->counts[i] + d->min_counts[i];
+        c->mass = mass;
+        c->error_ppm = (mass - s->target) / s->target * 1e6;
+        c->rdbe = rdbe;
+    }
+    s->found++;
+}
+
+/* Enumerate decompositions of integer mass m using elements [0, i] */
+static void decompose_integer(MassSearch* s, long long m, int i) {
+    const MassDecomposer* d = s->d;
+
+    if (i == 0) {
+        long long a0 = d->integer_masses[0];
+        if (m % a0 != 0 || m / a0 > d->ranges[0]) return;
+        s->counts[0] = (int)(m / a0);
+        check_candidate(s);
+        return;
+    }
+
+    long long ai = d->integer_masses[i];
+    long long a0 = d->residue_count;
+    int k = d->element_count;
+
+    /* Lower elements can absorb at most max_rest[i], which bounds j from below */
+    long long j = 0;
+    if (m > d->max_rest[i]) j = (m - d->max_rest[i] + ai - 1) / ai;
+
+    for (; j <= d->ranges[i]; j++) {
+        long long rest = m - j * ai;
+        if (rest < 0) break;
+        if (d->ert[(rest % a0) * k + (i - 1)] > rest) continue;
+        s->counts[i] = (int)j;
+        decompose_integer(s, rest, i - 1);
+    }
+    s->counts[i] = 0;
+}
+
+int mass_decompose(const MassDecomposer* d, double mass,
+                   const MassQueryOptions* options,
+                   MassCandidate* results, int max_results) {
+    if (!d || !d->ert || mass <= 0.0) return 0;
+
+    MassQueryOptions defaults;
+    if (!options) {
+        mass_query_options_default(&defaults);
+        options = &defaults;
+    }
+
+    MassSearch s;
+    memset(&s, 0, sizeof(MassSearch));
+    s.d = d;
+    s.options = options;
+    s.target = mass;
+    s.tolerance = mass * options->ppm * 1e-6;
+    s.results = results;
+    s.max_results = results ? max_results : 0;
+
+    /* Mass left after the mandatory minimum counts */
+    double fixed = 0.0;
+    for (int i = 0; i < d->element_count; i++) fixed += d->min_counts[i] * d->masses[i];
+    double lo = mass - s.tolerance - fixed;
+    double hi = mass + s.tolerance - fixed;
+    if (hi < 0.0) return 0;
+    if (lo < 0.0) lo = 0.0;
+
+    /* Integer masses of any formula in [lo, hi] lie within these bounds */
+    long long first = (long long)ceil(lo / d->precision * d->min_ratio - 1e-9);
+    long long last = (long long)floor(hi / d->precision * d->max_ratio + 1e-9);
+    int top = d->element_count - 1;
+
+    for (long long m = first; m <= last; m++) {
+        if (d->ert[(m % d->residue_count) * d->element_count + top] > m) continue;
+        decompose_integer(&s, m, top);
+    }
+    return s.found;
+}
+
+typedef struct {
+    const MassDecomposer* d;
+    const double* masses;
+    const MassQueryOptions* options;
+    MassCandidate* results;
+    int max_per_query;
+    int* counts;
+} MassBatch;
+
+static void decompose_range(int begin, int end, int thread_index, void* user_data) {
+    (void)thread_index;
+    MassBatch* b = user_data;
+    for (int q = begin; q < end; q++) {
+        MassCandidate* out = b->results ? &b->results[(size_t)q * b->max_per_query] : NULL;
+        b->counts[q] = mass_decompose(b->d, b->masses[q], b->options, out, b->max_per_query);
+    }
+}
+
+bool mass_decompose_batch(const MassDecomposer* d, const double* masses, int mass_count,
+                          const MassQueryOptions* options, MassCandidate* results,
+                          int max_per_query, int* counts, int threads) {
+    if (!d || !masses || !counts || mass_count < 0) return false;
+
+    MassBatch batch = {d, masses, options, results, max_per_query, counts};
+    parallel_for(mass_count, 16, threads, decompose_range, &batch);
+    return true;
+}
+
+/* ============ Output ============ */
+
+bool mass_candidate_to_formula(const MassDecomposer* d, const MassCandidate* c, Formula* formula) {
+    if (!d || !c || !formula) return false;
+
+    memset(formula, 0, sizeof(Formula));
+    formula->coefficient = 1;
+
+    /* Hill order: C, H, then the rest alphabetically (all alphabetical without C) */
+    int order[MASS_MAX_ELEMENTS];
+    bool has_carbon = false;
+    for (int i = 0; i < d->element_count; i++) {
+        order[i] = i;
+        if (d->elements[i]->atomic_number == 6 && c->counts[i] > 0) has_carbon = true;
+    }
+    for (int i = 1; i < d->element_count; i++) {
+        int key = order[i];
+        int j = i;
+        while (j > 0) {
+            const Element* a = d->elements[order[j - 1]];
+            const Element* b = d->elements[key];
+            int rank_a = has_carbon ? (a->atomic_number == 6 ? 0 : a->atomic_number == 1 ? 1 : 2) : 2;
+            int rank_b = has_carbon ? (b->atomic_number == 6 ? 0 : b->atomic_number == 1 ? 1 : 2) : 2;
+            if (rank_a < rank_b || (rank_a == rank_b && strcmp(a->symbol, b->symbol) <= 0)) break;
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = key;
+    }
+
+    for (int i = 0; i < d->element_count; i++) {
+        int idx = order[i];
+        if (c->counts[idx] > 0 && !formula_add_element(formula, d->elements[idx], c->counts[idx])) {
+            return false;
+        }
+    }
+    return formula->element_count > 0;
+}
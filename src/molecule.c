@@ -1,10 +1,13 @@
 #include "molecule.h"
+#include "molecule_pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
+#include <math.h>
 
-/* Initialize a molecule */
+/* Initialize a molecule (does not free previous contents; see molecule_free) */
 void molecule_init(Molecule* mol, const char* name) {
     if (!mol) return;
 
@@ -14,18 +17,426 @@ void molecule_init(Molecule* mol, const char* name) {
     }
 }
 
+/* ============ Storage ============ */
+
+/* Resize an array from the molecule's pool or the heap, keeping contents */
+static void* storage_resize(Molecule* mol, void* old, size_t old_bytes, size_t new_bytes) {
+    if (!mol->pool) return realloc(old, new_bytes);
+
+    if (old && molecule_pool_block_size(old) >= new_bytes) return old;
+    void* block = molecule_pool_alloc(mol->pool, new_bytes);
+    if (!block) return NULL;
+    if (old) {
+        memcpy(block, old, old_bytes < new_bytes ? old_bytes : new_bytes);
+        molecule_pool_free(mol->pool, old);
+    }
+    return block;
+}
+
+static void storage_release(Molecule* mol, void* block) {
+    if (mol->pool) molecule_pool_free(mol->pool, block);
+    else free(block);
+}
+
+void* molecule_storage_resize(Molecule* mol, void* block, size_t old_bytes, size_t new_bytes) {
+    return mol ? storage_resize(mol, block, old_bytes, new_bytes) : NULL;
+}
+
+void molecule_storage_release(Molecule* mol, void* block) {
+    if (mol) storage_release(mol, block);
+}
+
+/* Capacity actually available in a pooled array (blocks round up) */
+static int storage_capacity(const Molecule* mol, const void* block, int requested, size_t item) {
+    if (!mol->pool) return requested;
+    return (int)(molecule_pool_block_size(block) / item);
+}
+
+/* Release atom, bond and adjacency storage and reset to empty */
+void molecule_free(Molecule* mol) {
+    if (!mol) return;
+
+    storage_release(mol, mol->atoms);
+    storage_release(mol, mol->bonds);
+    storage_release(mol, mol->adjacency_offsets);
+    storage_release(mol, mol->adjacency);
+    storage_release(mol, mol->adjacency_bonds);
+    storage_release(mol, mol->ring_offsets);
+    storage_release(mol, mol->ring_atoms);
+    storage_release(mol, mol->ring_bonds);
+    storage_release(mol, mol->atom_ring_counts);
+    storage_release(mol, mol->coord_x);
+    storage_release(mol, mol->coord_y);
+    storage_release(mol, mol->coord_z);
+
+    MoleculePool* pool = mol->pool;
+    molecule_init(mol, NULL);
+    mol->pool = pool;
+}
+
+/* Remove all atoms and bonds but keep storage for reuse */
+void molecule_clear(Molecule* mol) {
+    if (!mol) return;
+
+    mol->name[0] = '\0';
+    mol->formula[0] = '\0';
+    mol->atom_count = 0;
+    mol->bond_count = 0;
+    mol->molecular_mass = 0.0;
+    mol->total_charge = 0;
+    mol->implicit_hydrogens = 0;
+    for (int i = 0; i < mol->element_kinds; i++) mol->element_counts[mol->elements[i]] = 0;
+    mol->element_kinds = 0;
+    mol->adjacency_valid = false;
+    mol->rings_valid = false;
+}
+
+/* Release a heap or pool molecule together with its storage */
+void molecule_destroy(Molecule* mol) {
+    if (!mol) return;
+
+    if (mol->pool) {
+        molecule_pool_release(mol->pool, mol);
+    } else {
+        molecule_free(mol);
+        free(mol);
+    }
+}
+
+/* Grow the coordinate arrays alongside the atoms */
+static bool resize_coordinates(Molecule* mol, int capacity) {
+    size_t old_bytes = (size_t)mol->atom_count * sizeof(double);
+    size_t new_bytes = (size_t)(capacity > 0 ? capacity : 1) * sizeof(double);
+    double** axes[3] = {&mol->coord_x, &mol->coord_y, &mol->coord_z};
+    for (int a = 0; a < 3; a++) {
+        double* coords = storage_resize(mol, *axes[a], old_bytes, new_bytes);
+        if (!coords) return false;
+        *axes[a] = coords;
+    }
+    return true;
+}
+
+/* Grow storage to hold at least the given numbers of atoms and bonds */
+bool molecule_reserve(Molecule* mol, int atom_capacity, int bond_capacity) {
+    if (!mol || atom_capacity < 0 || bond_capacity < 0) return false;
+
+    if (atom_capacity > mol->atom_capacity) {
+        Atom* atoms = storage_resize(mol, mol->atoms,
+                                     (size_t)mol->atom_count * sizeof(Atom),
+                                     (size_t)atom_capacity * sizeof(Atom));
+        if (!atoms) return false;
+        mol->atoms = atoms;
+        int capacity = storage_capacity(mol, atoms, atom_capacity, sizeof(Atom));
+        if (mol->coord_x && !resize_coordinates(mol, capacity)) return false;
+        mol->atom_capacity = capacity;
+    }
+    if (bond_capacity > mol->bond_capacity) {
+        Bond* bonds = storage_resize(mol, mol->bonds,
+                                     (size_t)mol->bond_count * sizeof(Bond),
+                                     (size_t)bond_capacity * sizeof(Bond));
+        if (!bonds) return false;
+        mol->bonds = bonds;
+        mol->bond_capacity = storage_capacity(mol, bonds, bond_capacity, sizeof(Bond));
+    }
+    return true;
+}
+
+/* Next capacity when an array of the given size is full */
+static int grow_capacity(int capacity) {
+    return capacity < 8 ? 8 : capacity * 2;
+}
+
+/* ============ Maintained Properties ============ */
+
+/* Mass of one atom, using the exact isotope mass when one is set */
+static double atom_mass(const Atom* atom) {
+    if (atom->isotope > 0) {
+        const Isotope* isotopes;
+        int count = element_isotopes(atom->element, &isotopes);
+        for (int i = 0; i < count; i++) {
+            if (isotopes[i].mass_number == atom->isotope) return isotopes[i].mass;
+        }
+        return (double)atom->isotope;
+    }
+    return atom->element->atomic_mass;
+}
+
+#define COUNT_OFFSET_NONE 0xFFFF
+
+/* Decimal digits of an atom count, none for a count of one */
+static int format_count(int count, char* digits) {
+    if (count <= 1) return 0;
+    char reversed[12];
+    int n = 0;
+    while (count > 0) {
+        reversed[n++] = (char)('0' + count % 10);
+        count /= 10;
+    }
+    for (int i = 0; i < n; i++) digits[i] = reversed[n - 1 - i];
+    return n;
+}
+
+/* Append symbol and count, remembering where the count starts */
+static char* append_element(Molecule* mol, char* p, const char* end, int z) {
+    const char* symbol = PERIODIC_TABLE[z - 1].symbol;
+    while (*symbol && p < end) *p++ = *symbol++;
+
+    char digits[12];
+    int n = format_count(mol->element_counts[z], digits);
+    if (*symbol || p + n > end) {
+        mol->count_offsets[z] = COUNT_OFFSET_NONE;
+        return p;
+    }
+    mol->count_offsets[z] = (unsigned short)(p - mol->formula);
+    memcpy(p, digits, n);
+    return p + n;
+}
+
+/*
+ * Regenerate the Hill formula: carbon, then hydrogen, then the rest
+ * alphabetically; without carbon everything is alphabetical. The element
+ * list is kept sorted by symbol, so this is linear in distinct elements.
+ */
+static void update_formula(Molecule* mol) {
+    char* p = mol->formula;
+    const char* end = mol->formula + sizeof(mol->formula) - 1;
+    bool carbon = mol->element_counts[6] > 0;
+
+    if (carbon) {
+        p = append_element(mol, p, end, 6);
+        if (mol->element_counts[1] > 0) p = append_element(mol, p, end, 1);
+    }
+    for (int i = 0; i < mol->element_kinds; i++) {
+        int z = mol->elements[i];
+        if (carbon && (z == 6 || z == 1)) continue;
+        p = append_element(mol, p, end, z);
+    }
+    *p = '\0';
+}
+
+/* Replace formula[at, at + old_length) with text, moving later count offsets */
+static bool splice_formula(Molecule* mol, unsigned short at, int old_length,
+                           const char* text, int length) {
+    if (length != old_length) {
+        size_t total = strlen(mol->formula);
+        if (total + length - old_length >= sizeof(mol->formula)) return false;
+        memmove(mol->formula + at + length, mol->formula + at + old_length,
+                total - at - old_length + 1);
+        for (int i = 0; i < mol->element_kinds; i++) {
+            unsigned short* offset = &mol->count_offsets[mol->elements[i]];
+            if (*offset > at && *offset != COUNT_OFFSET_NONE) {
+                *offset = (unsigned short)(*offset + length - old_length);
+            }
+        }
+    }
+    memcpy(mol->formula + at, text, length);
+    return true;
+}
+
+/* Digits currently written for element z */
+static int written_digits(const Molecule* mol, int z) {
+    const char* p = mol->formula + mol->count_offsets[z];
+    int n = 0;
+    while (p[n] >= '0' && p[n] <= '9') n++;
+    return n;
+}
+
+/*
+ * Splice a newly present element's symbol in at its Hill position. Carbon
+ * reorders hydrogen, so its arrival falls back to regenerating.
+ */
+static bool insert_element(Molecule* mol, int z) {
+    if (z == 6) return false;
+    bool carbon = mol->element_counts[6] > 0;
+
+    /* Nearest element before z in Hill order */
+    int previous = -1;
+    if (carbon && z == 1) {
+        previous = 6;
+    } else {
+        int i = 0;
+        while (mol->elements[i] != z) i++;
+        while (--i >= 0) {
+            int other = mol->elements[i];
+            if (!carbon || (other != 6 && other != 1)) {
+                previous = other;
+                break;
+            }
+        }
+        if (previous < 0 && carbon) previous = mol->element_counts[1] > 0 ? 1 : 6;
+    }
+
+    unsigned short at = 0;
+    if (previous > 0) {
+        if (mol->count_offsets[previous] == COUNT_OFFSET_NONE) return false;
+        at = (unsigned short)(mol->count_offsets[previous] + written_digits(mol, previous));
+    }
+
+    const char* symbol = PERIODIC_TABLE[z - 1].symbol;
+    int length = (int)strlen(symbol);
+    if (!splice_formula(mol, at, 0, symbol, length)) return false;
+    mol->count_offsets[z] = (unsigned short)(at + length);
+    return true;
+}
+
+/*
+ * Bring the formula up to date after adding atoms of element z. A single
+ * added atom usually just bumps the last digit; otherwise the count is
+ * rewritten in place (shifting the tail when its width changes) and a new
+ * element is spliced in. The string is only regenerated when carbon first
+ * appears or the formula is truncated.
+ */
+static void update_count(Molecule* mol, int z, int added) {
+    int count = mol->element_counts[z];
+    if (count == added && !insert_element(mol, z)) {
+        update_formula(mol);
+        return;
+    }
+    unsigned short offset = mol->count_offsets[z];
+    if (offset == COUNT_OFFSET_NONE) {
+        update_formula(mol);
+        return;
+    }
+
+    int old_digits = count == added ? 0 : written_digits(mol, z);
+    if (added == 1 && old_digits > 0) {
+        char* last = mol->formula + offset + old_digits - 1;
+        if (*last != '9') {
+            (*last)++;
+            return;
+        }
+    }
+
+    char digits[12];
+    int n = format_count(count, digits);
+    if (!splice_formula(mol, offset, old_digits, digits, n)) update_formula(mol);
+}
+
+/* Count atoms of an element, inserting it in symbol order if new */
+static void count_element(Molecule* mol, const Element* element, int added) {
+    int z = element->atomic_number;
+    int before = mol->element_counts[z];
+    mol->element_counts[z] += added;
+    if (before > 0) return;
+
+    int i = mol->element_kinds++;
+    while (i > 0 && strcmp(PERIODIC_TABLE[mol->elements[i - 1] - 1].symbol, element->symbol) > 0) {
+        mol->elements[i] = mol->elements[i - 1];
+        i--;
+    }
+    mol->elements[i] = (unsigned char)z;
+}
+
+/* Uncount atoms of element z, dropping it from the formula when none remain */
+static void discount_element(Molecule* mol, int z, int removed) {
+    mol->element_counts[z] -= removed;
+    if (mol->element_counts[z] > 0) {
+        update_count(mol, z, -removed);
+        return;
+    }
+
+    int i = 0;
+    while (mol->elements[i] != z) i++;
+    memmove(mol->elements + i, mol->elements + i + 1, mol->element_kinds - i - 1);
+    mol->element_kinds--;
+    update_formula(mol);
+}
+
+/* Account for a net change in implicit hydrogens */
+static void adjust_hydrogens(Molecule* mol, int delta) {
+    if (delta == 0) return;
+    const Element* hydrogen = &PERIODIC_TABLE[0];
+
+    mol->implicit_hydrogens += delta;
+    mol->molecular_mass += hydrogen->atomic_mass * delta;
+    if (delta > 0) {
+        count_element(mol, hydrogen, delta);
+        update_count(mol, 1, delta);
+    } else {
+        discount_element(mol, 1, -delta);
+    }
+}
+
+/* Add count atoms of one element; returns the first new atom ID or -1 */
+int molecule_add_atoms(Molecule* mol, const Element* element, int charge, int count) {
+    if (!mol || !element || count <= 0) return -1;
+    if (mol->atom_count + count > mol->atom_capacity) {
+        int capacity = grow_capacity(mol->atom_capacity);
+        while (capacity < mol->atom_count + count) capacity *= 2;
+        if (!molecule_reserve(mol, capacity, mol->bond_capacity)) return -1;
+    }
+
+    int first = mol->atom_count;
+    for (int id = first; id < first + count; id++) {
+        mol->atoms[id].element = element;
+        mol->atoms[id].charge = charge;
+        mol->atoms[id].id = id;
+        mol->atoms[id].isotope = 0;
+        mol->atoms[id].aromatic = false;
+        mol->atoms[id].hydrogens = 0;
+    }
+    if (mol->coord_x) {
+        size_t bytes = (size_t)count * sizeof(double);
+        memset(mol->coord_x + first, 0, bytes);
+        memset(mol->coord_y + first, 0, bytes);
+        memset(mol->coord_z + first, 0, bytes);
+    }
+    mol->atom_count += count;
+    mol->adjacency_valid = false;
+    mol->rings_valid = false;
+
+    mol->molecular_mass += element->atomic_mass * count;
+    mol->total_charge += charge * count;
+    count_element(mol, element, count);
+    update_count(mol, element->atomic_number, count);
+
+    return first;
+}
+
 /* Add an atom to a molecule, returns atom ID or -1 on failure */
 int molecule_add_atom(Molecule* mol, const Element* element, int charge) {
-    if (!mol || !element) return -1;
-    if (mol->atom_count >= MAX_ATOMS_PER_MOLECULE) return -1;
+    return molecule_add_atoms(mol, element, charge, 1);
+}
+
+bool molecule_set_atom_charge(Molecule* mol, int atom_id, int charge) {
+    if (!mol || atom_id < 0 || atom_id >= mol->atom_count) return false;
+    mol->total_charge += charge - mol->atoms[atom_id].charge;
+    mol->atoms[atom_id].charge = charge;
+    return true;
+}
+
+bool molecule_set_atom_isotope(Molecule* mol, int atom_id, int isotope) {
+    if (!mol || atom_id < 0 || atom_id >= mol->atom_count || isotope < 0) return false;
+    Atom* atom = &mol->atoms[atom_id];
+    mol->molecular_mass -= atom_mass(atom);
+    atom->isotope = isotope;
+    mol->molecular_mass += atom_mass(atom);
+    return true;
+}
+
+bool molecule_set_atom_hydrogens(Molecule* mol, int atom_id, int count) {
+    if (!mol || atom_id < 0 || atom_id >= mol->atom_count || count < 0 || count > UCHAR_MAX) {
+        return false;
+    }
+    int delta = count - mol->atoms[atom_id].hydrogens;
+    mol->atoms[atom_id].hydrogens = (unsigned char)count;
+    adjust_hydrogens(mol, delta);
+    return true;
+}
 
-    int id = mol->atom_count;
-    mol->atoms[id].element = element;
-    mol->atoms[id].charge = charge;
-    mol->atoms[id].id = id;
-    mol->atom_count++;
+bool molecule_set_hydrogens(Molecule* mol, const int* counts) {
+    if (!mol || !counts) return false;
+    for (int i = 0; i < mol->atom_count; i++) {
+        if (counts[i] < 0 || counts[i] > UCHAR_MAX) return false;
+    }
 
-    return id;
+    int delta = 0;
+    for (int i = 0; i < mol->atom_count; i++) {
+        delta += counts[i] - mol->atoms[i].hydrogens;
+        mol->atoms[i].hydrogens = (unsigned char)counts[i];
+    }
+    adjust_hydrogens(mol, delta);
+    return true;
 }
 
 /* Add a bond between two atoms */
@@ -33,28 +444,374 @@ bool molecule_add_bond(Molecule* mol, int atom1_id, int atom2_id, BondType type)
     if (!mol) return false;
     if (atom1_id < 0 || atom1_id >= mol->atom_count) return false;
     if (atom2_id < 0 || atom2_id >= mol->atom_count) return false;
-    if (mol->bond_count >= MAX_BONDS_PER_MOLECULE) return false;
     if (atom1_id == atom2_id) return false;
+    if (mol->bond_count == mol->bond_capacity &&
+        !molecule_reserve(mol, mol->atom_capacity, grow_capacity(mol->bond_capacity))) {
+        return false;
+    }
 
     int idx = mol->bond_count;
     mol->bonds[idx].atom1_id = atom1_id;
     mol->bonds[idx].atom2_id = atom2_id;
     mol->bonds[idx].type = type;
     mol->bond_count++;
+    mol->adjacency_valid = false;
+    mol->rings_valid = false;
 
     return true;
 }
 
-/* Calculate molecular mass from atoms */
+/* ============ Implicit Hydrogens ============ */
+
+static int bond_order(BondType type) {
+    return type == BOND_DOUBLE ? 2 : type == BOND_TRIPLE ? 3 : 1;
+}
+
+int molecule_default_hydrogens(const Atom* atom, int bond_order_sum) {
+    int valence = element_max_bonds(atom->element);
+
+    if (atom->aromatic) {
+        bond_order_sum++;
+    } else {
+        int limit = atom->element->valence_electrons;
+        while (valence < bond_order_sum && valence + 2 <= limit) valence += 2;
+    }
+    return valence > bond_order_sum ? valence - bond_order_sum : 0;
+}
+
+bool molecule_assign_hydrogens(Molecule* mol) {
+    if (!mol) return false;
+
+    int n = mol->atom_count;
+    int* sums = calloc((size_t)n + 1, sizeof(int));
+    if (!sums) return false;
+    for (int b = 0; b < mol->bond_count; b++) {
+        int order = bond_order(mol->bonds[b].type);
+        sums[mol->bonds[b].atom1_id] += order;
+        sums[mol->bonds[b].atom2_id] += order;
+    }
+
+    int delta = 0;
+    for (int i = 0; i < n; i++) {
+        Atom* atom = &mol->atoms[i];
+        if (atom->element->atomic_number == 1) continue;
+        int count = molecule_default_hydrogens(atom, sums[i]);
+        if (count > UCHAR_MAX) count = UCHAR_MAX;
+        delta += count - atom->hydrogens;
+        atom->hydrogens = (unsigned char)count;
+    }
+    free(sums);
+
+    adjust_hydrogens(mol, delta);
+    return true;
+}
+
+#define HYDROGEN_UNBONDED (-2)
+
+bool molecule_compact_hydrogens(Molecule* mol) {
+    if (!mol) return false;
+
+    int n = mol->atom_count;
+    if (n == 0) return true;
+    int* map = malloc((size_t)n * sizeof(int));
+    if (!map) return false;
+
+    /* map[i]: sole heavy neighbor of a foldable hydrogen, else -1 */
+    for (int i = 0; i < n; i++) {
+        const Atom* a = &mol->atoms[i];
+        bool plain = a->element->atomic_number == 1 && a->isotope == 0 &&
+                     a->charge == 0 && a->hydrogens == 0;
+        map[i] = plain ? HYDROGEN_UNBONDED : -1;
+    }
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        int ends[2] = {bond->atom1_id, bond->atom2_id};
+        for (int e = 0; e < 2; e++) {
+            int h = ends[e], other = ends[1 - e];
+            if (map[h] == -1) continue;
+            bool single = bond->type == BOND_SINGLE &&
+                          mol->atoms[other].element->atomic_number != 1;
+            map[h] = map[h] == HYDROGEN_UNBONDED && single ? other : -1;
+        }
+    }
+
+    /* Fold, then reuse map as the old -> new atom index */
+    int kept = 0;
+    int folded = 0;
+    for (int i = 0; i < n; i++) {
+        int heavy = map[i];
+        if (heavy >= 0 && mol->atoms[heavy].hydrogens < UCHAR_MAX) {
+            mol->atoms[heavy].hydrogens++;
+            folded++;
+            map[i] = -1;
+        } else {
+            map[i] = kept++;
+        }
+    }
+    if (folded == 0) {
+        free(map);
+        return true;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (map[i] < 0) continue;
+        mol->atoms[map[i]] = mol->atoms[i];
+        mol->atoms[map[i]].id = map[i];
+        if (mol->coord_x) {
+            mol->coord_x[map[i]] = mol->coord_x[i];
+            mol->coord_y[map[i]] = mol->coord_y[i];
+            mol->coord_z[map[i]] = mol->coord_z[i];
+        }
+    }
+    int bonds = 0;
+    for (int b = 0; b < mol->bond_count; b++) {
+        int a1 = map[mol->bonds[b].atom1_id];
+        int a2 = map[mol->bonds[b].atom2_id];
+        if (a1 < 0 || a2 < 0) continue;
+        mol->bonds[bonds].atom1_id = a1;
+        mol->bonds[bonds].atom2_id = a2;
+        mol->bonds[bonds++].type = mol->bonds[b].type;
+    }
+    free(map);
+
+    /* Hydrogens only changed form, so counts, mass and formula stand */
+    bool adjacency = mol->adjacency_valid;
+    mol->atom_count = kept;
+    mol->bond_count = bonds;
+    mol->implicit_hydrogens += folded;
+    mol->adjacency_valid = false;
+    mol->rings_valid = false;
+    return !adjacency || molecule_build_adjacency(mol);
+}
+
+/* Tetrahedral directions for hydrogens placed around their parent */
+static const double HYDROGEN_DIRECTIONS[4][3] = {
+    {0.577, 0.577, 0.577}, {0.577, -0.577, -0.577},
+    {-0.577, 0.577, -0.577}, {-0.577, -0.577, 0.577}
+};
+#define HYDROGEN_BOND_LENGTH 1.09
+
+bool molecule_expand_hydrogens(Molecule* mol) {
+    if (!mol) return false;
+    if (mol->implicit_hydrogens == 0) return true;
+
+    int n = mol->atom_count;
+    int total = mol->implicit_hydrogens;
+    if (!molecule_reserve(mol, n + total, mol->bond_count + total)) return false;
+
+    const Element* hydrogen = &PERIODIC_TABLE[0];
+    int id = n;
+    for (int i = 0; i < n; i++) {
+        for (int h = 0; h < mol->atoms[i].hydrogens; h++, id++) {
+            Atom* atom = &mol->atoms[id];
+            atom->element = hydrogen;
+            atom->charge = 0;
+            atom->id = id;
+            atom->isotope = 0;
+            atom->aromatic = false;
+            atom->hydrogens = 0;
+
+            Bond* bond = &mol->bonds[mol->bond_count++];
+            bond->atom1_id = i;
+            bond->atom2_id = id;
+            bond->type = BOND_SINGLE;
+
+            if (mol->coord_x) {
+                /* Rough placement, meant to be refined by minimization */
+                const double* d = HYDROGEN_DIRECTIONS[h % 4];
+                double scale = HYDROGEN_BOND_LENGTH * (1.0 + 0.1 * (h / 4));
+                mol->coord_x[id] = mol->coord_x[i] + scale * d[0];
+                mol->coord_y[id] = mol->coord_y[i] + scale * d[1];
+                mol->coord_z[id] = mol->coord_z[i] + scale * d[2];
+            }
+        }
+        mol->atoms[i].hydrogens = 0;
+    }
+
+    bool adjacency = mol->adjacency_valid;
+    mol->atom_count = id;
+    mol->implicit_hydrogens = 0;
+    mol->adjacency_valid = false;
+    mol->rings_valid = false;
+    return !adjacency || molecule_build_adjacency(mol);
+}
+
+/* ============ Coordinates ============ */
+
+bool molecule_enable_coordinates(Molecule* mol) {
+    if (!mol) return false;
+    if (mol->coord_x) return true;
+
+    int count = mol->atom_count;
+    if (!resize_coordinates(mol, mol->atom_capacity)) {
+        storage_release(mol, mol->coord_x);
+        storage_release(mol, mol->coord_y);
+        mol->coord_x = mol->coord_y = mol->coord_z = NULL;
+        return false;
+    }
+    size_t bytes = (size_t)count * sizeof(double);
+    memset(mol->coord_x, 0, bytes);
+    memset(mol->coord_y, 0, bytes);
+    memset(mol->coord_z, 0, bytes);
+    return true;
+}
+
+bool molecule_has_coordinates(const Molecule* mol) {
+    return mol && mol->coord_x;
+}
+
+bool molecule_set_atom_position(Molecule* mol, int atom_id, double x, double y, double z) {
+    if (!mol || !mol->coord_x || atom_id < 0 || atom_id >= mol->atom_count) return false;
+    mol->coord_x[atom_id] = x;
+    mol->coord_y[atom_id] = y;
+    mol->coord_z[atom_id] = z;
+    return true;
+}
+
+double molecule_distance(const Molecule* mol, int atom1_id, int atom2_id) {
+    if (!mol || !mol->coord_x) return -1.0;
+    if (atom1_id < 0 || atom1_id >= mol->atom_count ||
+        atom2_id < 0 || atom2_id >= mol->atom_count) return -1.0;
+    double dx = mol->coord_x[atom1_id] - mol->coord_x[atom2_id];
+    double dy = mol->coord_y[atom1_id] - mol->coord_y[atom2_id];
+    double dz = mol->coord_z[atom1_id] - mol->coord_z[atom2_id];
+    return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/* ============ Adjacency ============ */
+
+/* Build the CSR adjacency with a counting sort over bond endpoints */
+bool molecule_build_adjacency(Molecule* mol) {
+    if (!mol) return false;
+    if (mol->adjacency_valid) return true;
+
+    int n = mol->atom_count;
+    int m = mol->bond_count;
+    /* Contents are rebuilt, so nothing needs preserving */
+    int* offsets = storage_resize(mol, mol->adjacency_offsets, 0, (size_t)(n + 1) * sizeof(int));
+    if (!offsets) return false;
+    mol->adjacency_offsets = offsets;
+
+    int* adjacency = storage_resize(mol, mol->adjacency, 0, (size_t)(2 * m + 1) * sizeof(int));
+    if (!adjacency) return false;
+    mol->adjacency = adjacency;
+
+    int* adjacency_bonds = storage_resize(mol, mol->adjacency_bonds, 0,
+                                          (size_t)(2 * m + 1) * sizeof(int));
+    if (!adjacency_bonds) return false;
+    mol->adjacency_bonds = adjacency_bonds;
+
+    memset(offsets, 0, (size_t)(n + 1) * sizeof(int));
+    for (int b = 0; b < m; b++) {
+        offsets[mol->bonds[b].atom1_id + 1]++;
+        offsets[mol->bonds[b].atom2_id + 1]++;
+    }
+    for (int i = 0; i < n; i++) offsets[i + 1] += offsets[i];
+
+    /* Fill using offsets[i] as a cursor, then shift back */
+    for (int b = 0; b < m; b++) {
+        int a1 = mol->bonds[b].atom1_id;
+        int a2 = mol->bonds[b].atom2_id;
+        adjacency[offsets[a1]] = a2;
+        adjacency_bonds[offsets[a1]++] = b;
+        adjacency[offsets[a2]] = a1;
+        adjacency_bonds[offsets[a2]++] = b;
+    }
+    for (int i = n; i > 0; i--) offsets[i] = offsets[i - 1];
+    offsets[0] = 0;
+
+    mol->adjacency_valid = true;
+    return true;
+}
+
+/* Number of bonds at an atom */
+int molecule_degree(const Molecule* mol, int atom_id) {
+    return molecule_neighbors(mol, atom_id, NULL, NULL);
+}
+
+/* Neighbors of an atom from the CSR adjacency */
+int molecule_neighbors(const Molecule* mol, int atom_id,
+                       const int** neighbors, const int** bonds) {
+    if (!mol || !mol->adjacency_valid) return -1;
+    if (atom_id < 0 || atom_id >= mol->atom_count) return -1;
+
+    int begin = mol->adjacency_offsets[atom_id];
+    if (neighbors) *neighbors = mol->adjacency + begin;
+    if (bonds) *bonds = mol->adjacency_bonds + begin;
+    return mol->adjacency_offsets[atom_id + 1] - begin;
+}
+
+/* Find the bond joining two atoms */
+int molecule_find_bond(const Molecule* mol, int atom1_id, int atom2_id) {
+    const int* neighbors;
+    const int* bonds;
+    int degree = molecule_neighbors(mol, atom1_id, &neighbors, &bonds);
+    for (int i = 0; i < degree; i++) {
+        if (neighbors[i] == atom2_id) return bonds[i];
+    }
+    return -1;
+}
+
+/* Rebuild every maintained property from the atoms */
 void molecule_calculate_mass(Molecule* mol) {
     if (!mol) return;
 
+    for (int i = 0; i < mol->element_kinds; i++) mol->element_counts[mol->elements[i]] = 0;
+    mol->element_kinds = 0;
     mol->molecular_mass = 0.0;
+    mol->total_charge = 0;
+    mol->implicit_hydrogens = 0;
     for (int i = 0; i < mol->atom_count; i++) {
-        if (mol->atoms[i].element) {
-            mol->molecular_mass += mol->atoms[i].element->atomic_mass;
+        const Atom* atom = &mol->atoms[i];
+        if (!atom->element) continue;
+        mol->molecular_mass += atom_mass(atom);
+        mol->total_charge += atom->charge;
+        mol->implicit_hydrogens += atom->hydrogens;
+        count_element(mol, atom->element, 1);
+    }
+    if (mol->implicit_hydrogens > 0) {
+        const Element* hydrogen = &PERIODIC_TABLE[0];
+        mol->molecular_mass += hydrogen->atomic_mass * mol->implicit_hydrogens;
+        count_element(mol, hydrogen, mol->implicit_hydrogens);
+    }
+    update_formula(mol);
+}
+
+int molecule_element_count(const Molecule* mol, const Element* element) {
+    if (!mol || !element) return 0;
+    return mol->element_counts[element->atomic_number];
+}
+
+int molecule_charge(const Molecule* mol) {
+    return mol ? mol->total_charge : 0;
+}
+
+double molecule_mass(const Molecule* mol) {
+    return mol ? mol->molecular_mass : 0.0;
+}
+
+const char* molecule_formula(const Molecule* mol) {
+    return mol ? mol->formula : "";
+}
+
+bool molecule_to_formula(const Molecule* mol, Formula* formula) {
+    if (!mol || !formula) return false;
+
+    memset(formula, 0, sizeof(Formula));
+    formula->coefficient = 1;
+    bool carbon = mol->element_counts[6] > 0;
+    if (carbon) {
+        formula_add_element(formula, element_by_number(6), mol->element_counts[6]);
+        if (mol->element_counts[1] > 0) {
+            formula_add_element(formula, element_by_number(1), mol->element_counts[1]);
         }
     }
+    for (int i = 0; i < mol->element_kinds; i++) {
+        int z = mol->elements[i];
+        if (carbon && (z == 6 || z == 1)) continue;
+        if (!formula_add_element(formula, element_by_number(z), mol->element_counts[z])) return false;
+    }
+    return true;
 }
 
 /* Parse a chemical formula string (e.g., "H2O", "2CO2", "Ca(OH)2") */
@@ -78,19 +835,48 @@ bool formula_parse(const char* formula_str, Formula* result) {
         }
     }
 
+    /*
+     * Element terms are collected in order of appearance. Each open group
+     * remembers where its terms start so the closing multiplier can be
+     * applied to them (e.g., the 2 in "Ca(OH)2").
+     */
+    ElementCount terms[MAX_FORMULA_LENGTH];
+    int term_count = 0;
+    int group_start[MAX_FORMULA_LENGTH / 2];
+    int depth = 0;
+
     /* Parse elements and their counts */
     while (*p) {
         /* Skip whitespace */
         while (*p && isspace((unsigned char)*p)) p++;
         if (!*p) break;
 
-        /* Element symbol starts with uppercase letter */
-        if (!isupper((unsigned char)*p)) {
-            /* Handle parentheses - simplified, just skip for now */
-            if (*p == '(' || *p == ')') {
+        if (*p == '(' || *p == '[') {
+            if (depth >= (int)(sizeof(group_start) / sizeof(group_start[0]))) return false;
+            group_start[depth++] = term_count;
+            p++;
+            continue;
+        }
+
+        if (*p == ')' || *p == ']') {
+            if (depth == 0) return false;
+            p++;
+
+            int multiplier = 0;
+            while (*p && isdigit((unsigned char)*p)) {
+                multiplier = multiplier * 10 + (*p - '0');
                 p++;
-                continue;
             }
+            if (multiplier == 0) multiplier = 1;
+
+            for (int i = group_start[--depth]; i < term_count; i++) {
+                terms[i].count *= multiplier;
+            }
+            continue;
+        }
+
+        /* Element symbol starts with uppercase letter */
+        if (!isupper((unsigned char)*p)) {
             return false;
         }
 
@@ -117,11 +903,20 @@ bool formula_parse(const char* formula_str, Formula* result) {
         }
         if (count == 0) count = 1;
 
-        /* Add to result or update existing */
+        if (term_count >= MAX_FORMULA_LENGTH) return false;
+        terms[term_count].element = el;
+        terms[term_count].count = count;
+        term_count++;
+    }
+
+    if (depth != 0) return false;
+
+    /* Add to result or update existing */
+    for (int t = 0; t < term_count; t++) {
         bool found = false;
         for (int i = 0; i < result->element_count; i++) {
-            if (result->elements[i].element == el) {
-                result->elements[i].count += count;
+            if (result->elements[i].element == terms[t].element) {
+                result->elements[i].count += terms[t].count;
                 found = true;
                 break;
             }
@@ -131,8 +926,7 @@ bool formula_parse(const char* formula_str, Formula* result) {
             if (result->element_count >= MAX_ATOMS_PER_MOLECULE) {
                 return false;
             }
-            result->elements[result->element_count].element = el;
-            result->elements[result->element_count].count = count;
+            result->elements[result->element_count] = terms[t];
             result->element_count++;
         }
     }
@@ -171,6 +965,19 @@ double formula_mass(const Formula* formula) {
     return mass * formula->coefficient;
 }
 
+/* Calculate mass from the most abundant isotope of each element */
+double formula_monoisotopic_mass(const Formula* formula) {
+    if (!formula) return 0.0;
+
+    double mass = 0.0;
+    for (int i = 0; i < formula->element_count; i++) {
+        mass += element_monoisotopic_mass(formula->elements[i].element) *
+                formula->elements[i].count;
+    }
+
+    return mass * formula->coefficient;
+}
+
 /* Convert formula to string */
 bool formula_to_string(const Formula* formula, char* buffer, size_t buffer_size) {
     if (!formula || !buffer || buffer_size == 0) return false;
@@ -203,6 +1010,24 @@ bool formula_to_string(const Formula* formula, char* buffer, size_t buffer_size)
     return true;
 }
 
+/* Add atoms of an element to a formula, merging with an existing entry */
+bool formula_add_element(Formula* formula, const Element* element, int count) {
+    if (!formula || !element || count <= 0) return false;
+
+    for (int i = 0; i < formula->element_count; i++) {
+        if (formula->elements[i].element == element) {
+            formula->elements[i].count += count;
+            return true;
+        }
+    }
+
+    if (formula->element_count >= MAX_ATOMS_PER_MOLECULE) return false;
+    formula->elements[formula->element_count].element = element;
+    formula->elements[formula->element_count].count = count;
+    formula->element_count++;
+    return true;
+}
+
 /* Print molecule information */
 void molecule_print(const Molecule* mol) {
     if (!mol) {
@@ -212,7 +1037,11 @@ void molecule_print(const Molecule* mol) {
 
     printf("Molecule: %s\n", mol->name[0] ? mol->name : "(unnamed)");
     printf("Formula: %s\n", mol->formula[0] ? mol->formula : "(none)");
-    printf("Atoms: %d\n", mol->atom_count);
+    if (mol->implicit_hydrogens > 0) {
+        printf("Atoms: %d (+%d implicit H)\n", mol->atom_count, mol->implicit_hydrogens);
+    } else {
+        printf("Atoms: %d\n", mol->atom_count);
+    }
     printf("Bonds: %d\n", mol->bond_count);
     printf("Molecular mass: %.3f g/mol\n", mol->molecular_mass);
 }
@@ -223,34 +1052,12 @@ void molecule_print_composition(const Molecule* mol) {
 
     printf("Composition of %s:\n", mol->name[0] ? mol->name : mol->formula);
 
-    /* Count each element */
-    typedef struct { const Element* el; int count; } ECount;
-    ECount counts[MAX_ATOMS_PER_MOLECULE];
-    int num_elements = 0;
-
-    for (int i = 0; i < mol->atom_count; i++) {
-        const Element* el = mol->atoms[i].element;
-        bool found = false;
-
-        for (int j = 0; j < num_elements; j++) {
-            if (counts[j].el == el) {
-                counts[j].count++;
-                found = true;
-                break;
-            }
-        }
-
-        if (!found && num_elements < MAX_ATOMS_PER_MOLECULE) {
-            counts[num_elements].el = el;
-            counts[num_elements].count = 1;
-            num_elements++;
-        }
-    }
-
-    for (int i = 0; i < num_elements; i++) {
-        double percent = (counts[i].el->atomic_mass * counts[i].count / mol->molecular_mass) * 100;
-        printf("  %s: %d atom(s), %.2f%% by mass\n",
-               counts[i].el->name, counts[i].count, percent);
+    for (int i = 0; i < mol->element_kinds; i++) {
+        const Element* el = &PERIODIC_TABLE[mol->elements[i] - 1];
+        int count = mol->element_counts[el->atomic_number];
+        double percent = mol->molecular_mass > 0.0
+                         ? (el->atomic_mass * count / mol->molecular_mass) * 100 : 0.0;
+        printf("  %s: %d atom(s), %.2f%% by mass\n", el->name, count, percent);
     }
 }
 
@@ -277,66 +1084,115 @@ bool formula_equals(const Formula* f1, const Formula* f2) {
     return true;
 }
 
+/* Finalizer from SplitMix64, used to spread bits before combining */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+ * Composition fingerprint: equal for formulas that formula_equals() considers
+ * equal, regardless of element order or leading coefficient. Per-element
+ * terms are combined with addition so no sorting is needed.
+ */
+uint64_t formula_fingerprint(const Formula* formula) {
+    if (!formula) return 0;
+    return formula_fingerprint_parts(formula->elements, formula->element_count);
+}
+
+/* Same fingerprint from a bare element list (each element listed once) */
+uint64_t formula_fingerprint_parts(const ElementCount* elements, int element_count) {
+    if (!elements) return 0;
+
+    uint64_t h = 0;
+    for (int i = 0; i < element_count; i++) {
+        uint64_t key = ((uint64_t)elements[i].element->atomic_number << 32) |
+                       (uint32_t)elements[i].count;
+        h += mix64(key);
+    }
+    return mix64(h ^ (uint64_t)element_count);
+}
+
+/* Allocate a molecule from a pool, or from the heap when pool is NULL */
+static Molecule* molecule_new(MoleculePool* pool, const char* name) {
+    if (pool) return molecule_pool_create(pool, name);
+
+    Molecule* mol = malloc(sizeof(Molecule));
+    if (mol) molecule_init(mol, name);
+    return mol;
+}
+
+/* Finish a built-in molecule, releasing it if any step failed */
+static Molecule* molecule_finish(Molecule* mol, bool ok) {
+    if (ok) ok = molecule_build_adjacency(mol);
+    if (!ok) {
+        molecule_destroy(mol);
+        return NULL;
+    }
+    return mol;
+}
+
 /* Create water molecule (H2O) */
-Molecule* molecule_create_water(void) {
-    static Molecule water;
-    molecule_init(&water, "Water");
-    strcpy(water.formula, "H2O");
+Molecule* molecule_create_water(MoleculePool* pool) {
+    Molecule* water = molecule_new(pool, "Water");
+    if (!water) return NULL;
 
     const Element* H = element_by_symbol("H");
     const Element* O = element_by_symbol("O");
 
-    int o = molecule_add_atom(&water, O, 0);
-    int h1 = molecule_add_atom(&water, H, 0);
-    int h2 = molecule_add_atom(&water, H, 0);
+    bool ok = molecule_reserve(water, 3, 2);
+    int o = molecule_add_atom(water, O, 0);
+    int h1 = molecule_add_atom(water, H, 0);
+    int h2 = molecule_add_atom(water, H, 0);
 
-    molecule_add_bond(&water, o, h1, BOND_SINGLE);
-    molecule_add_bond(&water, o, h2, BOND_SINGLE);
+    ok = ok && molecule_add_bond(water, o, h1, BOND_SINGLE);
+    ok = ok && molecule_add_bond(water, o, h2, BOND_SINGLE);
 
-    molecule_calculate_mass(&water);
-    return &water;
+    return molecule_finish(water, ok);
 }
 
 /* Create carbon dioxide molecule (CO2) */
-Molecule* molecule_create_co2(void) {
-    static Molecule co2;
-    molecule_init(&co2, "Carbon Dioxide");
-    strcpy(co2.formula, "CO2");
+Molecule* molecule_create_co2(MoleculePool* pool) {
+    Molecule* co2 = molecule_new(pool, "Carbon Dioxide");
+    if (!co2) return NULL;
 
     const Element* C = element_by_symbol("C");
     const Element* O = element_by_symbol("O");
 
-    int c = molecule_add_atom(&co2, C, 0);
-    int o1 = molecule_add_atom(&co2, O, 0);
-    int o2 = molecule_add_atom(&co2, O, 0);
+    bool ok = molecule_reserve(co2, 3, 2);
+    int c = molecule_add_atom(co2, C, 0);
+    int o1 = molecule_add_atom(co2, O, 0);
+    int o2 = molecule_add_atom(co2, O, 0);
 
-    molecule_add_bond(&co2, c, o1, BOND_DOUBLE);
-    molecule_add_bond(&co2, c, o2, BOND_DOUBLE);
+    ok = ok && molecule_add_bond(co2, c, o1, BOND_DOUBLE);
+    ok = ok && molecule_add_bond(co2, c, o2, BOND_DOUBLE);
 
-    molecule_calculate_mass(&co2);
-    return &co2;
+    return molecule_finish(co2, ok);
 }
 
 /* Create methane molecule (CH4) */
-Molecule* molecule_create_methane(void) {
-    static Molecule methane;
-    molecule_init(&methane, "Methane");
-    strcpy(methane.formula, "CH4");
+Molecule* molecule_create_methane(MoleculePool* pool) {
+    Molecule* methane = molecule_new(pool, "Methane");
+    if (!methane) return NULL;
 
     const Element* C = element_by_symbol("C");
     const Element* H = element_by_symbol("H");
 
-    int c = molecule_add_atom(&methane, C, 0);
-    int h1 = molecule_add_atom(&methane, H, 0);
-    int h2 = molecule_add_atom(&methane, H, 0);
-    int h3 = molecule_add_atom(&methane, H, 0);
-    int h4 = molecule_add_atom(&methane, H, 0);
+    bool ok = molecule_reserve(methane, 5, 4);
+    int c = molecule_add_atom(methane, C, 0);
+    int h1 = molecule_add_atom(methane, H, 0);
+    int h2 = molecule_add_atom(methane, H, 0);
+    int h3 = molecule_add_atom(methane, H, 0);
+    int h4 = molecule_add_atom(methane, H, 0);
 
-    molecule_add_bond(&methane, c, h1, BOND_SINGLE);
-    molecule_add_bond(&methane, c, h2, BOND_SINGLE);
-    molecule_add_bond(&methane, c, h3, BOND_SINGLE);
-    molecule_add_bond(&methane, c, h4, BOND_SINGLE);
+    ok = ok && molecule_add_bond(methane, c, h1, BOND_SINGLE);
+    ok = ok && molecule_add_bond(methane, c, h2, BOND_SINGLE);
+    ok = ok && molecule_add_bond(methane, c, h3, BOND_SINGLE);
+    ok = ok && molecule_add_bond(methane, c, h4, BOND_SINGLE);
 
-    molecule_calculate_mass(&methane);
-    return &methane;
+    return molecule_finish(methane, ok);
 }
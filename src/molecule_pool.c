@@ -0,0 +1,181 @@
+#include "molecule_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_ALIGN 16
+#define POOL_MIN_CLASS 4            /* 16 bytes */
+
+struct MoleculePoolChunk {
+    MoleculePoolChunk* next;
+    size_t size;                    /* Usable bytes after the header */
+};
+
+/*
+ * Every block is preceded by a 16-byte header holding its size class, so
+ * frees need no size argument. Freed blocks store the free-list link in
+ * their first bytes.
+ */
+typedef struct {
+    size_t size_class;
+    size_t padding;
+} BlockHeader;
+
+/* Chunk header padded to keep blocks aligned */
+#define CHUNK_HEADER (((sizeof(MoleculePoolChunk) + POOL_ALIGN - 1) / POOL_ALIGN) * POOL_ALIGN)
+
+static int size_class_for(size_t bytes) {
+    int c = POOL_MIN_CLASS;
+    while (c < POOL_MIN_CLASS + MOLECULE_POOL_CLASSES && ((size_t)1 << c) < bytes) c++;
+    return c;
+}
+
+static MoleculePoolChunk* chunk_new(MoleculePool* pool, size_t size) {
+    MoleculePoolChunk* chunk = malloc(CHUNK_HEADER + size);
+    if (!chunk) return NULL;
+    chunk->size = size;
+    chunk->next = NULL;
+    pool->system_allocations++;
+    return chunk;
+}
+
+/* Point the bump allocator at a chunk */
+static void chunk_use(MoleculePool* pool, MoleculePoolChunk* chunk) {
+    pool->cursor = (char*)chunk + CHUNK_HEADER;
+    pool->remaining = chunk->size;
+}
+
+void molecule_pool_init(MoleculePool* pool, size_t chunk_size) {
+    if (!pool) return;
+    memset(pool, 0, sizeof(*pool));
+    pool->chunk_size = chunk_size > 0 ? chunk_size : MOLECULE_POOL_DEFAULT_CHUNK;
+}
+
+static void free_chunk_list(MoleculePoolChunk* chunk) {
+    while (chunk) {
+        MoleculePoolChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void molecule_pool_destroy(MoleculePool* pool) {
+    if (!pool) return;
+    free_chunk_list(pool->chunks);
+    free_chunk_list(pool->large);
+    size_t chunk_size = pool->chunk_size;
+    memset(pool, 0, sizeof(*pool));
+    pool->chunk_size = chunk_size;
+}
+
+void molecule_pool_reset(MoleculePool* pool) {
+    if (!pool) return;
+    free_chunk_list(pool->large);
+    pool->large = NULL;
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+    pool->live_molecules = 0;
+
+    /* Keep all chunks; restart bumping from the first */
+    if (pool->chunks) chunk_use(pool, pool->chunks);
+    else {
+        pool->cursor = NULL;
+        pool->remaining = 0;
+    }
+}
+
+/* Bump-allocate from the chunk list, moving to (or creating) the next chunk */
+static void* bump(MoleculePool* pool, size_t bytes) {
+    if (pool->remaining < bytes) {
+        /* Find the chunk after the current one, if reset left spares */
+        MoleculePoolChunk* current = NULL;
+        for (MoleculePoolChunk* c = pool->chunks; c; c = c->next) {
+            char* base = (char*)c + CHUNK_HEADER;
+            if (pool->cursor >= base && pool->cursor <= base + c->size) {
+                current = c;
+                break;
+            }
+        }
+
+        MoleculePoolChunk* next = current ? current->next : pool->chunks;
+        if (!next || next->size < bytes) {
+            next = chunk_new(pool, pool->chunk_size);
+            if (!next) return NULL;
+            if (current) {
+                next->next = current->next;
+                current->next = next;
+            } else {
+                next->next = pool->chunks;
+                pool->chunks = next;
+            }
+        }
+        chunk_use(pool, next);
+    }
+
+    void* p = pool->cursor;
+    pool->cursor += bytes;
+    pool->remaining -= bytes;
+    return p;
+}
+
+void* molecule_pool_alloc(MoleculePool* pool, size_t bytes) {
+    if (!pool) return NULL;
+
+    int c = size_class_for(bytes);
+    if (c >= POOL_MIN_CLASS + MOLECULE_POOL_CLASSES) return NULL;
+    int slot = c - POOL_MIN_CLASS;
+
+    void* block = pool->free_lists[slot];
+    if (block) {
+        pool->free_lists[slot] = *(void**)block;
+        return block;
+    }
+
+    size_t total = sizeof(BlockHeader) + ((size_t)1 << c);
+    BlockHeader* header;
+    if (total > pool->chunk_size / 4) {
+        /* Oversized: a dedicated allocation, released on reset */
+        MoleculePoolChunk* chunk = chunk_new(pool, total);
+        if (!chunk) return NULL;
+        chunk->next = pool->large;
+        pool->large = chunk;
+        header = (BlockHeader*)((char*)chunk + CHUNK_HEADER);
+    } else {
+        header = bump(pool, total);
+        if (!header) return NULL;
+    }
+
+    header->size_class = (size_t)c;
+    return header + 1;
+}
+
+void molecule_pool_free(MoleculePool* pool, void* block) {
+    if (!pool || !block) return;
+    BlockHeader* header = (BlockHeader*)block - 1;
+    int slot = (int)header->size_class - POOL_MIN_CLASS;
+    *(void**)block = pool->free_lists[slot];
+    pool->free_lists[slot] = block;
+}
+
+size_t molecule_pool_block_size(const void* block) {
+    if (!block) return 0;
+    const BlockHeader* header = (const BlockHeader*)block - 1;
+    return (size_t)1 << header->size_class;
+}
+
+/* ============ Molecules ============ */
+
+Molecule* molecule_pool_create(MoleculePool* pool, const char* name) {
+    Molecule* mol = molecule_pool_alloc(pool, sizeof(Molecule));
+    if (!mol) return NULL;
+
+    molecule_init(mol, name);
+    mol->pool = pool;
+    pool->live_molecules++;
+    return mol;
+}
+
+void molecule_pool_release(MoleculePool* pool, Molecule* mol) {
+    if (!pool || !mol) return;
+    molecule_free(mol);
+    molecule_pool_free(pool, mol);
+    pool->live_molecules--;
+}
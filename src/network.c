@@ -0,0 +1,554 @@
+#include "network.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NETWORK_SHARDS 64
+#define FRONTIER_CHUNK 8
+
+/*
+ * Set values: a species id, SPECIES_DROPPED for species cut by the species
+ * limit, or a species still pending in a worker's buffer during a round,
+ * encoded as -2 - (index in buffer * threads + thread).
+ */
+#define SPECIES_DROPPED -1
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t* keys;             /* 0 marks an empty slot */
+    int* values;
+    size_t capacity;
+    size_t count;
+} SpeciesShard;
+
+typedef struct {
+    NetworkReaction* reactions;
+    int reaction_count;
+    int reaction_capacity;
+    NetworkSpecies* fresh;      /* Species first seen by this worker this round */
+    int fresh_count;
+    int fresh_capacity;
+    Reaction* scratch;
+    long long pairs;
+    bool failed;
+    bool timed_out;
+    char padding[64];
+} ExpandWorker;
+
+typedef struct {
+    ReactionNetwork* network;
+    const NetworkOptions* options;
+    int frontier_begin;
+    int generation;
+    int threads;
+    double deadline;
+    ExpandWorker* workers;
+} ExpandJob;
+
+void network_options_default(NetworkOptions* options) {
+    if (!options) return;
+    options->max_species = 1000000;
+    options->max_generations = 4;
+    options->max_seconds = 0.0;
+    options->type_mask = REACTION_TYPE_ALL;
+    options->threads = 0;
+}
+
+const char* network_stop_str(NetworkStop stop) {
+    switch (stop) {
+        case NETWORK_STOP_EXHAUSTED:   return "no new species";
+        case NETWORK_STOP_GENERATIONS: return "generation limit";
+        case NETWORK_STOP_SPECIES:     return "species limit";
+        case NETWORK_STOP_TIME:        return "time limit";
+        default:                       return "unknown";
+    }
+}
+
+/* ============ Species Set ============ */
+
+static uint64_t set_key(uint64_t fingerprint) {
+    return fingerprint ? fingerprint : 1;
+}
+
+static SpeciesShard* shard_of(const ReactionNetwork* network, uint64_t key) {
+    return &((SpeciesShard*)network->shards)[key >> 58];
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static size_t shard_slot(const SpeciesShard* shard, uint64_t key) {
+    size_t mask = shard->capacity - 1;
+    size_t slot = (size_t)key & mask;
+    while (shard->keys[slot] && shard->keys[slot] != key) slot = (slot + 1) & mask;
+    return slot;
+}
+
+static bool shard_grow(SpeciesShard* shard) {
+    size_t capacity = shard->capacity ? shard->capacity * 2 : 1024;
+    uint64_t* keys = calloc(capacity, sizeof(uint64_t));
+    int* values = malloc(capacity * sizeof(int));
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return false;
+    }
+    for (size_t i = 0; i < shard->capacity; i++) {
+        uint64_t k = shard->keys[i];
+        if (!k) continue;
+        size_t slot = (size_t)k & (capacity - 1);
+        while (keys[slot]) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = k;
+        values[slot] = shard->values[i];
+    }
+    free(shard->keys);
+    free(shard->values);
+    shard->keys = keys;
+    shard->values = values;
+    shard->capacity = capacity;
+    return true;
+}
+
+/*
+ * Look up key, inserting it with claim if absent. *value receives the
+ * stored value. Returns 1 if inserted, 0 if present, -1 on allocation
+ * failure. Safe from any thread.
+ */
+static int shard_claim(SpeciesShard* shard, uint64_t key, int claim, int* value) {
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 2 > shard->capacity && !shard_grow(shard)) {
+        pthread_mutex_unlock(&shard->lock);
+        return -1;
+    }
+
+    int inserted = 0;
+    size_t slot = shard_slot(shard, key);
+    if (!shard->keys[slot]) {
+        shard->keys[slot] = key;
+        shard->values[slot] = claim;
+        shard->count++;
+        inserted = 1;
+    }
+    *value = shard->values[slot];
+    pthread_mutex_unlock(&shard->lock);
+    return inserted;
+}
+
+/* Serial phases only: overwrite the value of a present key */
+static void shard_set(SpeciesShard* shard, uint64_t key, int value) {
+    size_t slot = shard_slot(shard, key);
+    if (shard->keys[slot]) shard->values[slot] = value;
+}
+
+static void shards_clear(ReactionNetwork* network) {
+    SpeciesShard* shards = network->shards;
+    for (int s = 0; s < NETWORK_SHARDS; s++) {
+        if (shards[s].capacity) memset(shards[s].keys, 0, shards[s].capacity * sizeof(uint64_t));
+        shards[s].count = 0;
+    }
+}
+
+/* ============ Species Records ============ */
+
+static bool species_from_formula(const Formula* formula, NetworkSpecies* out) {
+    if (formula->element_count > NETWORK_MAX_ELEMENTS) return false;
+    for (int i = 0; i < formula->element_count; i++) {
+        if (formula->elements[i].count <= 0 || formula->elements[i].count > 0xFFFF) return false;
+        out->atomic_numbers[i] = (unsigned char)formula->elements[i].element->atomic_number;
+        out->counts[i] = (unsigned short)formula->elements[i].count;
+    }
+    out->element_count = (unsigned char)formula->element_count;
+    out->fingerprint = formula_fingerprint(formula);
+    out->generation = 0;
+    out->category = 0;
+    return true;
+}
+
+/* Only the used element entries are written; Formula is large */
+static void species_to_formula(const NetworkSpecies* species, Formula* out) {
+    for (int i = 0; i < species->element_count; i++) {
+        out->elements[i].element = element_by_number(species->atomic_numbers[i]);
+        out->elements[i].count = species->counts[i];
+    }
+    out->element_count = species->element_count;
+    out->coefficient = 1;
+}
+
+static bool grow(void** array, int* capacity, int needed, size_t item) {
+    if (needed <= *capacity) return true;
+    int cap = *capacity ? *capacity : 256;
+    while (cap < needed) cap *= 2;
+    void* grown = realloc(*array, (size_t)cap * item);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = cap;
+    return true;
+}
+
+static bool bucket_add(ReactionNetwork* network, int species) {
+    int c = network->species[species].category;
+    if (!grow((void**)&network->buckets[c], &network->bucket_capacities[c],
+              network->bucket_counts[c] + 1, sizeof(int))) {
+        return false;
+    }
+    network->buckets[c][network->bucket_counts[c]++] = species;
+    return true;
+}
+
+/* ============ Network ============ */
+
+void network_init(ReactionNetwork* network) {
+    if (!network) return;
+    memset(network, 0, sizeof(ReactionNetwork));
+}
+
+void network_free(ReactionNetwork* network) {
+    if (!network) return;
+    free(network->species);
+    free(network->reactions);
+    free(network->generation_offsets);
+    for (int c = 0; c < REACTION_RULE_CATEGORIES; c++) free(network->buckets[c]);
+
+    SpeciesShard* shards = network->shards;
+    if (shards) {
+        for (int s = 0; s < NETWORK_SHARDS; s++) {
+            pthread_mutex_destroy(&shards[s].lock);
+            free(shards[s].keys);
+            free(shards[s].values);
+        }
+        free(shards);
+    }
+    network_init(network);
+}
+
+static bool network_reset(ReactionNetwork* network) {
+    network->species_count = 0;
+    network->reaction_count = 0;
+    network->generation_count = 0;
+    for (int c = 0; c < REACTION_RULE_CATEGORIES; c++) network->bucket_counts[c] = 0;
+
+    if (network->shards) {
+        shards_clear(network);
+        return true;
+    }
+    SpeciesShard* shards = calloc(NETWORK_SHARDS, sizeof(SpeciesShard));
+    if (!shards) return false;
+    for (int s = 0; s < NETWORK_SHARDS; s++) pthread_mutex_init(&shards[s].lock, NULL);
+    network->shards = shards;
+    return true;
+}
+
+/* Close the newest generation at the current species count */
+static void push_generation(ReactionNetwork* network) {
+    network->generation_offsets[++network->generation_count] = network->species_count;
+}
+
+int network_species_find(const ReactionNetwork* network, const Formula* formula) {
+    if (!network || !formula || !network->shards) return -1;
+    uint64_t key = set_key(formula_fingerprint(formula));
+    const SpeciesShard* shard = shard_of(network, key);
+    if (shard->capacity == 0) return -1;
+    size_t slot = shard_slot(shard, key);
+    if (!shard->keys[slot]) return -1;
+    int value = shard->values[slot];
+    return value >= 0 ? value : -1;
+}
+
+bool network_species_formula(const ReactionNetwork* network, int species, Formula* out) {
+    if (!network || !out || species < 0 || species >= network->species_count) return false;
+    species_to_formula(&network->species[species], out);
+    return true;
+}
+
+bool network_reaction_get(const ReactionNetwork* network, int index, Reaction* out) {
+    if (!network || !out || index < 0 || index >= network->reaction_count) return false;
+    const NetworkReaction* r = &network->reactions[index];
+
+    reaction_init(out);
+    for (int i = 0; i < 2; i++) {
+        species_to_formula(&network->species[r->reactants[i]], &out->reactants[i]);
+        out->reactants[i].coefficient = r->reactant_coefficients[i];
+        out->reactant_species[i] = r->reactants[i];
+    }
+    out->reactant_count = 2;
+    for (int i = 0; i < r->product_count; i++) {
+        species_to_formula(&network->species[r->products[i]], &out->products[i]);
+        out->products[i].coefficient = r->product_coefficients[i];
+        out->product_species[i] = r->products[i];
+    }
+    out->product_count = r->product_count;
+    out->type = r->type;
+    out->is_balanced = true;
+    snprintf(out->description, sizeof(out->description), "Generation %d", r->generation);
+    return true;
+}
+
+/* ============ Expansion Round ============ */
+
+/* Species id or pending code of a product, claiming it if new */
+static int intern_product(ExpandJob* job, ExpandWorker* w, int thread_index,
+                          const Formula* formula, NetworkSpecies* species) {
+    if (!grow((void**)&w->fresh, &w->fresh_capacity, w->fresh_count + 1, sizeof(NetworkSpecies))) {
+        w->failed = true;
+        return SPECIES_DROPPED;
+    }
+
+    int pending = -2 - (w->fresh_count * job->threads + thread_index);
+    uint64_t key = set_key(species->fingerprint);
+    int value;
+    int inserted = shard_claim(shard_of(job->network, key), key, pending, &value);
+    if (inserted < 0) {
+        w->failed = true;
+        return SPECIES_DROPPED;
+    }
+    if (inserted) {
+        species->generation = job->generation;
+        species->category = (unsigned char)reaction_rules_category(formula);
+        w->fresh[w->fresh_count++] = *species;
+    }
+    return value;
+}
+
+static void record_reaction(ExpandJob* job, ExpandWorker* w, int thread_index, int a, int b) {
+    const Reaction* rxn = w->scratch;
+    if (rxn->reactant_count != 2 || rxn->product_count > NETWORK_MAX_PRODUCTS) return;
+
+    NetworkReaction r;
+    r.reactants[0] = a;
+    r.reactants[1] = b;
+    r.reactant_coefficients[0] = rxn->reactants[0].coefficient;
+    r.reactant_coefficients[1] = rxn->reactants[1].coefficient;
+    for (int p = 0; p < rxn->product_count; p++) {
+        NetworkSpecies species;
+        if (!species_from_formula(&rxn->products[p], &species)) return;
+        r.products[p] = intern_product(job, w, thread_index, &rxn->products[p], &species);
+        if (w->failed) return;
+        r.product_coefficients[p] = rxn->products[p].coefficient;
+    }
+    r.product_count = rxn->product_count;
+    r.generation = job->generation;
+    r.type = rxn->type;
+
+    if (!grow((void**)&w->reactions, &w->reaction_capacity, w->reaction_count + 1,
+              sizeof(NetworkReaction))) {
+        w->failed = true;
+        return;
+    }
+    w->reactions[w->reaction_count++] = r;
+}
+
+/* Pair each frontier species with every compatible species before it */
+static void expand_range(int begin, int end, int thread_index, void* user_data) {
+    ExpandJob* job = user_data;
+    ExpandWorker* w = &job->workers[thread_index];
+    const ReactionNetwork* network = job->network;
+    Formula pair[2];
+
+    for (int i = begin; i < end && !w->failed; i++) {
+        if (job->deadline > 0.0 && parallel_now() > job->deadline) {
+            w->timed_out = true;
+            return;
+        }
+
+        int f = job->frontier_begin + i;
+        const NetworkSpecies* sf = &network->species[f];
+        species_to_formula(sf, &pair[0]);
+
+        for (int c = 0; c < REACTION_RULE_CATEGORIES && !w->failed; c++) {
+            if (!reaction_rules_pair(sf->category, c)) continue;
+            const int* bucket = network->buckets[c];
+            for (int k = 0; k < network->bucket_counts[c] && bucket[k] < f; k++) {
+                species_to_formula(&network->species[bucket[k]], &pair[1]);
+                w->pairs++;
+                if (!reaction_rules_apply(pair, 2, w->scratch)) continue;
+                if (!(job->options->type_mask & REACTION_TYPE_BIT(w->scratch->type))) continue;
+                record_reaction(job, w, thread_index, f, bucket[k]);
+                if (w->failed) break;
+            }
+        }
+    }
+}
+
+/*
+ * Give the round's new species dense ids, worker by worker, keeping at
+ * most max_species in total, and append the reactions whose products all
+ * survived. Sets *truncated when species were dropped.
+ */
+static bool merge_round(ReactionNetwork* network, ExpandJob* job, int* bases, bool* truncated) {
+    int base = network->species_count;
+    int total = 0;
+    for (int t = 0; t < job->threads; t++) {
+        bases[t] = base + total;
+        total += job->workers[t].fresh_count;
+    }
+
+    int keep = total;
+    int max_species = job->options->max_species;
+    if (max_species > 0 && base + total > max_species) {
+        keep = max_species > base ? max_species - base : 0;
+        *truncated = true;
+    }
+    if (!grow((void**)&network->species, &network->species_capacity, base + keep,
+              sizeof(NetworkSpecies))) {
+        return false;
+    }
+
+    for (int t = 0; t < job->threads; t++) {
+        const ExpandWorker* w = &job->workers[t];
+        for (int l = 0; l < w->fresh_count; l++) {
+            int id = bases[t] + l;
+            uint64_t key = set_key(w->fresh[l].fingerprint);
+            if (id < base + keep) {
+                network->species[id] = w->fresh[l];
+                shard_set(shard_of(network, key), key, id);
+            } else {
+                shard_set(shard_of(network, key), key, SPECIES_DROPPED);
+            }
+        }
+    }
+    network->species_count = base + keep;
+    for (int id = base; id < base + keep; id++) {
+        if (!bucket_add(network, id)) return false;
+    }
+
+    for (int t = 0; t < job->threads; t++) {
+        const ExpandWorker* w = &job->workers[t];
+        for (int i = 0; i < w->reaction_count; i++) {
+            NetworkReaction r = w->reactions[i];
+            bool kept = true;
+            for (int p = 0; p < r.product_count; p++) {
+                if (r.products[p] >= 0) continue;
+                int code = -2 - r.products[p];
+                int id = bases[code % job->threads] + code / job->threads;
+                if (id >= base + keep) kept = false;
+                r.products[p] = id;
+            }
+            if (!kept) continue;
+            if (!grow((void**)&network->reactions, &network->reaction_capacity,
+                      network->reaction_count + 1, sizeof(NetworkReaction))) {
+                return false;
+            }
+            network->reactions[network->reaction_count++] = r;
+        }
+    }
+    return true;
+}
+
+/* ============ Expansion ============ */
+
+static bool add_seeds(ReactionNetwork* network, const Formula* seeds, int seed_count) {
+    for (int i = 0; i < seed_count; i++) {
+        NetworkSpecies species;
+        if (!species_from_formula(&seeds[i], &species)) return false;
+        species.category = (unsigned char)reaction_rules_category(&seeds[i]);
+
+        uint64_t key = set_key(species.fingerprint);
+        int value;
+        int inserted = shard_claim(shard_of(network, key), key, network->species_count, &value);
+        if (inserted < 0) return false;
+        if (!inserted) continue;
+
+        if (!grow((void**)&network->species, &network->species_capacity, network->species_count + 1,
+                  sizeof(NetworkSpecies))) {
+            return false;
+        }
+        network->species[network->species_count] = species;
+        if (!bucket_add(network, network->species_count++)) return false;
+    }
+    return true;
+}
+
+bool network_expand(ReactionNetwork* network, const Formula* seeds, int seed_count,
+                    const NetworkOptions* options, NetworkStats* stats) {
+    if (!network || (!seeds && seed_count > 0) || seed_count < 0) return false;
+
+    NetworkOptions defaults;
+    if (!options) {
+        network_options_default(&defaults);
+        options = &defaults;
+    }
+    NetworkStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(NetworkStats));
+    double start = parallel_now();
+
+    int max_generations = options->max_generations > 0 ? options->max_generations : 0;
+    if (!network_reset(network)) return false;
+    int* offsets = realloc(network->generation_offsets, (size_t)(max_generations + 2) * sizeof(int));
+    if (!offsets) return false;
+    network->generation_offsets = offsets;
+    offsets[0] = 0;
+    if (!add_seeds(network, seeds, seed_count)) return false;
+    push_generation(network);
+
+    int threads = parallel_thread_count(options->threads);
+    ExpandWorker* workers = calloc(threads, sizeof(ExpandWorker));
+    int* bases = malloc((size_t)threads * sizeof(int));
+    bool ok = workers && bases;
+    for (int t = 0; ok && t < threads; t++) {
+        workers[t].scratch = malloc(sizeof(Reaction));
+        ok = workers[t].scratch != NULL;
+    }
+
+    ExpandJob job;
+    job.network = network;
+    job.options = options;
+    job.threads = threads;
+    job.deadline = options->max_seconds > 0.0 ? start + options->max_seconds : 0.0;
+    job.workers = workers;
+
+    stats->stop = NETWORK_STOP_GENERATIONS;
+    for (int g = 1; ok && g <= max_generations; g++) {
+        int frontier_begin = network->generation_offsets[g - 1];
+        int frontier_count = network->generation_offsets[g] - frontier_begin;
+        if (frontier_count == 0) {
+            stats->stop = NETWORK_STOP_EXHAUSTED;
+            break;
+        }
+
+        for (int t = 0; t < threads; t++) {
+            workers[t].reaction_count = 0;
+            workers[t].fresh_count = 0;
+        }
+        job.frontier_begin = frontier_begin;
+        job.generation = g;
+        parallel_for(frontier_count, FRONTIER_CHUNK, threads, expand_range, &job);
+
+        bool timed_out = false;
+        for (int t = 0; t < threads; t++) {
+            ok = ok && !workers[t].failed;
+            timed_out = timed_out || workers[t].timed_out;
+            stats->pairs += workers[t].pairs;
+            workers[t].pairs = 0;
+        }
+
+        bool truncated = false;
+        ok = ok && merge_round(network, &job, bases, &truncated);
+        if (!ok) break;
+        push_generation(network);
+        stats->generations = g;
+
+        if (truncated) {
+            stats->stop = NETWORK_STOP_SPECIES;
+            break;
+        }
+        if (timed_out) {
+            stats->stop = NETWORK_STOP_TIME;
+            break;
+        }
+        if (network->generation_offsets[g + 1] == network->generation_offsets[g]) {
+            stats->stop = NETWORK_STOP_EXHAUSTED;
+            break;
+        }
+    }
+
+    for (int t = 0; workers && t < threads; t++) {
+        free(workers[t].reactions);
+        free(workers[t].fresh);
+        free(workers[t].scratch);
+    }
+    free(workers);
+    free(bases);
+    stats->seconds = parallel_now() - start;
+    return ok;
+}
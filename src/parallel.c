@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PARALLEL_MAX_THREADS 256
+
+typedef struct {
+    pthread_mutex_t lock;
+    int next;
+    int count;
+    int chunk_size;
+    ParallelRangeFn fn;
+    void* user_data;
+} ParallelJob;
+
+typedef struct {
+    ParallelJob* job;
+    int thread_index;
+} ParallelWorker;
+
+int parallel_thread_count(int requested) {
+    if (requested > 0) {
+        return requested < PARALLEL_MAX_THREADS ? requested : PARALLEL_MAX_THREADS;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    if (cpus > PARALLEL_MAX_THREADS) cpus = PARALLEL_MAX_THREADS;
+    return (int)cpus;
+}
+
+static void* parallel_worker(void* arg) {
+    ParallelWorker* worker = arg;
+    ParallelJob* job = worker->job;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int begin = job->next;
+        job->next += job->chunk_size;
+        pthread_mutex_unlock(&job->lock);
+
+        if (begin >= job->count) break;
+        int end = begin + job->chunk_size;
+        if (end > job->count) end = job->count;
+        job->fn(begin, end, worker->thread_index, job->user_data);
+    }
+    return NULL;
+}
+
+bool parallel_for(int count, int chunk_size, int threads,
+                  ParallelRangeFn fn, void* user_data) {
+    if (!fn || count <= 0) return true;
+    if (chunk_size < 1) chunk_size = 1;
+
+    threads = parallel_thread_count(threads);
+    int chunks = (count + chunk_size - 1) / chunk_size;
+    if (threads > chunks) threads = chunks;
+
+    if (threads <= 1) {
+        fn(0, count, 0, user_data);
+        return true;
+    }
+
+    ParallelJob job;
+    pthread_mutex_init(&job.lock, NULL);
+    job.next = 0;
+    job.count = count;
+    job.chunk_size = chunk_size;
+    job.fn = fn;
+    job.user_data = user_data;
+
+    pthread_t handles[PARALLEL_MAX_THREADS];
+    ParallelWorker workers[PARALLEL_MAX_THREADS];
+    int started = 0;
+
+    /* The calling thread acts as worker 0 */
+    for (int t = 1; t < threads; t++) {
+        workers[t].job = &job;
+        workers[t].thread_index = t;
+        if (pthread_create(&handles[t], NULL, parallel_worker, &workers[t]) != 0) break;
+        started = t;
+    }
+    workers[0].job = &job;
+    workers[0].thread_index = 0;
+    parallel_worker(&workers[0]);
+
+    for (int t = 1; t <= started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    return started == threads - 1;
+}
+
+double parallel_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
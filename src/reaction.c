@@ -1,13 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
 #include "reaction.h"
+#include "thermo.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
 
 /* ============ Reaction Database Storage ============ */
-static Reaction reaction_database[MAX_REACTIONS];
-static int reaction_db_size = 0;
-static bool reaction_db_initialized = false;
+/*
+ * Fingerprints and species live in chunks that are only ever appended to,
+ * so all snapshots share them: a snapshot reads the rows and species below
+ * its own counts and never looks past them. Reaction records (in blocks of
+ * DB_CHUNK_SIZE pointers) and postings lists are shared too, but replaced
+ * rather than changed: a write copies the small directories that point at
+ * them, rebuilds only what it touches and publishes the new snapshot with
+ * one pointer store. What it replaced is freed with the old snapshot.
+ */
+#define DB_CHUNK_SIZE 256
+#define DB_MAX_CHUNKS 65536         /* 16M reactions and species */
+#define DB_READER_SLOTS 256
+
+/* GCC/Clang builtins; every access is sequentially consistent */
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define ATOMIC_ADD(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+
+typedef struct {
+    void* block;                /* Allocation behind rows */
+    float* rows;                /* One aligned fingerprint per row */
+    float norms[DB_CHUNK_SIZE]; /* Squared lengths */
+    unsigned char types[DB_CHUNK_SIZE];
+} DbChunk;
+
+typedef struct {
+    Formula formulas[DB_CHUNK_SIZE];
+    uint64_t fingerprints[DB_CHUNK_SIZE];
+} SpeciesChunk;
+
+typedef struct {
+    void** items;
+    int count;
+    int capacity;
+} PtrList;
+
+typedef struct DbSnapshot {
+    int count;                  /* Rows, removed ones included */
+    int live_count;
+    unsigned char* live;
+    Reaction*** blocks;         /* Record pointers, one block per chunk of rows */
+    int block_count;
+
+    int species_count;
+    int species_capacity;
+    int* species_slots;         /* Open-addressing hash of species ids (-1 = empty) */
+    int species_slot_count;
+
+    /* Live reactions consuming/producing each species: {n, index...}, NULL if none */
+    int** consumers;
+    int** producers;
+
+    /* Set when retired: freed once no reader can hold the snapshot */
+    uint64_t retire_epoch;
+    PtrList garbage;            /* Records, blocks and lists newer snapshots replaced */
+    struct DbSnapshot* next;
+} DbSnapshot;
+
+static DbChunk* db_chunks[DB_MAX_CHUNKS];
+static SpeciesChunk* species_chunks[DB_MAX_CHUNKS];
+static DbSnapshot db_empty;
+static DbSnapshot* db_current = &db_empty;
+static DbSnapshot* retired_head = NULL;
+static DbSnapshot* retired_tail = NULL;
+static pthread_once_t db_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t db_write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Built-in reactions collected by reaction_db_init before the first publish */
+static Reaction* db_pending = NULL;
+static int db_pending_count = 0;
+
+/* ============ Reader Epochs ============ */
+/*
+ * A reader announces the global epoch in its slot while it holds a
+ * snapshot; a snapshot retired at epoch e is freed once every announced
+ * epoch is above e. Threads that find no free slot are counted instead
+ * and hold off all reclamation while they read.
+ */
+typedef struct {
+    uint64_t epoch;             /* 0 when not reading */
+    int taken;
+    char padding[52];
+} ReaderSlot;
+
+static ReaderSlot reader_slots[DB_READER_SLOTS];
+static uint64_t db_epoch = 1;
+static int overflow_readers = 0;
+static pthread_key_t reader_key;
+
+static __thread ReaderSlot* thread_slot = NULL;
+static __thread int thread_depth = 0;
+static __thread DbSnapshot* thread_snapshot = NULL;
+
+static void db_load(void);
 
 /* ============ Reaction Initialization ============ */
 
@@ -16,6 +116,11 @@ void reaction_init(Reaction* rxn) {
     memset(rxn, 0, sizeof(Reaction));
     rxn->condition = COND_NORMAL;
     rxn->type = RXTYPE_OTHER;
+    for (int i = 0; i < MAX_REACTANTS; i++) rxn->reactant_species[i] = -1;
+    for (int i = 0; i < MAX_PRODUCTS; i++) rxn->product_species[i] = -1;
+    rxn->energetics.enthalpy = NAN;
+    rxn->energetics.entropy = NAN;
+    rxn->energetics.gibbs = NAN;
 }
 
 bool reaction_add_reactant(Reaction* rxn, const char* formula) {
@@ -167,18 +272,28 @@ void reaction_print_detailed(const Reaction* rxn) {
     }
     printf("Reactant mass: %.3f g/mol\n", reactant_mass);
     printf("Product mass: %.3f g/mol\n", product_mass);
+
+    ReactionEnergetics energetics;
+    if (thermo_reaction(rxn, &energetics)) {
+        printf("Delta H: %.2f kJ/mol (%s)\n", energetics.enthalpy,
+               energetics.enthalpy < 0.0 ? "exothermic" : "endothermic");
+        if (!isnan(energetics.gibbs)) {
+            printf("Delta S: %.2f J/(mol K)\n", energetics.entropy);
+            printf("Delta G: %.2f kJ/mol at %.2f K\n", energetics.gibbs, THERMO_STANDARD_TEMPERATURE);
+        }
+    }
 }
 
 /* ============ Reaction Database ============ */
 
-/* Helper to add a reaction to the database */
+/* Helper to add a built-in reaction, published together at the end of loading */
 static void db_add_reaction(const char* reactants[], int r_count,
                            const char* products[], int p_count,
                            ReactionType type, ReactionCondition cond,
                            const char* description) {
-    if (reaction_db_size >= MAX_REACTIONS) return;
+    if (!db_pending || db_pending_count >= MAX_REACTIONS) return;
 
-    Reaction* rxn = &reaction_database[reaction_db_size];
+    Reaction* rxn = &db_pending[db_pending_count];
     reaction_init(rxn);
 
     for (int i = 0; i < r_count; i++) {
@@ -193,13 +308,26 @@ static void db_add_reaction(const char* reactants[], int r_count,
     if (description) {
         strncpy(rxn->description, description, sizeof(rxn->description) - 1);
     }
-
-    reaction_check_balanced(rxn);
-    reaction_db_size++;
+    db_pending_count++;
 }
 
 void reaction_db_init(void) {
-    if (reaction_db_initialized) return;
+    pthread_once(&db_once, db_load);
+}
+
+static bool db_append(const Reaction* reactions, int count, int* indices);
+
+static void reader_release(void* slot) {
+    ATOMIC_STORE(&((ReaderSlot*)slot)->taken, 0);
+}
+
+static void db_load(void) {
+    pthread_key_create(&reader_key, reader_release);
+    db_pending = malloc(MAX_REACTIONS * sizeof(Reaction));
+    if (!db_pending) {
+        fprintf(stderr, "Failed to load the reaction database\n");
+        return;
+    }
 
     /* ===== Combustion Reactions ===== */
 
@@ -367,7 +495,13 @@ void reaction_db_init(void) {
         "Burning magnesium"
     );
 
-    reaction_db_initialized = true;
+    pthread_mutex_lock(&db_write_lock);
+    if (!db_append(db_pending, db_pending_count, NULL)) {
+        fprintf(stderr, "Failed to load the reaction database\n");
+    }
+    pthread_mutex_unlock(&db_write_lock);
+    free(db_pending);
+    db_pending = NULL;
 }
 
 /* Compare two formulas for matching (ignoring coefficients) */
@@ -383,26 +517,10 @@ static bool formulas_match_set(const Formula* set1, int count1,
             if (used[j]) continue;
 
             /* Compare element composition (ignoring coefficient) */
-            if (set1[i].element_count == set2[j].element_count) {
-                bool match = true;
-                for (int k = 0; k < set1[i].element_count; k++) {
-                    bool el_found = false;
-                    for (int l = 0; l < set2[j].element_count; l++) {
-                        if (set1[i].elements[k].element == set2[j].elements[l].element) {
-                            el_found = true;
-                            break;
-                        }
-                    }
-                    if (!el_found) {
-                        match = false;
-                        break;
-                    }
-                }
-                if (match) {
-                    used[j] = true;
-                    found = true;
-                    break;
-                }
+            if (formula_equals(&set1[i], &set2[j])) {
+                used[j] = true;
+                found = true;
+                break;
             }
         }
         if (!found) return false;
@@ -410,22 +528,203 @@ static bool formulas_match_set(const Formula* set1, int count1,
     return true;
 }
 
-const Reaction* reaction_db_find(const Formula* reactants, int reactant_count) {
-    if (!reaction_db_initialized) reaction_db_init();
+/* ============ Snapshots ============ */
+
+static Reaction* row_record(const DbSnapshot* s, int row) {
+    return s->blocks[row / DB_CHUNK_SIZE][row % DB_CHUNK_SIZE];
+}
+
+static float* row_fingerprint(int row) {
+    return db_chunks[row / DB_CHUNK_SIZE]->rows + (size_t)(row % DB_CHUNK_SIZE) * REACTION_FP_DIMS;
+}
+
+static const Formula* species_formula(int id) {
+    return &species_chunks[id / DB_CHUNK_SIZE]->formulas[id % DB_CHUNK_SIZE];
+}
+
+static uint64_t species_fingerprint(int id) {
+    return species_chunks[id / DB_CHUNK_SIZE]->fingerprints[id % DB_CHUNK_SIZE];
+}
 
-    for (int i = 0; i < reaction_db_size; i++) {
-        if (formulas_match_set(reactants, reactant_count,
-                              reaction_database[i].reactants,
-                              reaction_database[i].reactant_count)) {
-            return &reaction_database[i];
+/* A live reaction of the snapshot, NULL if removed or out of range */
+static const Reaction* snapshot_get(const DbSnapshot* s, int index) {
+    if (index < 0 || index >= s->count || !s->live[index]) return NULL;
+    return row_record(s, index);
+}
+
+static ReaderSlot* reader_slot(void) {
+    if (thread_slot) return thread_slot;
+    for (int i = 0; i < DB_READER_SLOTS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&reader_slots[i].taken, &expected, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            thread_slot = &reader_slots[i];
+            pthread_setspecific(reader_key, thread_slot);
+            break;
         }
     }
-    return NULL;
+    return thread_slot;
+}
+
+void reaction_db_read_begin(void) {
+    reaction_db_init();
+    if (thread_depth++ > 0) return;
+
+    /* Announce the epoch before loading the pointer, so a writer that
+     * misses the announcement has already published past this reader */
+    ReaderSlot* slot = reader_slot();
+    if (slot) ATOMIC_STORE(&slot->epoch, ATOMIC_LOAD(&db_epoch));
+    else ATOMIC_ADD(&overflow_readers, 1);
+    thread_snapshot = ATOMIC_LOAD(&db_current);
+}
+
+void reaction_db_read_end(void) {
+    if (thread_depth == 0 || --thread_depth > 0) return;
+    thread_snapshot = NULL;
+    if (thread_slot) ATOMIC_STORE(&thread_slot->epoch, 0);
+    else ATOMIC_ADD(&overflow_readers, -1);
+}
+
+/* Snapshot for one public read call; pair with db_leave */
+static const DbSnapshot* db_enter(void) {
+    reaction_db_read_begin();
+    return thread_snapshot;
+}
+
+static void db_leave(void) {
+    reaction_db_read_end();
+}
+
+static bool ptrlist_push(PtrList* list, void* item) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        void** items = realloc(list->items, (size_t)capacity * sizeof(void*));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+    return true;
+}
+
+static void ptrlist_free(PtrList* list, bool free_items) {
+    if (free_items) {
+        for (int i = 0; i < list->count; i++) free(list->items[i]);
+    }
+    free(list->items);
+    memset(list, 0, sizeof(PtrList));
+}
+
+/* Free a snapshot's directories; shared records, blocks and lists stay */
+static void snapshot_free(DbSnapshot* s) {
+    free(s->live);
+    free(s->blocks);
+    free(s->species_slots);
+    free(s->consumers);
+    free(s->producers);
+    ptrlist_free(&s->garbage, true);
+    free(s);
+}
+
+/* Free retired snapshots older than every active reader (writer lock held) */
+static void db_reclaim(void) {
+    if (ATOMIC_LOAD(&overflow_readers) > 0) return;
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < DB_READER_SLOTS; i++) {
+        uint64_t epoch = ATOMIC_LOAD(&reader_slots[i].epoch);
+        if (epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+    while (retired_head && retired_head->retire_epoch < oldest) {
+        DbSnapshot* s = retired_head;
+        retired_head = s->next;
+        if (!retired_head) retired_tail = NULL;
+        snapshot_free(s);
+    }
+}
+
+/*
+ * Make s current and retire the old snapshot, handing it what s replaced:
+ * older snapshots retire first, so it is freed after every reader of them.
+ */
+static void db_publish(DbSnapshot* s, PtrList* replaced) {
+    DbSnapshot* old = db_current;
+    ATOMIC_STORE(&db_current, s);
+    if (old != &db_empty) {
+        old->garbage = *replaced;
+        old->retire_epoch = ATOMIC_LOAD(&db_epoch);
+        old->next = NULL;
+        if (retired_tail) retired_tail->next = old;
+        else retired_head = old;
+        retired_tail = old;
+    } else {
+        ptrlist_free(replaced, true);
+    }
+    memset(replaced, 0, sizeof(PtrList));
+    ATOMIC_ADD(&db_epoch, 1);
+    db_reclaim();
+}
+
+/* Copy the directories a write changes, with room for extra rows */
+static DbSnapshot* snapshot_copy(const DbSnapshot* cur, int extra_rows) {
+    DbSnapshot* s = calloc(1, sizeof(DbSnapshot));
+    if (!s) return NULL;
+    s->count = cur->count;
+    s->live_count = cur->live_count;
+    s->block_count = (cur->count + extra_rows + DB_CHUNK_SIZE - 1) / DB_CHUNK_SIZE;
+    s->species_count = cur->species_count;
+    s->species_capacity = cur->species_count + 64;
+    s->species_slot_count = cur->species_slot_count;
+
+    size_t rows = (size_t)(cur->count + extra_rows);
+    size_t species = (size_t)s->species_capacity;
+    s->live = malloc(rows > 0 ? rows : 1);
+    s->blocks = calloc((size_t)(s->block_count > 0 ? s->block_count : 1), sizeof(Reaction**));
+    s->species_slots = malloc((size_t)(cur->species_slot_count > 0 ? cur->species_slot_count : 1) * sizeof(int));
+    s->consumers = calloc(species, sizeof(int*));
+    s->producers = calloc(species, sizeof(int*));
+    if (!s->live || !s->blocks || !s->species_slots || !s->consumers || !s->producers) {
+        snapshot_free(s);
+        return NULL;
+    }
+
+    if (cur->count > 0) memcpy(s->live, cur->live, (size_t)cur->count);
+    if (cur->block_count > 0) memcpy(s->blocks, cur->blocks, (size_t)cur->block_count * sizeof(Reaction**));
+    if (cur->species_slot_count > 0) {
+        memcpy(s->species_slots, cur->species_slots, (size_t)cur->species_slot_count * sizeof(int));
+    }
+    if (cur->species_count > 0) {
+        memcpy(s->consumers, cur->consumers, (size_t)cur->species_count * sizeof(int*));
+        memcpy(s->producers, cur->producers, (size_t)cur->species_count * sizeof(int*));
+    }
+    return s;
+}
+
+/* Undo a write that failed: drop what it allocated, keep what it would have replaced */
+static void snapshot_discard(DbSnapshot* s, PtrList* fresh, PtrList* replaced) {
+    ptrlist_free(fresh, true);
+    ptrlist_free(replaced, false);
+    snapshot_free(s);
+}
+
+/* ============ Reaction Database Queries ============ */
+
+const Reaction* reaction_db_find(const Formula* reactants, int reactant_count) {
+    const DbSnapshot* s = db_enter();
+    const Reaction* found = NULL;
+    for (int i = 0; i < s->count && !found; i++) {
+        const Reaction* rxn = snapshot_get(s, i);
+        if (rxn && formulas_match_set(reactants, reactant_count,
+                                      rxn->reactants, rxn->reactant_count)) {
+            found = rxn;
+        }
+    }
+    db_leave();
+    return found;
 }
 
 const Reaction* reaction_db_find_by_string(const char* reactants_str) {
     if (!reactants_str) return NULL;
-    if (!reaction_db_initialized) reaction_db_init();
+    reaction_db_init();
 
     /* Parse the reactants string (e.g., "C + O2") */
     Formula formulas[MAX_REACTANTS];
@@ -435,97 +734,842 @@ const Reaction* reaction_db_find_by_string(const char* reactants_str) {
     strncpy(buffer, reactants_str, sizeof(buffer) - 1);
     buffer[sizeof(buffer) - 1] = '\0';
 
-    char* token = strtok(buffer, "+");
+    /* Split on '+' by hand: strtok is not safe with concurrent readers */
+    char* token = buffer;
     while (token && formula_count < MAX_REACTANTS) {
+        char* next = strchr(token, '+');
+        if (next) *next++ = '\0';
+
         /* Trim whitespace */
         while (*token && isspace((unsigned char)*token)) token++;
         char* end = token + strlen(token) - 1;
         while (end > token && isspace((unsigned char)*end)) *end-- = '\0';
 
-        if (formula_parse(token, &formulas[formula_count])) {
+        if (*token && formula_parse(token, &formulas[formula_count])) {
             formula_count++;
         }
-        token = strtok(NULL, "+");
+        token = next;
     }
 
     return reaction_db_find(formulas, formula_count);
 }
 
+static bool formula_has_element(const Formula* formulas, int count, const Element* el) {
+    for (int j = 0; j < count; j++) {
+        for (int k = 0; k < formulas[j].element_count; k++) {
+            if (formulas[j].elements[k].element == el) return true;
+        }
+    }
+    return false;
+}
+
 int reaction_db_find_by_element(const Element* el, const Reaction** results, int max_results) {
     if (!el || !results || max_results <= 0) return 0;
-    if (!reaction_db_initialized) reaction_db_init();
 
+    const DbSnapshot* s = db_enter();
     int count = 0;
-    for (int i = 0; i < reaction_db_size && count < max_results; i++) {
-        bool found = false;
+    for (int i = 0; i < s->count && count < max_results; i++) {
+        const Reaction* rxn = snapshot_get(s, i);
+        if (!rxn) continue;
+        if (formula_has_element(rxn->reactants, rxn->reactant_count, el) ||
+            formula_has_element(rxn->products, rxn->product_count, el)) {
+            results[count++] = rxn;
+        }
+    }
+    db_leave();
+    return count;
+}
+
+int reaction_db_count(void) {
+    const DbSnapshot* s = db_enter();
+    int count = s->count;
+    db_leave();
+    return count;
+}
+
+int reaction_db_live_count(void) {
+    const DbSnapshot* s = db_enter();
+    int count = s->live_count;
+    db_leave();
+    return count;
+}
+
+const Reaction* reaction_db_get(int index) {
+    const DbSnapshot* s = db_enter();
+    const Reaction* rxn = snapshot_get(s, index);
+    db_leave();
+    return rxn;
+}
 
-        /* Check reactants */
-        for (int j = 0; j < reaction_database[i].reactant_count && !found; j++) {
-            for (int k = 0; k < reaction_database[i].reactants[j].element_count; k++) {
-                if (reaction_database[i].reactants[j].elements[k].element == el) {
-                    found = true;
-                    break;
-                }
+/* Copy each block with fresh records carrying the new energetics (writer lock held) */
+static bool refresh_energetics(DbSnapshot* s, PtrList* fresh, PtrList* replaced) {
+    for (int b = 0; b < s->block_count; b++) {
+        Reaction** old = s->blocks[b];
+        if (!old) continue;
+        Reaction** block = calloc(DB_CHUNK_SIZE, sizeof(Reaction*));
+        if (!block || !ptrlist_push(fresh, block)) {
+            free(block);
+            return false;
+        }
+        for (int slot = 0; slot < DB_CHUNK_SIZE; slot++) {
+            int row = b * DB_CHUNK_SIZE + slot;
+            if (row >= s->count || !s->live[row]) continue;
+            Reaction* rxn = malloc(sizeof(Reaction));
+            if (!rxn || !ptrlist_push(fresh, rxn)) {
+                free(rxn);
+                return false;
             }
+            *rxn = *old[slot];
+            thermo_reaction(rxn, &rxn->energetics);
+            block[slot] = rxn;
+            if (!ptrlist_push(replaced, old[slot])) return false;
         }
+        if (!ptrlist_push(replaced, old)) return false;
+        s->blocks[b] = block;
+    }
+    return true;
+}
+
+void reaction_db_update_energetics(void) {
+    reaction_db_init();
+    pthread_mutex_lock(&db_write_lock);
+    PtrList fresh = {0}, replaced = {0};
+    DbSnapshot* s = snapshot_copy(db_current, 0);
+    if (s && refresh_energetics(s, &fresh, &replaced)) {
+        ptrlist_free(&fresh, false);
+        db_publish(s, &replaced);
+    } else if (s) {
+        snapshot_discard(s, &fresh, &replaced);
+    }
+    pthread_mutex_unlock(&db_write_lock);
+}
+
+/* ============ Species Index ============ */
 
-        /* Check products */
-        for (int j = 0; j < reaction_database[i].product_count && !found; j++) {
-            for (int k = 0; k < reaction_database[i].products[j].element_count; k++) {
-                if (reaction_database[i].products[j].elements[k].element == el) {
-                    found = true;
-                    break;
-                }
+static int species_lookup(const DbSnapshot* s, const Formula* formula, uint64_t fp) {
+    if (s->species_slot_count == 0) return -1;
+
+    int mask = s->species_slot_count - 1;
+    for (int slot = (int)(fp & (uint64_t)mask); ; slot = (slot + 1) & mask) {
+        int id = s->species_slots[slot];
+        if (id < 0) return -1;
+        if (species_fingerprint(id) == fp && formula_equals(species_formula(id), formula)) {
+            return id;
+        }
+    }
+}
+
+static void species_slot_insert(DbSnapshot* s, int id) {
+    int mask = s->species_slot_count - 1;
+    int slot = (int)(species_fingerprint(id) & (uint64_t)mask);
+    while (s->species_slots[slot] >= 0) slot = (slot + 1) & mask;
+    s->species_slots[slot] = id;
+}
+
+/*
+ * Species id of a formula in the snapshot being built, appending it to the
+ * shared chunks if new (-1 on allocation failure). Slots past the published
+ * count may hold leftovers of a failed write; they are overwritten.
+ */
+static int species_intern(DbSnapshot* s, const Formula* formula) {
+    uint64_t fp = formula_fingerprint(formula);
+    int id = species_lookup(s, formula, fp);
+    if (id >= 0) return id;
+
+    id = s->species_count;
+    int chunk = id / DB_CHUNK_SIZE;
+    if (chunk >= DB_MAX_CHUNKS) return -1;
+    if (!species_chunks[chunk]) {
+        species_chunks[chunk] = malloc(sizeof(SpeciesChunk));
+        if (!species_chunks[chunk]) return -1;
+    }
+
+    /* Keep the load factor at or below one half */
+    if ((s->species_count + 1) * 2 > s->species_slot_count) {
+        int slot_count = s->species_slot_count ? s->species_slot_count * 2 : 128;
+        int* slots = malloc((size_t)slot_count * sizeof(int));
+        if (!slots) return -1;
+        free(s->species_slots);
+        s->species_slots = slots;
+        s->species_slot_count = slot_count;
+        for (int i = 0; i < slot_count; i++) s->species_slots[i] = -1;
+        for (int i = 0; i < s->species_count; i++) species_slot_insert(s, i);
+    }
+
+    if (id == s->species_capacity) {
+        int capacity = s->species_capacity * 2;
+        int** consumers = realloc(s->consumers, (size_t)capacity * sizeof(int*));
+        if (!consumers) return -1;
+        s->consumers = consumers;
+        int** producers = realloc(s->producers, (size_t)capacity * sizeof(int*));
+        if (!producers) return -1;
+        s->producers = producers;
+        s->species_capacity = capacity;
+    }
+    s->consumers[id] = NULL;
+    s->producers[id] = NULL;
+
+    SpeciesChunk* c = species_chunks[chunk];
+    c->formulas[id % DB_CHUNK_SIZE] = *formula;
+    c->formulas[id % DB_CHUNK_SIZE].coefficient = 1;
+    c->fingerprints[id % DB_CHUNK_SIZE] = fp;
+    s->species_count++;
+    species_slot_insert(s, id);
+    return id;
+}
+
+/* Species ids on one side of a reaction, each listed once */
+static int distinct_species(const Reaction* rxn, bool reactant_side, int* out) {
+    const int* ids = reactant_side ? rxn->reactant_species : rxn->product_species;
+    int n = reactant_side ? rxn->reactant_count : rxn->product_count;
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        bool repeated = ids[i] < 0;
+        for (int j = 0; j < count && !repeated; j++) {
+            if (out[j] == ids[i]) repeated = true;
+        }
+        if (!repeated) out[count++] = ids[i];
+    }
+    return count;
+}
+
+typedef struct {
+    int species;
+    int row;
+} Posting;
+
+static int compare_posting(const void* a, const void* b) {
+    const Posting* x = a;
+    const Posting* y = b;
+    if (x->species != y->species) return x->species < y->species ? -1 : 1;
+    return (x->row > y->row) - (x->row < y->row);
+}
+
+/*
+ * Append rows to the postings of the species they touch, one new list per
+ * species (rows are above every listed one, so lists stay ascending).
+ */
+static bool postings_append(int** lists, Posting* added, int count,
+                            PtrList* fresh, PtrList* replaced) {
+    qsort(added, (size_t)count, sizeof(Posting), compare_posting);
+    for (int begin = 0, end; begin < count; begin = end) {
+        int id = added[begin].species;
+        for (end = begin; end < count && added[end].species == id; end++) {}
+
+        int* old = lists[id];
+        int n = old ? old[0] : 0;
+        int* list = malloc((size_t)(1 + n + end - begin) * sizeof(int));
+        if (!list || !ptrlist_push(fresh, list)) {
+            free(list);
+            return false;
+        }
+        if (n > 0) memcpy(list + 1, old + 1, (size_t)n * sizeof(int));
+        for (int i = begin; i < end; i++) list[1 + n++] = added[i].row;
+        list[0] = n;
+        if (old && !ptrlist_push(replaced, old)) return false;
+        lists[id] = list;
+    }
+    return true;
+}
+
+/* Drop a row from the postings of the species on one side of its reaction */
+static bool postings_remove(int** lists, const Reaction* rxn, bool reactant_side, int row,
+                            PtrList* fresh, PtrList* replaced) {
+    int ids[MAX_REACTANTS + MAX_PRODUCTS];
+    int count = distinct_species(rxn, reactant_side, ids);
+    for (int i = 0; i < count; i++) {
+        int* old = lists[ids[i]];
+        if (!old) continue;
+        int* list = NULL;
+        if (old[0] > 1) {
+            list = malloc((size_t)old[0] * sizeof(int));
+            if (!list || !ptrlist_push(fresh, list)) {
+                free(list);
+                return false;
+            }
+            int n = 0;
+            for (int j = 1; j <= old[0]; j++) {
+                if (old[j] != row) list[1 + n++] = old[j];
             }
+            list[0] = n;
         }
+        if (!ptrlist_push(replaced, old)) return false;
+        lists[ids[i]] = list;
+    }
+    return true;
+}
+
+int reaction_db_species_count(void) {
+    const DbSnapshot* s = db_enter();
+    int count = s->species_count;
+    db_leave();
+    return count;
+}
+
+const Formula* reaction_db_species_get(int species_id) {
+    const DbSnapshot* s = db_enter();
+    const Formula* formula = species_id >= 0 && species_id < s->species_count ?
+                             species_formula(species_id) : NULL;
+    db_leave();
+    return formula;
+}
+
+int reaction_db_species_find(const Formula* formula) {
+    if (!formula) return -1;
+    const DbSnapshot* s = db_enter();
+    int id = species_lookup(s, formula, formula_fingerprint(formula));
+    db_leave();
+    return id;
+}
 
-        if (found) {
-            results[count++] = &reaction_database[i];
+static int postings_get(const int* list, const int** reactions) {
+    static const int none[1] = {0};
+    if (reactions) *reactions = list ? list + 1 : none;
+    return list ? list[0] : 0;
+}
+
+int reaction_db_species_consumers(int species_id, const int** reactions) {
+    const DbSnapshot* s = db_enter();
+    int n = 0;
+    if (species_id >= 0 && species_id < s->species_count) {
+        n = postings_get(s->consumers[species_id], reactions);
+    }
+    db_leave();
+    return n;
+}
+
+int reaction_db_species_producers(int species_id, const int** reactions) {
+    const DbSnapshot* s = db_enter();
+    int n = 0;
+    if (species_id >= 0 && species_id < s->species_count) {
+        n = postings_get(s->producers[species_id], reactions);
+    }
+    db_leave();
+    return n;
+}
+
+/* ============ Reaction Fingerprints ============ */
+
+/* Salts keep the three feature kinds apart when hashes coincide */
+#define FEATURE_COMPOSITION 0x243F6A8885A308D3ull
+#define FEATURE_ELEMENT     0x13198A2E03707344ull
+#define FEATURE_PAIR        0xA4093822299F31D0ull
+
+static void add_feature(float* vector, uint64_t hash, uint64_t salt, float weight) {
+    uint64_t h = (hash ^ salt) * 0x9E3779B97F4A7C15ull;
+    vector[(h >> 32) % REACTION_FP_DIMS] += weight;
+}
+
+static void add_species(float* vector, const Formula* formula, float sign) {
+    float weight = sign * (float)(formula->coefficient > 0 ? formula->coefficient : 1);
+    add_feature(vector, formula_fingerprint(formula), FEATURE_COMPOSITION, weight);
+
+    for (int i = 0; i < formula->element_count; i++) {
+        add_feature(vector, formula_fingerprint_parts(&formula->elements[i], 1), FEATURE_ELEMENT,
+                    weight);
+        for (int j = i + 1; j < formula->element_count; j++) {
+            /* Counts zeroed: the pair is present whatever the amounts */
+            ElementCount pair[2] = {{formula->elements[i].element, 0},
+                                    {formula->elements[j].element, 0}};
+            add_feature(vector, formula_fingerprint_parts(pair, 2), FEATURE_PAIR, weight);
         }
     }
+}
+
+void reaction_fingerprint(const Reaction* rxn, float* vector) {
+    if (!vector) return;
+    memset(vector, 0, REACTION_FP_DIMS * sizeof(float));
+    if (!rxn) return;
+
+    for (int i = 0; i < rxn->reactant_count; i++) add_species(vector, &rxn->reactants[i], -1.0f);
+    for (int i = 0; i < rxn->product_count; i++) add_species(vector, &rxn->products[i], 1.0f);
+}
+
+/* Features are small integers, so float sums are exact in any order */
+static float fp_dot(const float* a, const float* b) {
+#if defined(__SSE__)
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (int i = 0; i < REACTION_FP_DIMS; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < REACTION_FP_DIMS; i++) sum += a[i] * b[i];
+    return sum;
+#endif
+}
+
+static double tanimoto(float dot, float norm_a, float norm_b) {
+    double denominator = (double)norm_a + norm_b - dot;
+    return denominator > 0.0 ? dot / denominator : 0.0;
+}
+
+double reaction_fingerprint_similarity(const float* a, const float* b) {
+    if (!a || !b) return 0.0;
+    return tanimoto(fp_dot(a, b), fp_dot(a, a), fp_dot(b, b));
+}
+
+const float* reaction_db_fingerprint(int index) {
+    const DbSnapshot* s = db_enter();
+    const float* row = snapshot_get(s, index) ? row_fingerprint(index) : NULL;
+    db_leave();
+    return row;
+}
 
+int reaction_db_similar(const Reaction* query, unsigned int type_mask, int k, SimilarityHit* hits) {
+    if (!query || !hits || k < 0) return -1;
+
+    float q[REACTION_FP_DIMS];
+    reaction_fingerprint(query, q);
+    float qn = fp_dot(q, q);
+
+    /* hits stays sorted; rows arrive by ascending index, so ties go behind */
+    const DbSnapshot* s = db_enter();
+    int count = 0;
+    for (int r = 0; r < s->count && k > 0; r++) {
+        const DbChunk* chunk = db_chunks[r / DB_CHUNK_SIZE];
+        int slot = r % DB_CHUNK_SIZE;
+        if (!s->live[r] || !(type_mask & REACTION_TYPE_BIT(chunk->types[slot]))) continue;
+
+        float n = chunk->norms[slot];
+        if (count == k) {
+            float g = sqrtf(qn * n);
+            if (tanimoto(g, qn, n) < hits[k - 1].similarity) continue;
+        }
+
+        double similarity = tanimoto(fp_dot(q, chunk->rows + (size_t)slot * REACTION_FP_DIMS), qn, n);
+        if (count == k && similarity <= hits[k - 1].similarity) continue;
+
+        int i = count < k ? count++ : k - 1;
+        while (i > 0 && hits[i - 1].similarity < similarity) {
+            hits[i] = hits[i - 1];
+            i--;
+        }
+        hits[i].index = r;
+        hits[i].similarity = similarity;
+    }
+    db_leave();
     return count;
 }
 
-int reaction_db_count(void) {
-    if (!reaction_db_initialized) reaction_db_init();
-    return reaction_db_size;
+/* ============ Live Updates ============ */
+
+/* Chunk for a new row, allocated on first use (writer lock held) */
+static DbChunk* row_chunk(int row) {
+    int chunk = row / DB_CHUNK_SIZE;
+    if (chunk >= DB_MAX_CHUNKS) return NULL;
+    if (!db_chunks[chunk]) {
+        DbChunk* c = calloc(1, sizeof(DbChunk));
+        if (!c) return NULL;
+        size_t row_bytes = REACTION_FP_DIMS * sizeof(float);
+        c->block = malloc(DB_CHUNK_SIZE * row_bytes + REACTION_FP_ALIGNMENT);
+        if (!c->block) {
+            free(c);
+            return NULL;
+        }
+        uintptr_t address = (uintptr_t)c->block;
+        address = (address + REACTION_FP_ALIGNMENT - 1) & ~(uintptr_t)(REACTION_FP_ALIGNMENT - 1);
+        c->rows = (float*)address;
+        db_chunks[chunk] = c;
+    }
+    return db_chunks[chunk];
 }
 
-const Reaction* reaction_db_get(int index) {
-    if (!reaction_db_initialized) reaction_db_init();
-    if (index < 0 || index >= reaction_db_size) return NULL;
-    return &reaction_database[index];
+/* Copy a reaction into row s->count of the snapshot being built (writer lock held) */
+static bool append_row(DbSnapshot* s, const Reaction* source, PtrList* fresh) {
+    int row = s->count;
+    DbChunk* chunk = row_chunk(row);
+    if (!chunk) return false;
+
+    /* The last block may be shared; slots past the published count are free */
+    Reaction*** block = &s->blocks[row / DB_CHUNK_SIZE];
+    if (!*block) {
+        *block = calloc(DB_CHUNK_SIZE, sizeof(Reaction*));
+        if (!*block || !ptrlist_push(fresh, *block)) {
+            free(*block);
+            *block = NULL;
+            return false;
+        }
+    }
+    Reaction* rxn = malloc(sizeof(Reaction));
+    if (!rxn || !ptrlist_push(fresh, rxn)) {
+        free(rxn);
+        return false;
+    }
+
+    *rxn = *source;
+    for (int j = 0; j < rxn->reactant_count; j++) {
+        rxn->reactant_species[j] = species_intern(s, &rxn->reactants[j]);
+        if (rxn->reactant_species[j] < 0) return false;
+    }
+    for (int j = 0; j < rxn->product_count; j++) {
+        rxn->product_species[j] = species_intern(s, &rxn->products[j]);
+        if (rxn->product_species[j] < 0) return false;
+    }
+    reaction_check_balanced(rxn);
+    thermo_reaction(rxn, &rxn->energetics);
+
+    int slot = row % DB_CHUNK_SIZE;
+    float* fp = chunk->rows + (size_t)slot * REACTION_FP_DIMS;
+    reaction_fingerprint(rxn, fp);
+    chunk->norms[slot] = fp_dot(fp, fp);
+    chunk->types[slot] = (unsigned char)rxn->type;
+    (*block)[slot] = rxn;
+    s->live[row] = 1;
+    s->count++;
+    s->live_count++;
+    return true;
+}
+
+/* Postings of every species the new rows touch (writer lock held) */
+static bool append_postings(DbSnapshot* s, int first_row, PtrList* fresh, PtrList* replaced) {
+    int rows = s->count - first_row;
+    Posting* consumed = malloc((size_t)(rows > 0 ? rows : 1) * MAX_REACTANTS * sizeof(Posting));
+    Posting* produced = malloc((size_t)(rows > 0 ? rows : 1) * MAX_PRODUCTS * sizeof(Posting));
+    bool ok = consumed && produced;
+
+    int consumed_count = 0, produced_count = 0;
+    int ids[MAX_REACTANTS + MAX_PRODUCTS];
+    for (int row = first_row; ok && row < s->count; row++) {
+        const Reaction* rxn = row_record(s, row);
+        int n = distinct_species(rxn, true, ids);
+        for (int i = 0; i < n; i++) consumed[consumed_count++] = (Posting){ids[i], row};
+        n = distinct_species(rxn, false, ids);
+        for (int i = 0; i < n; i++) produced[produced_count++] = (Posting){ids[i], row};
+    }
+    ok = ok && postings_append(s->consumers, consumed, consumed_count, fresh, replaced) &&
+         postings_append(s->producers, produced, produced_count, fresh, replaced);
+    free(consumed);
+    free(produced);
+    return ok;
+}
+
+/*
+ * Append reactions as new rows of a new snapshot and publish it (writer
+ * lock held). Rows past the published count belong to no snapshot, so
+ * they are written in place.
+ */
+static bool db_append(const Reaction* reactions, int count, int* indices) {
+    DbSnapshot* s = snapshot_copy(db_current, count);
+    if (!s) return false;
+
+    PtrList fresh = {0}, replaced = {0};
+    int first_row = s->count;
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) {
+        if (indices) indices[i] = s->count;
+        ok = append_row(s, &reactions[i], &fresh);
+    }
+    if (!ok || !append_postings(s, first_row, &fresh, &replaced)) {
+        snapshot_discard(s, &fresh, &replaced);
+        return false;
+    }
+    ptrlist_free(&fresh, false);
+    db_publish(s, &replaced);
+    return true;
+}
+
+int reaction_db_insert(const Reaction* rxn) {
+    if (!rxn) return -1;
+    int index = -1;
+    if (!reaction_db_insert_batch(rxn, 1, &index)) return -1;
+    return index;
+}
+
+bool reaction_db_insert_batch(const Reaction* reactions, int count, int* indices) {
+    if (!reactions || count < 0) return false;
+    reaction_db_init();
+    pthread_mutex_lock(&db_write_lock);
+    bool ok = db_append(reactions, count, indices);
+    pthread_mutex_unlock(&db_write_lock);
+    return ok;
+}
+
+bool reaction_db_remove(int index) {
+    reaction_db_init();
+    pthread_mutex_lock(&db_write_lock);
+    const DbSnapshot* cur = db_current;
+    bool ok = index >= 0 && index < cur->count && cur->live[index];
+    DbSnapshot* s = ok ? snapshot_copy(cur, 0) : NULL;
+    ok = s != NULL;
+    if (s) {
+        PtrList fresh = {0}, replaced = {0};
+        Reaction* rxn = row_record(s, index);
+        s->live[index] = 0;
+        s->live_count--;
+        ok = postings_remove(s->consumers, rxn, true, index, &fresh, &replaced) &&
+             postings_remove(s->producers, rxn, false, index, &fresh, &replaced) &&
+             ptrlist_push(&replaced, rxn);
+        if (ok) {
+            ptrlist_free(&fresh, false);
+            db_publish(s, &replaced);
+        } else {
+            snapshot_discard(s, &fresh, &replaced);
+        }
+    }
+    pthread_mutex_unlock(&db_write_lock);
+    return ok;
+}
+
+void reaction_db_mark(ReactionDbMark* mark) {
+    if (!mark) return;
+    const DbSnapshot* s = db_enter();
+    mark->count = s->count;
+    mark->species_count = s->species_count;
+    db_leave();
 }
 
-/* ============ Simple Equation Balancing ============ */
-/* Note: Full balancing is complex. This is a simplified version. */
+/* Drop rows at or past first_row from every postings list (writer lock held) */
+static bool postings_truncate(int** lists, int species_count, int first_row,
+                              PtrList* fresh, PtrList* replaced) {
+    for (int id = 0; id < species_count; id++) {
+        int* old = lists[id];
+        if (!old || old[old[0]] < first_row) continue;
+
+        /* Lists are ascending, so the dropped rows are a suffix */
+        int n = old[0];
+        while (n > 0 && old[n] >= first_row) n--;
+        int* list = NULL;
+        if (n > 0) {
+            list = malloc((size_t)(1 + n) * sizeof(int));
+            if (!list || !ptrlist_push(fresh, list)) {
+                free(list);
+                return false;
+            }
+            memcpy(list + 1, old + 1, (size_t)n * sizeof(int));
+            list[0] = n;
+        }
+        if (!ptrlist_push(replaced, old)) return false;
+        lists[id] = list;
+    }
+    return true;
+}
+
+/* Cut a snapshot back to a mark, replacing what it drops (writer lock held) */
+static bool snapshot_truncate(DbSnapshot* s, const ReactionDbMark* mark,
+                              PtrList* fresh, PtrList* replaced) {
+    for (int row = mark->count; row < s->count; row++) {
+        if (!s->live[row]) continue;
+        if (!ptrlist_push(replaced, row_record(s, row))) return false;
+        s->live_count--;
+    }
+
+    /* Blocks wholly past the mark go; the slots past it in a kept block are free */
+    int keep_blocks = (mark->count + DB_CHUNK_SIZE - 1) / DB_CHUNK_SIZE;
+    for (int b = keep_blocks; b < s->block_count; b++) {
+        if (s->blocks[b] && !ptrlist_push(replaced, s->blocks[b])) return false;
+        s->blocks[b] = NULL;
+    }
+    s->count = mark->count;
+    s->block_count = keep_blocks;
+
+    if (!postings_truncate(s->consumers, s->species_count, mark->count, fresh, replaced) ||
+        !postings_truncate(s->producers, s->species_count, mark->count, fresh, replaced)) {
+        return false;
+    }
+    s->species_count = mark->species_count;
+    for (int i = 0; i < s->species_slot_count; i++) s->species_slots[i] = -1;
+    for (int i = 0; i < s->species_count; i++) species_slot_insert(s, i);
+    return true;
+}
+
+/*
+ * Wait until no reader can still hold a snapshot retired at or before
+ * epoch, then free them (writer lock held).
+ */
+static void db_quiesce(uint64_t epoch) {
+    for (;;) {
+        bool busy = ATOMIC_LOAD(&overflow_readers) > 0;
+        for (int i = 0; i < DB_READER_SLOTS && !busy; i++) {
+            uint64_t e = ATOMIC_LOAD(&reader_slots[i].epoch);
+            busy = e != 0 && e <= epoch;
+        }
+        if (!busy) break;
+        sched_yield();
+    }
+    db_reclaim();
+}
+
+bool reaction_db_rollback(const ReactionDbMark* mark) {
+    if (!mark || thread_depth > 0) return false;
+    reaction_db_init();
+    pthread_mutex_lock(&db_write_lock);
+    const DbSnapshot* cur = db_current;
+    bool ok = mark->count >= 0 && mark->count <= cur->count &&
+              mark->species_count >= 0 && mark->species_count <= cur->species_count;
+    DbSnapshot* s = ok ? snapshot_copy(cur, 0) : NULL;
+    ok = s != NULL;
+    if (s) {
+        PtrList fresh = {0}, replaced = {0};
+        ok = snapshot_truncate(s, mark, &fresh, &replaced);
+        if (ok) {
+            /* Rows and species past the mark get rewritten in place by the
+             * next append, so no reader may still look at them by then */
+            uint64_t epoch = ATOMIC_LOAD(&db_epoch);
+            ptrlist_free(&fresh, false);
+            db_publish(s, &replaced);
+            db_quiesce(epoch);
+        } else {
+            snapshot_discard(s, &fresh, &replaced);
+        }
+    }
+    pthread_mutex_unlock(&db_write_lock);
+    return ok;
+}
+
+/* ============ Equation Balancing ============ */
+/*
+ * Coefficients form the null space of the element-by-species matrix
+ * (reactant columns positive, product columns negative). Fraction-free
+ * Gauss-Jordan elimination reduces it; a unique balance exists when the
+ * null space is one-dimensional and every coefficient has the same sign.
+ */
+
+static long long gcd_ll(long long a, long long b) {
+    if (a < 0) a = -a;
+    if (b < 0) b = -b;
+    while (b) {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
 
 bool reaction_balance(Reaction* rxn) {
-    /* For now, just check if it's balanced */
-    /* A full implementation would use linear algebra */
+    if (!rxn) return false;
+
+    int n = rxn->reactant_count + rxn->product_count;
+    if (n < 2) return reaction_check_balanced(rxn);
+
+    /* Collect the elements present */
+    int element_row[NUM_ELEMENTS];
+    int rows = 0;
+    for (int i = 0; i < NUM_ELEMENTS; i++) element_row[i] = -1;
+
+    long long matrix[NUM_ELEMENTS][MAX_REACTANTS + MAX_PRODUCTS];
+    for (int j = 0; j < n; j++) {
+        const Formula* f = j < rxn->reactant_count ? &rxn->reactants[j]
+                                                   : &rxn->products[j - rxn->reactant_count];
+        int sign = j < rxn->reactant_count ? 1 : -1;
+        for (int k = 0; k < f->element_count; k++) {
+            int z = f->elements[k].element->atomic_number - 1;
+            if (element_row[z] < 0) {
+                element_row[z] = rows;
+                memset(matrix[rows], 0, sizeof(matrix[rows]));
+                rows++;
+            }
+            matrix[element_row[z]][j] += sign * f->elements[k].count;
+        }
+    }
+
+    /* Reduce to row echelon form with pivots cleared above and below */
+    int pivot_col[NUM_ELEMENTS];
+    int rank = 0;
+    for (int col = 0; col < n && rank < rows; col++) {
+        int pivot = -1;
+        for (int r = rank; r < rows; r++) {
+            if (matrix[r][col] != 0) {
+                pivot = r;
+                break;
+            }
+        }
+        if (pivot < 0) continue;
+
+        for (int c = 0; c < n; c++) {
+            long long t = matrix[rank][c];
+            matrix[rank][c] = matrix[pivot][c];
+            matrix[pivot][c] = t;
+        }
+
+        for (int r = 0; r < rows; r++) {
+            if (r == rank || matrix[r][col] == 0) continue;
+            long long a = matrix[rank][col];
+            long long b = matrix[r][col];
+            long long g = 0;
+            for (int c = 0; c < n; c++) {
+                matrix[r][c] = matrix[r][c] * a - matrix[rank][c] * b;
+                g = gcd_ll(g, matrix[r][c]);
+            }
+            if (g > 1) {
+                for (int c = 0; c < n; c++) matrix[r][c] /= g;
+            }
+        }
+        pivot_col[rank++] = col;
+    }
+
+    /* Need exactly one free column */
+    if (n - rank != 1) return reaction_check_balanced(rxn);
+
+    int free_col = -1;
+    for (int c = 0, p = 0; c < n; c++) {
+        if (p < rank && pivot_col[p] == c) p++;
+        else free_col = c;
+    }
+
+    /* x_free = lcm of pivots, x_pivot = -row[free] * x_free / pivot */
+    long long scale = 1;
+    for (int r = 0; r < rank; r++) {
+        long long p = matrix[r][pivot_col[r]];
+        scale = scale / gcd_ll(scale, p) * (p < 0 ? -p : p);
+    }
+
+    long long coef[MAX_REACTANTS + MAX_PRODUCTS];
+    coef[free_col] = scale;
+    for (int r = 0; r < rank; r++) {
+        coef[pivot_col[r]] = -matrix[r][free_col] * (scale / matrix[r][pivot_col[r]]);
+    }
+
+    long long g = 0;
+    for (int j = 0; j < n; j++) g = gcd_ll(g, coef[j]);
+    if (g == 0) return reaction_check_balanced(rxn);
+
+    long long sign = coef[0] < 0 ? -1 : 1;
+    for (int j = 0; j < n; j++) {
+        coef[j] = coef[j] / g * sign;
+        if (coef[j] <= 0 || coef[j] > 1000000) return reaction_check_balanced(rxn);
+    }
+
+    for (int j = 0; j < n; j++) {
+        Formula* f = j < rxn->reactant_count ? &rxn->reactants[j]
+                                             : &rxn->products[j - rxn->reactant_count];
+        f->coefficient = (int)coef[j];
+    }
     return reaction_check_balanced(rxn);
 }
 
 /* ============ Reaction Prediction ============ */
-/* Simplified prediction based on reaction types */
+/* Database lookup first, then the rule engine in reaction_rules.c */
 
-bool reaction_predict(const Formula* reactants, int reactant_count,
-                     Formula* products, int* product_count) {
-    if (!reactants || !products || !product_count) return false;
+bool reaction_predict_reaction(const Formula* reactants, int reactant_count,
+                               Reaction* result) {
+    if (!reactants || !result) return false;
 
-    /* First, check if we have this reaction in our database */
     const Reaction* known = reaction_db_find(reactants, reactant_count);
     if (known) {
-        *product_count = known->product_count;
-        for (int i = 0; i < known->product_count; i++) {
-            products[i] = known->products[i];
-        }
+        *result = *known;
         return true;
     }
+    return reaction_rules_apply(reactants, reactant_count, result);
+}
 
-    /* Basic prediction rules could go here */
-    /* For now, return false if not in database */
-    *product_count = 0;
-    return false;
+bool reaction_predict(const Formula* reactants, int reactant_count,
+                     Formula* products, int* product_count) {
+    if (!reactants || !products || !product_count) return false;
+
+    Reaction rxn;
+    if (!reaction_predict_reaction(reactants, reactant_count, &rxn)) {
+        *product_count = 0;
+        return false;
+    }
+
+    *product_count = rxn.product_count;
+    for (int i = 0; i < rxn.product_count; i++) {
+        products[i] = rxn.products[i];
+    }
+    return true;
 }
@@ -0,0 +1,434 @@
+#include "reaction.h"
+#include "ion.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Rule-based product prediction
+ *
+ * Each reactant is classified into a category. The sorted pair of categories
+ * indexes a static dispatch table of rule functions, so choosing a rule is a
+ * single table lookup; the chosen rule builds products from ions and element
+ * properties, and the result is balanced with reaction_balance().
+ */
+
+typedef enum {
+    RC_METAL,           /* Elemental metal (e.g., Zn) */
+    RC_NONMETAL,        /* Elemental nonmetal other than oxygen (e.g., Cl2, C) */
+    RC_OXYGEN,          /* O2 */
+    RC_HYDROCARBON,     /* CxHy or CxHyOz that is not an acid */
+    RC_ACID,            /* H+ with an anion (e.g., HCl, H2SO4, CH3COOH) */
+    RC_BASE,            /* Cation with hydroxide (e.g., NaOH) */
+    RC_SALT,            /* Other ionic compound (e.g., CuSO4) */
+    RC_OTHER,
+    RC_COUNT            /* REACTION_RULE_CATEGORIES */
+} ReactantCategory;
+
+typedef struct {
+    const Formula* formula;
+    ReactantCategory category;
+    Ion cation;
+    Ion anion;
+    int cation_count;
+    int anion_count;
+} ClassifiedReactant;
+
+/* A rule fills products, type and condition; reactants are set by the caller */
+typedef bool (*PredictionRule)(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                               Reaction* out);
+
+/* ============ Chemistry Tables ============ */
+
+/* Metal activity series, most active first (hydrogen included as reference) */
+static const int ACTIVITY_SERIES[] = {
+    3, 19, 56, 38, 20, 11, 12, 13, 25, 30, 24, 26, 48, 27, 28, 50, 82,
+    1,  /* H */
+    29, 80, 47, 78, 79
+};
+
+/* Halogen activity, most active first */
+static const int HALOGEN_SERIES[] = {9, 17, 35, 53};
+
+static int series_rank(const int* series, int length, const Element* el) {
+    if (!el) return -1;
+    for (int i = 0; i < length; i++) {
+        if (series[i] == el->atomic_number) return i;
+    }
+    return -1;
+}
+
+static int activity_rank(const Element* el) {
+    return series_rank(ACTIVITY_SERIES, (int)(sizeof(ACTIVITY_SERIES) / sizeof(ACTIVITY_SERIES[0])), el);
+}
+
+static int halogen_rank(const Element* el) {
+    return series_rank(HALOGEN_SERIES, (int)(sizeof(HALOGEN_SERIES) / sizeof(HALOGEN_SERIES[0])), el);
+}
+
+static bool is_element(const Ion* ion, int atomic_number) {
+    return ion->element && ion->element->atomic_number == atomic_number;
+}
+
+static bool is_polyatomic(const Ion* ion, const char* formula) {
+    return ion->polyatomic >= 0 && ion->polyatomic == polyatomic_find(formula);
+}
+
+/* Simplified aqueous solubility rules */
+static bool is_soluble(const Ion* cation, const Ion* anion) {
+    if (is_element(cation, 1) || is_polyatomic(cation, "NH4")) return true;
+    if (cation->element && cation->element->category == CAT_ALKALI_METAL) return true;
+
+    if (is_polyatomic(anion, "NO3") || is_polyatomic(anion, "C2H3O2") ||
+        is_polyatomic(anion, "ClO3") || is_polyatomic(anion, "ClO4") ||
+        is_polyatomic(anion, "HCO3") || is_polyatomic(anion, "NO2")) {
+        return true;
+    }
+
+    int z = cation->element ? cation->element->atomic_number : 0;
+    bool ag_pb_hg = z == 47 || z == 82 || z == 80;
+
+    /* Chlorides, bromides, iodides */
+    if (is_element(anion, 17) || is_element(anion, 35) || is_element(anion, 53)) {
+        return !(ag_pb_hg || (z == 29 && cation->charge == 1));
+    }
+    if (is_element(anion, 9)) {
+        return !(z == 12 || z == 20 || z == 38 || z == 56 || z == 82);
+    }
+    if (is_polyatomic(anion, "SO4")) {
+        return !(ag_pb_hg || z == 20 || z == 38 || z == 56);
+    }
+    if (is_polyatomic(anion, "OH")) {
+        return z == 38 || z == 56;
+    }
+
+    /* Carbonates, phosphates, sulfides, oxides, sulfites, chromates */
+    if (is_polyatomic(anion, "CO3") || is_polyatomic(anion, "PO4") ||
+        is_polyatomic(anion, "SO3") || is_polyatomic(anion, "CrO4") ||
+        is_polyatomic(anion, "HPO4") || is_element(anion, 16) || is_element(anion, 8)) {
+        return false;
+    }
+    return true;
+}
+
+/* ============ Helpers ============ */
+
+/* Elemental form: diatomic for H, N, O and the halogens */
+static void elemental_formula(const Element* el, Formula* out) {
+    memset(out, 0, sizeof(Formula));
+    out->coefficient = 1;
+
+    int z = el->atomic_number;
+    bool diatomic = z == 1 || z == 7 || z == 8 || z == 9 || z == 17 || z == 35 || z == 53;
+    formula_add_element(out, el, diatomic ? 2 : 1);
+}
+
+static void formula_from_string(const char* str, Formula* out) {
+    if (!formula_parse(str, out)) {
+        memset(out, 0, sizeof(Formula));
+    }
+}
+
+static bool add_product(Reaction* out, const Formula* f) {
+    if (out->product_count >= MAX_PRODUCTS || f->element_count == 0) return false;
+    out->products[out->product_count] = *f;
+    out->products[out->product_count].coefficient = 1;
+    out->product_count++;
+    return true;
+}
+
+/* Highest common positive charge not above +4 (e.g., Fe -> 3, S -> 4) */
+static int synthesis_charge(const Element* el) {
+    int best = 0;
+    for (int i = 0; i < 4 && el->common_charges[i] != 0; i++) {
+        int c = el->common_charges[i];
+        if (c > 0 && c <= 4 && c > best) best = c;
+    }
+    return best;
+}
+
+/*
+ * Add the compound of a cation and anion to the products, decomposing
+ * unstable products (H2CO3 -> H2O + CO2, NH4OH -> NH3 + H2O).
+ * Sets *driving if it forms water or a gas.
+ */
+static bool add_ionic_product(Reaction* out, const Ion* cation, const Ion* anion, bool* driving) {
+    Formula f;
+
+    if (is_element(cation, 1) && is_polyatomic(anion, "CO3")) {
+        formula_from_string("H2O", &f);
+        add_product(out, &f);
+        formula_from_string("CO2", &f);
+        *driving = true;
+        return add_product(out, &f);
+    }
+    if (is_polyatomic(cation, "NH4") && is_polyatomic(anion, "OH")) {
+        formula_from_string("NH3", &f);
+        add_product(out, &f);
+        formula_from_string("H2O", &f);
+        *driving = true;
+        return add_product(out, &f);
+    }
+    if (is_element(cation, 1) && is_polyatomic(anion, "OH")) {
+        *driving = true;
+    }
+
+    if (!ion_compound(cation, anion, &f)) return false;
+    return add_product(out, &f);
+}
+
+/* ============ Rules ============ */
+
+/* Hydrocarbon + O2 -> CO2 + H2O */
+static bool rule_combustion(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                            Reaction* out) {
+    (void)a;
+    (void)b;
+    Formula f;
+    formula_from_string("CO2", &f);
+    add_product(out, &f);
+    formula_from_string("H2O", &f);
+    add_product(out, &f);
+
+    out->type = RXTYPE_COMBUSTION;
+    out->condition = COND_HEATED;
+    return true;
+}
+
+/* Two elements -> binary compound using common charges (e.g., Na + Cl2 -> NaCl) */
+static bool rule_binary_synthesis(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                                  Reaction* out) {
+    const Element* x = a->formula->elements[0].element;
+    const Element* y = b->formula->elements[0].element;
+
+    /* Metal or less electronegative element becomes the cation */
+    const Element* pos = x;
+    const Element* neg = y;
+    if (element_is_metal(y) || (!element_is_metal(x) && y->electronegativity < x->electronegativity)) {
+        pos = y;
+        neg = x;
+    }
+    if (pos == neg) return false;
+
+    int pos_charge = synthesis_charge(pos);
+    int neg_charge = element_anion_charge(neg);
+    if (pos_charge <= 0 || neg_charge >= 0) return false;
+
+    Ion cation = ion_monatomic(pos, pos_charge);
+    Ion anion = ion_monatomic(neg, neg_charge);
+    Formula f;
+    if (!ion_compound(&cation, &anion, &f)) return false;
+    add_product(out, &f);
+
+    bool burning = b->category == RC_OXYGEN && a->category == RC_NONMETAL;
+    out->type = burning ? RXTYPE_COMBUSTION : RXTYPE_SYNTHESIS;
+    out->condition = burning ? COND_HEATED : COND_NORMAL;
+    return true;
+}
+
+/* A + BC -> AC + B when A is more active than B */
+static bool rule_single_replacement(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                                    Reaction* out) {
+    const Element* free_el = a->formula->elements[0].element;
+    Formula f;
+
+    if (a->category == RC_METAL) {
+        const Element* bound = b->cation.element;
+        if (!bound || bound == free_el) return false;
+
+        int free_rank = activity_rank(free_el);
+        int bound_rank = activity_rank(bound);
+        if (free_rank < 0 || bound_rank < 0 || free_rank > bound_rank) return false;
+
+        Ion cation = ion_monatomic(free_el, element_cation_charge(free_el));
+        if (!ion_compound(&cation, &b->anion, &f)) return false;
+        add_product(out, &f);
+        elemental_formula(bound, &f);
+        add_product(out, &f);
+    } else {
+        /* Halogen displacing a less active halide */
+        const Element* bound = b->anion.element;
+        int free_rank = halogen_rank(free_el);
+        int bound_rank = halogen_rank(bound);
+        if (free_rank < 0 || bound_rank < 0 || free_rank >= bound_rank) return false;
+
+        Ion anion = ion_monatomic(free_el, element_anion_charge(free_el));
+        if (!ion_compound(&b->cation, &anion, &f)) return false;
+        add_product(out, &f);
+        elemental_formula(bound, &f);
+        add_product(out, &f);
+    }
+
+    out->type = RXTYPE_SINGLE_REPLACE;
+    out->condition = COND_NORMAL;
+    return true;
+}
+
+/* AB + CD -> AD + CB, only when a precipitate, water or gas forms */
+static bool rule_double_replacement(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                                    Reaction* out) {
+    if (ion_equals(&a->cation, &b->cation) || ion_equals(&a->anion, &b->anion)) return false;
+
+    bool driving = !is_soluble(&a->cation, &b->anion) || !is_soluble(&b->cation, &a->anion);
+    if (!add_ionic_product(out, &a->cation, &b->anion, &driving) ||
+        !add_ionic_product(out, &b->cation, &a->anion, &driving)) {
+        return false;
+    }
+    if (!driving) return false;
+
+    out->type = RXTYPE_DOUBLE_REPLACE;
+    out->condition = COND_NORMAL;
+    return true;
+}
+
+/* Acid + base -> salt + water */
+static bool rule_neutralization(const ClassifiedReactant* a, const ClassifiedReactant* b,
+                                Reaction* out) {
+    bool driving = false;
+    if (!add_ionic_product(out, &b->cation, &a->anion, &driving)) return false;
+
+    Formula water;
+    formula_from_string("H2O", &water);
+    add_product(out, &water);
+
+    out->type = RXTYPE_ACID_BASE;
+    out->condition = COND_NORMAL;
+    return true;
+}
+
+/*
+ * Dispatch table indexed by [lower category][higher category].
+ * Empty entries mean no rule applies.
+ */
+static const PredictionRule RULE_TABLE[RC_COUNT][RC_COUNT] = {
+    [RC_METAL][RC_NONMETAL]     = rule_binary_synthesis,
+    [RC_METAL][RC_OXYGEN]       = rule_binary_synthesis,
+    [RC_NONMETAL][RC_NONMETAL]  = rule_binary_synthesis,
+    [RC_NONMETAL][RC_OXYGEN]    = rule_binary_synthesis,
+    [RC_OXYGEN][RC_HYDROCARBON] = rule_combustion,
+    [RC_METAL][RC_ACID]         = rule_single_replacement,
+    [RC_METAL][RC_SALT]         = rule_single_replacement,
+    [RC_NONMETAL][RC_SALT]      = rule_single_replacement,
+    [RC_ACID][RC_BASE]          = rule_neutralization,
+    [RC_ACID][RC_SALT]          = rule_double_replacement,
+    [RC_BASE][RC_SALT]          = rule_double_replacement,
+    [RC_SALT][RC_SALT]          = rule_double_replacement
+};
+
+static const char* RULE_NAMES[RC_COUNT][RC_COUNT] = {
+    [RC_METAL][RC_NONMETAL]     = "binary ionic synthesis",
+    [RC_METAL][RC_OXYGEN]       = "metal oxide synthesis",
+    [RC_NONMETAL][RC_NONMETAL]  = "binary synthesis",
+    [RC_NONMETAL][RC_OXYGEN]    = "nonmetal combustion",
+    [RC_OXYGEN][RC_HYDROCARBON] = "hydrocarbon combustion",
+    [RC_METAL][RC_ACID]         = "single replacement",
+    [RC_METAL][RC_SALT]         = "single replacement",
+    [RC_NONMETAL][RC_SALT]      = "halogen replacement",
+    [RC_ACID][RC_BASE]          = "neutralization",
+    [RC_ACID][RC_SALT]          = "double replacement",
+    [RC_BASE][RC_SALT]          = "double replacement",
+    [RC_SALT][RC_SALT]          = "double replacement"
+};
+
+/* ============ Classification ============ */
+
+static void classify(const Formula* f, ClassifiedReactant* out) {
+    memset(out, 0, sizeof(ClassifiedReactant));
+    out->formula = f;
+    out->category = RC_OTHER;
+    out->cation.polyatomic = -1;
+    out->anion.polyatomic = -1;
+
+    if (f->element_count == 1) {
+        const Element* el = f->elements[0].element;
+        if (element_is_metal(el)) out->category = RC_METAL;
+        else if (el->atomic_number == 8 && f->elements[0].count == 2) out->category = RC_OXYGEN;
+        else if (el->category != CAT_NOBLE_GAS && el->atomic_number != 8) out->category = RC_NONMETAL;
+        return;
+    }
+
+    int c = 0, h = 0, o = 0;
+    for (int i = 0; i < f->element_count; i++) {
+        switch (f->elements[i].element->atomic_number) {
+            case 1: h = f->elements[i].count; break;
+            case 6: c = f->elements[i].count; break;
+            case 8: o = f->elements[i].count; break;
+            default: break;
+        }
+    }
+    if (c > 0 && h > 0 && f->element_count == (o > 0 ? 3 : 2)) {
+        /*
+         * Organic acids: a CxHyOz that splits into H+ and one tabulated
+         * oxyanion (acetate, carbonate, ...). Formulas carry composition
+         * only, so an isomeric ester such as methyl formate is also taken
+         * as the acid, and acids whose anion is not tabulated stay fuels.
+         * Requiring a single anion keeps sugars like C6H12O6 (which would
+         * split as H3(C2H3O2)3) fuels.
+         */
+        if (o >= 2 && ion_split(f, &out->cation, &out->cation_count, &out->anion, &out->anion_count) &&
+            is_element(&out->cation, 1) && out->anion.polyatomic >= 0 && out->anion_count == 1) {
+            out->category = RC_ACID;
+            return;
+        }
+        out->category = RC_HYDROCARBON;
+        return;
+    }
+    /* Water and peroxide are not acids */
+    if (h > 0 && o > 0 && f->element_count == 2) return;
+
+    if (!ion_split(f, &out->cation, &out->cation_count, &out->anion, &out->anion_count)) return;
+
+    if (is_element(&out->cation, 1)) out->category = RC_ACID;
+    else if (is_polyatomic(&out->anion, "OH")) out->category = RC_BASE;
+    else out->category = RC_SALT;
+}
+
+/* ============ Public Entry Point ============ */
+
+bool reaction_rules_apply(const Formula* reactants, int reactant_count, Reaction* result) {
+    if (!reactants || !result || reactant_count != 2) return false;
+
+    ClassifiedReactant a, b;
+    classify(&reactants[0], &a);
+    classify(&reactants[1], &b);
+    if (a.category > b.category) {
+        ClassifiedReactant t = a;
+        a = b;
+        b = t;
+    }
+
+    PredictionRule rule = RULE_TABLE[a.category][b.category];
+    if (!rule) return false;
+
+    Reaction rxn;
+    reaction_init(&rxn);
+    for (int i = 0; i < 2; i++) {
+        rxn.reactants[i] = reactants[i];
+        rxn.reactants[i].coefficient = 1;
+    }
+    rxn.reactant_count = 2;
+
+    if (!rule(&a, &b, &rxn)) return false;
+    if (!reaction_balance(&rxn)) return false;
+
+    snprintf(rxn.description, sizeof(rxn.description), "Predicted by rule: %s",
+             RULE_NAMES[a.category][b.category]);
+    *result = rxn;
+    return true;
+}
+
+int reaction_rules_category(const Formula* reactant) {
+    if (!reactant) return RC_OTHER;
+    ClassifiedReactant c;
+    classify(reactant, &c);
+    return c.category;
+}
+
+bool reaction_rules_pair(int category_a, int category_b) {
+    if (category_a > category_b) {
+        int t = category_a;
+        category_a = category_b;
+        category_b = t;
+    }
+    if (category_a < 0 || category_b >= RC_COUNT) return false;
+    return RULE_TABLE[category_a][category_b] != NULL;
+}
@@ -0,0 +1,545 @@
+#include "ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define RING_FIRST_DEPTH 3          /* Rings of up to 2 * 3 + 1 atoms in the first pass */
+
+/* ============ Context ============ */
+
+void ring_context_init(RingContext* ctx) {
+    if (!ctx) return;
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void ring_context_free(RingContext* ctx) {
+    if (!ctx) return;
+    free(ctx->disc);
+    free(ctx->low);
+    free(ctx->frames);
+    free(ctx->edge_stack);
+    free(ctx->components);
+    free(ctx->component_offsets);
+    free(ctx->local);
+    free(ctx->atoms);
+    free(ctx->offsets);
+    free(ctx->neighbors);
+    free(ctx->edges);
+    free(ctx->bonds);
+    free(ctx->dist);
+    free(ctx->parent);
+    free(ctx->parent_edge);
+    free(ctx->queue);
+    free(ctx->pivots);
+    free(ctx->row);
+    free(ctx->row_spans);
+    free(ctx->basis);
+    free(ctx->candidate_offsets);
+    free(ctx->sorted);
+    free(ctx->path_atoms);
+    free(ctx->path_edges);
+    free(ctx->ring_offsets);
+    free(ctx->ring_atoms);
+    free(ctx->ring_bonds);
+    ring_context_init(ctx);
+}
+
+static bool grow(void** array, size_t count, size_t item) {
+    void* p = realloc(*array, count * item);
+    if (!p) return false;
+    *array = p;
+    return true;
+}
+
+/* Grow a list, and optionally a parallel one, to hold needed items */
+static bool reserve(void** array, void** parallel, size_t parallel_item,
+                    int* capacity, int needed, size_t item) {
+    if (needed <= *capacity) return true;
+    int cap = *capacity < 64 ? 64 : *capacity;
+    while (cap < needed) cap *= 2;
+    if (!grow(array, (size_t)cap, item)) return false;
+    if (parallel && !grow(parallel, (size_t)cap, parallel_item)) return false;
+    *capacity = cap;
+    return true;
+}
+
+/* Arrays are allocated on first use even for zero atoms or bonds */
+static bool context_reserve(RingContext* ctx, int atoms, int bonds) {
+    if (atoms > ctx->capacity || ctx->capacity == 0) {
+        int cap = ctx->capacity < 64 ? 64 : ctx->capacity;
+        while (cap < atoms) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->disc, n, sizeof(int)) ||
+            !grow((void**)&ctx->low, n, sizeof(int)) ||
+            !grow((void**)&ctx->frames, 3 * n, sizeof(int)) ||
+            !grow((void**)&ctx->local, n, sizeof(int)) ||
+            !grow((void**)&ctx->atoms, n, sizeof(int)) ||
+            !grow((void**)&ctx->offsets, n, sizeof(int)) ||
+            !grow((void**)&ctx->dist, n, sizeof(int)) ||
+            !grow((void**)&ctx->parent, n, sizeof(int)) ||
+            !grow((void**)&ctx->parent_edge, n, sizeof(int)) ||
+            !grow((void**)&ctx->queue, n, sizeof(int))) {
+            return false;
+        }
+        ctx->capacity = cap;
+    }
+    if (bonds > ctx->edge_capacity || ctx->edge_capacity == 0) {
+        int cap = ctx->edge_capacity < 64 ? 64 : ctx->edge_capacity;
+        while (cap < bonds) cap *= 2;
+        size_t n = (size_t)cap + 1;
+        if (!grow((void**)&ctx->edge_stack, n, sizeof(int)) ||
+            !grow((void**)&ctx->components, n, sizeof(int)) ||
+            !grow((void**)&ctx->component_offsets, n, sizeof(int)) ||
+            !grow((void**)&ctx->neighbors, 2 * n, sizeof(int)) ||
+            !grow((void**)&ctx->edges, 2 * n, sizeof(int)) ||
+            !grow((void**)&ctx->bonds, n, sizeof(int)) ||
+            !grow((void**)&ctx->pivots, n, sizeof(int)) ||
+            !grow((void**)&ctx->row_spans, 3 * n, sizeof(int)) ||
+            !grow((void**)&ctx->row, n / 64 + 1, sizeof(uint64_t))) {
+            return false;
+        }
+        ctx->edge_capacity = cap;
+    }
+    return true;
+}
+
+/* ============ Biconnected Components ============ */
+
+/*
+ * Iterative Tarjan: bonds are stacked as they are explored, and when a
+ * child's low point does not reach above its parent, the bonds down to
+ * the tree bond form one component. Single-bond components are bridges
+ * and are dropped. Returns the number of ring systems.
+ */
+static int find_ring_systems(RingContext* ctx, const Molecule* mol) {
+    int n = mol->atom_count;
+    const int* adj_offsets = mol->adjacency_offsets;
+    memset(ctx->disc, 0, (size_t)n * sizeof(int));
+
+    int time = 0;
+    int systems = 0;
+    int written = 0;
+    int stacked = 0;
+    ctx->component_offsets[0] = 0;
+
+    for (int root = 0; root < n; root++) {
+        if (ctx->disc[root]) continue;
+        ctx->disc[root] = ctx->low[root] = ++time;
+        ctx->frames[0] = root;
+        ctx->frames[1] = adj_offsets[root];
+        ctx->frames[2] = -1;
+        int depth = 1;
+
+        while (depth > 0) {
+            int* frame = &ctx->frames[3 * (depth - 1)];
+            int v = frame[0];
+
+            if (frame[1] < adj_offsets[v + 1]) {
+                int entry = frame[1]++;
+                int w = mol->adjacency[entry];
+                int bond = mol->adjacency_bonds[entry];
+                if (bond == frame[2]) continue;
+
+                if (!ctx->disc[w]) {
+                    ctx->edge_stack[stacked++] = bond;
+                    ctx->disc[w] = ctx->low[w] = ++time;
+                    int* child = &ctx->frames[3 * depth++];
+                    child[0] = w;
+                    child[1] = adj_offsets[w];
+                    child[2] = bond;
+                } else if (ctx->disc[w] < ctx->disc[v]) {
+                    /* Back edge to an ancestor */
+                    ctx->edge_stack[stacked++] = bond;
+                    if (ctx->disc[w] < ctx->low[v]) ctx->low[v] = ctx->disc[w];
+                }
+                continue;
+            }
+
+            int tree_bond = frame[2];
+            depth--;
+            if (depth == 0) break;
+
+            int u = ctx->frames[3 * (depth - 1)];
+            if (ctx->low[v] < ctx->low[u]) ctx->low[u] = ctx->low[v];
+            if (ctx->low[v] >= ctx->disc[u]) {
+                int start = written;
+                int bond;
+                do {
+                    bond = ctx->edge_stack[--stacked];
+                    ctx->components[written++] = bond;
+                } while (bond != tree_bond);
+
+                if (written - start > 1) {
+                    ctx->component_offsets[++systems] = written;
+                } else {
+                    written = start;
+                }
+            }
+        }
+    }
+    return systems;
+}
+
+/* ============ Candidate Rings ============ */
+
+/* Whether two same-depth search paths first meet at the root */
+static bool paths_disjoint(const RingContext* ctx, int a, int b, int root) {
+    while (a != b) {
+        a = ctx->parent[a];
+        b = ctx->parent[b];
+    }
+    return a == root;
+}
+
+/*
+ * Record the cycle root .. a [- z] - b .. root. closing is the edge from
+ * a to z (or to b when z < 0), closing2 the edge from z to b.
+ */
+static bool add_candidate(RingContext* ctx, int root, int a, int z, int b,
+                          int closing, int closing2) {
+    int length = 2 * ctx->dist[a] + (z >= 0 ? 2 : 1);
+    int c = ctx->candidate_count;
+    if (!reserve((void**)&ctx->candidate_offsets, (void**)&ctx->sorted, sizeof(long long),
+                 &ctx->candidate_capacity, c + 2, sizeof(int))) {
+        return false;
+    }
+    int start = ctx->candidate_offsets[c];
+    if (!reserve((void**)&ctx->path_atoms, (void**)&ctx->path_edges, sizeof(int),
+                 &ctx->path_capacity, start + length, sizeof(int))) {
+        return false;
+    }
+
+    int* atoms = ctx->path_atoms + start;
+    int* edges = ctx->path_edges + start;
+    atoms[0] = root;
+
+    /* Down to a: edge i joins atoms i and i + 1 */
+    int pos = ctx->dist[a];
+    for (int v = a, i = pos; i >= 1; i--) {
+        atoms[i] = v;
+        edges[i - 1] = ctx->parent_edge[v];
+        v = ctx->parent[v];
+    }
+    edges[pos] = closing;
+    if (z >= 0) {
+        atoms[++pos] = z;
+        edges[pos] = closing2;
+    }
+    /* Back up from b */
+    for (int v = b; v != root; v = ctx->parent[v]) {
+        atoms[++pos] = v;
+        edges[pos] = ctx->parent_edge[v];
+    }
+
+    ctx->sorted[c] = ((long long)length << 32) | c;
+    ctx->candidate_offsets[c + 1] = start + length;
+    ctx->candidate_count = c + 1;
+    return true;
+}
+
+/*
+ * Prototypes rooted at root with lengths in (shortest, longest]: search
+ * atoms ordered before root out to max_depth, then close odd cycles over
+ * edges between equally distant atoms and even cycles at atoms with two
+ * neighbors one step closer.
+ */
+static bool root_candidates(RingContext* ctx, int root, int max_depth, int shortest, int longest) {
+    int head = 0, tail = 0;
+    ctx->dist[root] = 0;
+    ctx->parent[root] = -1;
+    ctx->queue[tail++] = root;
+
+    while (head < tail) {
+        int v = ctx->queue[head++];
+        if (ctx->dist[v] >= max_depth) continue;
+        for (int j = ctx->offsets[v]; j < ctx->offsets[v + 1]; j++) {
+            int w = ctx->neighbors[j];
+            if (w > root || ctx->dist[w] >= 0) continue;
+            ctx->dist[w] = ctx->dist[v] + 1;
+            ctx->parent[w] = v;
+            ctx->parent_edge[w] = ctx->edges[j];
+            ctx->queue[tail++] = w;
+        }
+    }
+
+    bool ok = true;
+    for (int q = 1; q < tail && ok; q++) {
+        int z = ctx->queue[q];
+        int d = ctx->dist[z];
+        bool odd = 2 * d + 1 > shortest && 2 * d + 1 <= longest;
+        bool even = 2 * d > shortest && 2 * d <= longest;
+        if (!odd && !even) continue;
+
+        for (int j = ctx->offsets[z]; j < ctx->offsets[z + 1] && ok; j++) {
+            int y = ctx->neighbors[j];
+            if (y > root || ctx->dist[y] < 0) continue;
+
+            if (odd && ctx->dist[y] == d && y < z && paths_disjoint(ctx, y, z, root)) {
+                ok = add_candidate(ctx, root, y, -1, z, ctx->edges[j], -1);
+            }
+            if (even && ctx->dist[y] == d - 1) {
+                for (int k = j + 1; k < ctx->offsets[z + 1] && ok; k++) {
+                    int x = ctx->neighbors[k];
+                    if (x > root || ctx->dist[x] != d - 1) continue;
+                    if (paths_disjoint(ctx, y, x, root)) {
+                        ok = add_candidate(ctx, root, y, z, x, ctx->edges[j], ctx->edges[k]);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int q = 0; q < tail; q++) ctx->dist[ctx->queue[q]] = -1;
+    return ok;
+}
+
+static int compare_keys(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* ============ Ring Selection ============ */
+
+static int lowest_bit(uint64_t word) {
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+}
+
+/*
+ * Reduce a candidate against the basis. Rows keep distinct lowest bits,
+ * so each step clears the current lowest bit, and each row stores only
+ * its span of non-zero words (rings are local, so spans stay short).
+ * Returns the new row index, -1 if dependent, -2 on allocation failure.
+ */
+static int add_to_basis(RingContext* ctx, int candidate, int* rank) {
+    uint64_t* row = ctx->row;
+    int lo = INT_MAX, hi = -1;
+    for (int i = ctx->candidate_offsets[candidate]; i < ctx->candidate_offsets[candidate + 1]; i++) {
+        int e = ctx->path_edges[i];
+        row[e >> 6] ^= 1ULL << (e & 63);
+        if ((e >> 6) < lo) lo = e >> 6;
+        if ((e >> 6) > hi) hi = e >> 6;
+    }
+
+    int w = lo;
+    int pivot;
+    for (;;) {
+        while (w <= hi && row[w] == 0) w++;
+        if (w > hi) return -1;          /* Row is all zero again */
+
+        pivot = ctx->pivots[w * 64 + lowest_bit(row[w])];
+        if (pivot < 0) break;
+        const int* span = &ctx->row_spans[3 * pivot];
+        const uint64_t* basis = ctx->basis + span[0];
+        for (int k = 0; k < span[2]; k++) row[span[1] + k] ^= basis[k];
+        if (span[1] + span[2] - 1 > hi) hi = span[1] + span[2] - 1;
+    }
+
+    while (row[hi] == 0) hi--;
+    int count = hi - w + 1;
+    int offset = ctx->basis_used;
+    if (!reserve((void**)&ctx->basis, NULL, 0, &ctx->basis_capacity, offset + count,
+                 sizeof(uint64_t))) {
+        memset(row + w, 0, (size_t)count * sizeof(uint64_t));
+        return -2;
+    }
+    memcpy(ctx->basis + offset, row + w, (size_t)count * sizeof(uint64_t));
+    ctx->basis_used = offset + count;
+
+    int r = (*rank)++;
+    ctx->row_spans[3 * r] = offset;
+    ctx->row_spans[3 * r + 1] = w;
+    ctx->row_spans[3 * r + 2] = count;
+    ctx->pivots[w * 64 + lowest_bit(row[w])] = r;
+    memset(row + w, 0, (size_t)count * sizeof(uint64_t));
+    return r;
+}
+
+static bool emit_ring(RingContext* ctx, int candidate) {
+    int begin = ctx->candidate_offsets[candidate];
+    int length = ctx->candidate_offsets[candidate + 1] - begin;
+    int r = ctx->ring_count;
+    int start = r > 0 ? ctx->ring_offsets[r] : 0;
+
+    if (!reserve((void**)&ctx->ring_offsets, NULL, 0, &ctx->ring_capacity, r + 2, sizeof(int)) ||
+        !reserve((void**)&ctx->ring_atoms, (void**)&ctx->ring_bonds, sizeof(int),
+                 &ctx->ring_atom_capacity, start + length, sizeof(int))) {
+        return false;
+    }
+    ctx->ring_offsets[r] = start;
+
+    for (int i = 0; i < length; i++) {
+        ctx->ring_atoms[start + i] = ctx->atoms[ctx->path_atoms[begin + i]];
+        ctx->ring_bonds[start + i] = ctx->bonds[ctx->path_edges[begin + i]];
+    }
+    ctx->ring_offsets[r + 1] = start + length;
+    ctx->ring_count = r + 1;
+    return true;
+}
+
+/* SSSR of one ring system given by its bonds */
+static bool system_rings(RingContext* ctx, const Molecule* mol, const int* bonds, int edge_count) {
+    /* Number the system's atoms and build its adjacency */
+    int n = 0;
+    for (int e = 0; e < edge_count; e++) {
+        const Bond* bond = &mol->bonds[bonds[e]];
+        int ends[2] = {bond->atom1_id, bond->atom2_id};
+        for (int k = 0; k < 2; k++) {
+            if (ctx->local[ends[k]] < 0) {
+                ctx->local[ends[k]] = n;
+                ctx->atoms[n++] = ends[k];
+            }
+        }
+        ctx->bonds[e] = bonds[e];
+    }
+
+    memset(ctx->offsets, 0, (size_t)(n + 1) * sizeof(int));
+    for (int e = 0; e < edge_count; e++) {
+        const Bond* bond = &mol->bonds[bonds[e]];
+        ctx->offsets[ctx->local[bond->atom1_id] + 1]++;
+        ctx->offsets[ctx->local[bond->atom2_id] + 1]++;
+    }
+    for (int i = 0; i < n; i++) ctx->offsets[i + 1] += ctx->offsets[i];
+    for (int e = 0; e < edge_count; e++) {
+        const Bond* bond = &mol->bonds[bonds[e]];
+        int a = ctx->local[bond->atom1_id], b = ctx->local[bond->atom2_id];
+        ctx->neighbors[ctx->offsets[a]] = b;
+        ctx->edges[ctx->offsets[a]++] = e;
+        ctx->neighbors[ctx->offsets[b]] = a;
+        ctx->edges[ctx->offsets[b]++] = e;
+    }
+    for (int i = n; i > 0; i--) ctx->offsets[i] = ctx->offsets[i - 1];
+    ctx->offsets[0] = 0;
+
+    for (int i = 0; i < n; i++) ctx->dist[i] = -1;
+    for (int e = 0; e < edge_count; e++) ctx->pivots[e] = -1;
+
+    int needed = edge_count - n + 1;
+    int words = (edge_count + 63) / 64;
+    memset(ctx->row, 0, (size_t)words * sizeof(uint64_t));
+    ctx->basis_used = 0;
+    int rank = 0;
+    bool ok = true;
+
+    /* Deepen the searches until the basis is complete */
+    int shortest = 2;
+    for (int depth = RING_FIRST_DEPTH; ok && rank < needed; depth *= 2) {
+        bool complete = depth >= n;
+        int longest = complete ? INT_MAX : 2 * depth + 1;
+
+        ctx->candidate_count = 0;
+        if (!reserve((void**)&ctx->candidate_offsets, (void**)&ctx->sorted, sizeof(long long),
+                     &ctx->candidate_capacity, 1, sizeof(int))) {
+            ok = false;
+            break;
+        }
+        ctx->candidate_offsets[0] = 0;
+        for (int root = 0; root < n && ok; root++) {
+            ok = root_candidates(ctx, root, complete ? n : depth, shortest, longest);
+        }
+        if (!ok) break;
+
+        qsort(ctx->sorted, (size_t)ctx->candidate_count, sizeof(long long), compare_keys);
+        for (int i = 0; i < ctx->candidate_count && rank < needed; i++) {
+            int candidate = (int)(ctx->sorted[i] & 0xFFFFFFFF);
+            int added = add_to_basis(ctx, candidate, &rank);
+            if (added == -2 || (added >= 0 && !emit_ring(ctx, candidate))) ok = false;
+            if (!ok) break;
+        }
+        if (complete) break;
+        shortest = longest;
+    }
+
+    for (int i = 0; i < n; i++) ctx->local[ctx->atoms[i]] = -1;
+    return ok;
+}
+
+/* ============ Perception ============ */
+
+/* Copy the rings into the molecule's cache */
+static bool store_rings(const RingContext* ctx, Molecule* mol) {
+    int count = ctx->ring_count;
+    int total = count > 0 ? ctx->ring_offsets[count] : 0;
+
+    int* offsets = molecule_storage_resize(mol, mol->ring_offsets, 0, (size_t)(count + 1) * sizeof(int));
+    if (!offsets) return false;
+    mol->ring_offsets = offsets;
+    int* atoms = molecule_storage_resize(mol, mol->ring_atoms, 0, (size_t)(total + 1) * sizeof(int));
+    if (!atoms) return false;
+    mol->ring_atoms = atoms;
+    int* bonds = molecule_storage_resize(mol, mol->ring_bonds, 0, (size_t)(total + 1) * sizeof(int));
+    if (!bonds) return false;
+    mol->ring_bonds = bonds;
+    int* counts = molecule_storage_resize(mol, mol->atom_ring_counts, 0,
+                                          (size_t)(mol->atom_count + 1) * sizeof(int));
+    if (!counts) return false;
+    mol->atom_ring_counts = counts;
+
+    offsets[0] = 0;
+    if (count > 0) {
+        memcpy(offsets, ctx->ring_offsets, (size_t)(count + 1) * sizeof(int));
+        memcpy(atoms, ctx->ring_atoms, (size_t)total * sizeof(int));
+        memcpy(bonds, ctx->ring_bonds, (size_t)total * sizeof(int));
+    }
+    memset(counts, 0, (size_t)mol->atom_count * sizeof(int));
+    for (int i = 0; i < total; i++) counts[atoms[i]]++;
+
+    mol->ring_count = count;
+    mol->rings_valid = true;
+    return true;
+}
+
+bool ring_find(RingContext* ctx, const Molecule* mol) {
+    if (!ctx || !mol || !mol->adjacency_valid) return false;
+
+    int n = mol->atom_count;
+    if (!context_reserve(ctx, n, mol->bond_count)) return false;
+    for (int i = 0; i < n; i++) ctx->local[i] = -1;
+
+    ctx->ring_count = 0;
+    int systems = find_ring_systems(ctx, mol);
+    for (int s = 0; s < systems; s++) {
+        int begin = ctx->component_offsets[s];
+        int end = ctx->component_offsets[s + 1];
+        if (!system_rings(ctx, mol, ctx->components + begin, end - begin)) return false;
+    }
+    return true;
+}
+
+bool ring_perceive(RingContext* ctx, Molecule* mol) {
+    if (!ctx || !mol) return false;
+    if (mol->rings_valid) return true;
+    if (!molecule_build_adjacency(mol)) return false;
+    return ring_find(ctx, mol) && store_rings(ctx, mol);
+}
+
+bool molecule_perceive_rings(Molecule* mol) {
+    RingContext ctx;
+    ring_context_init(&ctx);
+    bool ok = ring_perceive(&ctx, mol);
+    ring_context_free(&ctx);
+    return ok;
+}
+
+/* ============ Queries ============ */
+
+int molecule_ring_count(const Molecule* mol) {
+    return mol && mol->rings_valid ? mol->ring_count : -1;
+}
+
+int molecule_ring(const Molecule* mol, int ring, const int** atoms, const int** bonds) {
+    if (!mol || !mol->rings_valid || ring < 0 || ring >= mol->ring_count) return -1;
+    int begin = mol->ring_offsets[ring];
+    if (atoms) *atoms = mol->ring_atoms + begin;
+    if (bonds) *bonds = mol->ring_bonds + begin;
+    return mol->ring_offsets[ring + 1] - begin;
+}
+
+int molecule_atom_ring_count(const Molecule* mol, int atom_id) {
+    if (!mol || !mol->rings_valid || atom_id < 0 || atom_id >= mol->atom_count) return -1;
+    return mol->atom_ring_counts[atom_id];
+}
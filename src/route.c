@@ -0,0 +1,844 @@
+#include "route.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ROUTE_MAX_NODES (2 * ROUTE_MAX_STEPS + 2)
+
+/* ============ Graph Construction ============ */
+
+typedef int (*PostingsFn)(int species_id, const int** reactions);
+
+/* Copy species postings lists into one CSR block */
+static bool csr_from_postings(int species_count, PostingsFn postings,
+                              int** offsets_out, int** edges_out) {
+    int* offsets = malloc(((size_t)species_count + 1) * sizeof(int));
+    if (!offsets) return false;
+
+    offsets[0] = 0;
+    for (int s = 0; s < species_count; s++) {
+        offsets[s + 1] = offsets[s] + postings(s, NULL);
+    }
+
+    int* edges = malloc((size_t)(offsets[species_count] > 0 ? offsets[species_count] : 1) * sizeof(int));
+    if (!edges) {
+        free(offsets);
+        return false;
+    }
+    for (int s = 0; s < species_count; s++) {
+        const int* list;
+        int n = postings(s, &list);
+        if (n > 0) memcpy(&edges[offsets[s]], list, (size_t)n * sizeof(int));
+    }
+
+    *offsets_out = offsets;
+    *edges_out = edges;
+    return true;
+}
+
+/* Build reaction -> species CSR from the species ids stored on each reaction */
+static bool csr_from_reactions(int reaction_count, bool reactant_side,
+                               int** offsets_out, int** edges_out) {
+    int* offsets = malloc(((size_t)reaction_count + 1) * sizeof(int));
+    int* edges = malloc(((size_t)reaction_count * (MAX_REACTANTS + MAX_PRODUCTS) + 1) * sizeof(int));
+    if (!offsets || !edges) {
+        free(offsets);
+        free(edges);
+        return false;
+    }
+
+    int count = 0;
+    for (int r = 0; r < reaction_count; r++) {
+        const Reaction* rxn = reaction_db_get(r);
+        const int* ids = !rxn ? NULL : reactant_side ? rxn->reactant_species : rxn->product_species;
+        int n = !rxn ? 0 : reactant_side ? rxn->reactant_count : rxn->product_count;
+
+        offsets[r] = count;
+        for (int i = 0; i < n; i++) {
+            bool repeated = ids[i] < 0;
+            for (int j = offsets[r]; j < count && !repeated; j++) {
+                if (edges[j] == ids[i]) repeated = true;
+            }
+            if (!repeated) edges[count++] = ids[i];
+        }
+    }
+    offsets[reaction_count] = count;
+
+    *offsets_out = offsets;
+    *edges_out = edges;
+    return true;
+}
+
+bool route_graph_build(RouteGraph* graph) {
+    if (!graph) return false;
+    memset(graph, 0, sizeof(RouteGraph));
+
+    /* One snapshot, so postings and reaction rows agree */
+    reaction_db_read_begin();
+    graph->species_count = reaction_db_species_count();
+    graph->reaction_count = reaction_db_count();
+
+    bool ok = true;
+    if (!csr_from_postings(graph->species_count, reaction_db_species_consumers,
+                           &graph->consumer_offsets, &graph->consumers) ||
+        !csr_from_postings(graph->species_count, reaction_db_species_producers,
+                           &graph->producer_offsets, &graph->producers) ||
+        !csr_from_reactions(graph->reaction_count, false,
+                            &graph->product_offsets, &graph->products) ||
+        !csr_from_reactions(graph->reaction_count, true,
+                            &graph->reactant_offsets, &graph->reactants)) {
+        route_graph_free(graph);
+        ok = false;
+    }
+    reaction_db_read_end();
+    return ok;
+}
+
+void route_graph_free(RouteGraph* graph) {
+    if (!graph) return;
+    free(graph->consumer_offsets);
+    free(graph->consumers);
+    free(graph->product_offsets);
+    free(graph->products);
+    free(graph->producer_offsets);
+    free(graph->producers);
+    free(graph->reactant_offsets);
+    free(graph->reactants);
+    memset(graph, 0, sizeof(RouteGraph));
+}
+
+/* ============ Costs ============ */
+
+void route_options_default(RouteOptions* options) {
+    if (!options) return;
+    options->max_steps = 8;
+    options->cost = route_cost_by_condition;
+    options->user_data = NULL;
+    options->use_heuristic = true;
+}
+
+double route_cost_by_condition(const Reaction* rxn, void* user_data) {
+    static const double default_penalty[ROUTE_CONDITION_COUNT] = {
+        0.0,    /* COND_NORMAL */
+        0.5,    /* COND_HEATED */
+        2.0,    /* COND_HIGH_PRESSURE */
+        1.0,    /* COND_CATALYST */
+        1.0,    /* COND_LIGHT */
+        3.0     /* COND_ELECTROLYSIS */
+    };
+    const double* penalty = user_data ? (const double*)user_data : default_penalty;
+
+    if (!rxn) return 1.0;
+    if ((int)rxn->condition < 0 || (int)rxn->condition >= ROUTE_CONDITION_COUNT) return 1.0;
+    return 1.0 + penalty[rxn->condition];
+}
+
+/* ============ Query Setup ============ */
+/*
+ * Node numbering: species s is node s, reaction r is node S + r, and a
+ * virtual source feeding every start species is node S + R.
+ */
+
+typedef struct {
+    double f;               /* Priority (cost so far + heuristic) */
+    double g;               /* Cost so far */
+    int state;
+} HeapItem;
+
+typedef struct {
+    HeapItem* items;
+    int size;
+    int capacity;
+} Heap;
+
+static bool heap_push(Heap* heap, double f, double g, int state) {
+    if (heap->size == heap->capacity) {
+        int capacity = heap->capacity ? heap->capacity * 2 : 256;
+        HeapItem* items = realloc(heap->items, (size_t)capacity * sizeof(HeapItem));
+        if (!items) return false;
+        heap->items = items;
+        heap->capacity = capacity;
+    }
+
+    int i = heap->size++;
+    while (i > 0) {
+        int up = (i - 1) / 2;
+        if (heap->items[up].f <= f) break;
+        heap->items[i] = heap->items[up];
+        i = up;
+    }
+    heap->items[i].f = f;
+    heap->items[i].g = g;
+    heap->items[i].state = state;
+    return true;
+}
+
+static HeapItem heap_pop(Heap* heap) {
+    HeapItem top = heap->items[0];
+    HeapItem last = heap->items[--heap->size];
+
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->size) break;
+        if (child + 1 < heap->size && heap->items[child + 1].f < heap->items[child].f) child++;
+        if (heap->items[child].f >= last.f) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->size > 0) heap->items[i] = last;
+    return top;
+}
+
+typedef struct {
+    const RouteGraph* g;
+    int source;
+    int target;
+    int node_count;
+    bool* start;            /* Per species */
+    bool* feasible;         /* Per reaction: all reactants obtainable without the target */
+    double* rcost;          /* Per reaction cost of running it once */
+
+    /* Cheapest way to obtain each species from the start set on its own */
+    double* sub_cost;       /* INFINITY if unobtainable */
+    int* sub_steps;
+    int* sub_reaction;      /* Reaction making it (-1 for start species) */
+} RouteQuery;
+
+static void query_free(RouteQuery* q) {
+    free(q->start);
+    free(q->feasible);
+    free(q->rcost);
+    free(q->sub_cost);
+    free(q->sub_steps);
+    free(q->sub_reaction);
+}
+
+/*
+ * Cheapest sub-route to every species (Knuth's generalization of
+ * Dijkstra to AND/OR graphs): a reaction fires once all its reactants are
+ * settled, and costs its own cost plus the sub-route costs of all of its
+ * reactants. The target is settled but never fed forward, so nothing that
+ * needs the target counts as obtainable. Shared intermediates are counted
+ * once per use, as a route that needs them twice must make them twice.
+ */
+static bool settle_species(RouteQuery* q) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+    int R = g->reaction_count;
+
+    int* missing = malloc(((size_t)R + 1) * sizeof(int));
+    double* input_cost = calloc((size_t)R + 1, sizeof(double));
+    int* input_steps = calloc((size_t)R + 1, sizeof(int));
+    bool* settled = calloc((size_t)S + 1, sizeof(bool));
+    Heap heap = {0};
+    bool ok = missing && input_cost && input_steps && settled;
+
+    for (int r = 0; ok && r < R; r++) {
+        missing[r] = g->reactant_offsets[r + 1] - g->reactant_offsets[r];
+    }
+    for (int s = 0; ok && s < S; s++) {
+        if (q->start[s]) ok = heap_push(&heap, 0.0, 0.0, s);
+    }
+
+    while (ok && heap.size > 0) {
+        HeapItem item = heap_pop(&heap);
+        int s = item.state;
+        if (settled[s] || item.g > q->sub_cost[s]) continue;
+        settled[s] = true;
+        if (s == q->target) continue;
+
+        for (int e = g->consumer_offsets[s]; e < g->consumer_offsets[s + 1]; e++) {
+            int r = g->consumers[e];
+            input_cost[r] += q->sub_cost[s];
+            input_steps[r] += q->sub_steps[s];
+            if (--missing[r] != 0 || q->rcost[r] == INFINITY) continue;
+
+            q->feasible[r] = true;
+            double cost = q->rcost[r] + input_cost[r];
+            int steps = 1 + input_steps[r];
+            for (int p = g->product_offsets[r]; p < g->product_offsets[r + 1]; p++) {
+                int prod = g->products[p];
+                if (settled[prod] || cost > q->sub_cost[prod] ||
+                    (cost == q->sub_cost[prod] && steps >= q->sub_steps[prod])) {
+                    continue;
+                }
+                q->sub_cost[prod] = cost;
+                q->sub_steps[prod] = steps;
+                q->sub_reaction[prod] = r;
+                if (!heap_push(&heap, cost, cost, prod)) ok = false;
+            }
+        }
+    }
+
+    free(heap.items);
+    free(missing);
+    free(input_cost);
+    free(input_steps);
+    free(settled);
+    return ok;
+}
+
+/*
+ * Resolve start/target species, price every reaction (cost NULL: one per
+ * step) and find which reactions can ever fire, with the cheapest
+ * sub-route to each species.
+ */
+static bool query_init(RouteQuery* q, const RouteGraph* g,
+                       const Formula* start, int start_count, const Formula* target,
+                       RouteCostFn cost, void* user_data) {
+    memset(q, 0, sizeof(RouteQuery));
+    if (!g || !start || !target || start_count <= 0) return false;
+
+    int S = g->species_count;
+    int R = g->reaction_count;
+    q->g = g;
+    q->source = S + R;
+    q->node_count = S + R + 1;
+    q->target = reaction_db_species_find(target);
+    if (q->target < 0 || q->target >= S) return false;
+
+    q->start = calloc((size_t)S + 1, sizeof(bool));
+    q->feasible = calloc((size_t)R + 1, sizeof(bool));
+    q->rcost = malloc(((size_t)R + 1) * sizeof(double));
+    q->sub_cost = malloc(((size_t)S + 1) * sizeof(double));
+    q->sub_steps = calloc((size_t)S + 1, sizeof(int));
+    q->sub_reaction = malloc(((size_t)S + 1) * sizeof(int));
+    if (!q->start || !q->feasible || !q->rcost || !q->sub_cost || !q->sub_steps || !q->sub_reaction) {
+        query_free(q);
+        return false;
+    }
+
+    for (int r = 0; r < R; r++) {
+        /* A reaction removed since the graph was built is never taken */
+        const Reaction* rxn = reaction_db_get(r);
+        double c = !rxn ? INFINITY : cost ? cost(rxn, user_data) : 1.0;
+        q->rcost[r] = c >= 0.0 ? c : 0.0;
+    }
+
+    bool any_start = false;
+    for (int s = 0; s < S; s++) {
+        q->sub_cost[s] = INFINITY;
+        q->sub_reaction[s] = -1;
+    }
+    for (int i = 0; i < start_count; i++) {
+        int s = reaction_db_species_find(&start[i]);
+        if (s < 0 || s >= S) continue;
+        q->start[s] = true;
+        q->sub_cost[s] = 0.0;
+        any_start = true;
+    }
+
+    if (!any_start || !settle_species(q)) {
+        query_free(q);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Cost and steps of running reaction r when carrier (one of its reactants)
+ * comes from the chain: every other reactant is made by its own sub-route.
+ */
+static double step_cost(const RouteQuery* q, int carrier, int r, int* steps) {
+    const RouteGraph* g = q->g;
+    double cost = q->rcost[r];
+    int n = 1;
+    for (int e = g->reactant_offsets[r]; e < g->reactant_offsets[r + 1]; e++) {
+        int s = g->reactants[e];
+        if (s == carrier) continue;
+        cost += q->sub_cost[s];
+        n += q->sub_steps[s];
+    }
+    if (steps) *steps = n;
+    return cost;
+}
+
+/* Append the sub-route making s, inputs first (false if it does not fit) */
+static bool emit_subroute(const RouteQuery* q, int s, Route* route) {
+    const RouteGraph* g = q->g;
+    int r = q->sub_reaction[s];
+    if (r < 0 || q->start[s]) return true;
+
+    for (int e = g->reactant_offsets[r]; e < g->reactant_offsets[r + 1]; e++) {
+        if (!emit_subroute(q, g->reactants[e], route)) return false;
+    }
+    if (route->steps == ROUTE_MAX_STEPS) return false;
+    route->reactions[route->steps] = r;
+    route->species[route->steps++] = s;
+    return true;
+}
+
+/* Forward adjacency restricted to feasible reactions (returns neighbor count) */
+static int forward_neighbors(const RouteQuery* q, int node, int* out) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+    int n = 0;
+
+    if (node == q->source) {
+        for (int s = 0; s < S; s++) {
+            if (q->start[s]) out[n++] = s;
+        }
+    } else if (node < S) {
+        for (int e = g->consumer_offsets[node]; e < g->consumer_offsets[node + 1]; e++) {
+            int r = g->consumers[e];
+            if (q->feasible[r]) out[n++] = S + r;
+        }
+    } else {
+        int r = node - S;
+        for (int e = g->product_offsets[r]; e < g->product_offsets[r + 1]; e++) {
+            out[n++] = g->products[e];
+        }
+    }
+    return n;
+}
+
+/* Backward adjacency restricted to feasible reactions (source excluded) */
+static int backward_neighbors(const RouteQuery* q, int node, int* out) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+    int n = 0;
+
+    if (node == q->source) return 0;
+    if (node < S) {
+        for (int e = g->producer_offsets[node]; e < g->producer_offsets[node + 1]; e++) {
+            int r = g->producers[e];
+            if (q->feasible[r]) out[n++] = S + r;
+        }
+    } else {
+        int r = node - S;
+        for (int e = g->reactant_offsets[r]; e < g->reactant_offsets[r + 1]; e++) {
+            out[n++] = g->reactants[e];
+        }
+    }
+    return n;
+}
+
+/* Largest adjacency list, used to size neighbor scratch buffers */
+static int max_degree(const RouteQuery* q) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+    int R = g->reaction_count;
+    int best = S;   /* source fan-out */
+
+    for (int s = 0; s < S; s++) {
+        int d1 = g->consumer_offsets[s + 1] - g->consumer_offsets[s];
+        int d2 = g->producer_offsets[s + 1] - g->producer_offsets[s];
+        if (d1 > best) best = d1;
+        if (d2 > best) best = d2;
+    }
+    for (int r = 0; r < R; r++) {
+        int d1 = g->product_offsets[r + 1] - g->product_offsets[r];
+        int d2 = g->reactant_offsets[r + 1] - g->reactant_offsets[r];
+        if (d1 > best) best = d1;
+        if (d2 > best) best = d2;
+    }
+    return best > 0 ? best : 1;
+}
+
+/*
+ * Convert a node path [source, s0, r0, s1, ..., target] into a Route: each
+ * chain reaction is preceded by the sub-routes of its other reactants.
+ */
+static bool nodes_to_route(const RouteQuery* q, const int* nodes, int length, Route* route) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+
+    memset(route, 0, sizeof(Route));
+    for (int i = 2; i + 1 < length; i += 2) {
+        int carrier = nodes[i - 1];
+        int r = nodes[i] - S;
+        for (int e = g->reactant_offsets[r]; e < g->reactant_offsets[r + 1]; e++) {
+            int s = g->reactants[e];
+            if (s != carrier && !emit_subroute(q, s, route)) return false;
+        }
+        if (route->steps == ROUTE_MAX_STEPS) return false;
+        route->reactions[route->steps] = r;
+        route->species[route->steps++] = nodes[i + 1];
+    }
+    return true;
+}
+
+/* ============ Fewest Steps ============ */
+
+bool route_find_shortest(const RouteGraph* graph,
+                         const Formula* start, int start_count,
+                         const Formula* target, int max_steps, Route* route) {
+    if (!route) return false;
+    if (max_steps > ROUTE_MAX_STEPS) max_steps = ROUTE_MAX_STEPS;
+    if (max_steps < 0) return false;
+
+    /* With unit costs the cheapest sub-route of the target is the shortest */
+    RouteQuery q;
+    if (!query_init(&q, graph, start, start_count, target, NULL, NULL)) return false;
+
+    bool found = q.sub_cost[q.target] != INFINITY && q.sub_steps[q.target] <= max_steps;
+    if (found) {
+        memset(route, 0, sizeof(Route));
+        found = emit_subroute(&q, q.target, route);
+        route->cost = route->steps;
+    }
+    query_free(&q);
+    return found;
+}
+
+/* ============ A* / Dijkstra with Yen's k-shortest routes ============ */
+
+typedef struct {
+    int nodes[ROUTE_MAX_NODES];
+    int length;
+    double cost;
+} NodePath;
+
+typedef struct {
+    const RouteQuery* q;
+    int layers;             /* max_steps + 1: steps used so far in [0, max_steps] */
+    double min_cost;        /* Lower bound on the cost of any chain step */
+    int* to_target;         /* Reverse BFS distance (edges) to target, -1 unreachable */
+    bool use_heuristic;
+
+    double* dist;           /* Per (node, steps) state */
+    int* parent;
+    int* stamp;
+    int current_stamp;
+
+    Heap heap;
+
+    bool* banned;           /* Per node */
+    int* neighbors;
+} SearchSpace;
+
+static double heuristic(const SearchSpace* ws, int node) {
+    if (!ws->use_heuristic) return 0.0;
+    return (ws->to_target[node] / 2) * ws->min_cost;
+}
+
+/*
+ * Cheapest path from spur (reached after spur_hops steps) to the target,
+ * avoiding banned nodes and the banned first hops out of spur. States are
+ * (node, steps used, sub-routes included) so the step limit is enforced
+ * exactly.
+ */
+static bool spur_search(SearchSpace* ws, int spur, int spur_hops,
+                        const int* banned_next, int banned_next_count, NodePath* out) {
+    const RouteQuery* q = ws->q;
+    int S = q->g->species_count;
+    int L = ws->layers - 1;
+
+    if (++ws->current_stamp == 0) {
+        memset(ws->stamp, 0, (size_t)q->node_count * ws->layers * sizeof(int));
+        ws->current_stamp = 1;
+    }
+    ws->heap.size = 0;
+
+    int start_state = spur * ws->layers + spur_hops;
+    ws->stamp[start_state] = ws->current_stamp;
+    ws->dist[start_state] = 0.0;
+    ws->parent[start_state] = -1;
+    if (!heap_push(&ws->heap, heuristic(ws, spur), 0.0, start_state)) return false;
+
+    int goal = -1;
+    while (ws->heap.size > 0) {
+        HeapItem item = heap_pop(&ws->heap);
+        if (item.g > ws->dist[item.state]) continue;
+
+        int u = item.state / ws->layers;
+        int hops = item.state % ws->layers;
+        if (u == q->target) {
+            goal = item.state;
+            break;
+        }
+
+        int n = forward_neighbors(q, u, ws->neighbors);
+        for (int i = 0; i < n; i++) {
+            int v = ws->neighbors[i];
+            if (ws->banned[v] || ws->to_target[v] < 0) continue;
+            if (u == spur) {
+                bool skip = false;
+                for (int b = 0; b < banned_next_count; b++) {
+                    if (banned_next[b] == v) skip = true;
+                }
+                if (skip) continue;
+            }
+
+            bool is_reaction = v >= S && v != q->source;
+            int steps = 0;
+            double cost = is_reaction ? step_cost(q, u, v - S, &steps) : 0.0;
+            int next_hops = hops + steps;
+            if (next_hops + ws->to_target[v] / 2 > L) continue;
+
+            double nd = item.g + cost;
+            int state = v * ws->layers + next_hops;
+            if (ws->stamp[state] == ws->current_stamp && ws->dist[state] <= nd) continue;
+
+            ws->stamp[state] = ws->current_stamp;
+            ws->dist[state] = nd;
+            ws->parent[state] = item.state;
+            if (!heap_push(&ws->heap, nd + heuristic(ws, v), nd, state)) return false;
+        }
+    }
+    if (goal < 0) return false;
+
+    int reversed[ROUTE_MAX_NODES];
+    int length = 0;
+    for (int st = goal; st >= 0; st = ws->parent[st]) {
+        if (length == ROUTE_MAX_NODES) return false;
+        reversed[length++] = st / ws->layers;
+    }
+    out->length = length;
+    for (int i = 0; i < length; i++) out->nodes[i] = reversed[length - 1 - i];
+    out->cost = ws->dist[goal];
+    return true;
+}
+
+static bool path_is_simple(const NodePath* p) {
+    for (int i = 0; i < p->length; i++) {
+        for (int j = i + 1; j < p->length; j++) {
+            if (p->nodes[i] == p->nodes[j]) return false;
+        }
+    }
+    return true;
+}
+
+static bool path_same(const NodePath* a, const NodePath* b) {
+    return a->length == b->length &&
+           memcmp(a->nodes, b->nodes, (size_t)a->length * sizeof(int)) == 0;
+}
+
+/* Append a path as a route unless its reaction sequence was already reported */
+static void route_emit(const RouteQuery* q, const NodePath* path, Route* routes, int* route_count) {
+    Route route;
+    if (!nodes_to_route(q, path->nodes, path->length, &route)) return;
+    route.cost = path->cost;
+
+    for (int i = 0; i < *route_count; i++) {
+        if (routes[i].steps == route.steps &&
+            memcmp(routes[i].reactions, route.reactions, (size_t)route.steps * sizeof(int)) == 0) {
+            return;
+        }
+    }
+    routes[(*route_count)++] = route;
+}
+
+static bool search_space_init(SearchSpace* ws, const RouteQuery* q, const RouteOptions* opt) {
+    const RouteGraph* g = q->g;
+    int S = g->species_count;
+    int R = g->reaction_count;
+    int V = q->node_count;
+
+    memset(ws, 0, sizeof(SearchSpace));
+    ws->q = q;
+    ws->layers = opt->max_steps + 1;
+    ws->use_heuristic = opt->use_heuristic;
+
+    size_t states = (size_t)V * ws->layers;
+    ws->to_target = malloc((size_t)V * sizeof(int));
+    ws->dist = malloc(states * sizeof(double));
+    ws->parent = malloc(states * sizeof(int));
+    ws->stamp = calloc(states, sizeof(int));
+    ws->banned = calloc((size_t)V, sizeof(bool));
+    ws->neighbors = malloc((size_t)max_degree(q) * sizeof(int));
+    int* queue = malloc((size_t)V * sizeof(int));
+    if (!ws->to_target || !ws->dist || !ws->parent ||
+        !ws->stamp || !ws->banned || !ws->neighbors || !queue) {
+        free(queue);
+        return false;
+    }
+
+    /* Cheapest chain step anywhere, carrier chosen to save the dearest input */
+    ws->min_cost = INFINITY;
+    for (int r = 0; r < R; r++) {
+        if (!q->feasible[r]) continue;
+        for (int e = g->reactant_offsets[r]; e < g->reactant_offsets[r + 1]; e++) {
+            double c = step_cost(q, g->reactants[e], r, NULL);
+            if (c < ws->min_cost) ws->min_cost = c;
+        }
+    }
+    if (ws->min_cost == INFINITY) ws->min_cost = 0.0;
+
+    /* Reverse BFS from the target gives both pruning and the A* bound */
+    for (int v = 0; v < V; v++) ws->to_target[v] = -1;
+    int head = 0, tail = 0;
+    ws->to_target[q->target] = 0;
+    queue[tail++] = q->target;
+    while (head < tail) {
+        int u = queue[head++];
+        int n = backward_neighbors(q, u, ws->neighbors);
+        for (int i = 0; i < n; i++) {
+            int v = ws->neighbors[i];
+            if (ws->to_target[v] >= 0) continue;
+            ws->to_target[v] = ws->to_target[u] + 1;
+            queue[tail++] = v;
+        }
+    }
+    /* The source sits one edge before any reachable start species */
+    for (int s = 0; s < S; s++) {
+        if (q->start[s] && ws->to_target[s] >= 0 &&
+            (ws->to_target[q->source] < 0 || ws->to_target[s] + 1 < ws->to_target[q->source])) {
+            ws->to_target[q->source] = ws->to_target[s] + 1;
+        }
+    }
+
+    free(queue);
+    return true;
+}
+
+static void search_space_free(SearchSpace* ws) {
+    free(ws->to_target);
+    free(ws->dist);
+    free(ws->parent);
+    free(ws->stamp);
+    free(ws->heap.items);
+    free(ws->banned);
+    free(ws->neighbors);
+}
+
+int route_find_best(const RouteGraph* graph,
+                    const Formula* start, int start_count,
+                    const Formula* target, const RouteOptions* options,
+                    Route* routes, int k) {
+    if (!routes || k <= 0) return 0;
+
+    RouteOptions opt;
+    if (options) opt = *options;
+    else route_options_default(&opt);
+    if (opt.max_steps > ROUTE_MAX_STEPS) opt.max_steps = ROUTE_MAX_STEPS;
+    if (opt.max_steps < 0) return 0;
+
+    RouteQuery q;
+    if (!query_init(&q, graph, start, start_count, target,
+                    opt.cost ? opt.cost : route_cost_by_condition, opt.user_data)) {
+        return 0;
+    }
+
+    if (q.start[q.target]) {
+        memset(&routes[0], 0, sizeof(Route));
+        routes[0].species[0] = q.target;
+        query_free(&q);
+        return 1;
+    }
+
+    /*
+     * Node paths that differ only in which reactant carries the chain map to
+     * the same reaction sequence, so Yen's list may hold more paths than the
+     * routes we report. Bound it to keep the search predictable.
+     */
+    int found_limit = k * 8 + 32;
+    int route_count = 0;
+
+    SearchSpace ws;
+    memset(&ws, 0, sizeof(SearchSpace));
+    NodePath* found = malloc((size_t)found_limit * sizeof(NodePath));
+    NodePath* candidates = NULL;
+    int candidate_count = 0, candidate_capacity = 0;
+    int found_count = 0;
+
+    if (!found || !search_space_init(&ws, &q, &opt)) {
+        free(found);
+        search_space_free(&ws);
+        query_free(&q);
+        return 0;
+    }
+
+    if (spur_search(&ws, q.source, 0, NULL, 0, &found[0]) && path_is_simple(&found[0])) {
+        found_count = 1;
+        route_emit(&q, &found[0], routes, &route_count);
+    }
+
+    int banned_next[ROUTE_MAX_NODES * 4];
+    while (found_count > 0 && found_count < found_limit && route_count < k) {
+        const NodePath* prev = &found[found_count - 1];
+
+        for (int i = 0; i + 1 < prev->length; i++) {
+            int spur = prev->nodes[i];
+            int root_hops = 0;
+            double root_cost = 0.0;
+            for (int j = 1; j <= i; j++) {
+                int node = prev->nodes[j];
+                if (node >= graph->species_count && node != q.source) {
+                    int steps;
+                    root_cost += step_cost(&q, prev->nodes[j - 1], node - graph->species_count, &steps);
+                    root_hops += steps;
+                }
+            }
+
+            /* Ban the next hop of every accepted route sharing this root */
+            int banned_count = 0;
+            int max_banned = (int)(sizeof(banned_next) / sizeof(banned_next[0]));
+            for (int a = 0; a < found_count && banned_count < max_banned; a++) {
+                if (found[a].length > i + 1 &&
+                    memcmp(found[a].nodes, prev->nodes, (size_t)(i + 1) * sizeof(int)) == 0) {
+                    banned_next[banned_count++] = found[a].nodes[i + 1];
+                }
+            }
+            for (int j = 0; j < i; j++) ws.banned[prev->nodes[j]] = true;
+
+            NodePath spur_path;
+            bool ok = spur_search(&ws, spur, root_hops, banned_next, banned_count, &spur_path);
+
+            for (int j = 0; j < i; j++) ws.banned[prev->nodes[j]] = false;
+            if (!ok || i + spur_path.length > ROUTE_MAX_NODES) continue;
+
+            NodePath total;
+            memcpy(total.nodes, prev->nodes, (size_t)i * sizeof(int));
+            memcpy(&total.nodes[i], spur_path.nodes, (size_t)spur_path.length * sizeof(int));
+            total.length = i + spur_path.length;
+            total.cost = root_cost + spur_path.cost;
+            if (!path_is_simple(&total)) continue;
+
+            bool duplicate = false;
+            for (int c = 0; c < candidate_count && !duplicate; c++) {
+                duplicate = path_same(&candidates[c], &total);
+            }
+            for (int a = 0; a < found_count && !duplicate; a++) {
+                duplicate = path_same(&found[a], &total);
+            }
+            if (duplicate) continue;
+
+            if (candidate_count == candidate_capacity) {
+                int capacity = candidate_capacity ? candidate_capacity * 2 : 16;
+                NodePath* grown = realloc(candidates, (size_t)capacity * sizeof(NodePath));
+                if (!grown) break;
+                candidates = grown;
+                candidate_capacity = capacity;
+            }
+            candidates[candidate_count++] = total;
+        }
+
+        if (candidate_count == 0) break;
+
+        int best = 0;
+        for (int c = 1; c < candidate_count; c++) {
+            if (candidates[c].cost < candidates[best].cost) best = c;
+        }
+        found[found_count++] = candidates[best];
+        candidates[best] = candidates[--candidate_count];
+        route_emit(&q, &found[found_count - 1], routes, &route_count);
+    }
+
+    free(candidates);
+    free(found);
+    search_space_free(&ws);
+    query_free(&q);
+    return route_count;
+}
+
+/* ============ Output ============ */
+
+void route_print(const Route* route) {
+    if (!route) {
+        printf("(null route)\n");
+        return;
+    }
+
+    printf("Route: %d step(s), cost %.2f\n", route->steps, route->cost);
+    if (route->steps == 0) {
+        printf("  Target is already available\n");
+        return;
+    }
+    for (int i = 0; i < route->steps; i++) {
+        printf("  %d. ", i + 1);
+        reaction_print(reaction_db_get(route->reactions[i]));
+    }
+}
@@ -0,0 +1,584 @@
+#include "smiles.h"
+#include "molecule_pool.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define SMILES_MAX_BRANCH_DEPTH 256
+#define NO_BOND (-1)
+
+/* Open ring-closure: the atom it started at and any bond symbol given there */
+typedef struct {
+    int atom;
+    int bond;
+} RingOpening;
+
+/* Cursor over the input while parsing one SMILES */
+typedef struct {
+    SmilesParser* parser;
+    Molecule* mol;
+    const char* start;
+    const char* p;
+    const char* end;
+} ParseState;
+
+void smiles_parser_init(SmilesParser* parser) {
+    if (!parser) return;
+    memset(parser, 0, sizeof(*parser));
+    parser->error_position = -1;
+}
+
+void smiles_parser_free(SmilesParser* parser) {
+    if (!parser) return;
+    free(parser->bond_sums);
+    free(parser->hydrogens);
+    smiles_parser_init(parser);
+}
+
+static bool parse_error(ParseState* s, const char* message) {
+    s->parser->error = message;
+    s->parser->error_position = (int)(s->p - s->start);
+    return false;
+}
+
+/* Make room for per-atom scratch up to index atom */
+static bool scratch_reserve(SmilesParser* parser, int atom) {
+    if (atom < parser->capacity) return true;
+
+    int capacity = parser->capacity < 64 ? 64 : parser->capacity;
+    while (capacity <= atom) capacity *= 2;
+
+    int* bond_sums = realloc(parser->bond_sums, capacity * sizeof(int));
+    if (!bond_sums) return false;
+    parser->bond_sums = bond_sums;
+
+    int* hydrogens = realloc(parser->hydrogens, capacity * sizeof(int));
+    if (!hydrogens) return false;
+    parser->hydrogens = hydrogens;
+
+    parser->capacity = capacity;
+    return true;
+}
+
+static int bond_order(int type) {
+    switch (type) {
+        case BOND_DOUBLE: return 2;
+        case BOND_TRIPLE: return 3;
+        default: return 1;
+    }
+}
+
+static int add_atom(ParseState* s, const Element* el, int charge, int isotope,
+                    bool aromatic, int hydrogens) {
+    int id = molecule_add_atom(s->mol, el, charge);
+    if (id < 0 || !scratch_reserve(s->parser, id)) return -1;
+
+    if (isotope > 0) molecule_set_atom_isotope(s->mol, id, isotope);
+    s->mol->atoms[id].aromatic = aromatic;
+    s->parser->bond_sums[id] = 0;
+    s->parser->hydrogens[id] = hydrogens;
+    return id;
+}
+
+static bool add_bond(ParseState* s, int a, int b, int type) {
+    if (type == NO_BOND) {
+        type = (s->mol->atoms[a].aromatic && s->mol->atoms[b].aromatic)
+               ? BOND_AROMATIC : BOND_SINGLE;
+    }
+    if (a == b) return parse_error(s, "ring closure to the same atom");
+    if (!molecule_add_bond(s->mol, a, b, (BondType)type)) {
+        return parse_error(s, "failed to add bond");
+    }
+
+    int order = bond_order(type);
+    s->parser->bond_sums[a] += order;
+    s->parser->bond_sums[b] += order;
+    return true;
+}
+
+/* ============ Atoms ============ */
+
+/* Organic subset atom outside brackets; returns atom ID, -1 on error */
+static int parse_organic_atom(ParseState* s) {
+    const Element* el = NULL;
+    bool aromatic = false;
+    char c = *s->p++;
+    char next = s->p < s->end ? *s->p : '\0';
+
+    switch (c) {
+        case 'B':
+            if (next == 'r') {
+                s->p++;
+                el = element_by_number(35);
+            } else {
+                el = element_by_number(5);
+            }
+            break;
+        case 'C':
+            if (next == 'l') {
+                s->p++;
+                el = element_by_number(17);
+            } else {
+                el = element_by_number(6);
+            }
+            break;
+        case 'N': el = element_by_number(7); break;
+        case 'O': el = element_by_number(8); break;
+        case 'P': el = element_by_number(15); break;
+        case 'S': el = element_by_number(16); break;
+        case 'F': el = element_by_number(9); break;
+        case 'I': el = element_by_number(53); break;
+        case 'b': el = element_by_number(5); aromatic = true; break;
+        case 'c': el = element_by_number(6); aromatic = true; break;
+        case 'n': el = element_by_number(7); aromatic = true; break;
+        case 'o': el = element_by_number(8); aromatic = true; break;
+        case 'p': el = element_by_number(15); aromatic = true; break;
+        case 's': el = element_by_number(16); aromatic = true; break;
+        default:
+            s->p--;
+            parse_error(s, "unexpected character");
+            return -1;
+    }
+
+    int id = add_atom(s, el, 0, 0, aromatic, -1);
+    if (id < 0) parse_error(s, "out of memory");
+    return id;
+}
+
+static int parse_number(ParseState* s, int fallback) {
+    if (s->p >= s->end || !isdigit((unsigned char)*s->p)) return fallback;
+    int value = 0;
+    while (s->p < s->end && isdigit((unsigned char)*s->p) && value < 100000) {
+        value = value * 10 + (*s->p++ - '0');
+    }
+    return value;
+}
+
+/* Element symbol inside brackets, including aromatic forms */
+static const Element* parse_bracket_symbol(ParseState* s, bool* aromatic) {
+    char symbol[3] = {0};
+    const char* p = s->p;
+    if (p >= s->end) return NULL;
+
+    *aromatic = islower((unsigned char)*p) != 0;
+    if (*aromatic) {
+        /* Two-letter aromatic symbols first: se, as, te */
+        if (p + 1 < s->end && ((p[0] == 's' && p[1] == 'e') || (p[0] == 'a' && p[1] == 's') ||
+                               (p[0] == 't' && p[1] == 'e'))) {
+            symbol[0] = p[0];
+            symbol[1] = p[1];
+            s->p += 2;
+        } else if (strchr("bcnops", *p)) {
+            symbol[0] = *p;
+            s->p++;
+        } else {
+            return NULL;
+        }
+        return element_by_symbol(symbol);
+    }
+
+    if (!isupper((unsigned char)*p)) return NULL;
+    symbol[0] = p[0];
+    if (p + 1 < s->end && islower((unsigned char)p[1])) {
+        symbol[1] = p[1];
+        const Element* el = element_by_symbol(symbol);
+        if (el) {
+            s->p += 2;
+            return el;
+        }
+        symbol[1] = '\0';
+    }
+    s->p++;
+    return element_by_symbol(symbol);
+}
+
+/* Skip @, @@ and @TH1-style chirality marks */
+static void skip_chirality(ParseState* s) {
+    static const char* classes[] = {"TH", "AL", "SP", "TB", "OH"};
+    if (s->p >= s->end || *s->p != '@') return;
+
+    s->p++;
+    if (s->p < s->end && *s->p == '@') {
+        s->p++;
+        return;
+    }
+    for (int i = 0; i < 5; i++) {
+        if (s->p + 1 < s->end && s->p[0] == classes[i][0] && s->p[1] == classes[i][1]) {
+            s->p += 2;
+            parse_number(s, 0);
+            return;
+        }
+    }
+}
+
+/* [isotope? symbol chirality? hcount? charge? class?] */
+static int parse_bracket_atom(ParseState* s) {
+    s->p++;   /* '[' */
+
+    int isotope = parse_number(s, 0);
+
+    bool aromatic = false;
+    const Element* el = parse_bracket_symbol(s, &aromatic);
+    if (!el) {
+        parse_error(s, "unknown element in bracket atom");
+        return -1;
+    }
+
+    skip_chirality(s);
+
+    int hydrogens = 0;
+    if (s->p < s->end && *s->p == 'H') {
+        s->p++;
+        hydrogens = parse_number(s, 1);
+    }
+
+    int charge = 0;
+    if (s->p < s->end && (*s->p == '+' || *s->p == '-')) {
+        char sign = *s->p++;
+        int magnitude = 1;
+        if (s->p < s->end && isdigit((unsigned char)*s->p)) {
+            magnitude = parse_number(s, 1);
+        } else {
+            while (s->p < s->end && *s->p == sign) {
+                s->p++;
+                magnitude++;
+            }
+        }
+        charge = sign == '+' ? magnitude : -magnitude;
+    }
+
+    if (s->p < s->end && *s->p == ':') {
+        s->p++;
+        parse_number(s, 0);
+    }
+
+    if (s->p >= s->end || *s->p != ']') {
+        parse_error(s, "unterminated bracket atom");
+        return -1;
+    }
+    s->p++;
+
+    int id = add_atom(s, el, charge, isotope, aromatic, hydrogens);
+    if (id < 0) parse_error(s, "out of memory");
+    return id;
+}
+
+/* ============ Hydrogens ============ */
+
+/* Atoms without a bracket count get molecule_default_hydrogens */
+static bool add_hydrogens(ParseState* s) {
+    const Element* hydrogen = element_by_number(1);
+
+    Molecule* mol = s->mol;
+    int heavy = mol->atom_count;
+
+    int total = 0;
+    for (int i = 0; i < heavy; i++) {
+        if (s->parser->hydrogens[i] < 0) {
+            s->parser->hydrogens[i] = molecule_default_hydrogens(&mol->atoms[i],
+                                                                 s->parser->bond_sums[i]);
+        }
+        total += s->parser->hydrogens[i];
+    }
+    if (total == 0) return true;
+
+    if (s->parser->implicit_hydrogens) {
+        if (!molecule_set_hydrogens(mol, s->parser->hydrogens)) {
+            return parse_error(s, "too many hydrogens");
+        }
+        return true;
+    }
+
+    if (!molecule_reserve(mol, heavy + total, mol->bond_count + total)) {
+        return parse_error(s, "out of memory");
+    }
+    int id = molecule_add_atoms(mol, hydrogen, 0, total);
+    if (id < 0) return parse_error(s, "out of memory");
+    for (int i = 0; i < heavy; i++) {
+        for (int h = 0; h < s->parser->hydrogens[i]; h++) {
+            if (!molecule_add_bond(mol, i, id++, BOND_SINGLE)) return parse_error(s, "out of memory");
+        }
+    }
+    return true;
+}
+
+/* ============ Parser ============ */
+
+static int bond_symbol(char c) {
+    switch (c) {
+        case '-': case '/': case '\\': return BOND_SINGLE;
+        case '=': return BOND_DOUBLE;
+        case '#': return BOND_TRIPLE;
+        case ':': return BOND_AROMATIC;
+        default: return NO_BOND;
+    }
+}
+
+static bool parse_ring_bond(ParseState* s, RingOpening* rings, int prev, int* pending,
+                            int* open_rings) {
+    int number;
+    if (*s->p == '%') {
+        s->p++;
+        if (s->p + 1 >= s->end || !isdigit((unsigned char)s->p[0]) ||
+            !isdigit((unsigned char)s->p[1])) {
+            return parse_error(s, "expected two digits after %");
+        }
+        number = (s->p[0] - '0') * 10 + (s->p[1] - '0');
+        s->p += 2;
+    } else {
+        number = *s->p++ - '0';
+    }
+
+    if (prev < 0) return parse_error(s, "ring bond without an atom");
+
+    RingOpening* ring = &rings[number];
+    if (ring->atom < 0) {
+        ring->atom = prev;
+        ring->bond = *pending;
+        (*open_rings)++;
+    } else {
+        if (*pending != NO_BOND && ring->bond != NO_BOND && *pending != ring->bond) {
+            return parse_error(s, "conflicting ring bond orders");
+        }
+        int type = *pending != NO_BOND ? *pending : ring->bond;
+        if (!add_bond(s, ring->atom, prev, type)) return false;
+        ring->atom = -1;
+        (*open_rings)--;
+    }
+    *pending = NO_BOND;
+    return true;
+}
+
+bool smiles_parser_parse(SmilesParser* parser, const char* text, size_t length, Molecule* mol) {
+    if (!parser || !text || !mol) return false;
+    parser->error = NULL;
+    parser->error_position = -1;
+    molecule_clear(mol);
+
+    ParseState s = {parser, mol, text, text, text + length};
+
+    /* SMILES ends at the first whitespace; the rest is the name */
+    const char* smiles_end = text;
+    while (smiles_end < s.end && !isspace((unsigned char)*smiles_end)) smiles_end++;
+    s.end = smiles_end;
+
+    RingOpening rings[SMILES_MAX_RING_BONDS];
+    for (int i = 0; i < SMILES_MAX_RING_BONDS; i++) rings[i].atom = -1;
+    int open_rings = 0;
+
+    int branches[SMILES_MAX_BRANCH_DEPTH];
+    int depth = 0;
+    int prev = -1;
+    int pending = NO_BOND;
+
+    if (s.p == s.end) return parse_error(&s, "empty SMILES");
+
+    while (s.p < s.end) {
+        char c = *s.p;
+
+        if (c == '[' || isalpha((unsigned char)c)) {
+            int id = c == '[' ? parse_bracket_atom(&s) : parse_organic_atom(&s);
+            if (id < 0) return false;
+            if (prev >= 0 && !add_bond(&s, prev, id, pending)) return false;
+            pending = NO_BOND;
+            prev = id;
+        } else if (c == '(') {
+            if (prev < 0) return parse_error(&s, "branch without an atom");
+            if (depth == SMILES_MAX_BRANCH_DEPTH) return parse_error(&s, "branches nested too deeply");
+            branches[depth++] = prev;
+            s.p++;
+        } else if (c == ')') {
+            if (depth == 0) return parse_error(&s, "unmatched ')'");
+            if (pending != NO_BOND) return parse_error(&s, "bond before ')'");
+            prev = branches[--depth];
+            s.p++;
+        } else if (isdigit((unsigned char)c) || c == '%') {
+            if (!parse_ring_bond(&s, rings, prev, &pending, &open_rings)) return false;
+        } else if (c == '.') {
+            if (pending != NO_BOND) return parse_error(&s, "bond before '.'");
+            prev = -1;
+            s.p++;
+        } else if (bond_symbol(c) != NO_BOND) {
+            if (pending != NO_BOND) return parse_error(&s, "consecutive bond symbols");
+            if (prev < 0) return parse_error(&s, "bond without a preceding atom");
+            pending = bond_symbol(c);
+            s.p++;
+        } else if (c == '$') {
+            return parse_error(&s, "quadruple bonds are not supported");
+        } else {
+            return parse_error(&s, "unexpected character");
+        }
+    }
+
+    if (pending != NO_BOND) return parse_error(&s, "dangling bond");
+    if (depth != 0) return parse_error(&s, "unclosed branch");
+    if (open_rings != 0) return parse_error(&s, "unclosed ring bond");
+
+    if (!add_hydrogens(&s)) return false;
+
+    /* Name: remainder of the line after whitespace */
+    const char* name = smiles_end;
+    const char* text_end = text + length;
+    while (name < text_end && (*name == ' ' || *name == '\t')) name++;
+    size_t name_length = 0;
+    while (name + name_length < text_end && name[name_length] != '\n' &&
+           name[name_length] != '\r' && name_length < sizeof(mol->name) - 1) {
+        name_length++;
+    }
+    memcpy(mol->name, name, name_length);
+    mol->name[name_length] = '\0';
+
+    if (!molecule_build_adjacency(mol)) return parse_error(&s, "out of memory");
+    return true;
+}
+
+bool smiles_parse(const char* smiles, Molecule* mol) {
+    if (!smiles) return false;
+
+    SmilesParser parser;
+    smiles_parser_init(&parser);
+    bool ok = smiles_parser_parse(&parser, smiles, strlen(smiles), mol);
+    smiles_parser_free(&parser);
+    return ok;
+}
+
+/* ============ Bulk Parsing ============ */
+
+/* Per-worker state, padded so counters do not share cache lines */
+typedef struct {
+    SmilesParser parser;
+    MoleculePool pool;
+    Molecule* mol;
+    int parsed;
+    int failed;
+    long long atoms;
+    char padding[64];
+} SmilesWorker;
+
+typedef struct {
+    const char* text;
+    const size_t* starts;
+    const int* lengths;
+    SmilesWorker* workers;
+    SmilesMoleculeFn fn;
+    void* user_data;
+} SmilesBatch;
+
+static void parse_lines(int begin, int end, int thread_index, void* user_data) {
+    SmilesBatch* batch = user_data;
+    SmilesWorker* w = &batch->workers[thread_index];
+
+    for (int line = begin; line < end; line++) {
+        if (!w->mol) {
+            w->failed++;
+            continue;
+        }
+        if (!smiles_parser_parse(&w->parser, batch->text + batch->starts[line],
+                                 (size_t)batch->lengths[line], w->mol)) {
+            w->failed++;
+            continue;
+        }
+        w->parsed++;
+        w->atoms += w->mol->atom_count;
+        if (batch->fn) batch->fn(w->mol, line, thread_index, batch->user_data);
+    }
+}
+
+bool smiles_parse_buffer(const char* text, size_t length, int threads, bool implicit_hydrogens,
+                         SmilesMoleculeFn fn, void* user_data, SmilesBatchStats* stats) {
+    if (!text) return false;
+    double start = parallel_now();
+
+    /* Index non-empty lines */
+    int line_count = 0;
+    for (size_t i = 0; i < length; ) {
+        const char* nl = memchr(text + i, '\n', length - i);
+        size_t next = nl ? (size_t)(nl - text) + 1 : length;
+        if (!isspace((unsigned char)text[i])) line_count++;
+        i = next;
+    }
+
+    size_t* starts = malloc((line_count + 1) * sizeof(size_t));
+    int* lengths = malloc((line_count + 1) * sizeof(int));
+    if (!starts || !lengths) {
+        free(starts);
+        free(lengths);
+        return false;
+    }
+
+    int line = 0;
+    for (size_t i = 0; i < length; ) {
+        const char* nl = memchr(text + i, '\n', length - i);
+        size_t next = nl ? (size_t)(nl - text) + 1 : length;
+        if (!isspace((unsigned char)text[i])) {
+            starts[line] = i;
+            lengths[line++] = (int)((nl ? (size_t)(nl - text) : length) - i);
+        }
+        i = next;
+    }
+
+    threads = parallel_thread_count(threads);
+    SmilesWorker* workers = calloc(threads, sizeof(SmilesWorker));
+    if (!workers) {
+        free(starts);
+        free(lengths);
+        return false;
+    }
+    for (int t = 0; t < threads; t++) {
+        smiles_parser_init(&workers[t].parser);
+        workers[t].parser.implicit_hydrogens = implicit_hydrogens;
+        molecule_pool_init(&workers[t].pool, 0);
+        workers[t].mol = molecule_pool_create(&workers[t].pool, NULL);
+    }
+
+    SmilesBatch batch = {text, starts, lengths, workers, fn, user_data};
+    bool ok = parallel_for(line_count, 256, threads, parse_lines, &batch);
+
+    SmilesBatchStats totals = {0};
+    totals.lines = line_count;
+    totals.bytes = (long long)length;
+    for (int t = 0; t < threads; t++) {
+        totals.parsed += workers[t].parsed;
+        totals.failed += workers[t].failed;
+        totals.atoms += workers[t].atoms;
+        smiles_parser_free(&workers[t].parser);
+        molecule_pool_destroy(&workers[t].pool);
+    }
+    totals.seconds = parallel_now() - start;
+    if (stats) *stats = totals;
+
+    free(workers);
+    free(starts);
+    free(lengths);
+    return ok;
+}
+
+bool smiles_parse_file(const char* path, int threads, bool implicit_hydrogens,
+                       SmilesMoleculeFn fn, void* user_data, SmilesBatchStats* stats) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    if (fseek(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return false;
+    }
+    long size = ftell(file);
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    char* text = malloc((size_t)size + 1);
+    if (!text) {
+        fclose(file);
+        return false;
+    }
+    size_t read = fread(text, 1, (size_t)size, file);
+    fclose(file);
+
+    bool ok = smiles_parse_buffer(text, read, threads, implicit_hydrogens, fn, user_data, stats);
+    free(text);
+    return ok;
+}
@@ -0,0 +1,353 @@
+#include "stochastic.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ENSEMBLE_CHUNK 4
+
+/* ============ System ============ */
+
+bool stochastic_system_init(StochasticSystem* system, const KineticsModel* model) {
+    if (!system || !model) return false;
+    memset(system, 0, sizeof(StochasticSystem));
+    int n = model->species_count;
+    int m = model->reaction_count;
+    int reactant_entries = m > 0 ? model->reactant_offsets[m] : 0;
+    int stoich_entries = m > 0 ? model->stoich_offsets[m] : 0;
+
+    /* Reactions by reactant species, as CSR */
+    int* uses_offsets = calloc((size_t)n + 1, sizeof(int));
+    int* uses = malloc((size_t)(reactant_entries > 0 ? reactant_entries : 1) * sizeof(int));
+    int* stamp = malloc((size_t)(m > 0 ? m : 1) * sizeof(int));
+    system->deltas = malloc((size_t)(stoich_entries > 0 ? stoich_entries : 1) * sizeof(int64_t));
+    system->dependency_offsets = malloc(((size_t)m + 1) * sizeof(int));
+    bool ok = uses_offsets && uses && stamp && system->deltas && system->dependency_offsets;
+
+    if (ok) {
+        for (int r = 0; r < reactant_entries; r++) uses_offsets[model->reactant_species[r] + 1]++;
+        for (int s = 0; s < n; s++) uses_offsets[s + 1] += uses_offsets[s];
+        for (int j = 0; j < m; j++) {
+            for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+                uses[uses_offsets[model->reactant_species[r]]++] = j;
+            }
+        }
+        for (int s = n; s > 0; s--) uses_offsets[s] = uses_offsets[s - 1];
+        uses_offsets[0] = 0;
+        for (int e = 0; e < stoich_entries; e++) system->deltas[e] = llround(model->stoich_values[e]);
+    }
+
+    /* Dependents of j: reactions using a species j changes, excluding j */
+    int count = 0;
+    for (int pass = 0; ok && pass < 2; pass++) {
+        for (int j = 0; j < m; j++) stamp[j] = -1;
+        count = 0;
+        for (int j = 0; j < m; j++) {
+            system->dependency_offsets[j] = count;
+            stamp[j] = j;
+            for (int e = model->stoich_offsets[j]; e < model->stoich_offsets[j + 1]; e++) {
+                int s = model->stoich_species[e];
+                for (int u = uses_offsets[s]; u < uses_offsets[s + 1]; u++) {
+                    if (stamp[uses[u]] == j) continue;
+                    stamp[uses[u]] = j;
+                    if (pass == 1) system->dependencies[count] = uses[u];
+                    count++;
+                }
+            }
+        }
+        system->dependency_offsets[m] = count;
+        if (pass == 0) {
+            system->dependencies = malloc((size_t)(count > 0 ? count : 1) * sizeof(int));
+            ok = system->dependencies != NULL;
+        }
+    }
+
+    free(uses_offsets);
+    free(uses);
+    free(stamp);
+    if (!ok) {
+        stochastic_system_free(system);
+        return false;
+    }
+    system->model = model;
+    system->species_count = n;
+    system->reaction_count = m;
+    return true;
+}
+
+void stochastic_system_free(StochasticSystem* system) {
+    if (!system) return;
+    free(system->deltas);
+    free(system->dependency_offsets);
+    free(system->dependencies);
+    memset(system, 0, sizeof(StochasticSystem));
+}
+
+/* ============ Random Numbers ============ */
+
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* xorshift64*; 53-bit uniform in (0, 1] */
+static double random_unit(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (double)(((x * 0x2545F4914F6CDD1Dull) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static double random_exponential(uint64_t* state) {
+    return -log(random_unit(state));
+}
+
+/* ============ Trajectory ============ */
+
+void stochastic_state_init(StochasticState* state) {
+    if (!state) return;
+    memset(state, 0, sizeof(StochasticState));
+}
+
+void stochastic_state_free(StochasticState* state) {
+    if (!state) return;
+    free(state->counts);
+    free(state->propensities);
+    free(state->firing_times);
+    free(state->heap);
+    free(state->heap_index);
+    stochastic_state_init(state);
+}
+
+static bool state_reserve(StochasticState* state, int species, int reactions) {
+    if (species > state->species_capacity) {
+        int64_t* counts = realloc(state->counts, (size_t)species * sizeof(int64_t));
+        if (!counts) return false;
+        state->counts = counts;
+        state->species_capacity = species;
+    }
+    if (reactions > state->reaction_capacity) {
+        size_t size = (size_t)reactions;
+        double* propensities = realloc(state->propensities, size * sizeof(double));
+        if (propensities) state->propensities = propensities;
+        double* firing_times = realloc(state->firing_times, size * sizeof(double));
+        if (firing_times) state->firing_times = firing_times;
+        int* heap = realloc(state->heap, size * sizeof(int));
+        if (heap) state->heap = heap;
+        int* heap_index = realloc(state->heap_index, size * sizeof(int));
+        if (heap_index) state->heap_index = heap_index;
+        if (!propensities || !firing_times || !heap || !heap_index) return false;
+        state->reaction_capacity = reactions;
+    }
+    return true;
+}
+
+static double propensity(const KineticsModel* model, const int64_t* counts, int j) {
+    double a = model->rate_constants[j];
+    for (int r = model->reactant_offsets[j]; r < model->reactant_offsets[j + 1]; r++) {
+        int64_t n = counts[model->reactant_species[r]];
+        int order = model->reactant_orders[r];
+        if (n < order) return 0.0;
+        for (int i = 0; i < order; i++) a *= (double)(n - i) / (double)(i + 1);
+    }
+    return a;
+}
+
+static void heap_swap(StochasticState* state, int a, int b) {
+    int ra = state->heap[a], rb = state->heap[b];
+    state->heap[a] = rb;
+    state->heap[b] = ra;
+    state->heap_index[rb] = a;
+    state->heap_index[ra] = b;
+}
+
+/* Restore heap order around slot i after its key changed */
+static void heap_update(StochasticState* state, int i, int size) {
+    const double* key = state->firing_times;
+    while (i > 0 && key[state->heap[(i - 1) / 2]] > key[state->heap[i]]) {
+        heap_swap(state, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && key[state->heap[child + 1]] < key[state->heap[child]]) child++;
+        if (key[state->heap[child]] >= key[state->heap[i]]) break;
+        heap_swap(state, i, child);
+        i = child;
+    }
+}
+
+bool stochastic_state_reset(StochasticState* state, const StochasticSystem* system,
+                            const int64_t* counts, uint64_t seed) {
+    if (!state || !system || !counts) return false;
+    int n = system->species_count;
+    int m = system->reaction_count;
+    for (int s = 0; s < n; s++) {
+        if (counts[s] < 0) return false;
+    }
+    if (!state_reserve(state, n, m)) return false;
+
+    memcpy(state->counts, counts, (size_t)n * sizeof(int64_t));
+    uint64_t mix = seed;
+    state->rng = splitmix64(&mix);
+    if (state->rng == 0) state->rng = 0x9E3779B97F4A7C15ull;
+    state->time = 0.0;
+    state->events = 0;
+
+    for (int j = 0; j < m; j++) {
+        double a = propensity(system->model, state->counts, j);
+        state->propensities[j] = a;
+        state->firing_times[j] = a > 0.0 ? random_exponential(&state->rng) / a : INFINITY;
+        state->heap[j] = j;
+        state->heap_index[j] = j;
+    }
+    for (int i = m / 2 - 1; i >= 0; i--) heap_update(state, i, m);
+    return true;
+}
+
+long long stochastic_advance(StochasticState* state, const StochasticSystem* system,
+                             double t_end, long long max_events) {
+    if (!state || !system) return 0;
+    const KineticsModel* model = system->model;
+    int m = system->reaction_count;
+    if (m == 0) {
+        if (t_end > state->time) state->time = t_end;
+        return 0;
+    }
+
+    long long fired = 0;
+    while (max_events <= 0 || fired < max_events) {
+        int mu = state->heap[0];
+        double t = state->firing_times[mu];
+        if (!(t <= t_end)) {
+            if (t_end > state->time) state->time = t_end;
+            break;
+        }
+
+        for (int e = model->stoich_offsets[mu]; e < model->stoich_offsets[mu + 1]; e++) {
+            state->counts[model->stoich_species[e]] += system->deltas[e];
+        }
+        state->time = t;
+        fired++;
+
+        /* Rescale dependents' remaining waits by old / new propensity */
+        for (int d = system->dependency_offsets[mu]; d < system->dependency_offsets[mu + 1]; d++) {
+            int alpha = system->dependencies[d];
+            double old_a = state->propensities[alpha];
+            double new_a = propensity(model, state->counts, alpha);
+            double next;
+            if (new_a <= 0.0) next = INFINITY;
+            else if (old_a > 0.0) next = t + (old_a / new_a) * (state->firing_times[alpha] - t);
+            else next = t + random_exponential(&state->rng) / new_a;
+            state->propensities[alpha] = new_a;
+            state->firing_times[alpha] = next;
+            heap_update(state, state->heap_index[alpha], m);
+        }
+
+        double a = propensity(model, state->counts, mu);
+        state->propensities[mu] = a;
+        state->firing_times[mu] = a > 0.0 ? t + random_exponential(&state->rng) / a : INFINITY;
+        heap_update(state, 0, m);
+    }
+    state->events += fired;
+    return fired;
+}
+
+/* ============ Ensembles ============ */
+
+void stochastic_options_default(StochasticOptions* options) {
+    if (!options) return;
+    options->t_end = 1.0;
+    options->sample_count = 1;
+    options->max_events = 0;
+    options->seed = 1;
+    options->threads = 0;
+}
+
+typedef struct {
+    StochasticState state;
+    long long events;
+    int truncated;
+    bool failed;
+    char padding[64];
+} EnsembleWorker;
+
+typedef struct {
+    const StochasticSystem* system;
+    const int64_t* initial_counts;
+    const StochasticOptions* options;
+    int64_t* samples;
+    EnsembleWorker* workers;
+} EnsembleJob;
+
+static void ensemble_range(int begin, int end, int thread_index, void* user_data) {
+    EnsembleJob* job = user_data;
+    EnsembleWorker* w = &job->workers[thread_index];
+    const StochasticOptions* options = job->options;
+    int n = job->system->species_count;
+    int samples = options->sample_count;
+
+    for (int i = begin; i < end; i++) {
+        /* Seeds seed + i * gamma give distinct splitmix64 outputs per trajectory */
+        uint64_t stream = options->seed + (uint64_t)i * 0x9E3779B97F4A7C15ull;
+        if (!stochastic_state_reset(&w->state, job->system, job->initial_counts, stream)) {
+            w->failed = true;
+            return;
+        }
+
+        long long budget = options->max_events;
+        for (int s = 1; s <= samples; s++) {
+            double t = s == samples ? options->t_end : options->t_end * s / samples;
+            if (budget > 0 || options->max_events <= 0) {
+                long long fired = stochastic_advance(&w->state, job->system, t, budget);
+                if (options->max_events > 0) {
+                    budget -= fired;
+                    if (budget == 0 && w->state.time < t) w->truncated++;
+                }
+            }
+            if (job->samples) {
+                int64_t* row = job->samples + ((size_t)i * samples + (s - 1)) * n;
+                memcpy(row, w->state.counts, (size_t)n * sizeof(int64_t));
+            }
+        }
+        w->events += w->state.events;
+    }
+}
+
+bool stochastic_run_ensemble(const StochasticSystem* system, const int64_t* initial_counts,
+                             int trajectories, const StochasticOptions* options,
+                             int64_t* samples, StochasticStats* stats) {
+    if (!system || !initial_counts || trajectories < 0) return false;
+    StochasticOptions defaults;
+    if (!options) {
+        stochastic_options_default(&defaults);
+        options = &defaults;
+    }
+    if (options->sample_count < 1 || !(options->t_end >= 0.0)) return false;
+
+    double start = parallel_now();
+    int threads = parallel_thread_count(options->threads);
+    EnsembleWorker* workers = calloc(threads, sizeof(EnsembleWorker));
+    if (!workers) return false;
+    for (int t = 0; t < threads; t++) stochastic_state_init(&workers[t].state);
+
+    EnsembleJob job = {system, initial_counts, options, samples, workers};
+    bool ok = parallel_for(trajectories, ENSEMBLE_CHUNK, threads, ensemble_range, &job);
+
+    StochasticStats total = {0, 0, 0.0};
+    for (int t = 0; t < threads; t++) {
+        if (workers[t].failed) ok = false;
+        total.events += workers[t].events;
+        total.truncated += workers[t].truncated;
+        stochastic_state_free(&workers[t].state);
+    }
+    free(workers);
+    total.seconds = parallel_now() - start;
+    if (stats) *stats = total;
+    return ok;
+}
@@ -0,0 +1,504 @@
+#include "substruct.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_CHUNK 1024
+
+static uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static uint32_t atom_label(const Atom* atom) {
+    return ((uint32_t)atom->element->atomic_number << 8) | (uint32_t)((atom->charge + 128) & 0xFF);
+}
+
+/* Plain hydrogen singly bonded to a non-hydrogen */
+static bool terminal_hydrogen(const Molecule* mol, int atom) {
+    const Atom* a = &mol->atoms[atom];
+    if (a->element->atomic_number != 1 || a->isotope != 0 || a->charge != 0) return false;
+
+    const int* neighbors;
+    const int* bonds;
+    if (molecule_neighbors(mol, atom, &neighbors, &bonds) != 1) return false;
+    return mol->atoms[neighbors[0]].element->atomic_number != 1 &&
+           mol->bonds[bonds[0]].type == BOND_SINGLE;
+}
+
+/* ============ Library ============ */
+
+void substruct_library_init(SubstructLibrary* lib) {
+    if (!lib) return;
+    memset(lib, 0, sizeof(*lib));
+}
+
+void substruct_library_free(SubstructLibrary* lib) {
+    if (!lib) return;
+    free(lib->atom_offsets);
+    free(lib->fingerprints);
+    free(lib->atom_labels);
+    free(lib->edge_offsets);
+    free(lib->edge_targets);
+    free(lib->edge_types);
+    substruct_library_init(lib);
+}
+
+static bool library_reserve(SubstructLibrary* lib, int molecules, int atoms, int edges) {
+    if (molecules > lib->molecule_capacity) {
+        int cap = lib->molecule_capacity < 64 ? 64 : lib->molecule_capacity;
+        while (cap < molecules) cap *= 2;
+        int* offsets = realloc(lib->atom_offsets, ((size_t)cap + 1) * sizeof(int));
+        if (!offsets) return false;
+        lib->atom_offsets = offsets;
+        SubstructFingerprint* fps = realloc(lib->fingerprints, (size_t)cap * sizeof(SubstructFingerprint));
+        if (!fps) return false;
+        lib->fingerprints = fps;
+        lib->molecule_capacity = cap;
+    }
+    if (atoms > lib->atom_capacity) {
+        int cap = lib->atom_capacity < 1024 ? 1024 : lib->atom_capacity;
+        while (cap < atoms) cap *= 2;
+        uint32_t* labels = realloc(lib->atom_labels, (size_t)cap * sizeof(uint32_t));
+        if (!labels) return false;
+        lib->atom_labels = labels;
+        int* offsets = realloc(lib->edge_offsets, ((size_t)cap + 1) * sizeof(int));
+        if (!offsets) return false;
+        lib->edge_offsets = offsets;
+        lib->atom_capacity = cap;
+    }
+    if (edges > lib->edge_capacity) {
+        int cap = lib->edge_capacity < 2048 ? 2048 : lib->edge_capacity;
+        while (cap < edges) cap *= 2;
+        int* targets = realloc(lib->edge_targets, (size_t)cap * sizeof(int));
+        if (!targets) return false;
+        lib->edge_targets = targets;
+        unsigned char* types = realloc(lib->edge_types, (size_t)cap);
+        if (!types) return false;
+        lib->edge_types = types;
+        lib->edge_capacity = cap;
+    }
+    return true;
+}
+
+static void fp_set(SubstructFingerprint* fp, uint64_t feature) {
+    uint64_t h = mix64(feature);
+    fp->bits[(h >> 6) % SUBSTRUCT_FP_WORDS] |= 1ULL << (h & 63);
+}
+
+/* Order-independent key for a bonded pair (label, bond) seen from a center */
+static uint64_t arm(uint32_t label, int type) {
+    return ((uint64_t)label << 3) | (uint64_t)type;
+}
+
+/* Atoms, bonds, and 2- and 3-bond paths of library molecule m */
+static void fingerprint_molecule(SubstructLibrary* lib, int m) {
+    SubstructFingerprint* fp = &lib->fingerprints[m];
+    memset(fp, 0, sizeof(*fp));
+
+    int base = lib->atom_offsets[m];
+    int n = lib->atom_offsets[m + 1] - base;
+    const uint32_t* labels = lib->atom_labels + base;
+    const int* offsets = lib->edge_offsets + base;
+
+    for (int b = 0; b < n; b++) {
+        uint64_t lb = labels[b];
+        fp_set(fp, (1ULL << 60) | lb);
+
+        for (int e = offsets[b]; e < offsets[b + 1]; e++) {
+            int c = lib->edge_targets[e];
+            uint64_t ab = arm(labels[c], lib->edge_types[e]);
+
+            /* Bond, counted from its lower-labeled end */
+            if (lb < labels[c] || (lb == labels[c] && b < c)) {
+                fp_set(fp, (2ULL << 60) ^ (lb << 32) ^ ab);
+            }
+
+            /* Path x-b-c centered on b, each unordered pair once */
+            for (int f = e + 1; f < offsets[b + 1]; f++) {
+                uint64_t other = arm(labels[lib->edge_targets[f]], lib->edge_types[f]);
+                uint64_t lo = ab < other ? ab : other, hi = ab < other ? other : ab;
+                fp_set(fp, (3ULL << 60) ^ mix64(lb) ^ (lo << 24) ^ hi);
+            }
+
+            /* Path x-b-c-y over the directed edge b->c, canonical direction */
+            if (b < c) {
+                for (int f = offsets[b]; f < offsets[b + 1]; f++) {
+                    int x = lib->edge_targets[f];
+                    if (x == c) continue;
+                    for (int g = offsets[c]; g < offsets[c + 1]; g++) {
+                        int y = lib->edge_targets[g];
+                        if (y == b) continue;
+                        uint64_t fwd = mix64(arm(labels[x], lib->edge_types[f]) * 31 + lb) ^
+                                       mix64(ab) ^ (arm(labels[y], lib->edge_types[g]) << 1);
+                        uint64_t bwd = mix64(arm(labels[y], lib->edge_types[g]) * 31 + labels[c]) ^
+                                       mix64(arm(lb, lib->edge_types[e])) ^
+                                       (arm(labels[x], lib->edge_types[f]) << 1);
+                        fp_set(fp, (4ULL << 60) ^ (fwd < bwd ? fwd : bwd));
+                    }
+                }
+            }
+        }
+    }
+}
+
+int substruct_library_add(SubstructLibrary* lib, const Molecule* mol) {
+    if (!lib || !mol || !mol->adjacency_valid) return -1;
+
+    int n = mol->atom_count;
+    int m = lib->molecule_count;
+    /* The atom -> local index map borrows n edge slots ahead of the new edges */
+    if (!library_reserve(lib, m + 1, lib->atom_count + n,
+                         lib->edge_count + n + 2 * mol->bond_count)) {
+        return -1;
+    }
+
+    /* Local heavy-atom indices are assigned in atom order */
+    int base = lib->atom_count;
+    int local = 0;
+    int edge_start = lib->edge_count;
+    int* map = lib->edge_targets + edge_start;
+    for (int i = 0; i < n; i++) {
+        if (terminal_hydrogen(mol, i)) {
+            map[i] = -1;
+        } else {
+            lib->atom_labels[base + local] = atom_label(&mol->atoms[i]);
+            map[i] = local++;
+        }
+    }
+
+    /* Edges are written after the map region, then moved down */
+    int write = edge_start + n;
+    int atom = base;
+    for (int i = 0; i < n; i++) {
+        if (map[i] < 0) continue;
+        lib->edge_offsets[atom++] = write - n;
+
+        const int* neighbors;
+        const int* bonds;
+        int degree = molecule_neighbors(mol, i, &neighbors, &bonds);
+        for (int j = 0; j < degree; j++) {
+            int target = map[neighbors[j]];
+            if (target < 0) continue;
+            lib->edge_targets[write] = target;
+            lib->edge_types[write++] = (unsigned char)mol->bonds[bonds[j]].type;
+        }
+    }
+
+    int edges = write - edge_start - n;
+    memmove(lib->edge_targets + edge_start, lib->edge_targets + edge_start + n, edges * sizeof(int));
+    memmove(lib->edge_types + edge_start, lib->edge_types + edge_start + n, edges);
+
+    lib->atom_count = base + local;
+    lib->edge_count = edge_start + edges;
+    lib->edge_offsets[lib->atom_count] = lib->edge_count;
+    lib->atom_offsets[m] = base;
+    lib->atom_offsets[m + 1] = lib->atom_count;
+    lib->molecule_count = m + 1;
+
+    fingerprint_molecule(lib, m);
+    return m;
+}
+
+/* ============ Query ============ */
+
+void substruct_query_free(SubstructQuery* query) {
+    if (!query) return;
+    substruct_library_free(&query->graph);
+    free(query->order);
+    free(query->parent);
+    free(query->parent_bond);
+    memset(query, 0, sizeof(*query));
+}
+
+/*
+ * Match order: start at the most specific atom (non-carbon, highest
+ * degree), then repeatedly take the atom with most bonds into the ordered
+ * set so candidates always come from a mapped neighbor.
+ */
+bool substruct_query_compile(SubstructQuery* query, const Molecule* mol) {
+    if (!query || !mol) return false;
+    memset(query, 0, sizeof(*query));
+    substruct_library_init(&query->graph);
+
+    if (substruct_library_add(&query->graph, mol) < 0) {
+        substruct_query_free(query);
+        return false;
+    }
+
+    const SubstructLibrary* g = &query->graph;
+    int n = g->atom_count;
+    query->order = malloc((n + 1) * sizeof(int));
+    query->parent = malloc((n + 1) * sizeof(int));
+    query->parent_bond = malloc((n + 1) * sizeof(int));
+    int* position = malloc((n + 1) * sizeof(int));
+    if (!query->order || !query->parent || !query->parent_bond || !position) {
+        free(position);
+        substruct_query_free(query);
+        return false;
+    }
+    for (int i = 0; i < n; i++) position[i] = -1;
+
+    for (int slot = 0; slot < n; slot++) {
+        int best = -1, best_score = -1;
+        for (int a = 0; a < n; a++) {
+            if (position[a] >= 0) continue;
+            int connections = 0;
+            for (int e = g->edge_offsets[a]; e < g->edge_offsets[a + 1]; e++) {
+                if (position[g->edge_targets[e]] >= 0) connections++;
+            }
+            int degree = g->edge_offsets[a + 1] - g->edge_offsets[a];
+            int specific = (g->atom_labels[a] >> 8) != 6;
+            int score = connections * 1000 + specific * 100 + degree;
+            if (score > best_score) {
+                best_score = score;
+                best = a;
+            }
+        }
+
+        position[best] = slot;
+        query->order[slot] = best;
+        query->parent[slot] = -1;
+        query->parent_bond[slot] = 0;
+        for (int e = g->edge_offsets[best]; e < g->edge_offsets[best + 1]; e++) {
+            if (position[g->edge_targets[e]] >= 0 && position[g->edge_targets[e]] < slot) {
+                query->parent[slot] = g->edge_targets[e];
+                query->parent_bond[slot] = g->edge_types[e];
+                break;
+            }
+        }
+    }
+
+    free(position);
+    return true;
+}
+
+/* ============ Matching ============ */
+
+typedef struct {
+    const SubstructQuery* query;
+    const uint32_t* labels;         /* Target molecule views */
+    const int* offsets;
+    const int* targets;
+    const unsigned char* types;
+    int n;
+    int* query_map;                 /* Query atom -> target atom */
+    int* target_used;               /* Target atom -> 1 if mapped */
+} MatchState;
+
+static bool has_edge(const MatchState* s, int a, int b, int type) {
+    for (int e = s->offsets[a]; e < s->offsets[a + 1]; e++) {
+        if (s->targets[e] == b) return s->types[e] == type;
+    }
+    return false;
+}
+
+static bool feasible(const MatchState* s, int q, int t) {
+    const SubstructLibrary* g = &s->query->graph;
+    if (s->target_used[t] || s->labels[t] != g->atom_labels[q]) return false;
+
+    int query_degree = g->edge_offsets[q + 1] - g->edge_offsets[q];
+    if (s->offsets[t + 1] - s->offsets[t] < query_degree) return false;
+
+    for (int e = g->edge_offsets[q]; e < g->edge_offsets[q + 1]; e++) {
+        int mapped = s->query_map[g->edge_targets[e]];
+        if (mapped >= 0 && !has_edge(s, t, mapped, g->edge_types[e])) return false;
+    }
+    return true;
+}
+
+static bool match_from(MatchState* s, int depth) {
+    const SubstructQuery* query = s->query;
+    if (depth == query->graph.atom_count) return true;
+
+    int q = query->order[depth];
+    int parent = query->parent[depth];
+
+    if (parent >= 0) {
+        int anchor = s->query_map[parent];
+        for (int e = s->offsets[anchor]; e < s->offsets[anchor + 1]; e++) {
+            int t = s->targets[e];
+            if (s->types[e] != query->parent_bond[depth] || !feasible(s, q, t)) continue;
+            s->query_map[q] = t;
+            s->target_used[t] = 1;
+            if (match_from(s, depth + 1)) return true;
+            s->query_map[q] = -1;
+            s->target_used[t] = 0;
+        }
+        return false;
+    }
+
+    for (int t = 0; t < s->n; t++) {
+        if (!feasible(s, q, t)) continue;
+        s->query_map[q] = t;
+        s->target_used[t] = 1;
+        if (match_from(s, depth + 1)) return true;
+        s->query_map[q] = -1;
+        s->target_used[t] = 0;
+    }
+    return false;
+}
+
+static bool screen(const SubstructLibrary* lib, int index, const SubstructQuery* query) {
+    const uint64_t* t = lib->fingerprints[index].bits;
+    const uint64_t* q = query->graph.fingerprints[0].bits;
+    uint64_t missing = 0;
+    for (int w = 0; w < SUBSTRUCT_FP_WORDS; w++) missing |= q[w] & ~t[w];
+    return missing == 0;
+}
+
+/* Graph match with caller-provided scratch (capacity >= molecule atoms) */
+static bool match_entry(const SubstructLibrary* lib, int index, const SubstructQuery* query,
+                        int* query_map, int* target_used) {
+    int base = lib->atom_offsets[index];
+    int n = lib->atom_offsets[index + 1] - base;
+    if (n < query->graph.atom_count) return false;
+
+    MatchState s = {query, lib->atom_labels + base, lib->edge_offsets + base,
+                    lib->edge_targets, lib->edge_types, n, query_map, target_used};
+    for (int i = 0; i < query->graph.atom_count; i++) query_map[i] = -1;
+    memset(target_used, 0, n * sizeof(int));
+    return match_from(&s, 0);
+}
+
+static int max_molecule_atoms(const SubstructLibrary* lib) {
+    int max = 0;
+    for (int m = 0; m < lib->molecule_count; m++) {
+        int n = lib->atom_offsets[m + 1] - lib->atom_offsets[m];
+        if (n > max) max = n;
+    }
+    return max;
+}
+
+bool substruct_library_match(const SubstructLibrary* lib, int index, const SubstructQuery* query) {
+    if (!lib || !query || index < 0 || index >= lib->molecule_count) return false;
+    if (!screen(lib, index, query)) return false;
+
+    int n = lib->atom_offsets[index + 1] - lib->atom_offsets[index];
+    int* query_map = malloc((query->graph.atom_count + 1) * sizeof(int));
+    int* target_used = malloc((n + 1) * sizeof(int));
+    bool found = query_map && target_used && match_entry(lib, index, query, query_map, target_used);
+    free(query_map);
+    free(target_used);
+    return found;
+}
+
+bool substruct_match_molecule(const Molecule* mol, const SubstructQuery* query) {
+    SubstructLibrary lib;
+    substruct_library_init(&lib);
+    bool found = substruct_library_add(&lib, mol) == 0 && substruct_library_match(&lib, 0, query);
+    substruct_library_free(&lib);
+    return found;
+}
+
+/* ============ Parallel Search ============ */
+
+typedef struct {
+    int* hits;
+    int hit_count;
+    int hit_capacity;
+    int* query_map;
+    int* target_used;
+    int screened;
+    bool failed;
+    char padding[64];
+} SearchWorker;
+
+typedef struct {
+    const SubstructLibrary* lib;
+    const SubstructQuery* query;
+    SearchWorker* workers;
+} SearchJob;
+
+static void search_range(int begin, int end, int thread_index, void* user_data) {
+    SearchJob* job = user_data;
+    SearchWorker* w = &job->workers[thread_index];
+
+    for (int m = begin; m < end; m++) {
+        if (!screen(job->lib, m, job->query)) continue;
+        w->screened++;
+        if (!match_entry(job->lib, m, job->query, w->query_map, w->target_used)) continue;
+
+        if (w->hit_count == w->hit_capacity) {
+            int cap = w->hit_capacity < 256 ? 256 : w->hit_capacity * 2;
+            int* hits = realloc(w->hits, cap * sizeof(int));
+            if (!hits) {
+                w->failed = true;
+                continue;
+            }
+            w->hits = hits;
+            w->hit_capacity = cap;
+        }
+        w->hits[w->hit_count++] = m;
+    }
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int substruct_search(const SubstructLibrary* lib, const SubstructQuery* query,
+                     int threads, int* hits, int max_hits, SubstructSearchStats* stats) {
+    if (!lib || !query) return -1;
+    double start = parallel_now();
+
+    threads = parallel_thread_count(threads);
+    int max_atoms = max_molecule_atoms(lib);
+    SearchWorker* workers = calloc(threads, sizeof(SearchWorker));
+    if (!workers) return -1;
+
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        workers[t].query_map = malloc((query->graph.atom_count + 1) * sizeof(int));
+        workers[t].target_used = malloc((max_atoms + 1) * sizeof(int));
+        if (!workers[t].query_map || !workers[t].target_used) ok = false;
+    }
+
+    int total = -1;
+    if (ok) {
+        SearchJob job = {lib, query, workers};
+        parallel_for(lib->molecule_count, SEARCH_CHUNK, threads, search_range, &job);
+
+        int* all = NULL;
+        total = 0;
+        int screened = 0;
+        for (int t = 0; t < threads; t++) {
+            total += workers[t].hit_count;
+            screened += workers[t].screened;
+            if (workers[t].failed) ok = false;
+        }
+
+        all = malloc((total + 1) * sizeof(int));
+        if (all && ok) {
+            int n = 0;
+            for (int t = 0; t < threads; t++) {
+                if (workers[t].hit_count == 0) continue;
+                memcpy(all + n, workers[t].hits, workers[t].hit_count * sizeof(int));
+                n += workers[t].hit_count;
+            }
+            qsort(all, total, sizeof(int), compare_ints);
+            if (hits) memcpy(hits, all, (total < max_hits ? total : max_hits) * sizeof(int));
+        } else {
+            total = -1;
+        }
+        free(all);
+
+        if (stats && total >= 0) {
+            stats->molecules = lib->molecule_count;
+            stats->screened = screened;
+            stats->matched = total;
+            stats->seconds = parallel_now() - start;
+        }
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(workers[t].hits);
+        free(workers[t].query_map);
+        free(workers[t].target_used);
+    }
+    free(workers);
+    return total;
+}
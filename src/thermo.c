@@ -0,0 +1,472 @@
+#include "thermo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FIT_TOLERANCE 1e-12         /* Relative normal-equation residual */
+#define FIT_MIN_ITERATIONS 100
+
+/* ============ Standard Data ============ */
+
+/* Delta Hf (kJ/mol) and S (J/(mol K)) at 298.15 K, 1 bar, stable phase */
+static const struct {
+    const char* formula;
+    double enthalpy;
+    double entropy;
+} THERMO_STANDARD[] = {
+    /* Elements in their reference states */
+    {"H2", 0.0, 130.68},        {"O2", 0.0, 205.15},        {"N2", 0.0, 191.61},
+    {"F2", 0.0, 202.79},        {"Cl2", 0.0, 223.08},       {"Br2", 0.0, 152.21},
+    {"I2", 0.0, 116.14},        {"C", 0.0, 5.74},           {"S", 0.0, 32.07},
+    {"P", 0.0, 41.09},          {"Li", 0.0, 29.12},         {"Na", 0.0, 51.30},
+    {"K", 0.0, 64.68},          {"Mg", 0.0, 32.67},         {"Ca", 0.0, 41.59},
+    {"Ba", 0.0, 62.50},         {"Al", 0.0, 28.30},         {"Fe", 0.0, 27.28},
+    {"Cu", 0.0, 33.15},         {"Zn", 0.0, 41.63},         {"Ag", 0.0, 42.55},
+
+    /* Atoms and small molecules (gas unless noted) */
+    {"H", 218.00, 114.72},      {"O", 249.18, 161.06},      {"O3", 142.67, 238.93},
+    {"H2O", -285.83, 69.95},    /* liquid */
+    {"H2O2", -187.78, 109.60},  /* liquid */
+    {"CO", -110.53, 197.66},    {"CO2", -393.51, 213.79},
+    {"NH3", -45.94, 192.77},    {"NO", 91.29, 210.76},      {"NO2", 33.10, 240.04},
+    {"N2O4", 9.08, 304.38},     {"SO2", -296.81, 248.22},   {"SO3", -395.72, 256.77},
+    {"HF", -273.30, 173.78},    {"HCl", -92.31, 186.90},    {"HBr", -36.29, 198.70},
+    {"HNO3", -174.10, 155.60},  /* liquid */
+    {"H2SO4", -814.00, 156.90}, /* liquid */
+
+    /* Organics */
+    {"CH4", -74.87, 186.25},    {"C2H6", -84.00, 229.20},   {"C3H8", -103.80, 270.30},
+    {"C4H10", -125.60, 310.10}, {"C2H4", 52.40, 219.30},    {"C2H2", 227.40, 200.90},
+    {"C6H6", 49.10, 173.40},    /* liquid */
+    {"CH4O", -239.20, 126.80},  /* methanol, liquid */
+    {"C2H6O", -277.60, 160.70}, /* ethanol, liquid */
+    {"C6H12O6", -1273.30, 212.10}, /* glucose, solid */
+
+    /* Oxides, hydroxides and salts (solid) */
+    {"MgO", -601.60, 26.95},    {"CaO", -634.90, 38.10},    {"Al2O3", -1675.70, 50.92},
+    {"Fe2O3", -824.20, 87.40},  {"CuO", -157.30, 42.60},    {"ZnO", -350.50, 43.70},
+    {"NaOH", -425.80, 64.46},   {"KOH", -424.60, 81.20},    {"CaO2H2", -985.20, 83.40},
+    {"NaCl", -411.12, 72.11},   {"KCl", -436.50, 82.60},    {"MgCl2", -641.30, 89.62},
+    {"CaCl2", -795.40, 108.40}, {"ZnCl2", -415.10, 111.50}, {"AgCl", -127.00, 96.30},
+    {"BaCl2", -855.00, 123.70}, {"CaCO3", -1207.60, 91.70}, {"Na2CO3", -1130.70, 135.00},
+    {"Na2SO4", -1387.10, 149.60}, {"BaSO4", -1473.20, 132.20}, {"CuSO4", -771.40, 109.20},
+    {"FeSO4", -928.40, 107.50}, {"NaNO3", -467.90, 116.50}, {"AgNO3", -124.40, 140.90},
+};
+
+#define THERMO_STANDARD_COUNT ((int)(sizeof(THERMO_STANDARD) / sizeof(THERMO_STANDARD[0])))
+
+/* ============ Species Table ============ */
+
+static Formula* thermo_formulas = NULL;
+static uint64_t* thermo_fingerprints = NULL;
+static ThermoData* thermo_data = NULL;
+static int thermo_count = 0;
+static int thermo_capacity = 0;
+static int* thermo_slots = NULL;
+static int thermo_slot_count = 0;
+static bool thermo_loaded = false;
+
+/* Open addressing on composition fingerprints, shared by the table and fits */
+static int slots_lookup(const int* slots, int slot_count, const uint64_t* fingerprints,
+                        const Formula* formulas, const Formula* formula, uint64_t fp) {
+    if (slot_count == 0) return -1;
+    int mask = slot_count - 1;
+    for (int slot = (int)(fp & (uint64_t)mask); ; slot = (slot + 1) & mask) {
+        int id = slots[slot];
+        if (id < 0) return -1;
+        if (fingerprints[id] == fp && formula_equals(&formulas[id], formula)) return id;
+    }
+}
+
+static void slots_insert(int* slots, int slot_count, const uint64_t* fingerprints, int id) {
+    int mask = slot_count - 1;
+    int slot = (int)(fingerprints[id] & (uint64_t)mask);
+    while (slots[slot] >= 0) slot = (slot + 1) & mask;
+    slots[slot] = id;
+}
+
+/* Grow the slot array so count + 1 entries stay at or below half load */
+static bool slots_reserve(int** slots, int* slot_count, const uint64_t* fingerprints, int count) {
+    if ((count + 1) * 2 <= *slot_count) return true;
+    int size = *slot_count ? *slot_count * 2 : 128;
+    int* grown = malloc((size_t)size * sizeof(int));
+    if (!grown) return false;
+    free(*slots);
+    *slots = grown;
+    *slot_count = size;
+    for (int i = 0; i < size; i++) grown[i] = -1;
+    for (int i = 0; i < count; i++) slots_insert(grown, size, fingerprints, i);
+    return true;
+}
+
+static bool table_set(const Formula* formula, double enthalpy, double entropy) {
+    uint64_t fp = formula_fingerprint(formula);
+    int id = slots_lookup(thermo_slots, thermo_slot_count, thermo_fingerprints,
+                          thermo_formulas, formula, fp);
+    if (id < 0) {
+        if (thermo_count == thermo_capacity) {
+            int capacity = thermo_capacity ? thermo_capacity * 2 : 128;
+            Formula* formulas = realloc(thermo_formulas, (size_t)capacity * sizeof(Formula));
+            if (!formulas) return false;
+            thermo_formulas = formulas;
+            uint64_t* fps = realloc(thermo_fingerprints, (size_t)capacity * sizeof(uint64_t));
+            if (!fps) return false;
+            thermo_fingerprints = fps;
+            ThermoData* data = realloc(thermo_data, (size_t)capacity * sizeof(ThermoData));
+            if (!data) return false;
+            thermo_data = data;
+            thermo_capacity = capacity;
+        }
+        if (!slots_reserve(&thermo_slots, &thermo_slot_count, thermo_fingerprints, thermo_count)) {
+            return false;
+        }
+        id = thermo_count++;
+        thermo_formulas[id] = *formula;
+        thermo_formulas[id].coefficient = 1;
+        thermo_fingerprints[id] = fp;
+        slots_insert(thermo_slots, thermo_slot_count, thermo_fingerprints, id);
+    }
+    thermo_data[id].enthalpy = enthalpy;
+    thermo_data[id].entropy = entropy;
+    return true;
+}
+
+static void thermo_load(void) {
+    if (thermo_loaded) return;
+    thermo_loaded = true;
+    for (int i = 0; i < THERMO_STANDARD_COUNT; i++) {
+        Formula formula;
+        if (!formula_parse(THERMO_STANDARD[i].formula, &formula) ||
+            !table_set(&formula, THERMO_STANDARD[i].enthalpy, THERMO_STANDARD[i].entropy)) {
+            fprintf(stderr, "Failed to load thermochemistry for %s\n", THERMO_STANDARD[i].formula);
+        }
+    }
+}
+
+bool thermo_species_get(const Formula* formula, ThermoData* out) {
+    if (!formula) return false;
+    thermo_load();
+    int id = slots_lookup(thermo_slots, thermo_slot_count, thermo_fingerprints, thermo_formulas,
+                          formula, formula_fingerprint(formula));
+    if (id < 0) return false;
+    if (out) *out = thermo_data[id];
+    return true;
+}
+
+bool thermo_species_set(const Formula* formula, double enthalpy, double entropy) {
+    if (!formula) return false;
+    thermo_load();
+    return table_set(formula, enthalpy, entropy);
+}
+
+int thermo_species_count(void) {
+    thermo_load();
+    return thermo_count;
+}
+
+bool thermo_species_truncate(int count) {
+    thermo_load();
+    if (count < 0 || count > thermo_count) return false;
+    thermo_count = count;
+    for (int i = 0; i < thermo_slot_count; i++) thermo_slots[i] = -1;
+    for (int i = 0; i < thermo_count; i++) {
+        slots_insert(thermo_slots, thermo_slot_count, thermo_fingerprints, i);
+    }
+    return true;
+}
+
+/* ============ Reaction Energetics ============ */
+
+static void add_side(const Formula* formulas, int count, double sign, double* enthalpy,
+                     double* entropy) {
+    for (int i = 0; i < count; i++) {
+        ThermoData data;
+        double nu = sign * (formulas[i].coefficient > 0 ? formulas[i].coefficient : 1);
+        if (!thermo_species_get(&formulas[i], &data)) {
+            *enthalpy = NAN;
+            *entropy = NAN;
+            return;
+        }
+        *enthalpy += nu * data.enthalpy;
+        *entropy += nu * data.entropy;
+    }
+}
+
+bool thermo_reaction(const Reaction* rxn, ReactionEnergetics* out) {
+    if (!rxn || !out) return false;
+    double enthalpy = 0.0, entropy = 0.0;
+    add_side(rxn->reactants, rxn->reactant_count, -1.0, &enthalpy, &entropy);
+    add_side(rxn->products, rxn->product_count, 1.0, &enthalpy, &entropy);
+    out->enthalpy = enthalpy;
+    out->entropy = entropy;
+    out->gibbs = thermo_gibbs_at(out, THERMO_STANDARD_TEMPERATURE);
+    return !isnan(enthalpy);
+}
+
+double thermo_gibbs_at(const ReactionEnergetics* energetics, double temperature) {
+    if (!energetics) return NAN;
+    return energetics->enthalpy - temperature * energetics->entropy / 1000.0;
+}
+
+typedef struct {
+    double gibbs;
+    int index;
+} RankEntry;
+
+static int compare_rank(const void* a, const void* b) {
+    const RankEntry* x = a;
+    const RankEntry* y = b;
+    if (x->gibbs != y->gibbs) return x->gibbs < y->gibbs ? -1 : 1;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+int thermo_rank(const Reaction* const* reactions, int count, double max_gibbs, int* order) {
+    if (!reactions || !order || count < 0) return -1;
+    RankEntry* entries = malloc((size_t)(count > 0 ? count : 1) * sizeof(RankEntry));
+    if (!entries) return -1;
+
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        double gibbs = reactions[i] ? reactions[i]->energetics.gibbs : NAN;
+        if (gibbs <= max_gibbs) {
+            entries[kept].gibbs = gibbs;
+            entries[kept].index = i;
+            kept++;
+        }
+    }
+    qsort(entries, kept, sizeof(RankEntry), compare_rank);
+    for (int i = 0; i < kept; i++) order[i] = entries[i].index;
+    free(entries);
+    return kept;
+}
+
+/* ============ Hess's Law Fit ============ */
+
+void thermo_fit_init(HessFit* fit) {
+    if (!fit) return;
+    memset(fit, 0, sizeof(HessFit));
+}
+
+void thermo_fit_free(HessFit* fit) {
+    if (!fit) return;
+    free(fit->species);
+    free(fit->fingerprints);
+    free(fit->enthalpies);
+    free(fit->slots);
+    thermo_fit_init(fit);
+}
+
+/* Index of an unknown species, added if new (-1 on allocation failure) */
+static int fit_intern(HessFit* fit, const Formula* formula) {
+    uint64_t fp = formula_fingerprint(formula);
+    int id = slots_lookup(fit->slots, fit->slot_count, fit->fingerprints, fit->species, formula, fp);
+    if (id >= 0) return id;
+
+    if (fit->count == fit->capacity) {
+        int capacity = fit->capacity ? fit->capacity * 2 : 64;
+        Formula* species = realloc(fit->species, (size_t)capacity * sizeof(Formula));
+        if (!species) return -1;
+        fit->species = species;
+        uint64_t* fps = realloc(fit->fingerprints, (size_t)capacity * sizeof(uint64_t));
+        if (!fps) return -1;
+        fit->fingerprints = fps;
+        double* enthalpies = realloc(fit->enthalpies, (size_t)capacity * sizeof(double));
+        if (!enthalpies) return -1;
+        fit->enthalpies = enthalpies;
+        fit->capacity = capacity;
+    }
+    if (!slots_reserve(&fit->slots, &fit->slot_count, fit->fingerprints, fit->count)) return -1;
+
+    id = fit->count++;
+    fit->species[id] = *formula;
+    fit->species[id].coefficient = 1;
+    fit->fingerprints[id] = fp;
+    fit->enthalpies[id] = 0.0;
+    slots_insert(fit->slots, fit->slot_count, fit->fingerprints, id);
+    return id;
+}
+
+/* Sparse equation rows: unknown columns with net coefficients, and the right-hand side */
+typedef struct {
+    int* offsets;
+    int* columns;
+    double* values;
+    double* rhs;
+    int rows;
+    int entries;
+} FitSystem;
+
+/*
+ * Append one reaction's equation. Known species move to the right-hand
+ * side; unknown ones are merged per species and zero net terms dropped.
+ */
+static bool add_equation(HessFit* fit, FitSystem* system, const Reaction* rxn, double enthalpy) {
+    int columns[MAX_REACTANTS + MAX_PRODUCTS];
+    double values[MAX_REACTANTS + MAX_PRODUCTS];
+    int terms = 0;
+    double rhs = enthalpy;
+
+    for (int side = 0; side < 2; side++) {
+        const Formula* formulas = side ? rxn->products : rxn->reactants;
+        int count = side ? rxn->product_count : rxn->reactant_count;
+        double sign = side ? 1.0 : -1.0;
+        for (int i = 0; i < count; i++) {
+            double nu = sign * (formulas[i].coefficient > 0 ? formulas[i].coefficient : 1);
+            ThermoData data;
+            if (thermo_species_get(&formulas[i], &data) && !isnan(data.enthalpy)) {
+                rhs -= nu * data.enthalpy;
+                continue;
+            }
+            int column = fit_intern(fit, &formulas[i]);
+            if (column < 0) return false;
+            int t = 0;
+            while (t < terms && columns[t] != column) t++;
+            if (t == terms) {
+                columns[terms] = column;
+                values[terms++] = 0.0;
+            }
+            values[t] += nu;
+        }
+    }
+
+    int start = system->entries;
+    for (int t = 0; t < terms; t++) {
+        if (values[t] == 0.0) continue;
+        system->columns[system->entries] = columns[t];
+        system->values[system->entries++] = values[t];
+    }
+    if (system->entries == start) return true;
+    system->rhs[system->rows] = rhs;
+    system->offsets[++system->rows] = system->entries;
+    return true;
+}
+
+/* y = A x (rows) */
+static void multiply(const FitSystem* system, const double* x, double* y) {
+    for (int r = 0; r < system->rows; r++) {
+        double sum = 0.0;
+        for (int e = system->offsets[r]; e < system->offsets[r + 1]; e++) {
+            sum += system->values[e] * x[system->columns[e]];
+        }
+        y[r] = sum;
+    }
+}
+
+/* y = A^T x (columns) */
+static void multiply_transposed(const FitSystem* system, const double* x, double* y, int columns) {
+    memset(y, 0, (size_t)columns * sizeof(double));
+    for (int r = 0; r < system->rows; r++) {
+        for (int e = system->offsets[r]; e < system->offsets[r + 1]; e++) {
+            y[system->columns[e]] += system->values[e] * x[r];
+        }
+    }
+}
+
+static double dot(const double* a, const double* b, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+/* CGLS from x = 0: minimum-norm least squares on the consistent part */
+static int solve_cgls(const FitSystem* system, double* x, int n) {
+    int m = system->rows;
+    double* block = malloc((size_t)(2 * n + 2 * m + 1) * sizeof(double));
+    if (!block) return -1;
+    double* s = block;
+    double* p = s + n;
+    double* r = p + n;
+    double* q = r + m;
+
+    memset(x, 0, (size_t)n * sizeof(double));
+    memcpy(r, system->rhs, (size_t)m * sizeof(double));
+    multiply_transposed(system, r, s, n);
+    memcpy(p, s, (size_t)n * sizeof(double));
+    double gamma = dot(s, s, n);
+    double stop = FIT_TOLERANCE * FIT_TOLERANCE * gamma;
+
+    int max_iterations = 4 * n > FIT_MIN_ITERATIONS ? 4 * n : FIT_MIN_ITERATIONS;
+    int iteration = 0;
+    while (iteration < max_iterations && gamma > stop) {
+        multiply(system, p, q);
+        double qq = dot(q, q, m);
+        if (!(qq > 0.0)) break;
+        double alpha = gamma / qq;
+        for (int i = 0; i < n; i++) x[i] += alpha * p[i];
+        for (int i = 0; i < m; i++) r[i] -= alpha * q[i];
+        multiply_transposed(system, r, s, n);
+        double next = dot(s, s, n);
+        double beta = next / gamma;
+        gamma = next;
+        for (int i = 0; i < n; i++) p[i] = s[i] + beta * p[i];
+        iteration++;
+    }
+    free(block);
+    return iteration;
+}
+
+bool thermo_fit_enthalpies(HessFit* fit, const Reaction* const* reactions,
+                           const double* reaction_enthalpies, int count) {
+    if (!fit || !reactions || !reaction_enthalpies || count < 0) return false;
+    fit->count = 0;
+    fit->equations = 0;
+    fit->iterations = 0;
+    fit->rms_residual = 0.0;
+    for (int i = 0; i < fit->slot_count; i++) fit->slots[i] = -1;
+    thermo_load();
+
+    int max_entries = 0;
+    for (int i = 0; i < count; i++) {
+        if (reactions[i]) max_entries += reactions[i]->reactant_count + reactions[i]->product_count;
+    }
+    FitSystem system = {0};
+    system.offsets = malloc(((size_t)count + 1) * sizeof(int));
+    system.columns = malloc((size_t)(max_entries > 0 ? max_entries : 1) * sizeof(int));
+    system.values = malloc((size_t)(max_entries > 0 ? max_entries : 1) * sizeof(double));
+    system.rhs = malloc((size_t)(count > 0 ? count : 1) * sizeof(double));
+    bool ok = system.offsets && system.columns && system.values && system.rhs;
+    if (ok) system.offsets[0] = 0;
+
+    for (int i = 0; ok && i < count; i++) {
+        if (!reactions[i] || isnan(reaction_enthalpies[i])) continue;
+        ok = add_equation(fit, &system, reactions[i], reaction_enthalpies[i]);
+    }
+
+    if (ok && system.rows > 0) {
+        int iterations = solve_cgls(&system, fit->enthalpies, fit->count);
+        ok = iterations >= 0;
+        if (ok) {
+            fit->iterations = iterations;
+            fit->equations = system.rows;
+            double* predicted = malloc((size_t)system.rows * sizeof(double));
+            ok = predicted != NULL;
+            if (ok) {
+                multiply(&system, fit->enthalpies, predicted);
+                double sum = 0.0;
+                for (int r = 0; r < system.rows; r++) {
+                    double residual = predicted[r] - system.rhs[r];
+                    sum += residual * residual;
+                }
+                fit->rms_residual = sqrt(sum / system.rows);
+                free(predicted);
+            }
+        }
+    }
+
+    free(system.offsets);
+    free(system.columns);
+    free(system.values);
+    free(system.rhs);
+    return ok;
+}
+
+bool thermo_fit_store(const HessFit* fit) {
+    if (!fit) return false;
+    for (int i = 0; i < fit->count; i++) {
+        ThermoData data;
+        double entropy = thermo_species_get(&fit->species[i], &data) ? data.entropy : NAN;
+        if (!thermo_species_set(&fit->species[i], fit->enthalpies[i], entropy)) return false;
+    }
+    return true;
+}
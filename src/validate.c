@@ -0,0 +1,270 @@
+#include "validate.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_VALENCE_STATES 8
+#define MAX_FORMAL_CHARGE 3
+#define VALIDATE_CHUNK 256
+
+/* ============ Valence Rules ============ */
+
+static bool unchecked_element(const Element* el) {
+    return el->category == CAT_TRANSITION_METAL || el->category == CAT_LANTHANIDE ||
+           el->category == CAT_ACTINIDE;
+}
+
+int validate_valence_states(const Element* element, int charge, int* valences, int max) {
+    if (!element || !valences || max <= 0) return 0;
+    if (unchecked_element(element)) return -1;
+
+    if (element->atomic_number == 1) {
+        if (charge < -1 || charge > 1) return 0;
+        valences[0] = charge == 0 ? 1 : 0;
+        return 1;
+    }
+    if (element->category == CAT_NOBLE_GAS) {
+        if (charge != 0) return 0;
+        valences[0] = 0;
+        return 1;
+    }
+
+    int electrons = element->valence_electrons - charge;
+    if (electrons < 0 || electrons > 8) return 0;
+    if (electrons <= 4) {
+        valences[0] = electrons;
+        return 1;
+    }
+
+    /* Octet expansion only from period 3 on */
+    int count = 0;
+    int limit = element->atomic_number > 10 ? electrons : 8 - electrons;
+    for (int v = 8 - electrons; v <= limit && count < max; v += 2) valences[count++] = v;
+    return count;
+}
+
+static bool valence_allowed(const Element* el, int charge, int order_sum, int aromatic) {
+    int states[MAX_VALENCE_STATES];
+    int n = validate_valence_states(el, charge, states, MAX_VALENCE_STATES);
+    if (n < 0) return true;
+
+    int low = order_sum + aromatic;                 /* Every aromatic bond single */
+    int high = aromatic > 0 ? low + 1 : low;        /* One of them double */
+    for (int i = 0; i < n; i++) {
+        if (states[i] == low || states[i] == high) return true;
+    }
+    return false;
+}
+
+/* Smallest-magnitude charge (positive first) whose states admit the bonds */
+static bool implied_charge(const Element* el, int order_sum, int aromatic, int* charge) {
+    for (int magnitude = 0; magnitude <= MAX_FORMAL_CHARGE; magnitude++) {
+        if (valence_allowed(el, magnitude, order_sum, aromatic)) {
+            *charge = magnitude;
+            return true;
+        }
+        if (magnitude > 0 && valence_allowed(el, -magnitude, order_sum, aromatic)) {
+            *charge = -magnitude;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool common_charge(const Element* el, int charge) {
+    for (int i = 0; i < 4 && el->common_charges[i] != 0; i++) {
+        if (el->common_charges[i] == charge) return true;
+    }
+    return false;
+}
+
+const char* validation_kind_str(ValidationKind kind) {
+    switch (kind) {
+        case VALIDATION_BAD_BOND: return "bad bond";
+        case VALIDATION_VALENCE_EXCEEDED: return "valence exceeded";
+        case VALIDATION_VALENCE_UNSATISFIED: return "valence unsatisfied";
+        case VALIDATION_CHARGE_MISMATCH: return "charge mismatch";
+        case VALIDATION_UNCOMMON_CHARGE: return "uncommon charge";
+        default: return "unknown";
+    }
+}
+
+/* ============ Validator ============ */
+
+void validator_init(Validator* v) {
+    if (!v) return;
+    memset(v, 0, sizeof(*v));
+}
+
+void validator_free(Validator* v) {
+    if (!v) return;
+    free(v->order_sums);
+    free(v->aromatic_bonds);
+    free(v->formal_charges);
+    validator_init(v);
+}
+
+static bool validator_reserve(Validator* v, int atoms) {
+    if (atoms <= v->capacity) return true;
+
+    int cap = v->capacity < 64 ? 64 : v->capacity;
+    while (cap < atoms) cap *= 2;
+    int* order_sums = realloc(v->order_sums, cap * sizeof(int));
+    if (order_sums) v->order_sums = order_sums;
+    int* aromatic = realloc(v->aromatic_bonds, cap * sizeof(int));
+    if (aromatic) v->aromatic_bonds = aromatic;
+    int* formal = realloc(v->formal_charges, cap * sizeof(int));
+    if (formal) v->formal_charges = formal;
+    if (!order_sums || !aromatic || !formal) return false;
+
+    v->capacity = cap;
+    return true;
+}
+
+static void report(ValidationIssue* issues, int max_issues, int* count, ValidationKind kind,
+                   int atom, int order_sum, int declared, int formal) {
+    if (*count < max_issues) {
+        ValidationIssue* issue = &issues[*count];
+        issue->kind = kind;
+        issue->atom = atom;
+        issue->bond_order_sum = order_sum;
+        issue->declared_charge = declared;
+        issue->formal_charge = formal;
+    }
+    (*count)++;
+}
+
+int validator_check(Validator* v, const Molecule* mol, ValidationIssue* issues, int max_issues) {
+    if (!v || !mol) return -1;
+    if (!issues) max_issues = 0;
+
+    int n = mol->atom_count;
+    if (!validator_reserve(v, n)) return -1;
+    for (int i = 0; i < n; i++) v->order_sums[i] = mol->atoms[i].hydrogens;
+    memset(v->aromatic_bonds, 0, n * sizeof(int));
+
+    int found = 0;
+    for (int b = 0; b < mol->bond_count; b++) {
+        const Bond* bond = &mol->bonds[b];
+        int a1 = bond->atom1_id, a2 = bond->atom2_id;
+        if (a1 < 0 || a1 >= n || a2 < 0 || a2 >= n || a1 == a2) {
+            report(issues, max_issues, &found, VALIDATION_BAD_BOND, b, 0, 0, 0);
+            continue;
+        }
+        if (bond->type == BOND_AROMATIC) {
+            v->aromatic_bonds[a1]++;
+            v->aromatic_bonds[a2]++;
+        } else {
+            int order = bond->type == BOND_DOUBLE ? 2 : bond->type == BOND_TRIPLE ? 3 : 1;
+            v->order_sums[a1] += order;
+            v->order_sums[a2] += order;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        const Atom* atom = &mol->atoms[i];
+        const Element* el = atom->element;
+        int order_sum = v->order_sums[i];
+        int aromatic = v->aromatic_bonds[i];
+        int sum = order_sum + aromatic;
+
+        v->formal_charges[i] = atom->charge;
+        if (sum == 0 && atom->charge != 0 && !unchecked_element(el)) {
+            /* Lone ion: judged by its usual ionic charges */
+            if (!common_charge(el, atom->charge)) {
+                report(issues, max_issues, &found, VALIDATION_UNCOMMON_CHARGE,
+                       i, sum, atom->charge, atom->charge);
+            }
+            continue;
+        }
+        if (valence_allowed(el, atom->charge, order_sum, aromatic)) continue;
+
+        int states[MAX_VALENCE_STATES];
+        int count = validate_valence_states(el, atom->charge, states, MAX_VALENCE_STATES);
+        int charge;
+        if (count > 0 && sum < states[count - 1]) {
+            /* Room left at the declared charge: missing hydrogens or a radical */
+            report(issues, max_issues, &found, VALIDATION_VALENCE_UNSATISFIED,
+                   i, sum, atom->charge, atom->charge);
+        } else if (implied_charge(el, order_sum, aromatic, &charge)) {
+            v->formal_charges[i] = charge;
+            report(issues, max_issues, &found, VALIDATION_CHARGE_MISMATCH,
+                   i, sum, atom->charge, charge);
+        } else {
+            report(issues, max_issues, &found, VALIDATION_VALENCE_EXCEEDED,
+                   i, sum, atom->charge, atom->charge);
+        }
+    }
+    return found;
+}
+
+/* ============ Batch Validation ============ */
+
+#define BATCH_ISSUES 16
+
+typedef struct {
+    Validator validator;
+    ValidationStats stats;
+    bool failed;
+    char padding[64];
+} ValidateWorker;
+
+typedef struct {
+    const Molecule* const* molecules;
+    int* issue_counts;
+    ValidateWorker* workers;
+} ValidateJob;
+
+static void validate_range(int begin, int end, int thread_index, void* user_data) {
+    ValidateJob* job = user_data;
+    ValidateWorker* w = &job->workers[thread_index];
+    ValidationIssue issues[BATCH_ISSUES];
+
+    for (int m = begin; m < end; m++) {
+        int found = validator_check(&w->validator, job->molecules[m], issues, BATCH_ISSUES);
+        if (found < 0) {
+            w->failed = true;
+            found = 0;
+        }
+        if (job->issue_counts) job->issue_counts[m] = found;
+
+        w->stats.molecules++;
+        if (found == 0) {
+            w->stats.valid++;
+            continue;
+        }
+        w->stats.invalid++;
+        int recorded = found < BATCH_ISSUES ? found : BATCH_ISSUES;
+        for (int i = 0; i < recorded; i++) w->stats.issues[issues[i].kind]++;
+    }
+}
+
+bool validate_molecules(const Molecule* const* molecules, int count, int threads,
+                        int* issue_counts, ValidationStats* stats) {
+    if (!molecules || count < 0) return false;
+    double start = parallel_now();
+
+    threads = parallel_thread_count(threads);
+    ValidateWorker* workers = calloc(threads, sizeof(ValidateWorker));
+    if (!workers) return false;
+    for (int t = 0; t < threads; t++) validator_init(&workers[t].validator);
+
+    ValidateJob job = {molecules, issue_counts, workers};
+    bool ok = parallel_for(count, VALIDATE_CHUNK, threads, validate_range, &job);
+
+    ValidationStats totals;
+    memset(&totals, 0, sizeof(totals));
+    for (int t = 0; t < threads; t++) {
+        totals.molecules += workers[t].stats.molecules;
+        totals.valid += workers[t].stats.valid;
+        totals.invalid += workers[t].stats.invalid;
+        for (int k = 0; k < VALIDATION_KIND_COUNT; k++) totals.issues[k] += workers[t].stats.issues[k];
+        if (workers[t].failed) ok = false;
+        validator_free(&workers[t].validator);
+    }
+    totals.seconds = parallel_now() - start;
+    if (stats) *stats = totals;
+
+    free(workers);
+    return ok;
+}